@@ -235,6 +235,40 @@
 *    2021-03-12 JFL Optionally display the compression ratio in Windows.      *
 *		    Display more readable sizes, with thousands separators.   *
 *                   Version 3.7.                                              *
+*    2026-10-17 MAB Allocate the fif structures, names and link targets in    *
+*		    an arena, released in one go after each directory.        *
+*		    Version 3.7.1.					      *
+*		    Compile the wildcards patterns once with SysLib fnmatchx. *
+*		    Test the names and types before calling stat().	      *
+*    2026-10-17 MAB Scan the two directories concurrently, into separate      *
+*		    arrays sorted independently on precomputed lower case     *
+*		    keys. Then pair the files with a linear merge-join.       *
+*		    Version 3.8.					      *
+*		    Option -c compares the files in a pool of threads, and    *
+*		    Unix compares sizes before reading, then uses large reads.*
+*		    Added option -jobs to set the number of threads.          *
+*		    Version 3.9.					      *
+*		    Added option -cache to reuse files contents digests.      *
+*		    Version 3.10.					      *
+*		    Store only the stat fields used in compact fif records,   *
+*		    allocated in one array per directory, with the names in a *
+*		    separate arena, and an integer prefix of the sort key.    *
+*		    Version 3.11.					      *
+*		    Added option -prune to skip identical subtrees, based on  *
+*		    digests of both trees computed beforehand. Version 3.12.  *
+*		    Read link targets only for the links displayed or         *
+*		    digested, using readlinkat() in Unix. Version 3.12.1.     *
+*		    Added option -save-snapshot to record a tree in a file,   *
+*		    that can then be compared like a directory. Version 3.13. *
+*		    Added option -watch to keep comparing both trees after    *
+*		    the first pass, reporting only the entries whose status   *
+*		    changed, based on inotify events. Version 3.14.	      *
+*    2026-10-17 MAB Use the SysLib MurmurHash3 digest, which accepts pieces   *
+*		    of any length. Digest the -prune names with their length. *
+*		    Version 3.14.1.					      *
+*    2026-10-17 MAB In Unix, list directories with readdirplus(), and get     *
+*		    the stat data of the selected entries only.		      *
+*		    Version 3.14.2.					      *
 *		    							      *
 *       © Copyright 2016-2018 Hewlett Packard Enterprise Development LP       *
 * Licensed under the Apache 2.0 license - www.apache.org/licenses/LICENSE-2.0 *
@@ -242,8 +276,8 @@
 
 #define PROGRAM_DESCRIPTION "Compare directories side by side, sorted by file names"
 #define PROGRAM_NAME    "dirc"
-#define PROGRAM_VERSION "3.7"
-#define PROGRAM_DATE    "2021-03-12"
+#define PROGRAM_VERSION "3.14.2"
+#define PROGRAM_DATE    "2026-10-17"
 
 #include "predefine.h" /* Define optional features we need in the C libraries */
 
@@ -257,6 +291,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <ctype.h>
 #include <memory.h>
 #include <limits.h>
 #include <time.h>
@@ -273,6 +308,9 @@
 #include <stdarg.h>
 /* SysLib include files */
 #include "dirx.h"		/* Directory access functions eXtensions */
+#include "arena.h"		/* Arena allocator for the fif structures */
+#include "murmur3.h"		/* MurmurHash3 digests of the files contents */
+#include "fnmatchx.h"		/* Precompiled wildcards patterns */
 /* SysToolsLib include files */
 #include "debugm.h"	/* SysToolsLib debug macros */
 #include "stversion.h"	/* SysToolsLib version strings. Include last. */
@@ -306,6 +344,7 @@ DEBUG_GLOBALS	/* Define global variables used by debugging macros. (Necessary fo
 #define HAS_DRIVES FALSE
 
 #include <strings.h>
+#include <fcntl.h>		/* For open() and posix_fadvise() */
 
 #define _getch getchar
 
@@ -435,6 +474,38 @@ int SetMasterEnv(char *pszName, char *pszValue);
 
 /********************** End of OS-specific definitions ***********************/
 
+/* Flag OSs where we can scan the two directories in parallel threads */
+#if defined(_UNIX)
+  #define HAS_THREADS 1
+  #include <pthread.h>
+#else
+  #define HAS_THREADS 0
+#endif
+
+/* Flag OSs where we can cache files digests, keyed by device and inode */
+#if defined(_UNIX)
+  #define HAS_CACHE 1
+  #include <sys/mman.h>
+#else
+  #define HAS_CACHE 0
+#endif
+
+/* Flag OSs where we can prune identical subtrees, using the same digests */
+#define HAS_PRUNE HAS_CACHE
+
+/* Flag OSs where we can record snapshots, and map them in memory */
+#define HAS_SNAPSHOT HAS_CACHE
+
+/* Flag OSs where we can watch both trees for changes after comparing them */
+#if defined(__linux__)
+  #define HAS_INOTIFY 1
+  #include <sys/inotify.h>
+  #include <poll.h>
+  #include "hashtab.h"		/* SysToolsLib hash functions */
+#else
+  #define HAS_INOTIFY 0
+#endif
+
 /* Local definitions */
 
 #define PATHNAME_SIZE PATH_MAX		/* Buffer size for holding pathnames, including NUL */
@@ -479,23 +550,54 @@ typedef enum {
 #define _A_LINK     0x40
 #define _A_DEVICE   0x80
 
+/* lis() attributes for listing the subdirectories to descend into */
+#define SUBDIRS_ATTRIB (0x8000 | _A_SUBDIR | _A_SYSTEM | _A_HIDDEN)
+
 typedef int (*PSTATFUNC)(const char *path, struct stat *buf);
 
 /* Directory scan functions definitions */
 
+#ifdef _MSDOS
+typedef unsigned long keyprefix_t;  /* The largest integer for the key prefix */
+#else
+typedef uint64_t keyprefix_t;
+#endif
+
 typedef struct fif {	    /* OS-independant FInd File structure */
+  keyprefix_t keyPrefix;	/* The first bytes of key, packed big-endian */
   char *name; 			/* File node name, ending with a NUL */
-  struct stat st;		/* File size, time, etc */
+  char *key;			/* Name in lower case for sorting. Maybe = name */
 #ifndef _MSDOS
   char *target; 		/* Link target name, for links */
+#endif
+  off_t size;			/* The stat() data that dirc displays or compares */
+  time_t mtime;
+  unsigned int mode;
+#if _MSVCLIBX_STAT_DEFINED
+  unsigned int win32Attrs;
+  unsigned int reparseTag;
 #endif
 #ifdef _WIN32
   ULARGE_INTEGER qwComprSize;	/* The compressed file size */
 #endif
-  int column;
-  struct fif *next;
+#if HAS_SNAPSHOT
+  const uint64_t *pDigest;	/* Contents digest recorded in a snapshot, or NULL */
+#endif
 } fif;
 
+typedef struct {	    /* The sorted contents of one directory */
+  fif *pFifs;			/* The fif records, in the directory order */
+  fif **ppfif;			/* Sorted array of fif pointers, NULL-terminated */
+  int nfif;			/* Number of fif pointers in that array */
+  int iNext;			/* Index of the next entry to merge */
+} fifList;
+
+typedef struct {	    /* A line of the report */
+  fif *pfif1;			/* Left file, or NULL if none */
+  fif *pfif2;			/* Right file, or NULL if none */
+  int difference;		/* The result of CompareFifs(), or MISMATCH */
+} fifPair;
+
 /* Configuration flags recursively passed to all local subroutines */
 
 typedef struct {
@@ -512,6 +614,7 @@ typedef struct {
   int cont:1;		/* Continue after errors */
   int dtime:1;		/* Report equal files with != times */
   int nobak:1;		/* Skip backup files */
+  int prune:1;		/* Skip subtrees with identical digests */
 #ifdef _WIN32
   int compression:1;	/* Report the compression ratio */
 #endif
@@ -519,6 +622,228 @@ typedef struct {
               This would force to change DEBUG_ENTER() format strings for MS-DOS! */
 } t_opts;
 
+/* Arguments for scanning one directory, possibly in a parallel thread */
+
+typedef struct {
+  char *path;			/* Absolute pathname of the directory */
+  char *pattern;		/* Wildcards pattern */
+  int col;			/* 1 = left column; 2 = right column */
+  int attrib;			/* Search attributes. See lis() */
+  time_t datemin;		/* Minimal date */
+  time_t datemax;		/* Maximal date */
+  t_opts opts;			/* User-defined options */
+  fifList *pList;		/* Where to store the results. NULL=Don't scan */
+} scanJob;
+
+typedef struct {	    /* Reads the link targets of one directory on demand */
+  char *path;			/* Absolute pathname of the directory */
+  ARENA *pArena;		/* Where to store the targets */
+  char *pBuf;			/* Buffer for readlink(), or NULL if not allocated yet */
+#if defined(_UNIX)
+  int iDirFd;			/* The directory, or -1 if not opened yet, or -2 if failed */
+#endif
+} linkReader;
+
+#if HAS_THREADS
+/* Work shared by the file comparison threads */
+
+typedef struct {
+  fifPair *pPairs;		/* The pairs to compare */
+  int nPairs;			/* Number of pairs */
+  int iNext;			/* Index of the next pair to compare */
+  t_opts opts;			/* User-defined options */
+  pthread_mutex_t mutex;	/* Protects iNext */
+} comparePool;
+#endif /* HAS_THREADS */
+
+typedef struct _dirNode dirNode;
+
+#if HAS_CACHE
+/* Digest cache file layout: A header, then the records sorted by (dev, ino).
+   All in the native byte order, so that the file can be used in place once
+   mapped in memory. */
+#define DCC_MAGIC   0x43434344	    /* "DCCC" in little endian machines */
+#define DCC_VERSION 1
+
+typedef struct _dccHeader {	/* Digest cache file header */
+  uint32_t magic;		    /* DCC_MAGIC */
+  uint32_t version;		    /* DCC_VERSION */
+  uint64_t nRecords;		    /* Number of records following the header */
+} dccHeader;
+
+typedef struct _dccRecord {	/* Digest cache record for one file */
+  uint64_t dev;			    /* The file device and inode */
+  uint64_t ino;
+  int64_t size;			    /* Its size, mtime and ctime when read */
+  int64_t mtime;
+  int64_t mtimeNs;
+  int64_t ctime;
+  int64_t ctimeNs;
+  uint64_t digest[2];		    /* Its contents 128-bit digest */
+} dccRecord;
+
+typedef struct _digestCache {	/* A digest cache, loaded from, and saved to, a file */
+  char *pszFile;		    /* The cache file pathname */
+  time_t tStart;		    /* When the comparison started */
+  void *pMap;			    /* The previous cache file, mapped in memory */
+  size_t lMap;
+  const dccRecord *pOld;	    /* Its records */
+  uint64_t nOld;
+  dccRecord *pNew;		    /* The records for the files read this time */
+  uint64_t nNew;
+  uint64_t nNewAlloc;
+  long nHits;			    /* Number of digests reused */
+  long nMisses;			    /* Number of files read */
+#if HAS_THREADS
+  pthread_mutex_t mutex;	    /* Protects the new records and the counters */
+#endif /* HAS_THREADS */
+} digestCache;
+
+#if defined(__MACH__)
+#define ST_MTIME_NS(pst) ((pst)->st_mtimespec.tv_nsec)
+#define ST_CTIME_NS(pst) ((pst)->st_ctimespec.tv_nsec)
+#else
+#define ST_MTIME_NS(pst) ((pst)->st_mtim.tv_nsec)
+#define ST_CTIME_NS(pst) ((pst)->st_ctim.tv_nsec)
+#endif
+#endif /* HAS_CACHE */
+
+#if HAS_PRUNE
+/* Summary of a directory subtree, for skipping those identical on both sides */
+
+struct _dirNode {
+  char *name;			/* Directory node name. "" for the root */
+  uint64_t listDigest[2];	/* Digest of the files listed in this directory */
+  uint64_t treeDigest[2];	/* Digest of that list, and of all subtrees */
+  int listValid;		/* TRUE if listDigest accounts for all we compare */
+  int treeValid;		/* TRUE if treeDigest accounts for all we compare */
+  int nChildren;		/* Number of subdirectories */
+  dirNode **ppChildren;		/* Their nodes, in the descend() order */
+  dirNode *pParent;		/* The parent node, or NULL for the root */
+  int nPending;			/* Number of subdirectories not digested yet */
+};
+
+typedef struct _treeTask {  /* A directory to digest */
+  struct _treeTask *pNext;	/* The next one in the pool stack */
+  dirNode *pNode;		/* Its node, with the name and parent set */
+  char *path;			/* Its absolute pathname */
+} treeTask;
+
+typedef struct {	    /* Work shared by the tree digesting threads */
+  treeTask *pTasks;		/* Stack of directories to digest */
+  int nBusy;			/* Number of threads digesting a directory */
+  char *pattern;		/* Wildcards pattern */
+  int attrib;			/* Search attributes. See lis() */
+  time_t datemin;		/* Minimal date */
+  time_t datemax;		/* Maximal date */
+  t_opts opts;			/* User-defined options */
+#if HAS_THREADS
+  pthread_mutex_t mutex;	/* Protects the stack, nBusy, and nodes nPending */
+  pthread_cond_t cond;		/* Signaled when tasks are added, or all are done */
+#endif /* HAS_THREADS */
+} treePool;
+#endif /* HAS_PRUNE */
+
+#if HAS_SNAPSHOT
+/* Snapshot file layout: A header, then the directory records, the entry
+   records, and the strings. All in the native byte order, so that the file
+   can be used in place once mapped in memory. Directory 0 is the root. */
+#define DCS_MAGIC   0x53534344	    /* "DCSS" in little endian machines */
+#define DCS_VERSION 1
+#define DCS_DIGESTS 0x0001	    /* Flag: The contents digest is recorded */
+
+typedef struct _dcsHeader {	/* Snapshot file header */
+  uint32_t magic;		    /* DCS_MAGIC */
+  uint32_t version;		    /* DCS_VERSION */
+  uint32_t flags;		    /* DCS_DIGESTS if recorded with -c */
+  uint32_t reserved;
+  uint64_t nDirs;		    /* Number of dcsDir records */
+  uint64_t nEntries;		    /* Number of dcsEntry records */
+  uint64_t lStrings;		    /* Size of the NUL-terminated strings */
+} dcsHeader;
+
+typedef struct _dcsDir {	/* Snapshot record for one directory */
+  uint64_t iFirst;		    /* Index of its first dcsEntry */
+  uint64_t nEntries;		    /* Number of entries, sorted by name */
+} dcsDir;
+
+typedef struct _dcsEntry {	/* Snapshot record for one directory entry */
+  uint64_t oName;		    /* Offset of its name in the strings */
+  uint64_t oLink;		    /* Links: Target offset. Dirs: dcsDir index + 1 */
+  int64_t size;
+  int64_t mtime;
+  uint32_t mode;
+  uint32_t flags;		    /* DCS_DIGESTS if digest is valid */
+  uint64_t digest[2];		    /* Its contents 128-bit digest */
+} dcsEntry;
+
+typedef struct _snapshot {	/* A snapshot file mapped in memory */
+  char *pszFile;		    /* The snapshot file pathname, as given */
+  void *pMap;
+  size_t lMap;
+  const dcsHeader *pHdr;
+  const dcsDir *pDirs;
+  const dcsEntry *pEntries;
+  const char *pStrings;
+} snapshot;
+
+typedef struct _snapWriter {	/* A snapshot being recorded */
+  t_opts opts;			    /* User-defined options */
+  int attrib;			    /* Search attributes. See lis() */
+  dcsDir *pDirs;
+  uint64_t nDirs;
+  uint64_t nDirsAlloc;
+  dcsEntry *pEntries;
+  uint64_t nEntries;
+  uint64_t nEntriesAlloc;
+  char *pStrings;
+  uint64_t lStrings;
+  uint64_t lStringsAlloc;
+} snapWriter;
+#endif /* HAS_SNAPSHOT */
+
+#if HAS_INOTIFY
+/* A comparison kept up to date with the inotify events on both trees */
+
+#define WATCH_EVENTS (IN_ATTRIB | IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MODIFY \
+		      | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR | IN_DONT_FOLLOW)
+
+typedef struct _diffEntry {	/* An entry of the watched trees */
+  HASH_ENTRY_FIELDS();
+  char *path;			    /* Pathname relative to the roots */
+  int difference;		    /* The last CompareFifs() result, or MISMATCH */
+} diffEntry;
+
+typedef struct _diffTable {
+  HASH_TABLE_FIELDS(struct _diffEntry);
+} diffTable;
+
+HASH_DEFINE_TYPES(diffTable, diffEntry);
+
+typedef struct _watchChange {	/* An entry whose status changed */
+  char *path;			    /* Pathname relative to the roots */
+  fif fifs[2];			    /* Its left and right stat data */
+  fifPair pair;			    /* Pointers to these if present, and their difference */
+} watchChange;
+
+typedef struct _watchState {	/* Both trees being watched */
+  int iFd;			    /* The inotify instance */
+  char *roots[2];		    /* The left and right root directories */
+  size_t lRoots[2];		    /* The length of their names */
+  char **ppszWdDirs;		    /* Relative pathname of each watch descriptor dir. */
+  int nWdDirs;			    /* Size of that array */
+  diffTable *pDiffs;		    /* The entries that differ */
+  diffTable *pPending;		    /* The entries touched since the last report */
+  FNMPATTERN fnmPattern;	    /* The compiled wildcards pattern */
+  int attrib;			    /* Search attributes. See lis() */
+  time_t datemin;		    /* Minimal date */
+  time_t datemax;		    /* Maximal date */
+  t_opts opts;			    /* User-defined options */
+  int iDelay;			    /* Number of seconds to gather events before reporting */
+  int bFull;			    /* TRUE if the inotify watches limit was reached */
+} watchState;
+#endif /* HAS_INOTIFY */
+
 /* Global variables */
 
 #if HAS_DRIVES
@@ -526,10 +851,23 @@ char init_drive;                    /* Initial drive */
 #endif
 char init_dir[PATHNAME_SIZE];       /* Initial directory */
 int iPause = 0;			    /* If > 0, number of lines between pauses */
+#if HAS_THREADS
+int nJobs = 0;			    /* Number of files compared in parallel. 0=1/CPU */
+#endif
+#if HAS_CACHE
+digestCache *pDigestCache = NULL;   /* Files contents digests. NULL=Don't use any */
+#endif
+#if HAS_SNAPSHOT
+snapshot *pSnapshot = NULL;	    /* Snapshot listed in the left column, or NULL */
+#endif
+#if HAS_INOTIFY
+watchState *pWatch = NULL;	    /* Trees to watch after comparing them, or NULL */
+#endif
 char path1[PATHNAME_SIZE] = {0};    /* First path scanned */
 char path2[PATHNAME_SIZE] = {0};    /* Second path scanned */
-fif *firstfif = NULL;		    /* Pointer to the first allocated fif structure */
+ARENA nameArena[2] = {{0}};	    /* Where the left and right names are allocated */
 long lNFileFound = 0;		    /* Total number of distinct files found */
+long lNTreesPruned = 0;		    /* Number of identical subtrees skipped */
 long lLFileFound = 0;		    /* Total number of left files found */
 long lRFileFound = 0;		    /* Total number of right files found */
 long lEFileFound = 0;		    /* Total number of equal files found */
@@ -552,23 +890,75 @@ PSTATFUNC pStat = lstat;	    /* Function to use for getting file infos */
 void usage(void);                   /* Display a brief help and exit */
 void finis(int retcode, ...);       /* Return to the initial drive & exit */
 int IsSwitch(char *pszArg);	    /* Is this a command-line switch? */
-
-int lis(char *, char *, int, int, int, time_t, time_t, t_opts); /* Scan a directory */
+int isBackupFile(const char *pszName);    /* Is this a backup file name? */
+
+int ResolveDir(char *, char *, char *, char *, t_opts); /* Get a dir. abs. path */
+int lis(char *, char *, int, int, time_t, time_t, t_opts, fifList *); /* Scan a directory */
+int lisArena(char *, char *, ARENA *, int, time_t, time_t, t_opts, fifList *); /* Idem */
+void *ScanJob(void *pJob);	    /* Run lis() with a scanJob's arguments */
+void ListDirs(char *dir1, char *dir2, char *pattern, int attrib,
+	      time_t datemin, time_t datemax, t_opts opts, fifList *pLists);
+char *FoldName(ARENA *pArena, char *pszName); /* Get a name sort key */
+keyprefix_t KeyPrefix(const char *pszKey); /* Get a sort key integer prefix */
 int CDECL cmpfif(const fif **fif1, const fif **fif2, int ignorecase);
 void trie(fif **ppfif, int nfif, t_opts);
-int affiche(fif **, int, int, t_opts); /* Display sorted list on two columns */
+int MergeNext(fifList *pLists, fif **ppfif1, fif **ppfif2, t_opts opts);
+void ComparePairs(fifPair *, int, t_opts); /* Compare the paired files */
+int affiche(fifList *, int, t_opts); /* Display sorted lists on two columns */
+int affichePairs(fifPair *, int, int, int *, t_opts); /* Display compared pairs */
 void affichePaths(void);
 int affiche1(fif *pfif, int col, t_opts);
+void InitLinkReader(linkReader *pReader, char *path, ARENA *pArena);
+void ReadLinkTarget(linkReader *pReader, fif *pfif); /* Set pfif->target if it's a link */
+void FreeLinkReader(linkReader *pReader);
 int descend(char *from, char *to,
             char *pattern, int attrib,
             t_opts opts,
-	    time_t datemin, time_t datemax);
-fif **AllocFifArray(size_t nfif);   /* Allocate an array of fif pointers */
+	    time_t datemin, time_t datemax,
+	    dirNode **ppNodes);
+fif **AllocFifArray(fif *pfif, size_t nfif); /* Allocate an array of fif pointers */
 void FreeFifArray(fif **fiflist);
+void FreeFifLists(fifList *pLists); /* Free the arrays of both sides */
+void MarkNameArenas(ARENAMARK *pMarks);	   /* Mark both sides arenas */
+void ReleaseNameArenas(ARENAMARK *pMarks); /* Release both sides arenas */
 
 int makepathname(char *, char *, char *);
 int filecompare(char *, char *);    /* Compare two files */
-int CompareToNext(fif **, t_opts);  /* Compare dates w. next entry in fiflist */
+#if HAS_CACHE
+void DigestCacheLoad(digestCache *pCache); /* Map the previous cache file */
+int DigestCacheGet(digestCache *pCache, char *pszName,
+		   uint64_t *pDigest); /* Get a file digest, from the cache if possible */
+int DigestCacheSave(digestCache *pCache); /* Atomically replace the cache file */
+void DigestCacheFree(digestCache *pCache);
+void SaveDigestCache(t_opts opts);  /* Save and free the cache, if any */
+#endif
+#if HAS_SNAPSHOT
+int SnapshotSave(char *pszFile, char *dir, t_opts opts); /* Record a tree */
+int SnapshotLoad(snapshot *pSnap);  /* Map a snapshot in memory */
+void SnapshotFree(snapshot *pSnap);
+int SnapList(snapshot *pSnap, char *dir, char *pattern, int attrib, /* List a snapshot dir. */
+	     time_t datemin, time_t datemax, t_opts opts, fifList *pList);
+#endif
+int CompareFifs(fif *, fif *, t_opts); /* Compare a left and a right file */
+#if HAS_PRUNE
+int DigestTrees(char *dir1, char *dir2, char *pattern, int attrib,
+		time_t datemin, time_t datemax, t_opts opts, dirNode **ppRoots);
+dirNode *FindSubNode(dirNode *pNode, char *pszName, int *piNext);
+int SameLists(dirNode **ppNodes);   /* Are both directories lists identical? */
+int SameTrees(dirNode **ppNodes);   /* Are both subtrees identical? */
+void FreeDirNode(dirNode *pNode);
+#else
+#define FindSubNode(pNode, pszName, piNext) ((void)(piNext), (dirNode *)NULL)
+#define SameLists(ppNodes) FALSE
+#define SameTrees(ppNodes) FALSE
+#endif
+#if HAS_INOTIFY
+int WatchInit(watchState *pWatch, char *dir1, char *dir2, char *pattern, int attrib,
+	      time_t datemin, time_t datemax, t_opts opts); /* Prepare watching both trees */
+void WatchAddDir(watchState *pWatch, int side, char *pszDir); /* Watch a directory */
+void WatchRecordPairs(watchState *pWatch, fifPair *pPairs, int nPairs); /* Record the differences */
+void WatchLoop(watchState *pWatch); /* Report the changes. Does not return */
+#endif
 
 int GetScreenRows(void);	    /* Get the number of rows of a text screen */
 int GetScreenColumns(void);	    /* Get the number of columns of a text screen */
@@ -606,7 +996,6 @@ int main(int argc, char *argv[]) {
   t_opts opts = {0};	      /* User-defined options */
   NEW_PATHNAME_BUF(path);     /* Temporary pathname */
   int i;
-  int nfif = 0;
   /* File attributes to search, ie. all but disk labels. */
 #if defined(_UNIX)
   int attrib = (_A_SUBDIR | _A_SYSTEM | _A_HIDDEN | _A_LINK | _A_DEVICE);
@@ -616,12 +1005,25 @@ int main(int argc, char *argv[]) {
   int attrib = (_A_SUBDIR | _A_SYSTEM | _A_HIDDEN);
 #endif
   int nDirs = 1;		/* Number of columns to output (1 or 2) */
-  int iDir;			/* Current directory number (1 or 2) */
   time_t datemin = 0;		/* Minimum date stamp */
   time_t datemax = TIME_T_MAX;	/* Maximum date stamp */
   char *dateminarg = NULL;	/* Minimum date argument */
   char *datemaxarg = NULL;	/* Maximum date argument */
-  fif **fiflist;		/* Array of fif pointers for sorting */
+  fifList lists[2];		/* Sorted arrays of the left and right fifs */
+  ARENAMARK marks[2];		/* Arenas state before scanning the directories */
+  dirNode *roots[2] = {NULL, NULL}; /* Both trees digests with option -prune */
+  dirNode **ppRoots = NULL;	/* roots if they're valid, else NULL */
+#if HAS_CACHE
+  digestCache cache = {0};	/* Files contents digests */
+#endif
+#if HAS_SNAPSHOT
+  snapshot snap = {0};		/* Snapshot to compare with */
+  char *pszSaveSnapshot = NULL;	/* Snapshot to record */
+#endif
+#if HAS_INOTIFY
+  watchState watch = {0};	/* Both trees watched after the comparison */
+  int iWatchDelay = -1;		/* Seconds between reports. -1=Don't watch */
+#endif
   int iStats = FALSE;
 #ifdef _MSDOS
   char *pszOneToEnv = NULL;	/* Copy one file name to environment variable */
@@ -667,6 +1069,19 @@ int main(int argc, char *argv[]) {
 	opts.compare = 1;
 	continue;
       }
+#if HAS_CACHE
+      if (   streq(opt, "cache")    /* Reuse the digests of unchanged files */
+	  || streq(opt, "-cache")) {
+	if ((i+1) < argc) {
+	  cache.pszFile = argv[++i];
+	  pDigestCache = &cache;
+	  opts.compare = 1;
+	} else {
+	  fprintf(stderr, "Error: Missing cache file name: -cache\n");
+	}
+	continue;
+      }
+#endif
 #ifdef _WIN32
       if (streq(opt, "C")) {
 	opts.compression = 1;
@@ -737,6 +1152,15 @@ int main(int argc, char *argv[]) {
 	opts.notime = 1;	/* Ignore file date and time completely */
 	continue;
       }
+#if HAS_THREADS
+      if (   streq(opt, "jobs")	    /* Number of files to compare in parallel */
+	  || streq(opt, "-jobs")) {
+	if (((i+1) < argc) && !IsSwitch(argv[i+1]) && sscanf(argv[i+1], "%d", &nJobs)) {
+	  i += 1;		/* Skip the number in next argument */
+	}
+	continue;
+      }
+#endif
       if (streq(opt, "K")) {
 	opts.nocase = 1;	/* Ignore case completely in file names */
 	continue;
@@ -762,6 +1186,16 @@ int main(int argc, char *argv[]) {
 	iPause = GetScreenRows() - 1; /* Pause once per screen */
 	continue;
       }
+#if HAS_PRUNE
+      if (   streq(opt, "prune")    /* Skip identical subtrees */
+	  || streq(opt, "-prune")) {
+	opts.prune = 1;
+	opts.diff = 1;
+	opts.recurse = 1;
+	opts.zero = 1;
+	continue;
+      }
+#endif
       if (streq(opt, "r")) {	/* Alias for -d -f -s -z */
 	opts.diff = 1;
 	attrib &= ~_A_SUBDIR;   /* Clear the directory attribute */
@@ -769,6 +1203,17 @@ int main(int argc, char *argv[]) {
 	opts.zero = 1;
 	continue;
       }
+#if HAS_SNAPSHOT
+      if (   streq(opt, "save-snapshot") /* Record the tree in a file */
+	  || streq(opt, "-save-snapshot")) {
+	if ((i+1) < argc) {
+	  pszSaveSnapshot = argv[++i];
+	} else {
+	  fprintf(stderr, "Error: Missing snapshot file name: -save-snapshot\n");
+	}
+	continue;
+      }
+#endif
       if (streq(opt, "s")) {	/* Recursive search */
 	opts.recurse = 1;
 	continue;
@@ -811,6 +1256,18 @@ int main(int argc, char *argv[]) {
 	}
 	continue;
       }
+#if HAS_INOTIFY
+      if (   streq(opt, "watch")    /* Keep the comparison up to date */
+	  || streq(opt, "-watch")) {
+	iWatchDelay = 2;
+	if (   ((i+1) < argc) && argv[i+1][0]
+	    && (strspn(argv[i+1], "0123456789") == strlen(argv[i+1]))) {
+	  iWatchDelay = atoi(argv[++i]);
+	}
+	opts.recurse = 1;
+	continue;
+      }
+#endif
 #ifdef _WIN32
       if (streq(opt, "x")) {
 	attrib |= _A_SHORT;     /* Dummy attribute to force using short names */
@@ -926,23 +1383,108 @@ int main(int argc, char *argv[]) {
   if (to) FixNameCase(to);
 #endif // !defined(_UNIX)
 
-  nfif = lis(from, pattern, 0, iDir=1, attrib, datemin, datemax, opts);
-  if (to) nfif = lis(to, pattern, nfif, ++iDir, attrib, datemin, datemax, opts);
-  DEBUG_PRINTF(("nfif = %d;\n", nfif));
+  if (opts.nobak) isBackupFile(""); /* Compile the patterns before any thread uses them */
+#if HAS_THREADS
+  if (nJobs <= 0) nJobs = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+#if HAS_CACHE
+  /* Load the digests from the previous comparisons */
+  if (pDigestCache) DigestCacheLoad(pDigestCache);
+#endif
+
+#if HAS_SNAPSHOT
+  if (pszSaveSnapshot) {
+    if (SnapshotSave(pszSaveSnapshot, from, opts)) {
+      fprintf(stderr, "Error: Cannot save the snapshot %s. %s\n", pszSaveSnapshot, strerror(errno));
+      i = RETCODE_INACCESSIBLE;
+    } else {
+      i = RETCODE_SUCCESS;
+    }
+    SaveDigestCache(opts);
+    finis(i, NULL);
+  }
+  /* If the left path is a snapshot file, compare it like a directory */
+  snap.pszFile = from;
+  switch (SnapshotLoad(&snap)) {
+    case 0:
+      pSnapshot = &snap;
+      break;
+    case -1:
+      finis(RETCODE_INACCESSIBLE, "Invalid snapshot file %s", from);
+    default: /* Not a snapshot */
+      break;
+  }
+#endif
+
+#if HAS_INOTIFY
+  /* Watch both trees while comparing them, to report the changes afterwards */
+  if (iWatchDelay >= 0) {
+    if (   !to
+#if HAS_SNAPSHOT
+	|| pSnapshot		/* A snapshot does not change */
+#endif
+       ) {
+      finis(RETCODE_INACCESSIBLE, "Option -watch requires two directories");
+    }
+    opts.prune = 0;		/* All subtrees must be listed, to be watched */
+    watch.iDelay = iWatchDelay;
+    if (!WatchInit(&watch, from, to, pattern, attrib, datemin, datemax, opts)) {
+      finis(RETCODE_INACCESSIBLE, "Cannot watch %s and %s. %s", from, to, strerror(errno));
+    }
+    pWatch = &watch;
+  }
+#endif
+
+#if HAS_PRUNE
+  /* Digest both trees, to only list and compare the parts that differ */
+  if (   opts.prune && to
+#if HAS_SNAPSHOT
+      && !pSnapshot		/* The snapshot has no subtrees digests */
+#endif
+      && DigestTrees(from, to, pattern, attrib, datemin, datemax, opts, roots)) {
+    ppRoots = roots;
+  }
+#endif
+
+  lists[0].ppfif = lists[1].ppfif = NULL;
+  if (!SameLists(ppRoots)) {
+    MarkNameArenas(marks);
+    ListDirs(from, to, pattern, attrib, datemin, datemax, opts, lists);
+    DEBUG_PRINTF(("nfif = %d + %d;\n", lists[0].nfif, lists[1].nfif));
 
-  fiflist = AllocFifArray(nfif);
-  trie(fiflist, nfif, opts);
-  affiche(fiflist, nfif, iDir, opts);
-  FreeFifArray(fiflist);
+    affiche(lists, to ? 2 : 1, opts);
+    FreeFifLists(lists);
+    ReleaseNameArenas(marks);
+  }
 
   if (opts.recurse) {
-    descend(from, to, pattern, attrib, opts, datemin, datemax);
+    if (SameTrees(ppRoots)) {
+      lNTreesPruned += 1;
+    } else {
+      descend(from, to, pattern, attrib, opts, datemin, datemax, ppRoots);
+    }
     if (lNFileFound) { /* Only list the total if it's not null */
       printflf();
       printf("Total: %ld files or directories listed.", lNFileFound);
       printflf();
     }
   }
+#if HAS_PRUNE
+  if (ppRoots && opts.verbose) {
+    printflf();
+    printf("Skipped %ld identical subtrees.", lNTreesPruned);
+    printflf();
+  }
+  FreeDirNode(roots[0]);
+  FreeDirNode(roots[1]);
+#endif
+
+#if HAS_CACHE
+  SaveDigestCache(opts);
+#endif
+#if HAS_SNAPSHOT
+  if (pSnapshot) SnapshotFree(pSnapshot);
+#endif
 
 #ifdef _MSDOS
   /* Move the single line found to the given environment variable */
@@ -951,7 +1493,7 @@ int main(int argc, char *argv[]) {
       case 0:
 	finis(RETCODE_NO_FILE, NULL);
       case 1:
-	i = SetMasterEnv(pszOneToEnv, fiflist[0]->name);
+	i = SetMasterEnv(pszOneToEnv, lists[0].ppfif[0]->name);
 	if (i) printf("Out of environment space.\n");
 	finis(RETCODE_SUCCESS);
       default:
@@ -975,6 +1517,10 @@ int main(int argc, char *argv[]) {
     printflf();
   }
 
+#if HAS_INOTIFY
+  if (pWatch) WatchLoop(pWatch); /* Does not return */
+#endif
+
   finis(RETCODE_SUCCESS);
   return 0; // Satisfy the compiler.
 }
@@ -1009,7 +1555,12 @@ Usage:\n\
   dirc [SWITCHES] PATHNAME1 [PATHNAME2] [PATTERN]\n\
 \n\
 Pathname: directory_name[\\pattern]\n\
-  PATHNAME2 may be \"D:=\", meaning \"Same path as PATHNAME1 on drive D:\".\n\
+  PATHNAME2 may be \"D:=\", meaning \"Same path as PATHNAME1 on drive D:\".\n"
+#if HAS_SNAPSHOT
+"\
+  PATHNAME1 may be a snapshot file recorded with -save-snapshot.\n"
+#endif
+"\
 \n\
 Pattern: An optional global wildcards pattern. Default: " PATTERN_ALL "\n\
 If no pathname2 is entered, list only one directory, sorted.\n\
@@ -1028,6 +1579,12 @@ Switches:\n\
   -bd         Both.\n\
   -c          Compare the actual data of the files. May take a long time!\n\
   -ct         Compare data, and flag with a ~ equal files with different time.\n"
+#if HAS_CACHE
+"\
+  -cache FILE Compare data using the files digests recorded in FILE, then add\n\
+              the new ones. Implies -c. Files are read only if their size,\n\
+              mtime or ctime changed since their digest was recorded.\n"
+#endif
 #ifdef _WIN32
 "\
   -C          Report the compression ratio.\n"
@@ -1048,7 +1605,13 @@ Switches:\n\
 "\
   -f          List files only, but not subdirectories.\n\
   -i          Ignore integer number of hours differences, up to +/- 23 hours.\n\
-  -j          Ignore date/time completely.\n\
+  -j          Ignore date/time completely.\n"
+#if HAS_THREADS
+"\
+  -jobs N     Compare up to N files, or digest up to N directories with -prune,\n\
+              in parallel. Default: 1 per CPU\n"
+#endif
+"\
   -k          Consider case in file name comparisons." MATCHCASEDEFAULT "\n\
   -K          Ignore case in file name comparisons." IGNORECASEDEFAULT "\n\
   -L          Compare link targets, instead of the links themselves\n"
@@ -1057,9 +1620,22 @@ Switches:\n\
   -O          Force encoding the output using the OEM character set.\n"
 #endif
 "\
-  -p          Pause for each page displayed.\n\
+  -p          Pause for each page displayed.\n"
+#if HAS_PRUNE
+"\
+  -prune      Same as {-d -s -z}, but first digest both trees, then skip the\n\
+              subtrees with the same names, sizes, times (and contents with -c)\n\
+              With -c, this reads all files contents, unless -cache has them.\n"
+#endif
+"\
   -r          Same as {-d -f -s -z}\n\
-  -s          Compare matching subdirectories too.\n\
+  -s          Compare matching subdirectories too.\n"
+#if HAS_SNAPSHOT
+"\
+  -save-snapshot FILE  Record the PATHNAME1 tree names, types, sizes, times,\n\
+              (and contents digests with -c) in FILE, instead of listing it.\n"
+#endif
+"\
   -t	      Display statistics about total number of files, sizes, etc.\n\
   -u	      Convert all displayed names to upper case.\n"
 #ifdef _WIN32
@@ -1070,6 +1646,11 @@ Switches:\n\
   -v          Verbose mode\n\
   -V          Display this program version and exit.\n\
   -w COLS     Set the output width. Default: The display width.\n"
+#if HAS_INOTIFY
+"\
+  -watch [N]  Same as -s, then watch both trees, and every N seconds (Dflt: 2)\n\
+              report the entries whose status changed. Stop with Ctrl-C.\n"
+#endif
 #ifdef _WIN32
 "\
   -x          Display Short File Names.\n\
@@ -1163,76 +1744,71 @@ int IsSwitch(char *pszArg) {
 
 /******************************************************************************
 *                                                                             *
-*       Function:       lis                                                   *
+*       Function:       ResolveDir                                            *
 *                                                                             *
-*       Description:    Scan the directory, and fill the fif table            *
+*       Description:    Get the absolute pathname of a directory to scan      *
 *                                                                             *
 *       Arguments:                                                            *
 *                                                                             *
 *         char *startdir	Directory to scan. If "NUL", don't scan.      *
-*         char *pattern		Wildcard pattern.                             *
-*         int nfif		Number of files/directories found so far.     *
-*         int col		1 = left column; 2 = right column.            *
-*         int attrib		Bit 15: List directories exclusively.         *
-*                       	Bits 7-0: File/directory attribute.           *
-*         time_t datemin	Minimal date, or 0 if no minimum.             *
-*         time_t datemax	Maximal date, or 0 if no maximum.             *
+*         char *pattern		Wildcard pattern, or NULL for all files.      *
+*         char *pathbuf		Output buffer for the absolute pathname.      *
+*         char *pattern2	Output buffer for the pattern to use.         *
 *         t_opts opts		User-defined options.                         *
 *                                                                             *
-*       Return value:   Total number of files/directories in fif array.       *
+*       Return value:   TRUE if the directory can be scanned, else FALSE.     *
 *                                                                             *
-*       Notes:                                                                *
+*       Notes:          Changes the current directory temporarily, so this    *
+*                       must only be called by the main thread.               *
+*                       pathbuf must contain PATHNAME_SIZE bytes, and         *
+*                       pattern2 NODENAME_SIZE bytes.                         *
+*                       pathbuf is left unchanged if the result is FALSE.     *
 *                                                                             *
 *       Updates:                                                              *
+*        2026-10-17 MAB Split off lis(), so that lis() can run in threads.    *
 *                                                                             *
 ******************************************************************************/
 
 /* Check is a file name if a backup file name */
-int isBackupFile(char *pszName) {
+int isBackupFile(const char *pszName) {
   static char *patterns[] = {"*.bak", "*~", "#*#", NULL};
-  char **ppPattern;
-  for (ppPattern = patterns; *ppPattern; ppPattern++) {
-    if (fnmatch(*ppPattern, pszName, FNM_CASEFOLD) == 0) return TRUE; /* Match */
+  static FNMSET backupSet = {0};
+  if (!backupSet.nPatterns) { /* Compile the patterns the first time */
+    char **ppPattern;
+    for (ppPattern = patterns; *ppPattern; ppPattern++) {
+      if (FnmSetAdd(&backupSet, *ppPattern, FNM_CASEFOLD)) finis(RETCODE_NO_MEMORY, "Out of memory");
+    }
   }
-  return FALSE;
+  return (FnmSetMatch(&backupSet, pszName) == FNM_MATCH);
 }
 
-int lis(char *startdir, char *pattern, int nfif, int col, int attrib,
-	    time_t datemin, time_t datemax, t_opts opts) {
+int ResolveDir(char *startdir, char *pattern, char *pathbuf, char *pattern2,
+	       t_opts opts) {
 #if HAS_DRIVES
   char initdrive;                 /* Initial drive. Restored when done. */
 #endif
   NEW_PATHNAME_BUF(initdir);	    /* Initial directory. Restored when done. */
   NEW_PATHNAME_BUF(path);	    /* Temporary pathname */
-  NEW_PATHNAME_BUF(pathname);
   int err;
-  char pattern2[NODENAME_SIZE];
-  char *pname;
-  DIR *pDir;
-  struct dirent *pDirent;
   char *pcd;
 
-  DEBUG_ENTER(("lis(\"%s\", \"%s\", %d, %d, 0x%X, 0x%lX, 0x%lX, 0x%X);\n", startdir, pattern,
-	       nfif, col, attrib, (unsigned long)datemin, (unsigned long)datemax, opts));
+  DEBUG_ENTER(("ResolveDir(\"%s\", \"%s\", %p, %p, 0x%X);\n", startdir, pattern,
+	       pathbuf, pattern2, opts));
 
 #if PATHNAME_BUFS_IN_HEAP
   if ((!initdir) || (!path)) {
     FREE_PATHNAME_BUF(initdir);
     FREE_PATHNAME_BUF(path);
-    FREE_PATHNAME_BUF(pathname);
-    RETURN_INT_COMMENT(nfif, ("Out of memory\n"));
+    RETURN_INT_COMMENT(FALSE, ("Out of memory\n"));
   }
 #endif
 
   if (!stricmp(startdir, "nul")) {  /* Dummy name, used as place holder */
     FREE_PATHNAME_BUF(initdir);
     FREE_PATHNAME_BUF(path);
-    FREE_PATHNAME_BUF(pathname);
-    RETURN_INT_COMMENT(nfif, ("NUL\n"));
+    RETURN_INT_COMMENT(FALSE, ("NUL\n"));
   }
 
-  if (nfif == 0) firstfif = NULL; /* Make sure the linked list ends there */
-
   if (!pattern) pattern = PATTERN_ALL;
   strncpyz(pattern2, pattern, NODENAME_SIZE);
 
@@ -1300,8 +1876,7 @@ int lis(char *startdir, char *pattern, int nfif, int col, int attrib,
       if (opts.cont) {
 	FREE_PATHNAME_BUF(initdir);
 	FREE_PATHNAME_BUF(path);
-	FREE_PATHNAME_BUF(pathname);
-	RETURN_INT_COMMENT(nfif, ("Cannot access directory %s\n", path));
+	RETURN_INT_COMMENT(FALSE, ("Cannot access directory %s\n", path));
       }
       finis(RETCODE_INACCESSIBLE, NULL);
     }
@@ -1309,111 +1884,8 @@ int lis(char *startdir, char *pattern, int nfif, int col, int attrib,
 
   pcd = getcwd(path, PATHNAME_SIZE);
   if (!pcd) finis(RETCODE_INACCESSIBLE, "Cannot get the current directory");
+  strncpyz(pathbuf, path, PATHNAME_SIZE);
 
-  if (col == 1) {
-    strncpyz(path1, path, PATHNAME_SIZE);
-  } else {
-    strncpyz(path2, path, PATHNAME_SIZE);
-  }
-
-  /* start looking for all files */
-  pDir = opendirx(path);
-  if (pDir) {
-    while ((pDirent = readdirx(pDir)) != NULL) { /* readdirx() ensures d_type is set */
-      struct stat st;
-      DEBUG_CODE(
-	char *reason;
-	char szType[16];
-	sprintf(szType, "d_type=%u", (unsigned)(pDirent->d_type));
-      )
-
-      makepathname(pathname, path, pDirent->d_name);
-#if !_DIRENT2STAT_DEFINED
-      pStat(pathname, &st);
-#else
-      if (pStat == lstat) {
-	dirent2stat(pDirent, &st);
-      } else {
-	stat(pathname, &st);
-      }
-#endif
-      DEBUG_PRINTF(("// Found %10s %12s %lx\n",
-	    (pDirent->d_type == DT_DIR) ? "Directory" :
-	    (pDirent->d_type == DT_LNK) ? "Link" :
-	    (pDirent->d_type == DT_REG) ? "File" :
-	    szType,
-	    pDirent->d_name,
-	    (unsigned long)(st.st_mtime)));
-      DEBUG_CODE(reason = "it's .";)
-      if (    !streq(pDirent->d_name, ".")  /* skip . and .. */
-	      DEBUG_CODE(&& ((reason = "it's ..") != NULL))
-	   && !streq(pDirent->d_name, "..")
-	      DEBUG_CODE(&& ((reason = "it's not a directory") != NULL))
-	   && (   !(attrib & 0x8000)	  /* Skip files if dirs only */
-		|| (pDirent->d_type == DT_DIR))
-	      DEBUG_CODE(&& ((reason = "it's a directory") != NULL))
-	   && (   (attrib & _A_SUBDIR)	  /* Skip dirs if files only */
-		|| (pDirent->d_type != DT_DIR))
-	      DEBUG_CODE(&& ((reason = "the date is out of range") != NULL))
-	   && (st.st_mtime >= datemin) /* Skip files outside date range */
-	   && (st.st_mtime <= datemax)
-	      DEBUG_CODE(&& ((reason = "the pattern does not match") != NULL))
-	   && (fnmatch(pattern2, pDirent->d_name, FNM_CASEFOLD) == FNM_MATCH)
-	      DEBUG_CODE(&& ((reason = "it's a backup file") != NULL))
-	   && (!(opts.nobak && isBackupFile(pDirent->d_name)))
-	 ) {
-	fif *pfif;
-
-	DEBUG_PRINTF(("// OK\n"));
-	pfif = (fif *)malloc(sizeof(fif));
-	pname = strdup(pDirent->d_name);
-	if (!pfif || !pname) {
-	  closedirx(pDir);
-	  finis(RETCODE_NO_MEMORY, "Out of memory for directory access");
-	}
-	pfif->name = pname;
-	pfif->st = st;
-#if _MSVCLIBX_STAT_DEFINED
-	DEBUG_PRINTF(("st.st_Win32Attrs = 0x%08X\n", pfif->st.st_Win32Attrs));
-	DEBUG_PRINTF(("st.st_ReparseTag = 0x%08X\n", pfif->st.st_ReparseTag));
-#endif /* _MSVCLIBX_STAT_DEFINED */
-#if defined(S_ISLNK) && S_ISLNK(S_IFLNK) /* If the OS has links (For some OSs which don't, macros are defined, but always returns 0) */
-	pfif->target = NULL;
-	if (pDirent->d_type == DT_LNK) {
-	  char *pTarget = malloc(PATHNAME_SIZE);
-	  int lTarget;
-	  if (!pTarget) {
-	    closedirx(pDir);
-	    finis(RETCODE_NO_MEMORY, "Out of memory");
-	  }
-	  lTarget = (int)readlink(pathname, pTarget, PATHNAME_SIZE);
-	  if (lTarget != -1) {
-	    pTarget[lTarget] = '\0';
-	    pTarget = realloc(pTarget, lTarget+1);
-	    pfif->target = pTarget;
-	  } else {
-	    free(pTarget);
-	  }
-	}
-#endif
-#if defined(_WIN32)
-	if (opts.compression) {
-	  pfif->qwComprSize.LowPart = GetCompressedFileSize(pname, &(pfif->qwComprSize.HighPart));
-	  if ((pfif->qwComprSize.LowPart == INVALID_FILE_SIZE) && (GetLastError() != NO_ERROR)) pfif->qwComprSize.QuadPart = 0;
-	}
-#endif
-	// Note: The pointer to the name is copied as well.
-	pfif->column = col;
-	pfif->next = firstfif;
-	firstfif = pfif;
-	nfif += 1;
-      } else {
-	DEBUG_PRINTF(("// Ignored because %s\n", reason));
-      }
-    }
-
-    closedirx(pDir);
-  }
 #if !HAS_MSVCLIBX
   DEBUG_PRINTF(("chdir(\"%s\");\n", initdir));
 #endif
@@ -1429,76 +1901,503 @@ int lis(char *startdir, char *pattern, int nfif, int col, int attrib,
 
   FREE_PATHNAME_BUF(initdir);
   FREE_PATHNAME_BUF(path);
-  FREE_PATHNAME_BUF(pathname);
-  RETURN_INT(nfif);
+  RETURN_INT_COMMENT(TRUE, ("\"%s\" \"%s\"\n", pathbuf, pattern2));
 }
 
 /******************************************************************************
 *                                                                             *
-*       Function:       cmpfif                                                *
+*       Function:       lis, lisArena                                         *
 *                                                                             *
-*       Description:    Compare two files, for sorting the file list          *
+*       Description:    Scan the directory, and fill a sorted fif array       *
 *                                                                             *
 *       Arguments:                                                            *
 *                                                                             *
-*         fif **fif1    First file structure                                  *
-*         fif **fif2    Second file structure                                 *
+*         char *path		Absolute directory pathname, from ResolveDir. *
+*         char *pattern		Wildcard pattern.                             *
+*         int col		1 = left column; 2 = right column.            *
+*         ARENA *pArena		lisArena(): Where to allocate the names.      *
+*         int attrib		Bit 15: List directories exclusively.         *
+*                       	Bits 7-0: File/directory attribute.           *
+*         time_t datemin	Minimal date, or 0 if no minimum.             *
+*         time_t datemax	Maximal date, or 0 if no maximum.             *
+*         t_opts opts		User-defined options.                         *
+*         fifList *pList	Where to store the sorted fif array.          *
 *                                                                             *
-*       Return value:    0 : Equal                                            *
-*                       <0 : file1<file2                                      *
-*                       >0 : file1>file2                                      *
+*       Return value:   Number of files/directories in the fif array.         *
 *                                                                             *
-*       Notes:                                                                *
+*       Notes:          Does not change the current directory, and allocates  *
+*                       only in the column's own arena, so that the left and  *
+*                       right directories can be scanned in parallel threads. *
+*                       Other threads use lisArena() with their own arena.    *
+*                       Link targets are not read here. Use ReadLinkTarget()  *
+*                       for the links actually displayed or compared.         *
 *                                                                             *
 *       Updates:                                                              *
+*        2026-10-17 MAB Output a separate sorted array for each column.       *
+*                       Do not read the link targets.                         *
+*        2026-10-17 MAB In Unix, use readdirplus(), and show dangling links   *
+*                       as links with option -L.                              *
 *                                                                             *
 ******************************************************************************/
 
-int CDECL cmpfif(const fif **fif1, const fif **fif2, int ignorecase) {
-  int ret;
-  int bIsDir1, bIsDir2;
+int lis(char *path, char *pattern, int col, int attrib,
+	    time_t datemin, time_t datemax, t_opts opts, fifList *pList) {
+  /* Use this column's own arena */
+  return lisArena(path, pattern, &nameArena[col-1], attrib, datemin, datemax, opts, pList);
+}
 
-  /* List directories before files */
-#if _MSVCLIBX_STAT_DEFINED
-  bIsDir1 = (((*fif1)->st.st_Win32Attrs & FILE_ATTRIBUTE_DIRECTORY) == FILE_ATTRIBUTE_DIRECTORY);
-  bIsDir2 = (((*fif2)->st.st_Win32Attrs & FILE_ATTRIBUTE_DIRECTORY) == FILE_ATTRIBUTE_DIRECTORY);
+/* Apply the tests that only need the directory entry,
+   so that rejected entries cost no stat() at all */
+static int LisSelectName(FNMPATTERN *pPattern, const char *pszName, unsigned char type,
+			 int attrib, int bNoBak) {
+  DEBUG_CODE(
+    char *reason;
+    char szType[16];
+    sprintf(szType, "d_type=%u", (unsigned)type);
+  )
+
+  DEBUG_PRINTF(("// Found %10s %12s\n",
+	(type == DT_DIR) ? "Directory" :
+	(type == DT_LNK) ? "Link" :
+	(type == DT_REG) ? "File" :
+	szType,
+	pszName));
+  DEBUG_CODE(reason = "it's .";)
+  if (!(   !streq(pszName, ".")  /* skip . and .. */
+	  DEBUG_CODE(&& ((reason = "it's ..") != NULL))
+       && !streq(pszName, "..")
+	  DEBUG_CODE(&& ((reason = "it's not a directory") != NULL))
+       && (   !(attrib & 0x8000)	  /* Skip files if dirs only */
+	    || (type == DT_DIR))
+	  DEBUG_CODE(&& ((reason = "it's a directory") != NULL))
+       && (   (attrib & _A_SUBDIR)	  /* Skip dirs if files only */
+	    || (type != DT_DIR))
+	  DEBUG_CODE(&& ((reason = "the pattern does not match") != NULL))
+       && (FnmMatch(pPattern, pszName) == FNM_MATCH)
+	  DEBUG_CODE(&& ((reason = "it's a backup file") != NULL))
+       && (!(bNoBak && isBackupFile(pszName)))
+     )) {
+    DEBUG_PRINTF(("// Ignored because %s\n", reason));
+    return FALSE;
+  }
+  return TRUE;
+}
+
+/* Get a new fif at the end of the array, with its name. The caller sets its stat fields */
+static fif *LisNewFif(fif **ppFifs, int nfif, int *pnAlloc, ARENA *pArena, const char *pszName) {
+  fif *pfif;
+  char *pname;
+
+  DEBUG_PRINTF(("// OK\n"));
+  if (nfif == *pnAlloc) {
+    int nNew = *pnAlloc ? 2 * *pnAlloc : 64;
+    fif *pNew = (fif *)realloc(*ppFifs, nNew * sizeof(fif));
+    if (!pNew) finis(RETCODE_NO_MEMORY, "Out of memory for directory access");
+    *ppFifs = pNew;
+    *pnAlloc = nNew;
+  }
+  pfif = *ppFifs + nfif;
+  pname = ArenaStrdup(pArena, pszName);
+  if (pname) pfif->key = FoldName(pArena, pname);
+  if (!pname || !pfif->key) finis(RETCODE_NO_MEMORY, "Out of memory for directory access");
+  pfif->name = pname;
+  pfif->keyPrefix = KeyPrefix(pfif->key);
+#if defined(S_ISLNK) && S_ISLNK(S_IFLNK) /* If the OS has links (For some OSs which don't, macros are defined, but always returns 0) */
+  pfif->target = NULL;	/* Read later by ReadLinkTarget(), if needed */
+#endif
+#if HAS_SNAPSHOT
+  pfif->pDigest = NULL;
+#endif
+  return pfif;
+}
+
+#if defined(_UNIX)
+#define LIS_BATCH 256	/* Number of entries read per readdirplus() call */
+#endif
+
+int lisArena(char *path, char *pattern, ARENA *pArena, int attrib,
+	    time_t datemin, time_t datemax, t_opts opts, fifList *pList) {
+#if !defined(_UNIX)
+  NEW_PATHNAME_BUF(pathname);
+#endif
+  fif *pFifs = NULL;		    /* Array of the fifs found */
+  int nfif = 0;
+  int nAlloc = 0;		    /* Number of fifs allocated in that array */
+  FNMPATTERN fnmPattern;
+#if defined(_UNIX)
+  DIRPLUS *pDir;
+  direntplus aDE[LIS_BATCH];
+  int iFields = DXP_MODE | DXP_SIZE | DXP_MTIME;
+  int n;
 #else
-  bIsDir1 = S_ISDIR((*fif1)->st.st_mode);
-  bIsDir2 = S_ISDIR((*fif2)->st.st_mode);
+  DIR *pDir;
+  struct dirent *pDirent;
 #endif
-  ret = bIsDir2 - bIsDir1;
-  if (ret) return ret;
 
-  /* If both files, or both directories, sort case-independantly */
-  ret = strnicmp((*fif1)->name, (*fif2)->name, NODENAME_SIZE);
-  if (ret) return ret;
+  DEBUG_ENTER(("lisArena(\"%s\", \"%s\", %p, 0x%X, 0x%lX, 0x%lX, 0x%X, %p);\n", path, pattern,
+	       pArena, attrib, (unsigned long)datemin, (unsigned long)datemax, opts, pList));
 
-  /* If same name except for the case, sort upper case first */
-  if (!ignorecase) {  /* But do it only if requested */
-    ret = strncmp((*fif1)->name, (*fif2)->name, NODENAME_SIZE);
-    if (ret) return ret;
+  pList->pFifs = NULL;
+  pList->ppfif = NULL;
+  pList->nfif = 0;
+  pList->iNext = 0;
+
+#if PATHNAME_BUFS_IN_HEAP && !defined(_UNIX)
+  if (!pathname) {
+    RETURN_INT_COMMENT(0, ("Out of memory\n"));
   }
+#endif
 
-  /* If same names, list column 1 before column 2 */
-  return (*fif1)->column - (*fif2)->column;
-}
+  /* start looking for all files */
+  if (FnmCompile(&fnmPattern, pattern, FNM_CASEFOLD)) finis(RETCODE_NO_MEMORY, "Out of memory");
+#if defined(_UNIX)
+  /* Read the names and types in batches, test them, then get the stat data
+     of the selected entries only. The directory is searched only once */
+  if (pStat == stat) iFields |= DXP_FOLLOW;
+  pDir = opendirplus(path);
+  if (pDir) {
+    while ((n = readdirplus(pDir, aDE, LIS_BATCH, DXP_TYPE)) > 0) {
+      int i, nSel;
 
-int CDECL cmpfifCase(const fif **fif1, const fif **fif2) {
-  return cmpfif(fif1, fif2, FALSE);
-}
+      for (i = nSel = 0; i < n; i++) {
+	if (LisSelectName(&fnmPattern, aDE[i].d_name, aDE[i].d_type, attrib, opts.nobak)) {
+	  aDE[nSel++] = aDE[i];
+	}
+      }
+      statdirplusf(pDir, aDE, nSel, iFields, NULL);
 
-int CDECL cmpfifNoCase(const fif **fif1, const fif **fif2) {
-  return cmpfif(fif1, fif2, TRUE);
-}
+      for (i = 0; i < nSel; i++) {
+	direntplus *pDE = aDE + i;
+	fif *pfif;
 
-typedef int (* CDECL CMPFUNC)(const void *p1, const void *p2); // Strict type for C++
+	if (pDE->dx_errno && (iFields & DXP_FOLLOW)) { /* Dangling link. Show the link itself */
+	  pDE->dx_errno = 0;
+	  statdirplusf(pDir, pDE, 1, iFields & ~DXP_FOLLOW, NULL);
+	}
+	if (pDE->dx_errno) { /* Deleted since it was read, for example */
+	  DEBUG_PRINTF(("// Ignored because stat failed. %s\n", strerror(pDE->dx_errno)));
+	  continue;
+	}
+	if (   (pDE->dx_mtime.tv_sec < datemin) /* Skip files outside date range */
+	    || (pDE->dx_mtime.tv_sec > datemax)) {
+	  DEBUG_PRINTF(("// Ignored because the date %lx is out of range\n", (unsigned long)(pDE->dx_mtime.tv_sec)));
+	  continue;
+	}
 
-void trie(fif **ppfif, int nfif, t_opts opts) {
-  if (opts.nocase) {
-    qsort(ppfif, nfif, sizeof(fif *), (CMPFUNC)cmpfifNoCase);
-  } else {
-    qsort(ppfif, nfif, sizeof(fif *), (CMPFUNC)cmpfifCase);
+	/* OK, all criteria pass */
+	pfif = LisNewFif(&pFifs, nfif, &nAlloc, pArena, pDE->d_name);
+	pfif->size = pDE->dx_size;
+	pfif->mtime = pDE->dx_mtime.tv_sec;
+	pfif->mode = pDE->dx_mode;
+	nfif += 1;
+      }
+    }
+
+    closedirplus(pDir);
   }
+#else /* !defined(_UNIX) */
+  pDir = opendirx(path);
+  if (pDir) {
+    while ((pDirent = readdirx(pDir)) != NULL) { /* readdirx() ensures d_type is set */
+      struct stat st;
+      fif *pfif;
+
+      if (!LisSelectName(&fnmPattern, pDirent->d_name, pDirent->d_type, attrib, opts.nobak)) {
+	continue;
+      }
+
+      /* Then get the stat data, and apply the tests that need it */
+      makepathname(pathname, path, pDirent->d_name);
+#if !_DIRENT2STAT_DEFINED
+      pStat(pathname, &st);
+#else
+      if (pStat == lstat) {
+	dirent2stat(pDirent, &st);
+      } else {
+	stat(pathname, &st);
+      }
+#endif
+      if (   (st.st_mtime < datemin) /* Skip files outside date range */
+	  || (st.st_mtime > datemax)) {
+	DEBUG_PRINTF(("// Ignored because the date %lx is out of range\n", (unsigned long)(st.st_mtime)));
+	continue;
+      }
+
+      /* OK, all criteria pass */
+      pfif = LisNewFif(&pFifs, nfif, &nAlloc, pArena, pDirent->d_name);
+      pfif->size = st.st_size;
+      pfif->mtime = st.st_mtime;
+      pfif->mode = st.st_mode;
+#if _MSVCLIBX_STAT_DEFINED
+      pfif->win32Attrs = st.st_Win32Attrs;
+      pfif->reparseTag = st.st_ReparseTag;
+      DEBUG_PRINTF(("st.st_Win32Attrs = 0x%08X\n", pfif->win32Attrs));
+      DEBUG_PRINTF(("st.st_ReparseTag = 0x%08X\n", pfif->reparseTag));
+#endif /* _MSVCLIBX_STAT_DEFINED */
+#if defined(_WIN32)
+      if (opts.compression) {
+	pfif->qwComprSize.LowPart = GetCompressedFileSize(pathname, &(pfif->qwComprSize.HighPart));
+	if ((pfif->qwComprSize.LowPart == INVALID_FILE_SIZE) && (GetLastError() != NO_ERROR)) pfif->qwComprSize.QuadPart = 0;
+      }
+#endif
+      nfif += 1;
+    }
+
+    closedirx(pDir);
+  }
+#endif /* defined(_UNIX) */
+  FnmFree(&fnmPattern);
+
+  pList->pFifs = pFifs;
+  pList->ppfif = AllocFifArray(pFifs, nfif);
+  pList->nfif = nfif;
+  trie(pList->ppfif, nfif, opts);
+
+#if !defined(_UNIX)
+  FREE_PATHNAME_BUF(pathname);
+#endif
+  RETURN_INT(nfif);
+}
+
+/******************************************************************************
+*                                                                             *
+*       Function:       ListDirs                                              *
+*                                                                             *
+*       Description:    Scan the left and right directories                   *
+*                                                                             *
+*       Arguments:                                                            *
+*                                                                             *
+*         char *dir1		Left directory, or NULL if none.              *
+*         char *dir2		Right directory, or NULL if none.             *
+*         char *pattern		Wildcard pattern.                             *
+*         int attrib		Search attributes. See lis().                 *
+*         time_t datemin	Minimal date, or 0 if no minimum.             *
+*         time_t datemax	Maximal date, or 0 if no maximum.             *
+*         t_opts opts		User-defined options.                         *
+*         fifList *pLists	Where to store the left and right arrays.     *
+*                                                                             *
+*       Return value:   None                                                  *
+*                                                                             *
+*       Notes:          Sets path1 and path2 for the directories scanned.     *
+*                       When there are two directories, the right one is      *
+*                       scanned in a second thread, while the main thread     *
+*                       scans the left one.                                   *
+*                       If the left side is a snapshot, it's listed from its  *
+*                       mapping instead.                                      *
+*                       With -watch, the directories are watched before being *
+*                       scanned, so that no change is missed.                 *
+*                                                                             *
+*       Updates:                                                              *
+*        2026-10-17 MAB Initial implementation.                               *
+*                                                                             *
+******************************************************************************/
+
+void *ScanJob(void *pArg) {
+  scanJob *pJob = (scanJob *)pArg;
+  lis(pJob->path, pJob->pattern, pJob->col, pJob->attrib,
+      pJob->datemin, pJob->datemax, pJob->opts, pJob->pList);
+  return NULL;
+}
+
+void ListDirs(char *dir1, char *dir2, char *pattern, int attrib,
+	      time_t datemin, time_t datemax, t_opts opts, fifList *pLists) {
+  char *dirs[2];
+  char *paths[2];
+  char patterns[2][NODENAME_SIZE];
+  scanJob jobs[2];
+  int i;
+
+  DEBUG_ENTER(("ListDirs(\"%s\", \"%s\", \"%s\", 0x%X, 0x%lX, 0x%lX, 0x%X, %p);\n",
+	       dir1 ? dir1 : "", dir2 ? dir2 : "", pattern, attrib,
+	       (unsigned long)datemin, (unsigned long)datemax, opts, pLists));
+
+  dirs[0] = dir1;
+  dirs[1] = dir2;
+  paths[0] = path1;
+  paths[1] = path2;
+  for (i=0; i<2; i++) {
+    pLists[i].pFifs = NULL;
+    pLists[i].ppfif = NULL;
+    pLists[i].nfif = 0;
+    pLists[i].iNext = 0;
+    jobs[i].pList = NULL;
+#if HAS_SNAPSHOT
+    if (!i && dirs[0] && pSnapshot) { /* The left side is a snapshot */
+      SnapList(pSnapshot, dirs[0], pattern, attrib, datemin, datemax, opts, pLists);
+      continue;
+    }
+#endif
+    /* Resolve the paths sequentially, as this changes the current directory */
+    if (dirs[i] && ResolveDir(dirs[i], pattern, paths[i], patterns[i], opts)) {
+#if HAS_INOTIFY
+      if (pWatch) WatchAddDir(pWatch, i, paths[i]);
+#endif
+      jobs[i].path = paths[i];
+      jobs[i].pattern = patterns[i];
+      jobs[i].col = i+1;
+      jobs[i].attrib = attrib;
+      jobs[i].datemin = datemin;
+      jobs[i].datemax = datemax;
+      jobs[i].opts = opts;
+      jobs[i].pList = pLists+i;
+    }
+  }
+
+#if HAS_THREADS
+  if (jobs[0].pList && jobs[1].pList) {
+    pthread_t tid;
+    if (!pthread_create(&tid, NULL, ScanJob, jobs+1)) {
+      ScanJob(jobs);
+      pthread_join(tid, NULL);
+      RETURN();
+    } /* Else scan them sequentially below */
+  }
+#endif /* HAS_THREADS */
+
+  for (i=0; i<2; i++) if (jobs[i].pList) ScanJob(jobs+i);
+  RETURN();
+}
+
+/******************************************************************************
+*                                                                             *
+*       Function:       cmpfif                                                *
+*                                                                             *
+*       Description:    Compare two files, for sorting the file list          *
+*                                                                             *
+*       Arguments:                                                            *
+*                                                                             *
+*         fif **fif1    First file structure                                  *
+*         fif **fif2    Second file structure                                 *
+*                                                                             *
+*       Return value:    0 : Equal                                            *
+*                       <0 : file1<file2                                      *
+*                       >0 : file1>file2                                      *
+*                                                                             *
+*       Notes:          Used both for sorting each column, and for pairing    *
+*                       the left and right files. Equal means same file.      *
+*                                                                             *
+*       Updates:                                                              *
+*        2026-10-17 MAB Compare the precomputed lower case keys.              *
+*                       Do not compare columns, which are now sorted apart.   *
+*                       Compare the key prefixes first.                       *
+*                                                                             *
+******************************************************************************/
+
+/* Get the sort key for a name: The name itself if it has no upper case
+   letter, else a lower case copy in the arena. NULL=Out of memory. */
+char *FoldName(ARENA *pArena, char *pszName) {
+  char *pc;
+  char *pszKey;
+
+  for (pc = pszName; *pc; pc++) if (isupper((unsigned char)*pc)) break;
+  if (!*pc) return pszName;	/* The common case in Unix */
+
+  pszKey = ArenaStrdup(pArena, pszName);
+  if (!pszKey) return NULL;
+  for (pc = pszKey + (pc - pszName); *pc; pc++) *pc = (char)tolower((unsigned char)*pc);
+  return pszKey;
+}
+
+/* Pack the first bytes of a key into an integer, that sorts like the key */
+keyprefix_t KeyPrefix(const char *pszKey) {
+  keyprefix_t prefix = 0;
+  int i;
+
+  for (i = 0; i < (int)sizeof(keyprefix_t); i++) {
+    prefix <<= 8;
+    if (*pszKey) prefix |= (unsigned char)*(pszKey++);
+  }
+  return prefix;
+}
+
+int CDECL cmpfif(const fif **fif1, const fif **fif2, int ignorecase) {
+  int ret;
+  int bIsDir1, bIsDir2;
+
+  /* List directories before files */
+#if _MSVCLIBX_STAT_DEFINED
+  bIsDir1 = (((*fif1)->win32Attrs & FILE_ATTRIBUTE_DIRECTORY) == FILE_ATTRIBUTE_DIRECTORY);
+  bIsDir2 = (((*fif2)->win32Attrs & FILE_ATTRIBUTE_DIRECTORY) == FILE_ATTRIBUTE_DIRECTORY);
+#else
+  bIsDir1 = S_ISDIR((*fif1)->mode);
+  bIsDir2 = S_ISDIR((*fif2)->mode);
+#endif
+  ret = bIsDir2 - bIsDir1;
+  if (ret) return ret;
+
+  /* If both files, or both directories, sort case-independantly */
+  if ((*fif1)->keyPrefix != (*fif2)->keyPrefix) { /* Avoids reading the keys */
+    return ((*fif1)->keyPrefix < (*fif2)->keyPrefix) ? -1 : 1;
+  }
+  ret = strcmp((*fif1)->key, (*fif2)->key);
+  if (ret) return ret;
+
+  /* If same name except for the case, sort upper case first */
+  if (!ignorecase) {  /* But do it only if requested */
+    ret = strcmp((*fif1)->name, (*fif2)->name);
+  }
+
+  return ret;
+}
+
+int CDECL cmpfifCase(const fif **fif1, const fif **fif2) {
+  return cmpfif(fif1, fif2, FALSE);
+}
+
+int CDECL cmpfifNoCase(const fif **fif1, const fif **fif2) {
+  return cmpfif(fif1, fif2, TRUE);
+}
+
+typedef int (* CDECL CMPFUNC)(const void *p1, const void *p2); // Strict type for C++
+
+void trie(fif **ppfif, int nfif, t_opts opts) {
+  if (opts.nocase) {
+    qsort(ppfif, nfif, sizeof(fif *), (CMPFUNC)cmpfifNoCase);
+  } else {
+    qsort(ppfif, nfif, sizeof(fif *), (CMPFUNC)cmpfifCase);
+  }
+}
+
+/******************************************************************************
+*                                                                             *
+*       Function:       MergeNext                                             *
+*                                                                             *
+*       Description:    Get the next entry from the two sorted columns        *
+*                                                                             *
+*       Arguments:                                                            *
+*                                                                             *
+*         fifList *pLists	The left and right sorted arrays              *
+*         fif **ppfif1		Where to store the left file, or NULL         *
+*         fif **ppfif2		Where to store the right file, or NULL        *
+*         t_opts opts		User-defined options                          *
+*                                                                             *
+*       Return value:   TRUE if an entry was found, FALSE if both are done.   *
+*                                                                             *
+*       Notes:          A linear merge-join: Returns both files if they have  *
+*                       the same name, else the one that sorts first alone.   *
+*                                                                             *
+*       Updates:                                                              *
+*        2026-10-17 MAB Initial implementation.                               *
+*                                                                             *
+******************************************************************************/
+
+int MergeNext(fifList *pLists, fif **ppfif1, fif **ppfif2, t_opts opts) {
+  fifList *pList1 = pLists;
+  fifList *pList2 = pLists+1;
+  fif *pfif1 = (pList1->iNext < pList1->nfif) ? pList1->ppfif[pList1->iNext] : NULL;
+  fif *pfif2 = (pList2->iNext < pList2->nfif) ? pList2->ppfif[pList2->iNext] : NULL;
+
+  if (pfif1 && pfif2) {
+    int dif = cmpfif((const fif **)&pfif1, (const fif **)&pfif2, opts.nocase);
+    if (dif < 0) pfif2 = NULL;
+    if (dif > 0) pfif1 = NULL;
+  }
+  if (pfif1) pList1->iNext += 1;
+  if (pfif2) pList2->iNext += 1;
+
+  *ppfif1 = pfif1;
+  *ppfif2 = pfif2;
+  return (pfif1 || pfif2);
 }
 
 /******************************************************************************
@@ -1509,8 +2408,7 @@ void trie(fif **ppfif, int nfif, t_opts opts) {
 *                                                                             *
 *       Arguments:                                                            *
 *                                                                             *
-*         fif **ppfif   Sorted array of file info structure pointers          *
-*         int nfif      Number of files found (Total of both sides)           *
+*         fifList *pLists  Left and right sorted arrays of fif pointers       *
 *         int ndirs     Number of directories  1 or 2                         *
 *         t_opts opts	User-defined options		                      *
 *                                                                             *
@@ -1519,70 +2417,116 @@ void trie(fif **ppfif, int nfif, t_opts opts) {
 *       Notes:                                                                *
 *                                                                             *
 *       Updates:                                                              *
+*        2026-10-17 MAB Walk the two columns with MergeNext().                *
+*                       Compare all pairs first, possibly in parallel.        *
+*                       Read the targets of the links displayed.              *
+*                       Moved the display loop to affichePairs().             *
 *                                                                             *
 ******************************************************************************/
 
-int affiche(fif **ppfif, int nfif, int ndirs, t_opts opts) {
-  int i;
-  int col = 1;                      /* Current column */
-  int difference;
-  int nfiles = 0;
+int affiche(fifList *pLists, int ndirs, t_opts opts) {
+  fifPair *pPairs;
+  int nPairs;
+  int nfiles;
   int paths_done = FALSE;
 
   DEBUG_ENTER(("affiche(...);\n"));
 
-  for (i=0; i<nfif; i++) {
-    difference = CompareToNext(ppfif+i, opts); /* Compare ith file date with (i+1)th */
+  pPairs = (fifPair *)malloc((pLists[0].nfif + pLists[1].nfif + 1) * sizeof(fifPair));
+  if (!pPairs) finis(RETCODE_NO_MEMORY, "Out of memory for fif pairs");
+  for (nPairs=0; MergeNext(pLists, &pPairs[nPairs].pfif1, &pPairs[nPairs].pfif2, opts); nPairs++) ;
+  ComparePairs(pPairs, nPairs, opts);
+#if HAS_INOTIFY
+  if (pWatch) WatchRecordPairs(pWatch, pPairs, nPairs);
+#endif
+  nfiles = affichePairs(pPairs, nPairs, ndirs, &paths_done, opts);
+  free(pPairs);
+
+  if (opts.zero && !nfiles) RETURN_CONST(0);
+
+  if (!paths_done) affichePaths();
+  printflf();
+  printf("%d files or directories listed.", nfiles);
+  printflf();
+  lNFileFound += nfiles;
+
+  RETURN_CONST(0);
+}
+
+/******************************************************************************
+*                                                                             *
+*       Function:       affichePairs                                          *
+*                                                                             *
+*       Description:    Display the compared pairs selected by the options    *
+*                                                                             *
+*       Arguments:                                                            *
+*                                                                             *
+*         fifPair *pPairs	The compared pairs, in display order          *
+*         int nPairs		Number of pairs                               *
+*         int ndirs		Number of directories  1 or 2                 *
+*         int *pPathsDone	In/Out: TRUE if the paths have been displayed *
+*         t_opts opts		User-defined options                          *
+*                                                                             *
+*       Return value:   The number of files displayed                         *
+*                                                                             *
+*       Notes:          The paths in path1 and path2 are displayed before the *
+*                       first file, unless *pPathsDone is already TRUE.       *
+*                                                                             *
+*       Updates:                                                              *
+*        2026-10-17 MAB Split off affiche().                                  *
+*                                                                             *
+******************************************************************************/
+
+int affichePairs(fifPair *pPairs, int nPairs, int ndirs, int *pPathsDone, t_opts opts) {
+  int iPair;
+  fif *pfif1;
+  fif *pfif2;
+  int difference;
+  int nfiles = 0;
+  linkReader readers[2];	/* Read the link targets on demand */
+
+  InitLinkReader(readers, path1, nameArena);
+  InitLinkReader(readers+1, path2, nameArena+1);
+
+  for (iPair=0; iPair<nPairs; iPair++) {
+    pfif1 = pPairs[iPair].pfif1;
+    pfif2 = pPairs[iPair].pfif2;
+    difference = pPairs[iPair].difference;
 
     if (opts.diff && (difference == 0)) {
-      i += 1;
       continue;                   /* skip both if files match */
     }
 
-    if (opts.both && (col == 1) && (difference == MISMATCH)) {
+    if (opts.both && (difference == MISMATCH)) {
       continue;                    /* If both and no matching file, skip */
     }
 
     /* Ready to display the first file */
 
-    if (!paths_done) {             /* But diplay the paths names first */
+    if (!*pPathsDone) {            /* But diplay the paths names first */
       affichePaths();
-      paths_done = TRUE;
-    }
-
-    if ((col == 1) && (ppfif[i]->column == 2)) {
-      if (opts.both) continue; /* If both and no matching file, skip */
-      affiche1(NULL, 1, opts);
-      printf(" < ");
-      col = 2;
+      *pPathsDone = TRUE;
     }
 
-    affiche1(ppfif[i], col, opts); /* Display file characteristics */
-
-    /* Compute statistics about files displayed */
+    if (pfif1) {
+      ReadLinkTarget(readers, pfif1);
+      affiche1(pfif1, 1, opts); /* Display file characteristics */
 
-    if (col == 1) {
+      /* Compute statistics about files displayed */
       lLFileFound += 1;
-      llLTotalSize += ppfif[i]->st.st_size;
+      llLTotalSize += pfif1->size;
       if (!difference) {
 	lEFileFound += 1;
-	llETotalSize += ppfif[i]->st.st_size;
+	llETotalSize += pfif1->size;
       }
-    } else {
-      lRFileFound += 1;
-      llRTotalSize += ppfif[i]->st.st_size;
-    }
 
-    /* Display the comparison results */
-
-    if (ndirs == 1) {	       /* If one directory, go to next line */
-      nfiles += 1;
-      printflf();
-      continue;
-    }
+      if (ndirs == 1) {	       /* If one directory, go to next line */
+	nfiles += 1;
+	printflf();
+	continue;
+      }
 
-    if (col == 1) {
-      col = 2;
+      /* Display the comparison results */
       switch (difference) {
 	case 0:
 	  printf(" = ");
@@ -1600,36 +2544,126 @@ int affiche(fif **ppfif, int nfif, int ndirs, t_opts opts) {
 	  nfiles += 1;
 	  printf(" >");
 	  printflf();
-	  col = 1;
-	  break;
+	  continue;
 	default:
 	  nfiles += 1;
 	  printf(" ?!?");
 	  printflf();
-	  col = 1;
+	  affiche1(NULL, 1, opts);
+	  printf(" < ");
 	  break;
       }
     } else {
-      nfiles += 1;
-      printflf();
-      col = 1;
+      affiche1(NULL, 1, opts);
+      printf(" < ");
     }
-  }
 
-  if (col == 2) {
+    ReadLinkTarget(readers+1, pfif2);
+    affiche1(pfif2, 2, opts);
+    lRFileFound += 1;
+    llRTotalSize += pfif2->size;
     nfiles += 1;
     printflf();
   }
+  FreeLinkReader(readers);
+  FreeLinkReader(readers+1);
 
-  if (opts.zero && !nfiles) RETURN_CONST(0);
+  return nfiles;
+}
 
-  if (!paths_done) affichePaths();
-  printflf();
-  printf("%d files or directories listed.", nfiles);
-  printflf();
-  lNFileFound += nfiles;
+/******************************************************************************
+*                                                                             *
+*       Function:       ComparePairs                                          *
+*                                                                             *
+*       Description:    Compare all the left and right files paired           *
+*                                                                             *
+*       Arguments:                                                            *
+*                                                                             *
+*         fifPair *pPairs	The pairs, in display order                   *
+*         int nPairs		Number of pairs                               *
+*         t_opts opts		User-defined options                          *
+*                                                                             *
+*       Return value:   None. The results are in each pair's difference.      *
+*                                                                             *
+*       Notes:          With option -c, up to nJobs threads compare the       *
+*                       contents of the files that have the same size.        *
+*                       The report order does not depend on which finishes    *
+*                       first, as affiche() displays the pairs afterwards.    *
+*                                                                             *
+*       Updates:                                                              *
+*        2026-10-17 MAB Initial implementation.                               *
+*                                                                             *
+******************************************************************************/
 
-  RETURN_CONST(0);
+void ComparePair(fifPair *pPair, t_opts opts) {
+  if (pPair->pfif1 && pPair->pfif2) {
+    pPair->difference = CompareFifs(pPair->pfif1, pPair->pfif2, opts);
+  } else {
+    pPair->difference = MISMATCH;
+  }
+}
+
+#if HAS_THREADS
+void *CompareWorker(void *pArg) {
+  comparePool *pPool = (comparePool *)pArg;
+  int i;
+
+  while (1) {
+    pthread_mutex_lock(&pPool->mutex);
+    i = pPool->iNext++;
+    pthread_mutex_unlock(&pPool->mutex);
+    if (i >= pPool->nPairs) break;
+    ComparePair(pPool->pPairs + i, pPool->opts);
+  }
+  return NULL;
+}
+#endif /* HAS_THREADS */
+
+void ComparePairs(fifPair *pPairs, int nPairs, t_opts opts) {
+  int i;
+
+  DEBUG_ENTER(("ComparePairs(%p, %d, 0x%X);\n", pPairs, nPairs, opts));
+
+#if HAS_THREADS
+  if (opts.compare && (nJobs > 1)) {
+    int nThreads = 0;
+    /* Count the pairs that will need reading files */
+    for (i=0; i<nPairs; i++) {
+      fif *pfif1 = pPairs[i].pfif1;
+      fif *pfif2 = pPairs[i].pfif2;
+      if (   pfif1 && pfif2 && !S_ISDIR(pfif1->mode)
+	  && (pfif1->size == pfif2->size)) {
+	nThreads += 1;
+      }
+    }
+    if (nThreads > nJobs) nThreads = nJobs;
+    if (nThreads > 1) {
+      comparePool pool;
+      pthread_t *pThreads;
+      int nStarted;
+
+      pool.pPairs = pPairs;
+      pool.nPairs = nPairs;
+      pool.iNext = 0;
+      pool.opts = opts;
+      pthread_mutex_init(&pool.mutex, NULL);
+      pThreads = (pthread_t *)malloc(nThreads * sizeof(pthread_t));
+      if (!pThreads) finis(RETCODE_NO_MEMORY, "Out of memory for threads");
+      /* The main thread is one of the workers */
+      for (nStarted = 1; nStarted < nThreads; nStarted++) {
+	if (pthread_create(pThreads+nStarted, NULL, CompareWorker, &pool)) break;
+      }
+      CompareWorker(&pool);
+      for (i=1; i<nStarted; i++) pthread_join(pThreads[i], NULL);
+      free(pThreads);
+      pthread_mutex_destroy(&pool.mutex);
+      RETURN_COMMENT(("Compared using %d threads\n", nStarted));
+    }
+  }
+#endif /* HAS_THREADS */
+
+  for (i=0; i<nPairs; i++) ComparePair(pPairs+i, opts);
+  RETURN();
 }
 
 void affichePaths(void) {
@@ -1664,13 +2698,88 @@ void affichePaths(void) {
   printflf();
 }
 
-/* Display a huge integer with commas every three digits. */
-int Size2ReadableString(char *pBuf, intmax_t llSize) {
-  int n = 0;
-  char *pszFormat = "%" PRIdMAX;
-
-  if (llSize >= 1000) {
-    n = Size2ReadableString(pBuf, llSize/1000);
+/******************************************************************************
+*                                                                             *
+*       Function:       ReadLinkTarget                                        *
+*                                                                             *
+*       Description:    Read the target of a link, if not done already        *
+*                                                                             *
+*       Arguments:                                                            *
+*                                                                             *
+*         linkReader *pReader	The link's directory reader                   *
+*         fif *pfif		The directory entry. Ignored if not a link.   *
+*                                                                             *
+*       Return value:   None. pfif->target remains NULL if it can't be read.  *
+*                                                                             *
+*       Notes:          In Unix, the directory is opened once for all the     *
+*                       links read in it, and the targets read relative to it *
+*                       with readlinkat(). This avoids resolving the whole    *
+*                       pathname again for every link.                        *
+*                                                                             *
+*       Updates:                                                              *
+*        2026-10-17 MAB Initial implementation.                               *
+*                                                                             *
+******************************************************************************/
+
+void InitLinkReader(linkReader *pReader, char *path, ARENA *pArena) {
+  pReader->path = path;
+  pReader->pArena = pArena;
+  pReader->pBuf = NULL;
+#if defined(_UNIX)
+  pReader->iDirFd = -1;
+#endif
+}
+
+void ReadLinkTarget(linkReader *pReader, fif *pfif) {
+#if defined(S_ISLNK) && S_ISLNK(S_IFLNK) /* If the OS has links */
+  int lTarget;
+
+  if (pfif->target || !S_ISLNK(pfif->mode)) return;
+  if (!pReader->pBuf) {
+    pReader->pBuf = (char *)malloc(PATHNAME_SIZE);
+    if (!pReader->pBuf) finis(RETCODE_NO_MEMORY, "Out of memory");
+  }
+#if defined(_UNIX)
+  if (pReader->iDirFd == -1) {
+    pReader->iDirFd = open(pReader->path, O_RDONLY | O_DIRECTORY);
+    if (pReader->iDirFd < 0) pReader->iDirFd = -2;
+  }
+  if (pReader->iDirFd < 0) return;
+  lTarget = (int)readlinkat(pReader->iDirFd, pfif->name, pReader->pBuf, PATHNAME_SIZE);
+#else
+  {
+    NEW_PATHNAME_BUF(pathname);
+#if PATHNAME_BUFS_IN_HEAP
+    if (!pathname) return;
+#endif
+    makepathname(pathname, pReader->path, pfif->name);
+    lTarget = (int)readlink(pathname, pReader->pBuf, PATHNAME_SIZE);
+    FREE_PATHNAME_BUF(pathname);
+  }
+#endif
+  if (lTarget != -1) {
+    pfif->target = ArenaStrndup(pReader->pArena, pReader->pBuf, lTarget);
+    if (!pfif->target) finis(RETCODE_NO_MEMORY, "Out of memory");
+  }
+#endif /* defined(S_ISLNK) */
+}
+
+void FreeLinkReader(linkReader *pReader) {
+  free(pReader->pBuf);
+  pReader->pBuf = NULL;
+#if defined(_UNIX)
+  if (pReader->iDirFd >= 0) close(pReader->iDirFd);
+  pReader->iDirFd = -1;
+#endif
+}
+
+/* Display a huge integer with commas every three digits. */
+int Size2ReadableString(char *pBuf, intmax_t llSize) {
+  int n = 0;
+  char *pszFormat = "%" PRIdMAX;
+
+  if (llSize >= 1000) {
+    n = Size2ReadableString(pBuf, llSize/1000);
     llSize = llSize % 1000;
     pBuf[n++] = ',';
     pszFormat = "%03" PRIdMAX; /*  Display leading 0s for the following groups */
@@ -1703,7 +2812,7 @@ int affiche1(fif *pfif, int col, t_opts opts) {
     RETURN_CONST(0);
   }
 
-  pTime = LocalFileTime(&(pfif->st.st_mtime)); // Time of last data modification
+  pTime = LocalFileTime(&(pfif->mtime)); // Time of last data modification
   seconde = pTime->tm_sec;
   minute = pTime->tm_min;
   heure = pTime->tm_hour;
@@ -1719,7 +2828,7 @@ int affiche1(fif *pfif, int col, t_opts opts) {
   if (opts.upper) strupr(pNicename);	/* Do just the opposite if requested */
 
   /* Output the name */
-  if (S_ISDIR(pfif->st.st_mode)) {
+  if (S_ISDIR(pfif->mode)) {
 #if 1
 #if defined(_UNIX)
     { /* Append an OS-dependant directory separator */
@@ -1738,18 +2847,18 @@ int affiche1(fif *pfif, int col, t_opts opts) {
 #endif /* 1 */
     iShowSize = 0;
   }
-  if (   S_ISCHR(pfif->st.st_mode)
+  if (   S_ISCHR(pfif->mode)
 #if defined(S_ISBLK) && S_ISBLK(S_IFBLK) /* In DOS it's defined, but always returns 0 */
-      || S_ISBLK(pfif->st.st_mode)
+      || S_ISBLK(pfif->mode)
 #endif // defined(S_ISBLK)
      ) {
     // strcat(pNicename, " !");
     iShowSize = 0;
   }
 #if defined(S_ISLNK) && S_ISLNK(S_IFLNK) /* In DOS it's defined, but always returns 0 */
-  if (S_ISLNK(pfif->st.st_mode)) {
+  if (S_ISLNK(pfif->mode)) {
 #if 0 && defined(_WIN32) && _MSVCLIBX_STAT_DEFINED
-    if ((pfif->st.st_Win32Attrs & FILE_ATTRIBUTE_DIRECTORY) == FILE_ATTRIBUTE_DIRECTORY) {
+    if ((pfif->win32Attrs & FILE_ATTRIBUTE_DIRECTORY) == FILE_ATTRIBUTE_DIRECTORY) {
       strcat(pNicename, "\\"); /* Junctions and symlinkds behave like directories in Windows */
     }
 #endif
@@ -1759,13 +2868,13 @@ int affiche1(fif *pfif, int col, t_opts opts) {
   }
 #endif // defined(S_ISLNK)
 #if defined(S_ISFIFO) && S_ISFIFO(S_IFIFO) /* In DOS it's defined, but always returns 0 */
-  if (S_ISFIFO(pfif->st.st_mode)) {
+  if (S_ISFIFO(pfif->mode)) {
     strcat(pNicename, "|");
     iShowSize = 0;
   }
 #endif // defined(S_ISFIFO)
 #if defined(S_ISSOCK) && S_ISSOCK(S_IFSOCK) /* In DOS it's defined, but always returns 0 */
-  if (S_ISSOCK(pfif->st.st_mode)) {
+  if (S_ISSOCK(pfif->mode)) {
     strcat(pNicename, "=");
     iShowSize = 0;
   }
@@ -1777,13 +2886,13 @@ int affiche1(fif *pfif, int col, t_opts opts) {
 
   /* Output the size */
   if (iShowSize) { /* This is a normal file, and we need to display the size */
-    // int nBytes = sizeof(pfif->st.st_size); /* Could this be made a compile-time constant? */
+    // int nBytes = sizeof(pfif->size); /* Could this be made a compile-time constant? */
     // char *pszFormat = (nBytes == 4) ? "%"PRIu32 : "%"PRIu64;
-    // nSize = sprintf(szSize, pszFormat, pfif->st.st_size);
-    nSize = Size2ReadableString(szSize, pfif->st.st_size);
+    // nSize = sprintf(szSize, pszFormat, pfif->size);
+    nSize = Size2ReadableString(szSize, pfif->size);
   } else {         /* This is a special file, do not display a size */
 #if !defined(_UNIX)
-    if (S_ISDIR(pfif->st.st_mode)) { // This is a directory
+    if (S_ISDIR(pfif->mode)) { // This is a directory
 #if defined(_WIN32)
       nSize = sprintf(szSize, "<DIR>     "); // Add 5 spaces to align with <JUNCTION> and <SYMLINKD>
 #elif defined(_MSDOS)
@@ -1792,18 +2901,18 @@ int affiche1(fif *pfif, int col, t_opts opts) {
     }
 #endif
 
-    if (S_ISCHR(pfif->st.st_mode)) {
+    if (S_ISCHR(pfif->mode)) {
       nSize = sprintf(szSize, "<CHARDEV>"); // This is a character device
     }
 #if defined(S_ISBLK) && S_ISBLK(S_IFBLK) /* In DOS it's defined, but always returns 0 */
-    if (S_ISBLK(pfif->st.st_mode)) {
+    if (S_ISBLK(pfif->mode)) {
       nSize = sprintf(szSize, "<BLCKDEV>"); // This is a block device
     }
 #endif // defined(S_ISBLK)
 
 #if defined(_WIN32) && _MSVCLIBX_STAT_DEFINED
-    if (S_ISLNK(pfif->st.st_mode)) {
-      switch (pfif->st.st_ReparseTag) {
+    if (S_ISLNK(pfif->mode)) {
+      switch (pfif->reparseTag) {
       	case IO_REPARSE_TAG_MOUNT_POINT: // This is a junction
 	  nSize = sprintf(szSize, "<JUNCTION>"); break;
       	case IO_REPARSE_TAG_APPEXECLINK: // This is an UWP application execution link
@@ -1812,7 +2921,7 @@ int affiche1(fif *pfif, int col, t_opts opts) {
 	  nSize = sprintf(szSize, "<LXSYMLNK>"); break;
       	case IO_REPARSE_TAG_SYMLINK: // This is a Windows symlink
 	default:
-          if (pfif->st.st_Win32Attrs & FILE_ATTRIBUTE_DIRECTORY) { // This is a symlinkd
+          if (pfif->win32Attrs & FILE_ATTRIBUTE_DIRECTORY) { // This is a symlinkd
 	    nSize = sprintf(szSize, "<SYMLINKD>");
 	  } // Else it's a Windows symbolic link, and it's implied by the -> after the name
 	  break;
@@ -1821,12 +2930,12 @@ int affiche1(fif *pfif, int col, t_opts opts) {
 #endif
 
 #if defined(S_ISFIFO) && S_ISFIFO(S_IFIFO) /* In DOS it's defined, but always returns 0 */
-    if (S_ISFIFO(pfif->st.st_mode)) {
+    if (S_ISFIFO(pfif->mode)) {
       nSize = sprintf(szSize, "<FIFO>   "); // This is a fifo
     }
 #endif // defined(S_ISFIFO)
 #if defined(S_ISSOCK) && S_ISSOCK(S_IFSOCK) /* In DOS it's defined, but always returns 0 */
-    if (S_ISSOCK(pfif->st.st_mode)) {
+    if (S_ISSOCK(pfif->mode)) {
       nSize = sprintf(szSize, "<SOCKET> "); // This is a network socket
     }
 #endif // defined(S_ISSOCK)
@@ -1849,249 +2958,2191 @@ int affiche1(fif *pfif, int col, t_opts opts) {
   /* Optionally display the compression ratio */
   if (opts.compression) {
     // printf("%12"PRIu64, pfif->qwComprSize.QuadPart);
-    if (pfif->st.st_size && pfif->qwComprSize.QuadPart && (pfif->st.st_size != (off64_t)(pfif->qwComprSize.QuadPart))) {
-      int iRatio = (int)(((pfif->st.st_size - pfif->qwComprSize.QuadPart) * 100) / pfif->st.st_size);
+    if (pfif->size && pfif->qwComprSize.QuadPart && (pfif->size != (off64_t)(pfif->qwComprSize.QuadPart))) {
+      int iRatio = (int)(((pfif->size - pfif->qwComprSize.QuadPart) * 100) / pfif->size);
       printf("%3d%%", iRatio);
     } else {
       printf("    ");
     }
   }
-#endif
+#endif
+
+  /* Display the date and time */
+  if (iYearWidth == 2) {
+    printf(" %02d-%02d-%02d %02d:%02d:%02d",
+	    an % 100, mois, jour, heure, minute, seconde);
+  } else {
+    printf(" %04d-%02d-%02d %02d:%02d:%02d",
+	    an, mois, jour, heure, minute, seconde);
+  }
+  RETURN_CONST(0);
+}
+
+/******************************************************************************
+*                                                                             *
+*       Function:       CompareFifs                                           *
+*                                                                             *
+*       Description:    Compare a left file date and time with the right one  *
+*                                                                             *
+*       Arguments:                                                            *
+*         fif *pfif1    Left file info structure                              *
+*         fif *pfif2    Right file info structure                             *
+*         t_opts opts	User-defined options		                      *
+*                                                                             *
+*       Return value:   0=Same file; <0 Older than right; >0 Newer than right.*
+*                                                                             *
+*       Notes:          The files are paired by MergeNext(), so they are      *
+*                       known to have the same type and name.                 *
+*                                                                             *
+*       Updates:                                                              *
+*        2026-10-17 MAB Renamed CompareToNext() as CompareFifs().             *
+*                                                                             *
+******************************************************************************/
+
+int CompareFifs(fif *pfif1, fif *pfif2, t_opts opts) { /* Compare a left and a right file */
+  long deltatime;                 /* Date and Time difference, in seconds */
+  int deltasize;                  /* Sign of the difference, or 0 if equal */
+  int dif;
+
+  DEBUG_ENTER(("CompareFifs(%p, %p, 0x%X); // \"%s\" / \"%s\"\n", pfif1, pfif2, opts, pfif1->name, pfif2->name));
+
+  deltatime = (long)pfif1->mtime;
+  deltatime -= (long)pfif2->mtime;
+
+  if (pfif1->size < pfif2->size) {
+    deltasize = -1;
+  } else if (pfif1->size > pfif2->size) {
+    deltasize = 1;
+  } else {
+    deltasize = 0;
+  }
+
+  /* If in filecomp mode, check if same data files with different dates */
+  if (   opts.compare && !deltasize && !S_ISDIR(pfif1->mode) /* Let the actual data decide */
+#if HAS_SNAPSHOT
+      && (pfif1->pDigest || S_ISLNK(pfif1->mode) || !pSnapshot) /* Snapshot files can't be read */
+#endif
+     ) {
+    NEW_PATHNAME_BUF(name1);
+    NEW_PATHNAME_BUF(name2);
+
+    makepathname(name1, path1, pfif1->name);
+    makepathname(name2, path2, pfif2->name);
+    dif = MISMATCH; /* Not known yet */
+#if HAS_SNAPSHOT
+    if (pfif1->pDigest) { /* Compare with the digest recorded in the snapshot */
+      uint64_t digest2[2];
+      dif = 2;
+      if (S_ISREG(pfif2->mode) && !DigestCacheGet(pDigestCache, name2, digest2)) {
+	dif = ((pfif1->pDigest[0] == digest2[0]) && (pfif1->pDigest[1] == digest2[1])) ? 0 : 2;
+      }
+    } else if (pSnapshot) { /* Compare with the link target recorded in the snapshot */
+      NEW_PATHNAME_BUF(target2);
+      int n2 = -1;
+#if PATHNAME_BUFS_IN_HEAP
+      if (!target2) finis(RETCODE_NO_MEMORY, "Out of memory");
+#endif
+      if (S_ISLNK(pfif2->mode)) n2 = (int)readlink(name2, target2, PATHNAME_SIZE-1);
+      dif = 3;
+      if ((n2 != -1) && pfif1->target) {
+	target2[n2] = '\0';
+	dif = strcmp(pfif1->target, target2);
+      }
+      FREE_PATHNAME_BUF(target2);
+    }
+#endif
+#if HAS_CACHE
+    if (   (dif == MISMATCH) && pDigestCache
+	&& S_ISREG(pfif1->mode) && S_ISREG(pfif2->mode)) {
+      uint64_t digest1[2], digest2[2];
+      if (   !DigestCacheGet(pDigestCache, name1, digest1)
+	  && !DigestCacheGet(pDigestCache, name2, digest2)) {
+	dif = ((digest1[0] == digest2[0]) && (digest1[1] == digest2[1])) ? 0 : 2;
+	/* If they differ, only the data can tell which one is larger */
+	if (dif && !deltatime) dif = MISMATCH;
+      }
+    }
+#endif
+    if (dif == MISMATCH) dif = filecompare(name1, name2);
+    FREE_PATHNAME_BUF(name1);
+    FREE_PATHNAME_BUF(name2);
+    if (!dif) {
+      if (deltatime && opts.dtime) {
+	DEBUG_RETURN_INT(DATE_MISMATCH, "Contents are identical but dates differ");
+      }
+      DEBUG_RETURN_INT(0, "Contents are identical"); /* They are actually identical */
+    }
+    if (deltatime) DEBUG_RETURN_INT(SIGN(deltatime), "Timestamps and contents differ");
+    DEBUG_RETURN_INT(SIGN(dif), "Contents differ");
+  }
+
+  /* If same file name, compare date and time */
+  if (!opts.notime && deltatime) {     /* If comparison expected, and there is a difference */
+    int sign;               /* Sign of deltatime */
+
+    sign = (deltatime > 0) ? 1 : -1;        /* Sign of the difference */
+
+    if (opts.notz) {   /* Special case if we wish to ignore time-zone differences */
+      /* Ignore differences that are an integer number of hours  less than 24 hours */
+      int deltaseconds;
+
+      deltaseconds = (int)(deltatime % 3600);
+      if (deltaseconds < 0) deltaseconds += 3600;
+      deltatime /= 3600;                   /* Convert difference to hours */
+      if ((deltatime > 23) || (deltatime < -23))
+	  DEBUG_RETURN_INT(sign, "Timestamps differ > 1 day"); /* More than 1 day of diff. */
+      switch (deltaseconds) { // ~~jfl 1996-09-16
+	case 0:
+	case 2:
+	case 3600-2:
+	/* Assume the difference isn't meaningful. Go compare the size. */
+	break;
+	default:
+	DEBUG_RETURN_INT(sign, "Timestamps differ > 2 seconds");
+      }
+    } else {      /* Common case where any date & time difference counts */
+      DEBUG_RETURN_INT(sign, "Timestamps differ");
+    }
+  }
+
+  /* If same date & time, compare size */
+  if (deltasize) DEBUG_RETURN_INT(deltasize, "Sizes differ (yet times match)");
+
+  DEBUG_RETURN_INT(0, "Same files");
+}
+
+/******************************************************************************
+*                                                                             *
+*       Function:       filecompare                                           *
+*                                                                             *
+*       Description:    Compare the contents of two files                     *
+*                                                                             *
+*       Arguments:                                                            *
+*                                                                             *
+*         char *name1   Pathname of first file                                *
+*         char *name2   Pathname of second file                               *
+*                                                                             *
+*       Return value:   0=Same contents                                       *
+*                       1/-1=Length difference                                *
+*                       2/-2=Data difference                                  *
+*                       3/-3=One of the files is missing                      *
+*                                                                             *
+*       Notes:          Thread-safe in Unix, where it's called by the         *
+*                       ComparePairs() threads.                               *
+*                                                                             *
+*       Updates:                                                              *
+*        1995-06-12 JFL Made this routine generic (Independant of DIRC)       *
+*        2014-01-21 JFL Use a much larger buffer for 32-bits apps, to improve *
+*                       performance.                                          *
+*        2026-10-17 MAB In Unix, compare the sizes before reading anything,   *
+*                       then use large sequential read()s in thread buffers.  *
+*                                                                             *
+******************************************************************************/
+
+#ifdef _MSDOS		/* If it's a 16-bits app, use a 4K buffer. */
+#define FBUFSIZE 4096
+#elif defined(_UNIX)	/* Unix buffers are allocated once per comparison thread */
+#define FBUFSIZE (256 * 1024)
+#else			/* Else for 32-bits or 64-bits apps, use a 4M buffer */
+#define FBUFSIZE (4096 * 1024)
+#endif
+
+#if defined(_UNIX)
+/* Read as much as possible, until the buffer is full or the end of file */
+ssize_t ReadFull(int fd, char *pBuf, size_t nBytes) {
+  size_t nDone = 0;
+  while (nDone < nBytes) {
+    ssize_t n = read(fd, pBuf+nDone, nBytes-nDone);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return -1;
+    }
+    if (n == 0) break;	/* End of file */
+    nDone += n;
+  }
+  return (ssize_t)nDone;
+}
+
+/* Each thread gets its own pair of read buffers, allocated the first time
+   it needs them, and freed when it exits. This keeps the thread stacks small. */
+pthread_key_t kFBufs;
+pthread_once_t onceFBufs = PTHREAD_ONCE_INIT;
+
+void InitFBufs(void) {
+  pthread_key_create(&kFBufs, free);
+}
+
+/* Get the two FBUFSIZE buffers of the current thread. NULL if out of memory */
+char *GetFBufs(void) {
+  char *pBufs;
+  pthread_once(&onceFBufs, InitFBufs);
+  pBufs = pthread_getspecific(kFBufs);
+  if (!pBufs) {
+    pBufs = malloc(2 * FBUFSIZE);
+    if (pBufs && pthread_setspecific(kFBufs, pBufs)) {
+      free(pBufs);
+      pBufs = NULL;
+    }
+  }
+  return pBufs;
+}
+
+/* Compare the contents of two open files. Same return values as filecompare() */
+int fdcompare(int fd1, int fd2) {
+  struct stat st1, st2;
+  char *buf1, *buf2;
+  ssize_t l1, l2;
+  int dif;
+
+  /* Files that don't have the same size can't be identical */
+  if (fstat(fd1, &st1) || fstat(fd2, &st2)) return 2;
+  if (S_ISREG(st1.st_mode) && S_ISREG(st2.st_mode) && (st1.st_size != st2.st_size)) {
+    return (st1.st_size > st2.st_size) ? 1 : -1;
+  }
+  buf1 = GetFBufs();
+  if (!buf1) return 2;			/* Can't tell. Assume they differ */
+  buf2 = buf1 + FBUFSIZE;
+
+#if defined(POSIX_FADV_SEQUENTIAL)
+  posix_fadvise(fd1, 0, 0, POSIX_FADV_SEQUENTIAL); /* Allow more read-ahead */
+  posix_fadvise(fd2, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+  while (1) {
+    l1 = ReadFull(fd1, buf1, FBUFSIZE);
+    l2 = ReadFull(fd2, buf2, FBUFSIZE);
+    if ((l1 < 0) || (l2 < 0)) return 2;	/* Can't tell. Assume they differ */
+    if (l1 > l2) return 1;
+    if (l1 < l2) return -1;
+    if (!l1) return 0;			/* Both ended at the same time */
+    dif = memcmp(buf1, buf2, l1);	/* The C library memcmp() uses SIMD */
+    if (dif) return (dif > 0) ? 2 : -2;	/* If different data found, return immediately */
+  }
+}
+#endif /* defined(_UNIX) */
+
+int filecompare(char *name1, char *name2) { /* Compare two files */
+#if defined(_UNIX)
+  int fd1;
+  int fd2;
+#else
+  static char *pbuf1 = NULL;
+  static char *pbuf2 = NULL;
+  FILE *f1;
+  FILE *f2;
+  size_t l1, l2;
+#endif
+  int dif;
+
+  DEBUG_ENTER(("filecompare(\"%s\", \"%s\");\n", name1, name2));
+
+  /* For links, compare the link targets */
+#if defined(S_ISLNK) && S_ISLNK(S_IFLNK) /* In DOS it's defined, but always returns 0 */
+  {
+    int err1, err2;
+    struct stat st1;
+    struct stat st2;
+    err1 = lstat(name1, &st1);
+    err2 = lstat(name2, &st2);
+    if ((!err1) && S_ISLNK(st1.st_mode) && (!err2) && S_ISLNK(st2.st_mode)) {
+#if defined(_WIN32) && _MSVCLIBX_STAT_DEFINED
+      if ((st1.st_Win32Attrs & FILE_ATTRIBUTE_DIRECTORY) && (st2.st_Win32Attrs & FILE_ATTRIBUTE_DIRECTORY))
+#else
+      err1 = stat(name1, &st1);
+      err2 = stat(name2, &st2);
+      if (err1 && err2) RETURN_INT_COMMENT(0, ("Both dead links. Ignore.\n"));
+      if (err1) RETURN_INT_COMMENT(-3, ("The first link is dead.\n"));
+      if (err2) RETURN_INT_COMMENT( 3, ("The second link is dead.\n"));
+      if (S_ISDIR(st1.st_mode) && S_ISDIR(st2.st_mode))
+#endif
+	{
+	NEW_PATHNAME_BUF(target1);
+	NEW_PATHNAME_BUF(target2);
+	int n1, n2;
+#if PATHNAME_BUFS_IN_HEAP
+	if ((!target1) || (!target2)) finis(RETCODE_NO_MEMORY, "Out of memory");
+#endif
+	n1 = (int)readlink(name1, target1, PATHNAME_SIZE-1);
+	n2 = (int)readlink(name2, target2, PATHNAME_SIZE-1);
+	if ((n1 == -1) && (n2 == -1)) {
+	  dif = 0;	/* Both dead links. Ignore. */
+	} else if (n1 == -1) {
+	  dif = -3;	/* The first link is dead */
+	} else if (n2 == -1) {
+	  dif = 3;	/* The second link is dead */
+	} else {
+	  target1[n1] = '\0';
+	  target2[n2] = '\0';
+	  dif = strcmp(target1, target2);
+	}
+	FREE_PATHNAME_BUF(target1);
+	FREE_PATHNAME_BUF(target2);
+	RETURN_INT_COMMENT(dif, ("Link targets are %s\n", dif ? "different" : "identical"));
+      }
+    }
+  }
+#endif // OS supporting links
+
+  /* For files or links to files, compare the data itself */
+#if defined(_UNIX)
+  fd1 = open(name1, O_RDONLY);
+  fd2 = open(name2, O_RDONLY);
+  if ((fd1 == -1) && (fd2 == -1)) RETURN_INT_COMMENT(0, ("Neither file exists.\n"));
+  if (fd1 == -1) {
+    close(fd2);
+    RETURN_INT_COMMENT(-3, ("The first file does not exist.\n"));
+  }
+  if (fd2 == -1) {
+    close(fd1);
+    RETURN_INT_COMMENT( 3, ("The second file does not exist.\n"));
+  }
+
+  dif = fdcompare(fd1, fd2);
+
+  close(fd1);
+  close(fd2);
+#else /* !defined(_UNIX) */
+  if (!pbuf1) {
+    pbuf1 = (char *)malloc(FBUFSIZE);
+    pbuf2 = (char *)malloc(FBUFSIZE);
+    if (!pbuf2) {
+      finis(RETCODE_NO_MEMORY, "Out of memory");   /* Note: This is still DIRC-specific */
+    }
+  }
+
+  f1 = fopen(name1, "rb");
+  f2 = fopen(name2, "rb");
+  if ((!f1) && (!f2)) RETURN_INT_COMMENT(0, ("Neither file exists.\n"));
+  if (!f1) {
+    fclose(f2);
+    RETURN_INT_COMMENT(-3, ("The first file does not exist.\n"));
+  }
+  if (!f2) {
+    fclose(f1);
+    RETURN_INT_COMMENT( 3, ("The second file does not exist.\n"));
+  }
+
+  dif = 0;
+  while ((l1 = fread(pbuf1, 1, FBUFSIZE, f1)) != 0) {
+    l2 = fread(pbuf2, 1, FBUFSIZE, f2);
+    if (l1 > l2) {dif = 1; break;}
+    if (l1 < l2) {dif = -1; break;}
+    dif = memcmp(pbuf1, pbuf2, l1);
+    if (dif) {
+      dif = (dif > 0) ? 2 : -2;
+      break;   /* If different data found, return immediately */
+    }
+  }
+
+  fclose(f1);
+  fclose(f2);
+#endif /* defined(_UNIX) */
+
+  RETURN_INT_COMMENT(dif, ("Files are %s\n", dif ? "different" : "identical"));
+}
+
+/******************************************************************************
+*                                                                             *
+*       Function:       DigestCacheLoad                                       *
+*                                                                             *
+*       Description:    Map in memory the digest cache of previous comparisons*
+*                                                                             *
+*       Arguments:                                                            *
+*         digestCache *pCache	The cache. pCache->pszFile = Its pathname     *
+*                                                                             *
+*       Return value:   None                                                  *
+*                                                                             *
+*       Notes:          The cache is keyed by the device and inode numbers of *
+*                       the files. A file record is valid as long as the file *
+*                       size, mtime and ctime have not changed.               *
+*                       A missing or invalid file is not an error: All files  *
+*                       compared are read, and the file is recreated.         *
+*                       The digest is a 128-bit MurmurHash3, from SysLib.     *
+*                       Accidental collisions are astronomically unlikely,    *
+*                       but it does not resist deliberate ones.               *
+*                       Records for files that are gone are not purged.       *
+*                       Delete the cache file to shrink it.                   *
+*                                                                             *
+*       History:                                                              *
+*        2026-10-17 MAB Created this routine.                                 *
+*                                                                             *
+******************************************************************************/
+
+#if HAS_CACHE
+
+void DigestCacheLoad(digestCache *pCache) {
+  int iFile;
+  struct stat st;
+  const dccHeader *pHdr;
+  void *pMap;
+  size_t lMap;
+
+  pCache->tStart = time(NULL);
+#if HAS_THREADS
+  pthread_mutex_init(&pCache->mutex, NULL);
+#endif
+
+  iFile = open(pCache->pszFile, O_RDONLY | O_CLOEXEC);
+  if (iFile < 0) return; /* No previous comparison */
+  if (fstat(iFile, &st) || (st.st_size < (off_t)sizeof(dccHeader))) {
+    close(iFile);
+    return;
+  }
+  lMap = (size_t)st.st_size;
+  pMap = mmap(NULL, lMap, PROT_READ, MAP_SHARED, iFile, 0);
+  close(iFile); /* The mapping remains valid */
+  if (pMap == MAP_FAILED) return;
+
+  pHdr = pMap;
+  if (   (pHdr->magic != DCC_MAGIC)
+      || (pHdr->version != DCC_VERSION)
+      || ((sizeof(dccHeader) + (pHdr->nRecords * sizeof(dccRecord))) != lMap)) {
+    fprintf(stderr, "Warning: Ignoring invalid cache file %s\n", pCache->pszFile);
+    munmap(pMap, lMap);
+    return;
+  }
+
+  pCache->pMap = pMap;
+  pCache->lMap = lMap;
+  pCache->pOld = (const dccRecord *)(pHdr + 1);
+  pCache->nOld = pHdr->nRecords;
+}
+
+/* Get the record of a file, if it has not changed since it was read */
+const dccRecord *DigestCacheLookup(digestCache *pCache, struct stat *pStat) {
+  uint64_t dev = (uint64_t)pStat->st_dev;
+  uint64_t ino = (uint64_t)pStat->st_ino;
+  uint64_t lo = 0;
+  uint64_t hi = pCache->nOld;
+
+  while (lo < hi) { /* Binary search in the records sorted by (dev, ino) */
+    uint64_t mid = lo + (hi - lo) / 2;
+    const dccRecord *pRec = pCache->pOld + mid;
+    if ((pRec->dev < dev) || ((pRec->dev == dev) && (pRec->ino < ino))) {
+      lo = mid + 1;
+    } else if ((pRec->dev > dev) || (pRec->ino > ino)) {
+      hi = mid;
+    } else { /* Found it. Is it still valid? */
+      if (   (pRec->size == (int64_t)pStat->st_size)
+	  && (pRec->mtime == (int64_t)pStat->st_mtime)
+	  && (pRec->mtimeNs == (int64_t)ST_MTIME_NS(pStat))
+	  && (pRec->ctime == (int64_t)pStat->st_ctime)
+	  && (pRec->ctimeNs == (int64_t)ST_CTIME_NS(pStat))) {
+	return pRec;
+      }
+      break;
+    }
+  }
+  return NULL;
+}
+
+/* Record the digest of a file read, for the next comparisons */
+void DigestCacheAdd(digestCache *pCache, struct stat *pStat, uint64_t *pDigest) {
+  dccRecord *pRec;
+
+#if HAS_THREADS
+  pthread_mutex_lock(&pCache->mutex);
+#endif
+  pCache->nMisses += 1;
+  /* Don't record files that changed since the comparison started, as they
+     may change again later on without changing their mtime seconds */
+  if ((pStat->st_mtime >= pCache->tStart) || (pStat->st_ctime >= pCache->tStart)) goto cleanup;
+
+  if (pCache->nNew == pCache->nNewAlloc) {
+    uint64_t nNew = pCache->nNewAlloc ? 2 * pCache->nNewAlloc : 1024;
+    dccRecord *pNew = realloc(pCache->pNew, (size_t)(nNew * sizeof(dccRecord)));
+    if (!pNew) finis(RETCODE_NO_MEMORY, "Out of memory");
+    pCache->pNew = pNew;
+    pCache->nNewAlloc = nNew;
+  }
+
+  pRec = pCache->pNew + pCache->nNew++;
+  pRec->dev = (uint64_t)pStat->st_dev;
+  pRec->ino = (uint64_t)pStat->st_ino;
+  pRec->size = (int64_t)pStat->st_size;
+  pRec->mtime = (int64_t)pStat->st_mtime;
+  pRec->mtimeNs = (int64_t)ST_MTIME_NS(pStat);
+  pRec->ctime = (int64_t)pStat->st_ctime;
+  pRec->ctimeNs = (int64_t)ST_CTIME_NS(pStat);
+  pRec->digest[0] = pDigest[0];
+  pRec->digest[1] = pDigest[1];
+
+cleanup:
+#if HAS_THREADS
+  pthread_mutex_unlock(&pCache->mutex);
+#endif
+  return;
+}
+
+/* Get the digest of a file. Returns 0=Success, -1=Cannot read it.
+   pCache may be NULL, to compute the digest without using any cache. */
+int DigestCacheGet(digestCache *pCache, char *pszName, uint64_t *pDigest) {
+  const dccRecord *pRec;
+  char *buf;
+  digestState ds;
+  struct stat st, st2;
+  ssize_t n;
+  int iFile;
+
+  /* The fif records don't keep the inode and ctime. So stat() it again. */
+  if (stat(pszName, &st)) return -1;
+  pRec = pCache ? DigestCacheLookup(pCache, &st) : NULL;
+  if (pRec) {
+    pDigest[0] = pRec->digest[0];
+    pDigest[1] = pRec->digest[1];
+#if HAS_THREADS
+    pthread_mutex_lock(&pCache->mutex);
+#endif
+    pCache->nHits += 1;
+#if HAS_THREADS
+    pthread_mutex_unlock(&pCache->mutex);
+#endif
+    return 0;
+  }
+
+  buf = GetFBufs();
+  if (!buf) return -1;
+  iFile = open(pszName, O_RDONLY);
+  if (iFile < 0) return -1;
+  if (fstat(iFile, &st) || !S_ISREG(st.st_mode)) {
+    close(iFile);
+    return -1;
+  }
+#if defined(POSIX_FADV_SEQUENTIAL)
+  posix_fadvise(iFile, 0, 0, POSIX_FADV_SEQUENTIAL); /* Allow more read-ahead */
+#endif
+  DigestInit(&ds);
+  while ((n = ReadFull(iFile, buf, FBUFSIZE)) > 0) {
+    DigestUpdate(&ds, buf, (size_t)n);
+    if (n < FBUFSIZE) break;	/* End of file */
+  }
+  /* Don't trust the digest of a file that changed while we read it */
+  if (   (n < 0) || fstat(iFile, &st2)
+      || (st2.st_size != st.st_size)
+      || (st2.st_mtime != st.st_mtime) || (ST_MTIME_NS(&st2) != ST_MTIME_NS(&st))
+      || (st2.st_ctime != st.st_ctime) || (ST_CTIME_NS(&st2) != ST_CTIME_NS(&st))) {
+    close(iFile);
+    return -1;
+  }
+  close(iFile);
+  DigestFinal(&ds, pDigest);
+
+  if (pCache) DigestCacheAdd(pCache, &st, pDigest);
+  return 0;
+}
+
+/* Sort records by device and inode */
+int CDECL DigestCacheCompare(const dccRecord *pRec1, const dccRecord *pRec2) {
+  if (pRec1->dev != pRec2->dev) return (pRec1->dev < pRec2->dev) ? -1 : 1;
+  if (pRec1->ino != pRec2->ino) return (pRec1->ino < pRec2->ino) ? -1 : 1;
+  return 0;
+}
+
+/* Write the old records merged with the new ones into a temporary file, then
+   rename it as the cache. So concurrent or interrupted comparisons always see
+   a complete cache file. */
+int DigestCacheSave(digestCache *pCache) {
+  dccHeader hdr = {0};
+  char *pszTemp;
+  int iFile;
+  FILE *hf;
+  uint64_t i, j, n;
+  int iErr = 0;
+
+  if (pCache->nNew) {	/* pNew is NULL if nothing was added */
+    qsort(pCache->pNew, (size_t)pCache->nNew, sizeof(dccRecord), (CMPFUNC)DigestCacheCompare);
+    /* Keep only one record for files reached through several links */
+    for (i = n = 0; i < pCache->nNew; i++) {
+      if (n && !DigestCacheCompare(pCache->pNew + n - 1, pCache->pNew + i)) continue;
+      pCache->pNew[n++] = pCache->pNew[i];
+    }
+    pCache->nNew = n;
+  }
+
+  hdr.magic = DCC_MAGIC;
+  hdr.version = DCC_VERSION;
+
+  pszTemp = malloc(strlen(pCache->pszFile) + 8);
+  if (!pszTemp) return -1;
+  sprintf(pszTemp, "%s.XXXXXX", pCache->pszFile);
+  iFile = mkstemp(pszTemp);
+  if (iFile < 0) {
+    free(pszTemp);
+    return -1;
+  }
+  {			/* mkstemp() creates it private. Use the usual permissions. */
+    mode_t mask = umask(0);
+    umask(mask);
+    fchmod(iFile, 0666 & ~mask);
+  }
+  hf = fdopen(iFile, "wb");
+  if (!hf) {
+    close(iFile);
+    goto cleanup_error;
+  }
+  if (fwrite(&hdr, sizeof(hdr), 1, hf) != 1) goto cleanup_close;
+  /* Merge the two sorted lists. The new records replace the old ones. */
+  for (i = j = n = 0; (i < pCache->nOld) || (j < pCache->nNew); n++) {
+    const dccRecord *pRec;
+    int dif = (i == pCache->nOld) ? 1 : (j == pCache->nNew) ? -1 :
+	      DigestCacheCompare(pCache->pOld + i, pCache->pNew + j);
+    if (dif < 0) {
+      pRec = pCache->pOld + i++;
+    } else {
+      if (!dif) i++;
+      pRec = pCache->pNew + j++;
+    }
+    if (fwrite(pRec, sizeof(dccRecord), 1, hf) != 1) goto cleanup_close;
+  }
+  hdr.nRecords = n;
+  if (   fseek(hf, 0, SEEK_SET)
+      || (fwrite(&hdr, sizeof(hdr), 1, hf) != 1)
+      || fflush(hf)
+      || fsync(iFile)) {
+    goto cleanup_close;
+  }
+  if (fclose(hf)) goto cleanup_error;
+  if (rename(pszTemp, pCache->pszFile)) goto cleanup_error;
+  free(pszTemp);
+  return 0;
+
+cleanup_close:
+  iErr = errno;
+  fclose(hf);
+  errno = iErr;
+cleanup_error:
+  iErr = errno;
+  unlink(pszTemp);
+  free(pszTemp);
+  errno = iErr;
+  return -1;
+}
+
+/* Replace the cache file with the old and new digests, if any, and free it */
+void SaveDigestCache(t_opts opts) {
+  if (!pDigestCache) return;
+  if (DigestCacheSave(pDigestCache)) {
+    fprintf(stderr, "Warning: Cannot update the cache file %s. %s\n", pDigestCache->pszFile, strerror(errno));
+  } else if (opts.verbose) {
+    printflf();
+    printf("Reused the cached digest of %ld files, and read %ld.", pDigestCache->nHits, pDigestCache->nMisses);
+    printflf();
+  }
+  DigestCacheFree(pDigestCache);
+  pDigestCache = NULL;
+}
+
+void DigestCacheFree(digestCache *pCache) {
+  if (pCache->pMap) munmap(pCache->pMap, pCache->lMap);
+  free(pCache->pNew);
+#if HAS_THREADS
+  pthread_mutex_destroy(&pCache->mutex);
+#endif
+}
+
+#endif /* HAS_CACHE */
+
+/******************************************************************************
+*                                                                             *
+*       Function:       DigestTrees                                           *
+*                                                                             *
+*       Description:    Compute the digests of all directories in two trees   *
+*                                                                             *
+*       Arguments:                                                            *
+*                                                                             *
+*         char *dir1		Left directory.                               *
+*         char *dir2		Right directory.                              *
+*         char *pattern		Wildcard pattern, or NULL.                    *
+*         int attrib		Search attributes. See lis().                 *
+*         time_t datemin	Minimal date, or 0 if no minimum.             *
+*         time_t datemax	Maximal date, or 0 if no maximum.             *
+*         t_opts opts		User-defined options.                         *
+*         dirNode **ppRoots	Where to store the left and right trees.      *
+*                                                                             *
+*       Return value:   TRUE if both trees were digested, else FALSE.         *
+*                                                                             *
+*       Notes:          A Merkle tree: Each directory listDigest covers the   *
+*                       names, types, sizes, times, link targets, and with -c *
+*                       the contents, of the files that affiche() would list. *
+*                       Its treeDigest covers that listDigest, plus the names *
+*                       and treeDigests of all the subdirectories descend()   *
+*                       goes into. Names are digested with their length, so   *
+*                       that no two lists of names give the same byte stream. *
+*                       They're computed bottom-up, using the same            *
+*                       lis() scans as the comparison, so that equal digests  *
+*                       guaranty that the comparison would find no difference.*
+*                       The converse is not true: Differences ignored by the  *
+*                       comparison options, like with -i, change the digest.  *
+*                       Then the directory is just compared as usual.         *
+*                       Up to nJobs threads digest the directories of both    *
+*                       trees, each with its own names arena. The last one to *
+*                       finish a subdirectory computes its parent treeDigest. *
+*                                                                             *
+*       Updates:                                                              *
+*        2026-10-17 MAB Initial implementation.                               *
+*        2026-10-17 MAB Digest the subdirectories names with their length.    *
+*                                                                             *
+******************************************************************************/
+
+#if HAS_PRUNE
+
+/* Digest one directory entry, as affiche() would compare it */
+int DigestFif(digestState *pDS, char *path, fif *pfif, t_opts opts) {
+  struct {			/* Initialized with memset, so no random padding */
+    uint64_t mode;
+    int64_t size;
+    int64_t mtime;
+    uint64_t digest[2];
+  } rec;
+  int iValid = TRUE;
+
+  DigestString(pDS, pfif->name);
+  memset(&rec, 0, sizeof(rec));
+  rec.mode = (uint64_t)(pfif->mode & S_IFMT);
+  rec.size = (int64_t)pfif->size;
+  /* Times matter, except with -j, unless -ct flags them */
+  if (!opts.notime || opts.dtime) rec.mtime = (int64_t)pfif->mtime;
+  if (opts.compare && S_ISREG(pfif->mode)) {
+    NEW_PATHNAME_BUF(pathname);
+#if PATHNAME_BUFS_IN_HEAP
+    if (!pathname) return FALSE;
+#endif
+    makepathname(pathname, path, pfif->name);
+    if (DigestCacheGet(pDigestCache, pathname, rec.digest)) iValid = FALSE;
+    FREE_PATHNAME_BUF(pathname);
+  } else if (opts.compare && !S_ISDIR(pfif->mode) && !S_ISLNK(pfif->mode)) {
+    iValid = FALSE;		/* Devices, pipes, etc, can't be digested */
+  }
+  DigestUpdate(pDS, &rec, sizeof(rec));
+  DigestString(pDS, pfif->target ? pfif->target : "");
+  return iValid;
+}
+
+/* Create a task for digesting a directory. Its node only has the name and parent. */
+treeTask *NewTreeTask(char *path, char *name, dirNode *pParent) {
+  treeTask *pTask = (treeTask *)calloc(1, sizeof(treeTask));
+  dirNode *pNode = (dirNode *)calloc(1, sizeof(dirNode));
+
+  if (pTask) pTask->path = strdup(path);
+  if (pNode) pNode->name = strdup(name);
+  if (!pTask || !pTask->path || !pNode || !pNode->name) {
+    finis(RETCODE_NO_MEMORY, "Out of memory for the directories digests");
+  }
+  pNode->pParent = pParent;
+  pTask->pNode = pNode;
+  return pTask;
+}
+
+/* Digest the files in a directory, and create the tasks for its subdirectories.
+   Returns the list of these tasks. */
+treeTask *DigestDir(treePool *pPool, treeTask *pTask, ARENA *pArena) {
+  dirNode *pNode = pTask->pNode;
+  char *path = pTask->path;
+  treeTask *pSubTasks = NULL;
+  ARENAMARK mark;
+  fifList list;
+  digestState ds;
+  linkReader reader;
+  int i;
+  NEW_PATHNAME_BUF(subdir);
+
+  DEBUG_ENTER(("DigestDir(%p, \"%s\", %p);\n", pPool, path, pArena));
+
+#if PATHNAME_BUFS_IN_HEAP
+  if (!subdir) finis(RETCODE_NO_MEMORY, "Out of memory for the directories digests");
+#endif
+
+  /* lis() silently skips directories it cannot open. descend() may not */
+  pNode->listValid = !access(path, R_OK | X_OK);
+
+  /* Digest the files that affiche() would list */
+  ArenaMark(pArena, &mark);
+  lisArena(path, pPool->pattern, pArena, pPool->attrib, pPool->datemin, pPool->datemax,
+	   pPool->opts, &list);
+  InitLinkReader(&reader, path, pArena);
+  DigestInit(&ds);
+  for (i=0; i<list.nfif; i++) {
+    ReadLinkTarget(&reader, list.ppfif[i]);
+    if (!DigestFif(&ds, path, list.ppfif[i], pPool->opts)) pNode->listValid = FALSE;
+  }
+  DigestFinal(&ds, pNode->listDigest);
+  FreeLinkReader(&reader);
+  FreeFifArray(list.ppfif);
+  free(list.pFifs);
+
+  /* Queue the subdirectories that descend() would go into */
+  lisArena(path, PATTERN_ALL, pArena, SUBDIRS_ATTRIB, 0, TIME_T_MAX, pPool->opts, &list);
+  pNode->treeValid = pNode->listValid;
+  pNode->nChildren = list.nfif;
+  pNode->nPending = list.nfif;
+  pNode->ppChildren = (dirNode **)malloc((list.nfif + 1) * sizeof(dirNode *));
+  if (!pNode->ppChildren) finis(RETCODE_NO_MEMORY, "Out of memory for the directories digests");
+  for (i=list.nfif-1; i>=0; i--) { /* Stack them, so that the first one is on top */
+    treeTask *pSubTask;
+    makepathname(subdir, path, list.ppfif[i]->name);
+    pSubTask = NewTreeTask(subdir, list.ppfif[i]->name, pNode);
+    pNode->ppChildren[i] = pSubTask->pNode;
+    pSubTask->pNext = pSubTasks;
+    pSubTasks = pSubTask;
+  }
+  FreeFifArray(list.ppfif);
+  free(list.pFifs);
+  ArenaRelease(pArena, &mark);
+
+  FREE_PATHNAME_BUF(subdir);
+  RETURN_PTR_COMMENT(pSubTasks, ("listValid=%d, nChildren=%d\n", pNode->listValid, pNode->nChildren));
+}
+
+/* Compute the treeDigest of a node whose subtrees are all digested. Then do
+   the same for its parents, if it was the last subtree they were waiting for.
+   Called with the pool mutex locked. */
+void FinishDirNode(dirNode *pNode) {
+  while (pNode) {
+    digestState ds;
+    int i;
+
+    DigestInit(&ds);
+    DigestUpdate(&ds, pNode->listDigest, sizeof(pNode->listDigest));
+    for (i=0; i<pNode->nChildren; i++) {
+      dirNode *pChild = pNode->ppChildren[i];
+      DigestString(&ds, pChild->name);
+      DigestUpdate(&ds, pChild->treeDigest, sizeof(pChild->treeDigest));
+      if (!pChild->treeValid) pNode->treeValid = FALSE;
+    }
+    DigestFinal(&ds, pNode->treeDigest);
+    DEBUG_PRINTF(("// Digested tree %s: treeValid=%d\n", pNode->name, pNode->treeValid));
+
+    pNode = pNode->pParent;
+    if (pNode && --(pNode->nPending)) break; /* Other subtrees are still pending */
+  }
+}
+
+/* Digest directories from the pool, until there are none left */
+void *TreeWorker(void *pArg) {
+  treePool *pPool = (treePool *)pArg;
+  ARENA arena = {0};		/* This thread's own names arena */
+
+#if HAS_THREADS
+  pthread_mutex_lock(&pPool->mutex);
+#endif
+  while (1) {
+    treeTask *pTask, *pSubTasks;
+
+#if HAS_THREADS
+    /* Wait while others may still add subdirectories */
+    while (!pPool->pTasks && pPool->nBusy) pthread_cond_wait(&pPool->cond, &pPool->mutex);
+#endif
+    pTask = pPool->pTasks;
+    if (!pTask) break;		/* All done */
+    pPool->pTasks = pTask->pNext;
+    pPool->nBusy += 1;
+#if HAS_THREADS
+    pthread_mutex_unlock(&pPool->mutex);
+#endif
+
+    pSubTasks = DigestDir(pPool, pTask, &arena);
+
+#if HAS_THREADS
+    pthread_mutex_lock(&pPool->mutex);
+#endif
+    if (pSubTasks) {		/* Push them on the stack */
+      treeTask *pLast = pSubTasks;
+      while (pLast->pNext) pLast = pLast->pNext;
+      pLast->pNext = pPool->pTasks;
+      pPool->pTasks = pSubTasks;
+    } else {			/* This is a leaf. Its tree digest is complete. */
+      FinishDirNode(pTask->pNode);
+    }
+    pPool->nBusy -= 1;
+#if HAS_THREADS
+    if (pSubTasks || !pPool->nBusy) pthread_cond_broadcast(&pPool->cond);
+#endif
+    free(pTask->path);
+    free(pTask);
+  }
+#if HAS_THREADS
+  pthread_mutex_unlock(&pPool->mutex);
+#endif
+
+  ArenaFree(&arena);
+  return NULL;
+}
+
+int DigestTrees(char *dir1, char *dir2, char *pattern, int attrib,
+		time_t datemin, time_t datemax, t_opts opts, dirNode **ppRoots) {
+  char *dirs[2];
+  char paths[2][PATHNAME_SIZE];
+  char pattern2[NODENAME_SIZE];
+  treePool pool = {0};
+  t_opts quietOpts = opts;
+  int i;
+
+  DEBUG_ENTER(("DigestTrees(\"%s\", \"%s\", \"%s\", 0x%X, 0x%lX, 0x%lX, 0x%X, %p);\n",
+	       dir1, dir2, pattern, attrib, (unsigned long)datemin,
+	       (unsigned long)datemax, opts, ppRoots));
+
+  dirs[0] = dir1;
+  dirs[1] = dir2;
+  quietOpts.verbose = 0;	/* The comparison will report errors, if any */
+  for (i=0; i<2; i++) {
+    /* Resolve the paths sequentially, as this changes the current directory.
+       Give up on paths ending with a pattern, which descend() handles its own way. */
+    if (   !ResolveDir(dirs[i], PATTERN_ALL, paths[i], pattern2, quietOpts)
+	|| !streq(pattern2, PATTERN_ALL)) {
+      RETURN_INT_COMMENT(FALSE, ("Cannot digest %s\n", dirs[i]));
+    }
+  }
+
+  pool.pattern = pattern ? pattern : PATTERN_ALL;
+  pool.attrib = attrib;
+  pool.datemin = datemin;
+  pool.datemax = datemax;
+  pool.opts = opts;
+  for (i=1; i>=0; i--) {	/* Stack both roots, the left one on top */
+    treeTask *pTask = NewTreeTask(paths[i], "", NULL);
+    ppRoots[i] = pTask->pNode;
+    pTask->pNext = pool.pTasks;
+    pool.pTasks = pTask;
+  }
+
+#if HAS_THREADS
+  pthread_mutex_init(&pool.mutex, NULL);
+  pthread_cond_init(&pool.cond, NULL);
+  if (nJobs > 1) {
+    pthread_t *pThreads = (pthread_t *)malloc(nJobs * sizeof(pthread_t));
+    int nStarted = 1;		/* The main thread is one of the workers */
+    if (pThreads) {
+      for ( ; nStarted < nJobs; nStarted++) {
+	if (pthread_create(pThreads+nStarted, NULL, TreeWorker, &pool)) break;
+      }
+    }
+    TreeWorker(&pool);
+    for (i=1; i<nStarted; i++) pthread_join(pThreads[i], NULL);
+    free(pThreads);
+  } else
+#endif /* HAS_THREADS */
+  TreeWorker(&pool);
+#if HAS_THREADS
+  pthread_cond_destroy(&pool.cond);
+  pthread_mutex_destroy(&pool.mutex);
+#endif /* HAS_THREADS */
+
+  RETURN_INT(TRUE);
+}
+
+/* Find a subdirectory node. Usually the next one, as both are sorted alike */
+dirNode *FindSubNode(dirNode *pNode, char *pszName, int *piNext) {
+  int i;
+
+  for (i = *piNext; i < pNode->nChildren; i++) {
+    if (streq(pNode->ppChildren[i]->name, pszName)) {
+      *piNext = i+1;
+      return pNode->ppChildren[i];
+    }
+  }
+  return NULL;	/* The directory appeared since the digests were computed */
+}
+
+int SameLists(dirNode **ppNodes) {
+  return (   ppNodes && ppNodes[0] && ppNodes[1]
+	  && ppNodes[0]->listValid && ppNodes[1]->listValid
+	  && !memcmp(ppNodes[0]->listDigest, ppNodes[1]->listDigest, sizeof(ppNodes[0]->listDigest)));
+}
+
+int SameTrees(dirNode **ppNodes) {
+  return (   ppNodes && ppNodes[0] && ppNodes[1]
+	  && ppNodes[0]->treeValid && ppNodes[1]->treeValid
+	  && !memcmp(ppNodes[0]->treeDigest, ppNodes[1]->treeDigest, sizeof(ppNodes[0]->treeDigest)));
+}
+
+void FreeDirNode(dirNode *pNode) {
+  int i;
+
+  if (!pNode) return;
+  for (i=0; i<pNode->nChildren; i++) FreeDirNode(pNode->ppChildren[i]);
+  free(pNode->ppChildren);
+  free(pNode->name);
+  free(pNode);
+}
+
+#endif /* HAS_PRUNE */
+
+/******************************************************************************
+*                                                                             *
+*       Function:       SnapshotSave                                          *
+*                                                                             *
+*       Description:    Record a directory tree into a snapshot file          *
+*                                                                             *
+*       Arguments:                                                            *
+*                                                                             *
+*         char *pszFile		The snapshot file pathname                    *
+*         char *dir		The root directory of the tree                *
+*         t_opts opts		User-defined options                          *
+*                                                                             *
+*       Return value:   0=Success; -1=Failure, with errno set                 *
+*                                                                             *
+*       Notes:          Records all entries, whatever the pattern, dates, and *
+*                       attributes options. These filter the snapshot entries *
+*                       when it's compared, like they do for a live directory.*
+*                       With -c, also records the regular files digests.      *
+*                       Each directory entries are sorted by name, so that    *
+*                       SnapshotLoad() just maps the file, and the lookups    *
+*                       are binary searches in place.                         *
+*                                                                             *
+*       Updates:                                                              *
+*        2026-10-17 MAB Initial implementation.                               *
+*                                                                             *
+******************************************************************************/
+
+#if HAS_SNAPSHOT
+
+/* Append a string to the snapshot strings, and return its offset */
+uint64_t SnapAddString(snapWriter *pW, const char *pszString) {
+  size_t l = strlen(pszString) + 1;
+  uint64_t o = pW->lStrings;
+
+  if ((pW->lStrings + l) > pW->lStringsAlloc) {
+    uint64_t lNew = pW->lStringsAlloc ? 2 * pW->lStringsAlloc : 65536;
+    char *pNew;
+    while (lNew < (pW->lStrings + l)) lNew *= 2;
+    pNew = realloc(pW->pStrings, (size_t)lNew);
+    if (!pNew) finis(RETCODE_NO_MEMORY, "Out of memory for the snapshot");
+    pW->pStrings = pNew;
+    pW->lStringsAlloc = lNew;
+  }
+  memcpy(pW->pStrings + o, pszString, l);
+  pW->lStrings += l;
+  return o;
+}
+
+int CDECL cmpfifName(const fif **fif1, const fif **fif2) {
+  return strcmp((*fif1)->name, (*fif2)->name);
+}
+
+/* Record a directory and all its subdirectories. Returns its dcsDir index. */
+uint64_t SnapSaveDir(snapWriter *pW, char *path) {
+  ARENAMARK mark;
+  fifList list;
+  linkReader reader;
+  uint64_t iDir, iFirst;
+  int i;
+  NEW_PATHNAME_BUF(pathname);
+
+  DEBUG_ENTER(("SnapSaveDir(%p, \"%s\");\n", pW, path));
+
+#if PATHNAME_BUFS_IN_HEAP
+  if (!pathname) finis(RETCODE_NO_MEMORY, "Out of memory for the snapshot");
+#endif
+
+  ArenaMark(nameArena, &mark);
+  lis(path, PATTERN_ALL, 1, pW->attrib, 0, TIME_T_MAX, pW->opts, &list);
+  qsort(list.ppfif, list.nfif, sizeof(fif *), (CMPFUNC)cmpfifName);
+
+  /* Reserve the records for this directory and all its entries */
+  if (pW->nDirs == pW->nDirsAlloc) {
+    uint64_t nNew = pW->nDirsAlloc ? 2 * pW->nDirsAlloc : 1024;
+    dcsDir *pNew = realloc(pW->pDirs, (size_t)(nNew * sizeof(dcsDir)));
+    if (!pNew) finis(RETCODE_NO_MEMORY, "Out of memory for the snapshot");
+    pW->pDirs = pNew;
+    pW->nDirsAlloc = nNew;
+  }
+  if ((pW->nEntries + list.nfif) > pW->nEntriesAlloc) {
+    uint64_t nNew = pW->nEntriesAlloc ? 2 * pW->nEntriesAlloc : 16384;
+    dcsEntry *pNew;
+    while (nNew < (pW->nEntries + list.nfif)) nNew *= 2;
+    pNew = realloc(pW->pEntries, (size_t)(nNew * sizeof(dcsEntry)));
+    if (!pNew) finis(RETCODE_NO_MEMORY, "Out of memory for the snapshot");
+    pW->pEntries = pNew;
+    pW->nEntriesAlloc = nNew;
+  }
+  iDir = pW->nDirs++;
+  iFirst = pW->nEntries;
+  pW->nEntries += list.nfif;
+  pW->pDirs[iDir].iFirst = iFirst;
+  pW->pDirs[iDir].nEntries = (uint64_t)list.nfif;
+
+  InitLinkReader(&reader, path, nameArena);
+  for (i=0; i<list.nfif; i++) {
+    fif *pfif = list.ppfif[i];
+    dcsEntry *pE = pW->pEntries + iFirst + i;
+    memset(pE, 0, sizeof(dcsEntry));
+    pE->oName = SnapAddString(pW, pfif->name);
+    pE->size = (int64_t)pfif->size;
+    pE->mtime = (int64_t)pfif->mtime;
+    pE->mode = (uint32_t)pfif->mode;
+    if (S_ISLNK(pfif->mode)) {
+      ReadLinkTarget(&reader, pfif);
+      if (pfif->target) pE->oLink = SnapAddString(pW, pfif->target);
+    }
+    if (pW->opts.compare && S_ISREG(pfif->mode)) {
+      makepathname(pathname, path, pfif->name);
+      if (!DigestCacheGet(pDigestCache, pathname, pE->digest)) pE->flags |= DCS_DIGESTS;
+    }
+  }
+  FreeLinkReader(&reader);
+
+  /* Then record the subdirectories, after all the entries of this one */
+  for (i=0; i<list.nfif; i++) {
+    if (S_ISDIR(list.ppfif[i]->mode)) {
+      uint64_t iSubDir;
+      makepathname(pathname, path, list.ppfif[i]->name);
+      iSubDir = SnapSaveDir(pW, pathname);
+      pW->pEntries[iFirst + i].oLink = iSubDir + 1;
+    }
+  }
+
+  FreeFifArray(list.ppfif);
+  free(list.pFifs);
+  ArenaRelease(nameArena, &mark);
+  FREE_PATHNAME_BUF(pathname);
+  RETURN_LONG_COMMENT((long)iDir, ("%lu entries\n", (unsigned long)pW->pDirs[iDir].nEntries));
+}
+
+int SnapshotSave(char *pszFile, char *dir, t_opts opts) {
+  snapWriter w = {0};
+  dcsHeader hdr = {0};
+  char path[PATHNAME_SIZE];
+  char pattern2[NODENAME_SIZE];
+  char *pszTemp;
+  int iFile;
+  FILE *hf;
+  int iErr = 0;
+
+  if (!ResolveDir(dir, PATTERN_ALL, path, pattern2, opts)) {
+    errno = ENOENT;
+    return -1;
+  }
+  w.opts = opts;
+  w.opts.nobak = 0;		/* Record everything */
+  w.attrib = _A_SUBDIR | _A_SYSTEM | _A_HIDDEN | _A_LINK | _A_DEVICE;
+  SnapAddString(&w, "");	/* Offset 0 is the empty string */
+  SnapSaveDir(&w, path);
+
+  hdr.magic = DCS_MAGIC;
+  hdr.version = DCS_VERSION;
+  hdr.flags = opts.compare ? DCS_DIGESTS : 0;
+  hdr.nDirs = w.nDirs;
+  hdr.nEntries = w.nEntries;
+  hdr.lStrings = w.lStrings;
+
+  pszTemp = malloc(strlen(pszFile) + 8);
+  if (!pszTemp) goto cleanup_free;
+  sprintf(pszTemp, "%s.XXXXXX", pszFile);
+  iFile = mkstemp(pszTemp);
+  if (iFile < 0) goto cleanup_free;
+  {			/* mkstemp() creates it private. Use the usual permissions. */
+    mode_t mask = umask(0);
+    umask(mask);
+    fchmod(iFile, 0666 & ~mask);
+  }
+  hf = fdopen(iFile, "wb");
+  if (!hf) {
+    close(iFile);
+    goto cleanup_error;
+  }
+  if (   (fwrite(&hdr, sizeof(hdr), 1, hf) != 1)
+      || (fwrite(w.pDirs, sizeof(dcsDir), (size_t)w.nDirs, hf) != (size_t)w.nDirs)
+      || (fwrite(w.pEntries, sizeof(dcsEntry), (size_t)w.nEntries, hf) != (size_t)w.nEntries)
+      || (fwrite(w.pStrings, 1, (size_t)w.lStrings, hf) != (size_t)w.lStrings)
+      || fflush(hf)
+      || fsync(iFile)) {
+    iErr = errno;
+    fclose(hf);
+    errno = iErr;
+    goto cleanup_error;
+  }
+  if (fclose(hf)) goto cleanup_error;
+  if (rename(pszTemp, pszFile)) goto cleanup_error;
+  if (opts.verbose) {
+    printf("Recorded %lu directories and %lu entries in %s.",
+	   (unsigned long)w.nDirs, (unsigned long)w.nEntries, pszFile);
+    printflf();
+  }
+  free(pszTemp);
+  free(w.pDirs);
+  free(w.pEntries);
+  free(w.pStrings);
+  return 0;
+
+cleanup_error:
+  iErr = errno;
+  unlink(pszTemp);
+  errno = iErr;
+cleanup_free:
+  iErr = errno;
+  free(pszTemp);
+  free(w.pDirs);
+  free(w.pEntries);
+  free(w.pStrings);
+  errno = iErr;
+  return -1;
+}
+
+#endif /* HAS_SNAPSHOT */
+
+/******************************************************************************
+*                                                                             *
+*       Function:       SnapshotLoad                                          *
+*                                                                             *
+*       Description:    Map a snapshot file in memory                         *
+*                                                                             *
+*       Arguments:                                                            *
+*         snapshot *pSnap	The snapshot. pSnap->pszFile = Its pathname,  *
+*				possibly followed by a path inside it.        *
+*                                                                             *
+*       Return value:   0=Success; 1=Not a snapshot; -1=Invalid snapshot      *
+*                                                                             *
+*       Notes:          On success, pSnap->pszFile is the snapshot file name  *
+*                       alone, in a new string freed by SnapshotFree().       *
+*                       The records are used in place. Listing a directory    *
+*                       costs a binary search per path component, then one    *
+*                       fif per entry, pointing to the names in the mapping.  *
+*                                                                             *
+*       Updates:                                                              *
+*        2026-10-17 MAB Initial implementation.                               *
+*                                                                             *
+******************************************************************************/
+
+#if HAS_SNAPSHOT
+
+int SnapshotLoad(snapshot *pSnap) {
+  int iFile;
+  struct stat st;
+  const dcsHeader *pHdr;
+  uint32_t magic = 0;
+  void *pMap;
+  size_t lMap;
+  uint64_t i;
+  char *pszFile = strdup(pSnap->pszFile);
+
+  if (!pszFile) return 1;
+  /* Remove the path inside the snapshot, if any */
+  while ((iFile = open(pszFile, O_RDONLY | O_CLOEXEC)) < 0) {
+    char *pc = strrchr(pszFile, DIRSEPARATOR);
+    if ((errno != ENOTDIR) || !pc || (pc == pszFile)) {
+      free(pszFile);
+      return 1;
+    }
+    *pc = '\0';
+  }
+  if (   fstat(iFile, &st) || !S_ISREG(st.st_mode)
+      || (read(iFile, &magic, sizeof(magic)) != sizeof(magic))
+      || (magic != DCS_MAGIC)) {
+    close(iFile);
+    free(pszFile);
+    return 1;
+  }
+  pSnap->pszFile = pszFile;
+  if (st.st_size < (off_t)sizeof(dcsHeader)) {
+    close(iFile);
+    return -1;
+  }
+  lMap = (size_t)st.st_size;
+  pMap = mmap(NULL, lMap, PROT_READ, MAP_SHARED, iFile, 0);
+  close(iFile); /* The mapping remains valid */
+  if (pMap == MAP_FAILED) return -1;
+
+  pHdr = pMap;
+  pSnap->pMap = pMap;
+  pSnap->lMap = lMap;
+  if (   (pHdr->version != DCS_VERSION)
+      || (pHdr->nDirs < 1) || (pHdr->lStrings < 1)
+      /* Bound each count first, so that the sum below cannot overflow */
+      || (pHdr->nDirs > (lMap / sizeof(dcsDir)))
+      || (pHdr->nEntries > (lMap / sizeof(dcsEntry)))
+      || (pHdr->lStrings > lMap)
+      || ((sizeof(dcsHeader) + (pHdr->nDirs * sizeof(dcsDir))
+	   + (pHdr->nEntries * sizeof(dcsEntry)) + pHdr->lStrings) != lMap)) {
+    goto invalid;
+  }
+  pSnap->pHdr = pHdr;
+  pSnap->pDirs = (const dcsDir *)(pHdr + 1);
+  pSnap->pEntries = (const dcsEntry *)(pSnap->pDirs + pHdr->nDirs);
+  pSnap->pStrings = (const char *)(pSnap->pEntries + pHdr->nEntries);
+
+  /* Check the offsets once, so that lookups can trust them */
+  if (pSnap->pStrings[pHdr->lStrings - 1]) goto invalid;
+  for (i = 0; i < pHdr->nDirs; i++) {
+    const dcsDir *pDir = pSnap->pDirs + i;
+    uint64_t j;
+    if (   (pDir->iFirst > pHdr->nEntries)
+	|| (pDir->nEntries > (pHdr->nEntries - pDir->iFirst))) goto invalid;
+    /* Subdirectories are recorded after their parent. Requiring this
+       prevents loops back to the directory itself or to an ancestor. */
+    for (j = 0; j < pDir->nEntries; j++) {
+      const dcsEntry *pE = pSnap->pEntries + pDir->iFirst + j;
+      if (S_ISDIR(pE->mode) && pE->oLink && ((pE->oLink - 1) <= i)) goto invalid;
+    }
+  }
+  for (i = 0; i < pHdr->nEntries; i++) {
+    const dcsEntry *pE = pSnap->pEntries + i;
+    if (   (pE->oName >= pHdr->lStrings)
+	|| (S_ISDIR(pE->mode) ? (pE->oLink > pHdr->nDirs) : (pE->oLink >= pHdr->lStrings))) goto invalid;
+  }
+  return 0;
+
+invalid:
+  SnapshotFree(pSnap);
+  return -1;
+}
+
+void SnapshotFree(snapshot *pSnap) {
+  if (pSnap->pMap) munmap(pSnap->pMap, pSnap->lMap);
+  pSnap->pMap = NULL;
+  free(pSnap->pszFile);
+  pSnap->pszFile = NULL;
+}
+
+/* Find a directory in a snapshot. Returns its dcsDir index, or -1 if not found */
+long SnapFindDir(snapshot *pSnap, char *pszRelPath) {
+  uint64_t iDir = 0;	/* The root */
+  char *pszName = pszRelPath;
+
+  while (*pszName) {
+    const dcsDir *pDir = pSnap->pDirs + iDir;
+    size_t l;
+    uint64_t lo = 0;
+    uint64_t hi = pDir->nEntries;
+    const dcsEntry *pFound = NULL;
+
+    if (*pszName == DIRSEPARATOR) {
+      pszName += 1;
+      continue;
+    }
+    for (l = 0; pszName[l] && (pszName[l] != DIRSEPARATOR); l++) ;
+    while (lo < hi) { /* Binary search in the entries sorted by name */
+      uint64_t mid = lo + (hi - lo) / 2;
+      const dcsEntry *pE = pSnap->pEntries + pDir->iFirst + mid;
+      const char *pszEntry = pSnap->pStrings + pE->oName;
+      int dif = strncmp(pszEntry, pszName, l);
+      if (!dif && pszEntry[l]) dif = 1;
+      if (dif < 0) {
+	lo = mid + 1;
+      } else if (dif > 0) {
+	hi = mid;
+      } else {
+	pFound = pE;
+	break;
+      }
+    }
+    if (!pFound || !S_ISDIR(pFound->mode) || !pFound->oLink) return -1;
+    iDir = pFound->oLink - 1;
+    pszName += l;
+  }
+  return (long)iDir;
+}
+
+/******************************************************************************
+*                                                                             *
+*       Function:       SnapList                                              *
+*                                                                             *
+*       Description:    List a snapshot directory, like lis() does on disk    *
+*                                                                             *
+*       Arguments:                                                            *
+*                                                                             *
+*         snapshot *pSnap	The snapshot                                  *
+*         char *dir		The snapshot file name, then optionally a     *
+*				relative path, and optionally a pattern.      *
+*         Others		See lis().                                    *
+*                                                                             *
+*       Return value:   Number of files/directories in the fif array.         *
+*                                                                             *
+*       Notes:          Sets path1, as the left column is the snapshot.       *
+*                                                                             *
+*       Updates:                                                              *
+*        2026-10-17 MAB Initial implementation.                               *
+*                                                                             *
+******************************************************************************/
+
+int SnapList(snapshot *pSnap, char *dir, char *pattern, int attrib,
+	     time_t datemin, time_t datemax, t_opts opts, fifList *pList) {
+  size_t lFile = strlen(pSnap->pszFile);
+  char pattern2[NODENAME_SIZE];
+  FNMPATTERN fnmPattern;
+  const dcsDir *pDir;
+  fif *pFifs;
+  long iDir = -1;
+  int nfif = 0;
+  uint64_t i;
+
+  DEBUG_ENTER(("SnapList(%p, \"%s\", \"%s\", 0x%X, 0x%lX, 0x%lX, 0x%X, %p);\n", pSnap, dir, pattern,
+	       attrib, (unsigned long)datemin, (unsigned long)datemax, opts, pList));
+
+  pList->pFifs = NULL;
+  pList->ppfif = NULL;
+  pList->nfif = 0;
+  pList->iNext = 0;
+
+  strncpyz(path1, dir, PATHNAME_SIZE);
+  strncpyz(pattern2, pattern ? pattern : PATTERN_ALL, NODENAME_SIZE);
+  if (!strncmp(path1, pSnap->pszFile, lFile)) {
+    iDir = SnapFindDir(pSnap, path1 + lFile);
+    if (iDir < 0) {		/* See if this is because of a file name pattern */
+      char *pc = strrchr(path1 + lFile, DIRSEPARATOR);
+      if (pc) {
+	strncpyz(pattern2, pc+1, NODENAME_SIZE);
+	*pc = '\0';
+	iDir = SnapFindDir(pSnap, path1 + lFile);
+      }
+    }
+  }
+  if (iDir < 0) {
+    if (opts.verbose || !opts.cont) {
+      fprintf(stderr, "dirc: Error: Cannot access directory %s.\n", dir);
+    }
+    if (!opts.cont) finis(RETCODE_INACCESSIBLE, NULL);
+    RETURN_INT_COMMENT(0, ("Cannot access directory %s\n", dir));
+  }
+
+  pDir = pSnap->pDirs + iDir;
+  pFifs = (fif *)malloc((size_t)(pDir->nEntries + 1) * sizeof(fif));
+  if (!pFifs) finis(RETCODE_NO_MEMORY, "Out of memory for directory access");
+  if (FnmCompile(&fnmPattern, pattern2, FNM_CASEFOLD)) finis(RETCODE_NO_MEMORY, "Out of memory");
+  for (i = 0; i < pDir->nEntries; i++) {
+    const dcsEntry *pE = pSnap->pEntries + pDir->iFirst + i;
+    char *pszName = (char *)(pSnap->pStrings + pE->oName);
+    fif *pfif;
+
+    /* Apply the same filters as lis() */
+    if (   ((attrib & 0x8000) && !S_ISDIR(pE->mode))
+	|| (!(attrib & _A_SUBDIR) && S_ISDIR(pE->mode))
+	|| (FnmMatch(&fnmPattern, pszName) != FNM_MATCH)
+	|| (opts.nobak && isBackupFile(pszName))
+	|| ((time_t)pE->mtime < datemin)
+	|| ((time_t)pE->mtime > datemax)) {
+      continue;
+    }
+
+    pfif = pFifs + nfif++;
+    pfif->name = pszName;
+    pfif->key = FoldName(nameArena, pszName);
+    if (!pfif->key) finis(RETCODE_NO_MEMORY, "Out of memory for directory access");
+    pfif->keyPrefix = KeyPrefix(pfif->key);
+    pfif->size = (off_t)pE->size;
+    pfif->mtime = (time_t)pE->mtime;
+    pfif->mode = (unsigned int)pE->mode;
+    pfif->target = (S_ISLNK(pE->mode) && pE->oLink) ? (char *)(pSnap->pStrings + pE->oLink) : NULL;
+    pfif->pDigest = (pE->flags & DCS_DIGESTS) ? pE->digest : NULL;
+  }
+  FnmFree(&fnmPattern);
+
+  pList->pFifs = pFifs;
+  pList->ppfif = AllocFifArray(pFifs, nfif);
+  pList->nfif = nfif;
+  trie(pList->ppfif, nfif, opts);
+  RETURN_INT(nfif);
+}
+
+#endif /* HAS_SNAPSHOT */
+
+#if HAS_INOTIFY
+
+/******************************************************************************
+*                                                                             *
+*       Function:       WatchInit                                             *
+*                                                                             *
+*       Description:    Prepare watching both trees while comparing them      *
+*                                                                             *
+*       Arguments:                                                            *
+*                                                                             *
+*         watchState *pWatch	The watch state to initialize                 *
+*         char *dir1		Left directory                                *
+*         char *dir2		Right directory                               *
+*         char *pattern	Wildcard pattern, or NULL                     *
+*         int attrib		Search attributes. See lis().                 *
+*         time_t datemin	Minimal date, or 0 if no minimum.             *
+*         time_t datemax	Maximal date, or 0 if no maximum.             *
+*         t_opts opts		User-defined options.                         *
+*                                                                             *
+*       Return value:   TRUE if success, else FALSE and errno is set.         *
+*                                                                             *
+*       Notes:          The first comparison then records here the entries    *
+*                       that differ, with WatchRecordPairs(), and the         *
+*                       directories it lists, with WatchAddDir().             *
+*                       Then WatchLoop() reads the inotify events, and        *
+*                       compares again the entries they touched.              *
+*                       The entries are identified by their pathname relative *
+*                       to the roots, which is the same on both sides. So     *
+*                       the -K case-insensitive pairing does not apply here.  *
+*                                                                             *
+*       Updates:                                                              *
+*        2026-10-17 MAB Initial implementation.                               *
+*                                                                             *
+******************************************************************************/
+
+size_t HASH_KEY(diffEntry)(diffEntry *pEntry) {return HashString(pEntry->path);}
+int HASH_CMP(diffEntry)(diffEntry *pEntry1, diffEntry *pEntry2) {return strcmp(pEntry1->path, pEntry2->path);}
+HASH_DEFINE_PROCS(diffTable, diffEntry);
+
+int WatchInit(watchState *pWatch, char *dir1, char *dir2, char *pattern, int attrib,
+	      time_t datemin, time_t datemax, t_opts opts) {
+  char *dirs[2];
+  char patterns[2][NODENAME_SIZE];
+  NEW_PATHNAME_BUF(path);
+  int i;
+
+  DEBUG_ENTER(("WatchInit(%p, \"%s\", \"%s\", \"%s\", 0x%X, 0x%lX, 0x%lX, 0x%X);\n",
+	       pWatch, dir1, dir2, pattern, attrib,
+	       (unsigned long)datemin, (unsigned long)datemax, opts));
+
+#if PATHNAME_BUFS_IN_HEAP
+  if (!path) {
+    errno = ENOMEM;
+    RETURN_INT_COMMENT(FALSE, ("Out of memory\n"));
+  }
+#endif
+
+  dirs[0] = dir1;
+  dirs[1] = dir2;
+  for (i=0; i<2; i++) {
+    if (!ResolveDir(dirs[i], pattern, path, patterns[i], opts)) {
+      FREE_PATHNAME_BUF(path);
+      errno = ENOENT;
+      RETURN_INT_COMMENT(FALSE, ("Cannot access %s\n", dirs[i]));
+    }
+    pWatch->roots[i] = strdup(path);
+    if (!pWatch->roots[i]) finis(RETCODE_NO_MEMORY, "Out of memory");
+    pWatch->lRoots[i] = strlen(path);
+  }
+  FREE_PATHNAME_BUF(path);
+
+  pWatch->iFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (pWatch->iFd == -1) RETURN_INT_COMMENT(FALSE, ("inotify_init1() failed\n"));
+
+  if (FnmCompile(&pWatch->fnmPattern, patterns[0], FNM_CASEFOLD)) finis(RETCODE_NO_MEMORY, "Out of memory");
+  pWatch->pDiffs = new_diffEntry_hash();
+  pWatch->pPending = new_diffEntry_hash();
+  if (!pWatch->pDiffs || !pWatch->pPending) finis(RETCODE_NO_MEMORY, "Out of memory");
+  pWatch->ppszWdDirs = NULL;
+  pWatch->nWdDirs = 0;
+  pWatch->attrib = attrib;
+  pWatch->datemin = datemin;
+  pWatch->datemax = datemax;
+  pWatch->opts = opts;
+  pWatch->bFull = FALSE;
+
+  RETURN_INT(TRUE);
+}
+
+/* Get the pathname relative to a root, or NULL if it's not in that tree */
+char *WatchRelPath(watchState *pWatch, int side, char *pszPath) {
+  char *pszRoot = pWatch->roots[side];
+  size_t l = pWatch->lRoots[side];
+
+  if (strncmp(pszPath, pszRoot, l)) return NULL;
+  if (!pszPath[l]) return pszPath + l;
+  if (pszPath[l] == DIRSEPARATOR) return pszPath + l + 1;
+  if (l && (pszRoot[l-1] == DIRSEPARATOR)) return pszPath + l; /* The root is / */
+  return NULL;
+}
+
+/* Build the absolute pathname of a relative pathname in one tree */
+void WatchAbsPath(watchState *pWatch, int side, char *pszRel, char *pszBuf) {
+  if (*pszRel) {
+    makepathname(pszBuf, pWatch->roots[side], pszRel);
+  } else {
+    strncpyz(pszBuf, pWatch->roots[side], PATHNAME_SIZE);
+  }
+}
+
+/* Set path1 and path2 to the parent directories of a relative pathname */
+char *WatchSetPaths(watchState *pWatch, char *pszRel) {
+  NEW_PATHNAME_BUF(pszDir);
+  char *pszName = strrchr(pszRel, DIRSEPARATOR);
+
+#if PATHNAME_BUFS_IN_HEAP
+  if (!pszDir) finis(RETCODE_NO_MEMORY, "Out of memory");
+#endif
+
+  strncpyz(pszDir, pszRel, PATHNAME_SIZE);
+  pszDir[pszName ? (pszName - pszRel) : 0] = '\0';
+  WatchAbsPath(pWatch, 0, pszDir, path1);
+  WatchAbsPath(pWatch, 1, pszDir, path2);
+  FREE_PATHNAME_BUF(pszDir);
+  return pszName ? pszName + 1 : pszRel; /* The node name */
+}
+
+/******************************************************************************
+*                                                                             *
+*       Function:       WatchAddDir                                           *
+*                                                                             *
+*       Description:    Watch the changes in one directory                    *
+*                                                                             *
+*       Arguments:                                                            *
+*                                                                             *
+*         watchState *pWatch	The watch state                               *
+*         int side		0 = Left tree; 1 = Right tree                 *
+*         char *pszDir		The directory absolute pathname               *
+*                                                                             *
+*       Return value:   None                                                  *
+*                                                                             *
+*       Notes:          Watching the same directory again returns the same    *
+*                       watch descriptor, and just updates its pathname.      *
+*                       A directory moved within a tree keeps its watch, with *
+*                       its old pathname until it's watched again under the   *
+*                       new one. Since the events only tell which entries to  *
+*                       compare again, such stale pathnames cost a few        *
+*                       useless comparisons, but never wrong results.         *
+*                                                                             *
+*       Updates:                                                              *
+*        2026-10-17 MAB Initial implementation.                               *
+*                                                                             *
+******************************************************************************/
+
+void WatchAddDir(watchState *pWatch, int side, char *pszDir) {
+  char *pszRel = WatchRelPath(pWatch, side, pszDir);
+  int wd;
+
+  if (!pszRel || pWatch->bFull) return;
+  wd = inotify_add_watch(pWatch->iFd, pszDir, WATCH_EVENTS);
+  if (wd == -1) {
+    if (errno == ENOSPC) { /* Reached /proc/sys/fs/inotify/max_user_watches */
+      fprintf(stderr, "Warning: Cannot watch more than %d directories. Changes in the others will not be reported.\n", pWatch->nWdDirs);
+      pWatch->bFull = TRUE;
+    }
+    return;
+  }
+  if (wd >= pWatch->nWdDirs) {
+    int nNew = pWatch->nWdDirs ? 2 * pWatch->nWdDirs : 256;
+    char **ppszNew;
+    while (nNew <= wd) nNew *= 2;
+    ppszNew = (char **)realloc(pWatch->ppszWdDirs, nNew * sizeof(char *));
+    if (!ppszNew) finis(RETCODE_NO_MEMORY, "Out of memory for the watched directories");
+    memset(ppszNew + pWatch->nWdDirs, 0, (nNew - pWatch->nWdDirs) * sizeof(char *));
+    pWatch->ppszWdDirs = ppszNew;
+    pWatch->nWdDirs = nNew;
+  }
+  if (!pWatch->ppszWdDirs[wd] || !streq(pWatch->ppszWdDirs[wd], pszRel)) {
+    free(pWatch->ppszWdDirs[wd]);
+    pWatch->ppszWdDirs[wd] = strdup(pszRel);
+    if (!pWatch->ppszWdDirs[wd]) finis(RETCODE_NO_MEMORY, "Out of memory for the watched directories");
+  }
+}
+
+/******************************************************************************
+*                                                                             *
+*       Function:       WatchRecordPairs                                      *
+*                                                                             *
+*       Description:    Record the pairs that differ in the watch state       *
+*                                                                             *
+*       Arguments:                                                            *
+*                                                                             *
+*         watchState *pWatch	The watch state                               *
+*         fifPair *pPairs	The pairs compared in path1 and path2         *
+*         int nPairs		Number of pairs                               *
+*                                                                             *
+*       Return value:   None                                                  *
+*                                                                             *
+*       Notes:          Called by affiche() for every directory compared,     *
+*                       before the -b and -d options filter the display.      *
+*                                                                             *
+*       Updates:                                                              *
+*        2026-10-17 MAB Initial implementation.                               *
+*                                                                             *
+******************************************************************************/
+
+/* Set the last known difference of an entry. 0 = Same or absent */
+void WatchSetDiff(watchState *pWatch, char *pszPath, int difference) {
+  diffEntry entry = {0};
+  diffEntry *pEntry;
+  int bAdded;
+
+  entry.path = pszPath;
+  if (!difference) {
+    pEntry = get_diffEntry(pWatch->pDiffs, &entry);
+    if (pEntry) {
+      char *pszOld = pEntry->path;
+      remove_diffEntry(pWatch->pDiffs, &entry);
+      free(pszOld);
+    }
+    return;
+  }
+  pEntry = put_diffEntry(pWatch->pDiffs, &entry, &bAdded);
+  if (pEntry && bAdded) pEntry->path = strdup(pszPath);
+  if (!pEntry || !pEntry->path) finis(RETCODE_NO_MEMORY, "Out of memory for the differences");
+  pEntry->difference = difference;
+}
+
+void WatchRecordPairs(watchState *pWatch, fifPair *pPairs, int nPairs) {
+  NEW_PATHNAME_BUF(pathname);
+  char *pszDir = NULL;
+  int i;
+
+#if PATHNAME_BUFS_IN_HEAP
+  if (!pathname) finis(RETCODE_NO_MEMORY, "Out of memory");
+#endif
+
+  if (path1[0]) pszDir = WatchRelPath(pWatch, 0, path1);
+  if (!pszDir && path2[0]) pszDir = WatchRelPath(pWatch, 1, path2);
+  if (pszDir) {
+    for (i=0; i<nPairs; i++) {
+      fif *pfif = pPairs[i].pfif1 ? pPairs[i].pfif1 : pPairs[i].pfif2;
+      if (!pPairs[i].difference) continue;
+      makepathname(pathname, pszDir, pfif->name);
+      WatchSetDiff(pWatch, pathname, pPairs[i].difference);
+    }
+  }
+  FREE_PATHNAME_BUF(pathname);
+}
+
+/******************************************************************************
+*                                                                             *
+*       Function:       WatchQueue                                            *
+*                                                                             *
+*       Description:    Queue entries to compare again at the next report     *
+*                                                                             *
+*       Arguments:                                                            *
+*                                                                             *
+*         watchState *pWatch	The watch state                               *
+*         char *pszRel		The entry pathname relative to the roots      *
+*                                                                             *
+*       Return value:   None                                                  *
+*                                                                             *
+*       Notes:          The pending set merges the bursts of events about the *
+*                       same entry, so that it's compared only once per       *
+*                       report.                                               *
+*                       WatchQueueTree() queues a whole subtree on both sides,*
+*                       watching its directories, for directories created,    *
+*                       deleted, or moved; Plus the entries recorded as       *
+*                       different in it, which may exist on neither side now. *
+*                                                                             *
+*       Updates:                                                              *
+*        2026-10-17 MAB Initial implementation.                               *
+*                                                                             *
+******************************************************************************/
+
+void WatchQueue(watchState *pWatch, char *pszRel) {
+  diffEntry entry = {0};
+  diffEntry *pEntry;
+  int bAdded;
+
+  entry.path = pszRel;
+  pEntry = put_diffEntry(pWatch->pPending, &entry, &bAdded);
+  if (pEntry && bAdded) pEntry->path = strdup(pszRel);
+  if (!pEntry || !pEntry->path) finis(RETCODE_NO_MEMORY, "Out of memory for the changes");
+}
+
+void WatchQueueSide(watchState *pWatch, int side, char *pszRel) {
+  NEW_PATHNAME_BUF(pathname);
+  NEW_PATHNAME_BUF(relname);
+  DIR *pDir;
+  struct dirent *pDirent;
+
+#if PATHNAME_BUFS_IN_HEAP
+  if ((!pathname) || (!relname)) finis(RETCODE_NO_MEMORY, "Out of memory");
+#endif
+
+  WatchAbsPath(pWatch, side, pszRel, pathname);
+  WatchAddDir(pWatch, side, pathname); /* Watch it before listing it */
+  pDir = opendirx(pathname);
+  if (pDir) {
+    while ((pDirent = readdirx(pDir)) != NULL) {
+      if (streq(pDirent->d_name, ".") || streq(pDirent->d_name, "..")) continue;
+      makepathname(relname, pszRel, pDirent->d_name);
+      WatchQueue(pWatch, relname);
+      if (pDirent->d_type == DT_DIR) WatchQueueSide(pWatch, side, relname);
+    }
+    closedirx(pDir);
+  }
+  FREE_PATHNAME_BUF(pathname);
+  FREE_PATHNAME_BUF(relname);
+}
 
-  /* Display the date and time */
-  if (iYearWidth == 2) {
-    printf(" %02d-%02d-%02d %02d:%02d:%02d",
-	    an % 100, mois, jour, heure, minute, seconde);
-  } else {
-    printf(" %04d-%02d-%02d %02d:%02d:%02d",
-	    an, mois, jour, heure, minute, seconde);
+typedef struct {	    /* Arguments for WatchQueueDiff() */
+  watchState *pWatch;
+  char *pszPrefix;
+  size_t lPrefix;
+} watchPrefix;
+
+void *WatchQueueDiff(diffEntry *pEntry, void *ref) {
+  watchPrefix *pPrefix = (watchPrefix *)ref;
+  char *pszPath = pEntry->path;
+
+  if (   !pPrefix->lPrefix
+      || (   !strncmp(pszPath, pPrefix->pszPrefix, pPrefix->lPrefix)
+	  && (pszPath[pPrefix->lPrefix] == DIRSEPARATOR))) {
+    WatchQueue(pPrefix->pWatch, pszPath);
   }
-  RETURN_CONST(0);
+  return NULL;
+}
+
+void WatchQueueTree(watchState *pWatch, char *pszRel) {
+  watchPrefix prefix;
+
+  DEBUG_ENTER(("WatchQueueTree(%p, \"%s\");\n", pWatch, pszRel));
+
+  WatchQueueSide(pWatch, 0, pszRel);
+  WatchQueueSide(pWatch, 1, pszRel);
+  prefix.pWatch = pWatch;
+  prefix.pszPrefix = pszRel;
+  prefix.lPrefix = strlen(pszRel);
+  foreach_diffEntry(pWatch->pDiffs, WatchQueueDiff, &prefix);
+  RETURN();
 }
 
 /******************************************************************************
 *                                                                             *
-*       Function:       CompareToNext                                         *
+*       Function:       WatchRead                                             *
 *                                                                             *
-*       Description:    Compare a file date and time with the next entry      *
+*       Description:    Read the pending inotify events                       *
 *                                                                             *
 *       Arguments:                                                            *
-*         fif **ppfif   Sorted array of file info structure pointers          *
-*         t_opts opts	User-defined options		                      *
 *                                                                             *
-*       Return value:   0=Same file; <0 Older than next; >0 Newer than next.  *
+*         watchState *pWatch	The watch state                               *
 *                                                                             *
-*       Notes:                                                                *
+*       Return value:   None                                                  *
+*                                                                             *
+*       Notes:          Queues the entries that the events are about, and the *
+*                       directories in which entries were created or deleted, *
+*                       as their own time changed.                            *
+*                       If the kernel queue overflowed, then events were      *
+*                       lost, so queue both trees entirely.                   *
 *                                                                             *
 *       Updates:                                                              *
+*        2026-10-17 MAB Initial implementation.                               *
 *                                                                             *
 ******************************************************************************/
 
-int CompareToNext(fif **ppfif, t_opts opts) { /* Compare file date with next entry in fiflist */
-  long deltatime;                 /* Date and Time difference, in seconds */
-  int deltasize;                  /* Sign of the difference, or 0 if equal */
-  fif *pfif1;
-  fif *pfif2;
-  int dif;
-
-  pfif1 = ppfif[0];
-  pfif2 = ppfif[1];
-  DEBUG_ENTER(("CompareToNext(%p, 0x%X); // \"%s\" / \"%s\"\n", ppfif, opts, pfif1->name, pfif2?pfif2->name:""));
-  if (!pfif2) DEBUG_RETURN_INT(MISMATCH, "No next entry");	/* No next entry */
+void WatchRead(watchState *pWatch) {
+  union {			/* Ensure the events alignment */
+    struct inotify_event event;
+    char buf[16 * 1024];
+  } u;
+  NEW_PATHNAME_BUF(relname);
+  ssize_t n;
 
-  /* ~~jfl 95/06/12 Can't compare a file to a directory */
-  dif = S_ISDIR(pfif1->st.st_mode);
-  dif ^= S_ISDIR(pfif2->st.st_mode);
-  if (dif) DEBUG_RETURN_INT(MISMATCH, "Types differ");
-
-  /* Compare names, with or without case depending on command */
-  if (opts.nocase) {
-    dif = stricmp(pfif1->name, pfif2->name);
-  } else {
-    dif = strcmp(pfif1->name, pfif2->name);
-  }
-  if (dif) DEBUG_RETURN_INT(MISMATCH, "Names differ");	/* Names don't match */
-
-  deltatime = (long)pfif1->st.st_mtime;
-  deltatime -= (long)pfif2->st.st_mtime;
+#if PATHNAME_BUFS_IN_HEAP
+  if (!relname) finis(RETCODE_NO_MEMORY, "Out of memory");
+#endif
 
-  if (pfif1->st.st_size < pfif2->st.st_size) {
-    deltasize = -1;
-  } else if (pfif1->st.st_size > pfif2->st.st_size) {
-    deltasize = 1;
-  } else {
-    deltasize = 0;
-  }
+  while ((n = read(pWatch->iFd, u.buf, sizeof(u.buf))) > 0) {
+    char *pc;
+    struct inotify_event *pEvent;
 
-  /* If in filecomp mode, check if same data files with different dates */
-  if (opts.compare && !deltasize && !S_ISDIR(pfif1->st.st_mode)) { /* Let the actual data decide */
-    NEW_PATHNAME_BUF(name1);
-    NEW_PATHNAME_BUF(name2);
+    for (pc = u.buf; pc < (u.buf + n); pc += sizeof(struct inotify_event) + pEvent->len) {
+      char *pszDir;
 
-    makepathname(name1, path1, pfif1->name);
-    makepathname(name2, path2, pfif2->name);
-    dif = filecompare(name1, name2);
-    FREE_PATHNAME_BUF(name1);
-    FREE_PATHNAME_BUF(name2);
-    if (!dif) {
-      if (deltatime && opts.dtime) {
-	DEBUG_RETURN_INT(DATE_MISMATCH, "Contents are identical but dates differ");
+      pEvent = (struct inotify_event *)pc;
+      DEBUG_PRINTF(("// inotify wd=%d mask=0x%X name=\"%s\"\n", pEvent->wd, pEvent->mask,
+		    pEvent->len ? pEvent->name : ""));
+      if (pEvent->mask & IN_Q_OVERFLOW) {
+	WatchQueueTree(pWatch, "");
+	continue;
+      }
+      if ((pEvent->wd < 0) || (pEvent->wd >= pWatch->nWdDirs)) continue;
+      pszDir = pWatch->ppszWdDirs[pEvent->wd];
+      if (!pszDir) continue;
+      if (pEvent->mask & IN_IGNORED) { /* The directory is not watched anymore */
+	free(pszDir);
+	pWatch->ppszWdDirs[pEvent->wd] = NULL;
+	continue;
+      }
+      if (!pEvent->len || !pEvent->name[0]) { /* An event about the directory itself */
+	if (*pszDir) WatchQueue(pWatch, pszDir);
+	continue;
+      }
+      if (*pszDir && (pEvent->mask & (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO))) {
+	WatchQueue(pWatch, pszDir);	/* Its time changed */
+      }
+      makepathname(relname, pszDir, pEvent->name);
+      WatchQueue(pWatch, relname);
+      if (   (pEvent->mask & IN_ISDIR)
+	  && (pEvent->mask & (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO))) {
+	WatchQueueTree(pWatch, relname);
       }
-      DEBUG_RETURN_INT(0, "Contents are identical"); /* They are actually identical */
     }
-    if (deltatime) DEBUG_RETURN_INT(SIGN(deltatime), "Timestamps and contents differ");
-    DEBUG_RETURN_INT(SIGN(dif), "Contents differ");
   }
+  FREE_PATHNAME_BUF(relname);
+}
 
-  /* If same file name, compare date and time */
-  if (!opts.notime && deltatime) {     /* If comparison expected, and there is a difference */
-    int sign;               /* Sign of deltatime */
+/******************************************************************************
+*                                                                             *
+*       Function:       WatchCompare                                          *
+*                                                                             *
+*       Description:    Compare again an entry of the watched trees           *
+*                                                                             *
+*       Arguments:                                                            *
+*                                                                             *
+*         watchState *pWatch	The watch state                               *
+*         char *pszRel		The entry pathname relative to the roots      *
+*         watchChange *pChange	Where to store the new status                 *
+*                                                                             *
+*       Return value:   TRUE if its status changed, else FALSE                *
+*                                                                             *
+*       Notes:          Applies the same filters as lis(), so that an entry   *
+*                       is compared only if the first comparison would have   *
+*                       listed it.                                            *
+*                       Sets path1 and path2 to the entry parent directories, *
+*                       as CompareFifs() and affiche1() expect.               *
+*                       The fif names point into pszRel, so it must not be    *
+*                       freed before the change is displayed.                 *
+*                                                                             *
+*       Updates:                                                              *
+*        2026-10-17 MAB Initial implementation.                               *
+*                                                                             *
+******************************************************************************/
 
-    sign = (deltatime > 0) ? 1 : -1;        /* Sign of the difference */
+int WatchCompare(watchState *pWatch, char *pszRel, watchChange *pChange) {
+  NEW_PATHNAME_BUF(pathname);
+  char *paths[2];
+  fif *pfifs[2];
+  char *pszName;
+  diffEntry entry = {0};
+  diffEntry *pOld;
+  int difference = 0;
+  int i;
 
-    if (opts.notz) {   /* Special case if we wish to ignore time-zone differences */
-      /* Ignore differences that are an integer number of hours  less than 24 hours */
-      int deltaseconds;
+  DEBUG_ENTER(("WatchCompare(%p, \"%s\", %p);\n", pWatch, pszRel, pChange));
 
-      deltaseconds = (int)(deltatime % 3600);
-      if (deltaseconds < 0) deltaseconds += 3600;
-      deltatime /= 3600;                   /* Convert difference to hours */
-      if ((deltatime > 23) || (deltatime < -23))
-	  DEBUG_RETURN_INT(sign, "Timestamps differ > 1 day"); /* More than 1 day of diff. */
-      switch (deltaseconds) { // ~~jfl 1996-09-16
-	case 0:
-	case 2:
-	case 3600-2:
-	/* Assume the difference isn't meaningful. Go compare the size. */
-	break;
-	default:
-	DEBUG_RETURN_INT(sign, "Timestamps differ > 2 seconds");
-      }
-    } else {      /* Common case where any date & time difference counts */
-      DEBUG_RETURN_INT(sign, "Timestamps differ");
+#if PATHNAME_BUFS_IN_HEAP
+  if (!pathname) finis(RETCODE_NO_MEMORY, "Out of memory");
+#endif
+
+  pszName = WatchSetPaths(pWatch, pszRel);
+  paths[0] = path1;
+  paths[1] = path2;
+  for (i=0; i<2; i++) {
+    fif *pfif = pChange->fifs + i;
+    struct stat st;
+
+    pfifs[i] = NULL;
+    makepathname(pathname, paths[i], pszName);
+    if (pStat(pathname, &st)) continue;
+    if (   (S_ISDIR(st.st_mode) && !(pWatch->attrib & _A_SUBDIR))
+	|| (FnmMatch(&pWatch->fnmPattern, pszName) != FNM_MATCH)
+	|| (pWatch->opts.nobak && isBackupFile(pszName))
+	|| (st.st_mtime < pWatch->datemin)
+	|| (st.st_mtime > pWatch->datemax)) {
+      continue;		/* lis() would not list it */
     }
+    memset(pfif, 0, sizeof(fif));
+    pfif->name = pfif->key = pszName;
+    pfif->keyPrefix = KeyPrefix(pszName);
+    pfif->size = st.st_size;
+    pfif->mtime = st.st_mtime;
+    pfif->mode = st.st_mode;
+    pfifs[i] = pfif;
   }
+  FREE_PATHNAME_BUF(pathname);
 
-  /* If same date & time, compare size */
-  if (deltasize) DEBUG_RETURN_INT(deltasize, "Sizes differ (yet times match)");
-
-  DEBUG_RETURN_INT(0, "Same files");
+  if (pfifs[0] && pfifs[1]) {
+    difference = CompareFifs(pfifs[0], pfifs[1], pWatch->opts);
+  } else if (pfifs[0] || pfifs[1]) {
+    difference = MISMATCH;
+  }
+  pChange->path = pszRel;
+  pChange->pair.pfif1 = pfifs[0];
+  pChange->pair.pfif2 = pfifs[1];
+  pChange->pair.difference = difference;
+
+  entry.path = pszRel;
+  pOld = get_diffEntry(pWatch->pDiffs, &entry);
+  if (pOld ? (pOld->difference == difference) : !difference) {
+    RETURN_INT_COMMENT(FALSE, ("Unchanged\n"));
+  }
+  WatchSetDiff(pWatch, pszRel, difference);
+  RETURN_INT_COMMENT(TRUE, ("difference = %d\n", difference));
 }
 
 /******************************************************************************
 *                                                                             *
-*       Function:       filecompare                                           *
+*       Function:       WatchReport                                           *
 *                                                                             *
-*       Description:    Compare the contents of two files                     *
+*       Description:    Compare again the queued entries, and report changes  *
 *                                                                             *
 *       Arguments:                                                            *
 *                                                                             *
-*         char *name1   Pathname of first file                                *
-*         char *name2   Pathname of second file                               *
+*         watchState *pWatch	The watch state                               *
 *                                                                             *
-*       Return value:   0=Same contents                                       *
-*                       1/-1=Length difference                                *
-*                       2/-2=Data difference                                  *
-*                       3/-3=One of the files is missing                      *
+*       Return value:   The number of entries whose status changed            *
 *                                                                             *
-*       Notes:                                                                *
+*       Notes:          The entries are displayed by directory, like in the   *
+*                       first comparison, but regardless of options -b and    *
+*                       -d, so that the entries that became identical, or     *
+*                       present on one side only, are reported too.           *
+*                       The entries deleted on both sides are reported by     *
+*                       name only.                                            *
 *                                                                             *
 *       Updates:                                                              *
-*        1995-06-12 JFL Made this routine generic (Independant of DIRC)       *
-*        2014-01-21 JFL Use a much larger buffer for 32-bits apps, to improve *
-*                       performance.                                          *
+*        2026-10-17 MAB Initial implementation.                               *
 *                                                                             *
 ******************************************************************************/
 
-#ifdef _MSDOS		/* If it's a 16-bits app, use a 4K buffer. */
-#define FBUFSIZE 4096
-#else			/* Else for 32-bits or 64-bits apps, use a 4M buffer */
-#define FBUFSIZE (4096 * 1024)
-#endif
+typedef struct {	    /* Arguments for WatchTakePending() */
+  char **ppszPaths;
+  size_t nPaths;
+} watchPaths;
 
-int filecompare(char *name1, char *name2) { /* Compare two files */
-  static char *pbuf1 = NULL;
-  static char *pbuf2 = NULL;
-  FILE *f1;
-  FILE *f2;
-  size_t l1, l2;
-  int dif;
+void *WatchTakePending(diffEntry *pEntry, void *ref) {
+  watchPaths *pPaths = (watchPaths *)ref;
+  pPaths->ppszPaths[pPaths->nPaths++] = pEntry->path;
+  return NULL;
+}
 
-  DEBUG_ENTER(("filecompare(\"%s\", \"%s\");\n", name1, name2));
+/* Sort relative pathnames by parent directory, then by name */
+int CDECL cmpRelPath(const char **ppsz1, const char **ppsz2) {
+  const char *pszName1 = strrchr(*ppsz1, DIRSEPARATOR);
+  const char *pszName2 = strrchr(*ppsz2, DIRSEPARATOR);
+  size_t l1 = pszName1 ? (size_t)(pszName1 - *ppsz1) : 0;
+  size_t l2 = pszName2 ? (size_t)(pszName2 - *ppsz2) : 0;
+  int ret = strncmp(*ppsz1, *ppsz2, (l1 < l2) ? l1 : l2);
 
-  if (!pbuf1) {
-    pbuf1 = (char *)malloc(FBUFSIZE);
-    pbuf2 = (char *)malloc(FBUFSIZE);
-    if (!pbuf2) {
-      finis(RETCODE_NO_MEMORY, "Out of memory");   /* Note: This is still DIRC-specific */
+  if (ret) return ret;
+  if (l1 != l2) return (l1 < l2) ? -1 : 1;
+  return strcmp(pszName1 ? pszName1+1 : *ppsz1, pszName2 ? pszName2+1 : *ppsz2);
+}
+
+int WatchReport(watchState *pWatch) {
+  watchPaths paths;
+  watchChange *pChanges;
+  fifPair *pPairs;
+  int nChanges = 0;
+  int iChange, jChange;
+  ARENAMARK marks[2];
+  t_opts opts = pWatch->opts;
+  time_t tNow;
+  struct tm *pTime;
+  size_t i;
+
+  DEBUG_ENTER(("WatchReport(%p);\n", pWatch));
+
+  /* Take the pending entries, and start gathering the next ones */
+  paths.nPaths = 0;
+  paths.ppszPaths = (char **)malloc((num_diffEntry(pWatch->pPending) + 1) * sizeof(char *));
+  if (!paths.ppszPaths) finis(RETCODE_NO_MEMORY, "Out of memory for the changes");
+  foreach_diffEntry(pWatch->pPending, WatchTakePending, &paths);
+  free_diffEntry_hash(pWatch->pPending);
+  pWatch->pPending = new_diffEntry_hash();
+  if (!pWatch->pPending) finis(RETCODE_NO_MEMORY, "Out of memory for the changes");
+  qsort(paths.ppszPaths, paths.nPaths, sizeof(char *), (CMPFUNC)cmpRelPath);
+
+  /* Compare them again */
+  pChanges = (watchChange *)malloc((paths.nPaths + 1) * sizeof(watchChange));
+  pPairs = (fifPair *)malloc((paths.nPaths + 1) * sizeof(fifPair));
+  if (!pChanges || !pPairs) finis(RETCODE_NO_MEMORY, "Out of memory for the changes");
+  for (i=0; i<paths.nPaths; i++) {
+    if (WatchCompare(pWatch, paths.ppszPaths[i], pChanges + nChanges)) {
+      nChanges += 1;
+    } else {
+      free(paths.ppszPaths[i]);
     }
   }
-
-  /* For links, compare the link targets */
-#if defined(S_ISLNK) && S_ISLNK(S_IFLNK) /* In DOS it's defined, but always returns 0 */
-  {
-    int err1, err2;
-    struct stat st1;
-    struct stat st2;
-    err1 = lstat(name1, &st1);
-    err2 = lstat(name2, &st2);
-    if ((!err1) && S_ISLNK(st1.st_mode) && (!err2) && S_ISLNK(st2.st_mode)) {
-#if defined(_WIN32) && _MSVCLIBX_STAT_DEFINED
-      if ((st1.st_Win32Attrs & FILE_ATTRIBUTE_DIRECTORY) && (st2.st_Win32Attrs & FILE_ATTRIBUTE_DIRECTORY))
-#else
-      err1 = stat(name1, &st1);
-      err2 = stat(name2, &st2);
-      if (err1 && err2) RETURN_INT_COMMENT(0, ("Both dead links. Ignore.\n"));
-      if (err1) RETURN_INT_COMMENT(-3, ("The first link is dead.\n"));
-      if (err2) RETURN_INT_COMMENT( 3, ("The second link is dead.\n"));
-      if (S_ISDIR(st1.st_mode) && S_ISDIR(st2.st_mode))
-#endif
-	{
-	int n1 = (int)readlink(name1, pbuf1, FBUFSIZE);
-	int n2 = (int)readlink(name2, pbuf2, FBUFSIZE);
-	if ((n1 == -1) && (n2 == -1)) RETURN_INT_COMMENT(0, ("Both dead links. Ignore.\n"));
-	if (n1 == -1) RETURN_INT_COMMENT(-3, ("The first link is dead.\n"));
-	if (n2 == -1) RETURN_INT_COMMENT( 3, ("The second link is dead.\n"));
-	pbuf1[n1] = '\0';
-	pbuf2[n2] = '\0';
-	dif = strcmp(pbuf1, pbuf2);
-	RETURN_INT_COMMENT(dif, ("Link targets are %s\n", dif ? "different" : "identical"));
+  free(paths.ppszPaths);
+
+  /* Display the changes, by directory */
+  opts.diff = 0;
+  opts.both = 0;
+  MarkNameArenas(marks);
+  for (iChange = 0; iChange < nChanges; iChange = jChange) {
+    char *pszName = strrchr(pChanges[iChange].path, DIRSEPARATOR);
+    size_t lDir = pszName ? (size_t)(pszName - pChanges[iChange].path) : 0;
+    int nPairs = 0;
+    int paths_done = FALSE;
+
+    for (jChange = iChange; jChange < nChanges; jChange++) {
+      watchChange *pChange = pChanges + jChange;
+      if (   strncmp(pChange->path, pChanges[iChange].path, lDir)
+	  || (strrchr(pChange->path, DIRSEPARATOR) != (lDir ? pChange->path + lDir : NULL))) {
+	break;		/* It's in another directory */
+      }
+      if (pChange->pair.pfif1 || pChange->pair.pfif2) pPairs[nPairs++] = pChange->pair;
+    }
+    WatchSetPaths(pWatch, pChanges[iChange].path); /* Display their parent dirs */
+    affichePairs(pPairs, nPairs, 2, &paths_done, opts);
+    for ( ; iChange < jChange; iChange++) {
+      watchChange *pChange = pChanges + iChange;
+      if (!pChange->pair.pfif1 && !pChange->pair.pfif2) {
+	if (!paths_done) {
+	  affichePaths();
+	  paths_done = TRUE;
+	}
+	printf("%s: No longer on either side", pChange->path + lDir + (lDir ? 1 : 0));
+	printflf();
       }
+      free(pChange->path);
     }
   }
-#endif // OS supporting links
+  ReleaseNameArenas(marks);
+  free(pChanges);
+  free(pPairs);
 
-  /* For files or links to files, compare the data itself */
-  f1 = fopen(name1, "rb");
-  f2 = fopen(name2, "rb");
-  if ((!f1) && (!f2)) RETURN_INT_COMMENT(0, ("Neither file exists.\n"));
-  if (!f1) {
-    fclose(f2);
-    RETURN_INT_COMMENT(-3, ("The first file does not exist.\n"));
+  if (nChanges || opts.verbose) {
+    tNow = time(NULL);
+    pTime = localtime(&tNow);
+    printflf();
+    printf("%04d-%02d-%02d %02d:%02d:%02d  %d entries changed.",
+	   pTime->tm_year + 1900, pTime->tm_mon + 1, pTime->tm_mday,
+	   pTime->tm_hour, pTime->tm_min, pTime->tm_sec, nChanges);
+    printflf();
+    fflush(stdout);
   }
-  if (!f2) {
-    fclose(f1);
-    RETURN_INT_COMMENT( 3, ("The second file does not exist.\n"));
+  RETURN_INT(nChanges);
+}
+
+/******************************************************************************
+*                                                                             *
+*       Function:       WatchLoop                                             *
+*                                                                             *
+*       Description:    Report the changes in both trees until interrupted    *
+*                                                                             *
+*       Arguments:                                                            *
+*                                                                             *
+*         watchState *pWatch	The watch state                               *
+*                                                                             *
+*       Return value:   Does not return                                       *
+*                                                                             *
+*       Notes:          The first event after a report starts a delay of      *
+*                       iDelay seconds, during which all events are gathered. *
+*                       So a burst of changes gives a single report, at most  *
+*                       iDelay seconds late.                                  *
+*                       The events that occurred during the first comparison  *
+*                       are in the inotify queue already, so the first report *
+*                       catches up with the changes that this one missed.     *
+*                                                                             *
+*       Updates:                                                              *
+*        2026-10-17 MAB Initial implementation.                               *
+*                                                                             *
+******************************************************************************/
+
+void WatchLoop(watchState *pWatch) {
+  struct pollfd pfd;
+  time_t tReport = 0;		/* When the next report is due. 0=None pending */
+
+  DEBUG_ENTER(("WatchLoop(%p);\n", pWatch));
+
+  if (pWatch->opts.verbose) {
+    printflf();
+    printf("Watching %s and %s. Press Ctrl-C to stop.", pWatch->roots[0], pWatch->roots[1]);
+    printflf();
   }
+  fflush(stdout);
 
-  dif = 0;
-  while ((l1 = fread(pbuf1, 1, FBUFSIZE, f1)) != 0) {
-    l2 = fread(pbuf2, 1, FBUFSIZE, f2);
-    if (l1 > l2) {dif = 1; break;}
-    if (l1 < l2) {dif = -1; break;}
-    dif = memcmp(pbuf1, pbuf2, l1);
-    if (dif) {
-      dif = (dif > 0) ? 2 : -2;
-      break;   /* If different data found, return immediately */
+  pfd.fd = pWatch->iFd;
+  pfd.events = POLLIN;
+  while (1) {
+    int iTimeout = -1;		/* Wait for the first event */
+
+    if (num_diffEntry(pWatch->pPending)) {
+      time_t tNow = time(NULL);
+      if (!tReport) tReport = tNow + pWatch->iDelay;
+      if (tNow >= tReport) {
+	WatchReport(pWatch);
+	tReport = 0;
+	continue;
+      }
+      iTimeout = (int)(tReport - tNow) * 1000;
+    }
+    pfd.revents = 0;
+    if (poll(&pfd, 1, iTimeout) == -1) {
+      if (errno == EINTR) continue;
+      finis(RETCODE_INACCESSIBLE, "Cannot watch the directories. %s", strerror(errno));
     }
+    if (pfd.revents & POLLIN) WatchRead(pWatch);
   }
-
-  fclose(f1);
-  fclose(f2);
-
-  RETURN_INT_COMMENT(dif, ("Files are %s\n", dif ? "different" : "identical"));
 }
 
+#endif /* HAS_INOTIFY */
+
 /******************************************************************************
 *                                                                             *
 *       Function:       descend                                               *
@@ -2107,30 +5158,37 @@ int filecompare(char *name1, char *name2) { /* Compare two files */
 *         t_opts opts		User-defined options	                      *
 *	  time_t datemin	First date to consider			      *
 *	  time_t datemax	Last date to consider			      *
+*	  dirNode **ppNodes	Left and right digests, or NULL if none.      *
 *                                                                             *
 *       Return value:   0=Success; !0=Failure                                 *
 *                                                                             *
-*       Notes:                                                                *
+*       Notes:          With digests, skip the identical subtrees, and do not *
+*                       list the directories with identical files lists.      *
 *                                                                             *
 *       Updates:                                                              *
 *	 1993-10-15 JFL  Initial implementation 			      *
 *	 1994-03-17 JFL  Rewritten to recurse within the same appli. instance.*
+*	 2026-10-17 MAB  Added the ppNodes argument.			      *
 *                                                                             *
 ******************************************************************************/
 
 int descend(char *from, char *to, char *pattern,
                 int attrib, t_opts opts,
-		time_t datemin, time_t datemax) {
-  int nfif;
-  int i;
-  fif **directories;
-  fif **ppfif;
-  uint16_t wFlags = 0x8000 | _A_SUBDIR | _A_SYSTEM | _A_HIDDEN;
+		time_t datemin, time_t datemax,
+		dirNode **ppNodes) {
+  fifList directories[2];
+  fifList files[2];
+  fif *pfif1;
+  fif *pfif2;
+  ARENAMARK dirsMarks[2], filesMarks[2];
+  uint16_t wFlags = SUBDIRS_ATTRIB;
+  dirNode *subNodes[2];
+  int iNext1 = 0, iNext2 = 0;	/* Where to search the next subNodes */
   NEW_PATHNAME_BUF(name1);
   NEW_PATHNAME_BUF(name2);
 
-  DEBUG_ENTER(("descend(\"%s\", \"%s\", \"%s\", 0x%X, 0x%X, 0x%lX, 0x%lX);\n", from, to, pattern,
-	       attrib, opts, (unsigned long)datemin, (unsigned long)datemax));
+  DEBUG_ENTER(("descend(\"%s\", \"%s\", \"%s\", 0x%X, 0x%X, 0x%lX, 0x%lX, %p);\n", from, to, pattern,
+	       attrib, opts, (unsigned long)datemin, (unsigned long)datemax, ppNodes));
 
 #if PATHNAME_BUFS_IN_HEAP
   if ((!name1) || (!name2)) {
@@ -2141,70 +5199,59 @@ int descend(char *from, char *to, char *pattern,
 #endif
 
   /* Get all subdirectories */
-  nfif = 0;
-  if (from) nfif = lis(from, PATTERN_ALL, nfif, 1, wFlags, 0, TIME_T_MAX, opts);
-  if (to) nfif = lis(to, PATTERN_ALL, nfif, 2, wFlags, 0, TIME_T_MAX, opts);
-  directories = AllocFifArray(nfif);
-  trie(directories, nfif, opts);
+  MarkNameArenas(dirsMarks);
+  ListDirs(from, to, PATTERN_ALL, wFlags, 0, TIME_T_MAX, opts, directories);
 
-  for (i=0; i<nfif; i++) {
+  while (MergeNext(directories, &pfif1, &pfif2, opts)) {
     char *pname1;
     char *pname2;
-    char *pn1;
-    int nfif2;
     int ndir;
 
-    pn1 = directories[i]->name;
+    if (opts.both && !(pfif1 && pfif2)) {
+      DEBUG_PRINTF(("// There is no directory %s in %s\n",
+		 pfif1 ? pfif1->name : pfif2->name, pfif1 ? to : from));
+      continue;                    /* If both and no matching dir, skip */
+    }
+
+    subNodes[0] = subNodes[1] = NULL;
+    if (ppNodes) {
+      if (pfif1) subNodes[0] = FindSubNode(ppNodes[0], pfif1->name, &iNext1);
+      if (pfif2) subNodes[1] = FindSubNode(ppNodes[1], pfif2->name, &iNext2);
+    }
+    if (SameTrees(subNodes)) {
+      DEBUG_PRINTF(("// Skipping identical subtrees %s\n", pfif1->name));
+      lNTreesPruned += 1;
+      continue;
+    }
+
     path1[0] = path2[0] = '\0'; /* Cleanup static title buffers */
     pname1 = pname2 = NULL;
-    ndir = 1;
-    if (from) {
-      makepathname(name1, from, pn1);
+    ndir = to ? 2 : 1;
+    if (pfif1) {
+      makepathname(name1, from, pfif1->name);
       pname1 = name1;
       DEBUG_PRINTF(("// Descent possible into %s\n", name1));
     }
-    name2[0] = '\0';
-    if (to) {
-      makepathname(name2, to, pn1);
+    if (pfif2) {
+      makepathname(name2, to, pfif2->name);
       pname2 = name2;
-      ndir = 2;
-      DEBUG_PRINTF(("// and into %s\n", name2));
-    }
-    if (   to
-	 && ((i+1) < nfif)
-	 && (opts.nocase ?
-		!stricmp(directories[i]->name, directories[i+1]->name)
-	      : streq(directories[i]->name, directories[i+1]->name)  ) ) {
-      /* Both subdirectories match */
-      i += 1;
-      nfif2 = lis(name1, pattern, 0, 1, attrib, datemin, datemax, opts);
-      if (to) nfif2 = lis(name2, pattern, nfif2, 2, attrib, datemin, datemax, opts);
-      ppfif = AllocFifArray(nfif2);
-      trie(ppfif, nfif2, opts);
-      affiche(ppfif, nfif2, ndir, opts);
-      FreeFifArray(ppfif);
-
-      descend(pname1, pname2, pattern, attrib, opts, datemin, datemax);
-    } else if (!opts.both) {
-      DEBUG_PRINTF(("// There is no directory %s",
-		 (directories[i]->column == 1) ? name2 : name1));
-      if (directories[i]->column == 1) {
-	pname2 = NULL;
-	nfif2 = lis(name1, pattern, 0, 1, attrib, datemin, datemax, opts);
-      } else {
-	pname1 = NULL;
-	nfif2 = lis(name2, pattern, 0, 2, attrib, datemin, datemax, opts);
-      }
-      ppfif = AllocFifArray(nfif2);
-      trie(ppfif, nfif2, opts);
-      affiche(ppfif, nfif2, ndir, opts);
-      FreeFifArray(ppfif);
+      DEBUG_PRINTF(("// Descent possible into %s\n", name2));
+    }
 
-      descend(pname1, pname2, pattern, attrib, opts, datemin, datemax);
+    if (!SameLists(subNodes)) {
+      MarkNameArenas(filesMarks);
+      ListDirs(pname1, pname2, pattern, attrib, datemin, datemax, opts, files);
+      affiche(files, ndir, opts);
+      FreeFifLists(files);
+      ReleaseNameArenas(filesMarks);
     }
-  } /* End for */
 
-  FreeFifArray(directories);
+    descend(pname1, pname2, pattern, attrib, opts, datemin, datemax,
+	    (subNodes[0] && subNodes[1]) ? subNodes : NULL);
+  } /* End while */
+
+  FreeFifLists(directories);
+  ReleaseNameArenas(dirsMarks);
   FREE_PATHNAME_BUF(name1);
   FREE_PATHNAME_BUF(name2);
   RETURN_CONST(0);
@@ -2218,6 +5265,7 @@ int descend(char *from, char *to, char *pattern,
 *                                                                             *
 *       Arguments:                                                            *
 *                                                                             *
+*         fif *pfif     Array of fif structures.                              *
 *         int nfif      Number of fif structures.                             *
 *                                                                             *
 *       Return value:   The array address. Aborts the program if failure.     *
@@ -2228,22 +5276,15 @@ int descend(char *from, char *to, char *pattern,
 *                                                                             *
 ******************************************************************************/
 
-fif **AllocFifArray(size_t nfif) {
+fif **AllocFifArray(fif *pfif, size_t nfif) {
   fif **ppfif;
-  fif *pfif;
   size_t i;
 
   /* Allocate an array for sorting */
   ppfif = (fif **)malloc((nfif+1) * sizeof(fif *));
   if (!ppfif) finis(RETCODE_NO_MEMORY, "Out of memory for fif array");
-  /* Fill the array with pointers to the list of structures */
-  pfif = firstfif;
-  for (i=0; i<nfif; i++) {
-    ppfif[i] = pfif;
-    pfif = pfif->next;
-  }
-  /* Make sure following the linked list ends with the array */
-  if (nfif) ppfif[nfif-1]->next = NULL;
+  /* Fill the array with pointers to the structures */
+  for (i=0; i<nfif; i++) ppfif[i] = pfif + i;
   /* Make sure FreeFifArray works in all cases. */
   ppfif[nfif] = NULL;
 
@@ -2254,7 +5295,7 @@ fif **AllocFifArray(size_t nfif) {
 *                                                                             *
 *       Function:       FreeFifArray                                          *
 *                                                                             *
-*       Description:    Free an array of fif pointers, and the fifs too.      *
+*       Description:    Free an array of fif pointers.                        *
 *                                                                             *
 *       Arguments:                                                            *
 *                                                                             *
@@ -2262,26 +5303,38 @@ fif **AllocFifArray(size_t nfif) {
 *                                                                             *
 *       Return value:   None                                                  *
 *                                                                             *
-*       Notes:                                                                *
+*       Notes:          The fifs names are in the nameArenas. The caller      *
+*                       releases them with ReleaseNameArenas().               *
 *                                                                             *
 *       Updates:                                                              *
 *                                                                             *
 ******************************************************************************/
 
 void FreeFifArray(fif **ppfif) {
-  fif **ppf;
+  free(ppfif);
 
-  for (ppf=ppfif; *ppf; ppf++) {
-    free((*ppf)->name);
-#ifndef _MSDOS
-    free((*ppf)->target);
-#endif
-    free(*ppf);
+  return;
+}
+
+/* Free the left and right arrays built by ListDirs() */
+void FreeFifLists(fifList *pLists) {
+  int i;
+  for (i=0; i<2; i++) {
+    FreeFifArray(pLists[i].ppfif);
+    free(pLists[i].pFifs);
   }
+}
 
-  free(ppfif);
+/* Record the state of the left and right name arenas */
+void MarkNameArenas(ARENAMARK *pMarks) {
+  ArenaMark(&nameArena[0], pMarks);
+  ArenaMark(&nameArena[1], pMarks+1);
+}
 
-  return;
+/* Free everything allocated in both arenas after MarkNameArenas() */
+void ReleaseNameArenas(ARENAMARK *pMarks) {
+  ArenaRelease(&nameArena[0], pMarks);
+  ArenaRelease(&nameArena[1], pMarks+1);
 }
 
 /******************************************************************************
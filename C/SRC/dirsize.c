@@ -74,6 +74,43 @@
 *                   Continue by default for all recursive operations.	      *
 *                   Version 3.5.					      *
 *    2022-01-12 JFL Added option -f to follow links to directories. Ver. 3.6. *
+*    2026-10-17 MAB Compile the wildcards pattern once with FnmCompile().     *
+*		    Version 3.6.1.					      *
+*    2026-10-17 MAB Test the file names before calling lstat(), and don't     *
+*		    call it at all if there's no date range. Version 3.6.2.   *
+*    2026-10-17 MAB Scan subdirectories relative to their parent directory fd,*
+*		    with an incrementally built pathname, instead of chdir()  *
+*		    into each of them and calling getcwd(). Version 3.7.      *
+*    2026-10-17 MAB Added option -j to scan the top-level subdirectories in   *
+*		    parallel threads, with the output in the usual order.     *
+*		    Version 3.8.					      *
+*    2026-10-17 MAB Get the stat data only once per file, returned by	      *
+*		    scandirX() with the entries. Don't sort subdirectories    *
+*		    when their sizes are not displayed. Version 3.8.1.	      *
+*    2026-10-17 MAB Added option -cache to reuse the sizes of directories     *
+*		    that did not change since the previous scan. Version 3.9. *
+*    2026-10-17 MAB Added options -top and -minsize to report only the	      *
+*		    largest directories, in bounded memory. Version 3.10.     *
+*    2026-10-17 MAB Added options -profile and -ages to tabulate the number   *
+*		    and size of files by age, extension, and owner, in a      *
+*		    single scan. Version 3.11.				      *
+*    2026-10-17 MAB Added option -telemetry to report the scan progress, and  *
+*		    the latency histograms of directory reads and stats.      *
+*		    Version 3.12.					      *
+*    2026-10-17 MAB Option -j now scans subdirectories in parallel at all     *
+*		    depths. Fatal errors in worker threads exit from the main *
+*		    thread. Version 3.12.1.				      *
+*    2026-10-17 MAB In Unix, read the files sizes in bulk with readdirplusf(),*
+*		    which tests the names and types before any stat, and only *
+*		    gets the fields needed. Version 3.12.2.		      *
+*    2026-10-17 MAB -telemetry times each directory read and each stat done   *
+*		    by readdirplusf(), instead of whole batches as reads.     *
+*		    Version 3.12.3.					      *
+*    2026-10-17 MAB In Unix, list the files and the subdirectories in a       *
+*		    single readdirplusf() pass, on a dup of the directory fd. *
+*		    Version 3.12.4.					      *
+*    2026-10-17 MAB In Unix, get the link targets types with readdirplusf(),  *
+*		    in the same batch as the files sizes. Version 3.12.5.     *
 *		    							      *
 *         © Copyright 2016 Hewlett Packard Enterprise Development LP          *
 * Licensed under the Apache 2.0 license - www.apache.org/licenses/LICENSE-2.0 *
@@ -81,8 +118,8 @@
 
 #define PROGRAM_DESCRIPTION "Display the total size used by a directory"
 #define PROGRAM_NAME    "dirsize"
-#define PROGRAM_VERSION "3.6"
-#define PROGRAM_DATE    "2022-01-13"
+#define PROGRAM_VERSION "3.12.5"
+#define PROGRAM_DATE    "2026-10-17"
 
 #include "predefine.h" /* Define optional features we need in the C libraries */
 
@@ -97,13 +134,18 @@
 #include <dirent.h>		/* We use the DIR type and the dirent structure */
 #include <fnmatch.h>		/* We use wild card file name matching */
 #include <unistd.h>		/* For chdir() */
+#include <fcntl.h>		/* For openat() */
 #include <errno.h>
 #include <stdarg.h>
 #include <limits.h>
+#include <ctype.h>		/* For toupper() and tolower() */
 /* SysLib include files */
 #include "dirx.h"		/* Directory access functions eXtensions */
+#include "fnmatchx.h"		/* Precompiled wildcards patterns */
+#include "pathnames.h"		/* Pathname management definitions and functions */
 /* SysToolsLib include files */
 #include "debugm.h"	/* SysToolsLib debug macros */
+#include "hashtab.h"	/* SysToolsLib hash functions */
 #include "stversion.h"	/* SysToolsLib version strings. Include last. */
 
 #ifndef UINTMAX_MAX /* For example Tru64 doesn't define it */
@@ -171,6 +213,8 @@ DEBUG_GLOBALS	/* Define global variables used by debugging macros. (Necessary fo
 
 #define CDECL				/* No such thing needed for Linux builds */
 
+#include <pwd.h>			/* For getpwuid() */
+
 #endif /* defined(__unix__) */
 
 /*********************************** Other ***********************************/
@@ -188,6 +232,22 @@ DEBUG_GLOBALS	/* Define global variables used by debugging macros. (Necessary fo
   #define OS_HAS_LINKS 0
 #endif
 
+/* Flag OSs where we can scan subdirectories in parallel threads */
+#if defined(_UNIX)
+  #define HAS_THREADS 1
+  #include <pthread.h>
+#else
+  #define HAS_THREADS 0
+#endif
+
+/* Flag OSs where we can cache directories sizes, keyed by device and inode */
+#if defined(_UNIX)
+  #define HAS_CACHE 1
+  #include <sys/mman.h>
+#else
+  #define HAS_CACHE 0
+#endif
+
 /* Local definitions */
 
 #define PATHNAME_SIZE PATH_MAX		/* Buffer size for holding pathnames, including NUL */
@@ -232,6 +292,8 @@ DEBUG_GLOBALS	/* Define global variables used by debugging macros. (Necessary fo
 
 typedef struct _selectOpts {	/* Options for selecting files */
   char *pattern;		    /* Wildcards pattern. NULL = select all */
+  FNMPATTERN fnmPattern;	    /* The same, compiled */
+  FNMSET fnmSet;		    /* The same, for readdirplusf() */
   time_t datemin;		    /* Minimum timestamp. 0 = no minimum */
   time_t datemax;		    /* Maximum timestamp. 0 = no maximum */
 } selectOpts;
@@ -245,8 +307,220 @@ typedef struct _scanOpts {	/* Options for scanning the directory tree */
 #if OS_HAS_LINKS
   int follow;			    /* If TRUE, follow links to subdirectories */
 #endif /* OS_HAS_LINKS */
+#if HAS_THREADS
+  int nThreads;			    /* Number of threads for scanning subdirs. 0=1/CPU */
+  struct _scanTask *pTask;	    /* If not NULL, buffer the output in this task */
+  struct _scanPool *pPool;	    /* The pool that task belongs to */
+#endif /* HAS_THREADS */
+#if HAS_CACHE
+  struct _dirCache *pCache;	    /* If not NULL, the directories sizes cache */
+#endif /* HAS_CACHE */
+  struct _sizeProfile *pProfile;    /* If not NULL, aggregate files sizes there */
 } scanOpts;
 
+typedef struct _dirEntry {	/* A directory entry returned by scandirX() */
+  struct dirent de;		    /* A copy of the readdir() entry */
+  int bStat;			    /* TRUE if st is valid */
+  struct stat st;		    /* Its stat data, if obtained by the selection callback */
+} dirEntry;
+
+typedef int (CDECL *pCompareProc)(const void *item1, const void *item2); /* qsort() callback */
+
+/* scandirX() selection callback return values */
+#define SELECT_NO   0		    /* Skip that entry */
+#define SELECT_YES  1		    /* Select that entry */
+#define SELECT_STAT 2		    /* Select that entry, and its stat data is valid */
+
+#define MAX_EXT_LENGTH 15	    /* Longer "extensions" are counted as no extension */
+#define MAX_PROFILE_ROWS 20	    /* Max # of extensions or owners displayed */
+
+typedef struct _sizeBucket {	/* Number and size of files in a category */
+  total_t size;
+  uintmax_t nFiles;
+} sizeBucket;
+
+typedef struct _extEntry {	/* Files with a given extension */
+  HASH_ENTRY_FIELDS();
+  char ext[MAX_EXT_LENGTH+1];	    /* The lower case extension, or "" if none */
+  sizeBucket bucket;
+} extEntry;
+
+typedef struct _extTable {
+  HASH_TABLE_FIELDS(struct _extEntry);
+} extTable;
+
+HASH_DEFINE_TYPES(extTable, extEntry);
+
+typedef struct _uidEntry {	/* Files belonging to a given owner */
+  HASH_ENTRY_FIELDS();
+  unsigned long uid;
+  sizeBucket bucket;
+} uidEntry;
+
+typedef struct _uidTable {
+  HASH_TABLE_FIELDS(struct _uidEntry);
+} uidTable;
+
+HASH_DEFINE_TYPES(uidTable, uidEntry);
+
+typedef struct _sizeProfile {	/* Files sizes aggregated by age, extension, and owner */
+  sizeBucket all;		    /* All files */
+  sizeBucket *pAges;		    /* One per age range in pAgeLimits, plus one for older files */
+  extTable *pExts;		    /* One per extension */
+  uidTable *pUids;		    /* One per owner */
+} sizeProfile;
+
+#define TELEMETRY_OP_OPEN 0	    /* Open a directory */
+#define TELEMETRY_OP_READ 1	    /* Read directory entries */
+#define TELEMETRY_OP_STAT 2	    /* Get a file stat data */
+#define TELEMETRY_OPS	  3
+#define TELEMETRY_BUCKETS 26	    /* < 1us, then up to 2^24us = 16s, then longer */
+
+typedef struct _telemetryThread { /* The measurements of one scanning thread */
+  struct _telemetryThread *pNext;   /* The next thread's measurements */
+  int iOp;			    /* The operation in progress, or -1 if none */
+  int64_t nsOp;			    /* When it started, in ns */
+  int iDepth;			    /* Depth of the last directory entered */
+  char *pszPath;		    /* Pathname of the last directory entered */
+  size_t lPathAlloc;
+  int64_t nsEnter;		    /* When it was entered, in ns */
+  uintmax_t aHist[TELEMETRY_OPS][TELEMETRY_BUCKETS]; /* Latency histograms */
+  double adTotal[TELEMETRY_OPS];    /* Total time spent in each operation */
+  double adMax[TELEMETRY_OPS];	    /* Longest time spent in each operation */
+#if HAS_THREADS
+  pthread_mutex_t mutex;	    /* Protects the path, against the reporter thread */
+#endif /* HAS_THREADS */
+} telemetryThread;
+
+typedef struct _telemetry {	/* Scan progress and latency measurements */
+  int iInterval;		    /* Seconds between progress reports */
+  double tStart;		    /* When the scan started */
+  uintmax_t nDirs;		    /* Number of directories scanned */
+  uintmax_t nFiles;		    /* Number of files counted */
+  telemetryThread *pThreads;	    /* The measurements of every scanning thread */
+  double tReport;		    /* When the last progress report was displayed */
+  uintmax_t nDirsReport;	    /* The counts at that time */
+  uintmax_t nFilesReport;
+#if HAS_THREADS
+  pthread_key_t key;		    /* The current thread's telemetryThread */
+  pthread_mutex_t mutex;	    /* Protects pThreads, and the reporter fields */
+  pthread_cond_t cond;		    /* Signaled to stop the reporter thread */
+  int bStop;			    /* TRUE to stop the reporter thread */
+  int bReporter;		    /* TRUE if the reporter thread is running */
+  pthread_t reporter;
+#endif /* HAS_THREADS */
+} telemetry;
+
+/* The fields read by the reporter thread while the others update them */
+#if HAS_THREADS
+#define TelemetryAdd(pInt, n) __atomic_add_fetch(pInt, n, __ATOMIC_RELAXED)
+#define TelemetryLoad(pInt) __atomic_load_n(pInt, __ATOMIC_ACQUIRE)
+#define TelemetryStore(pInt, n) __atomic_store_n(pInt, n, __ATOMIC_RELEASE)
+#else
+#define TelemetryAdd(pInt, n) (*(pInt) += (n))
+#define TelemetryLoad(pInt) (*(pInt))
+#define TelemetryStore(pInt, n) (*(pInt) = (n))
+#endif
+
+typedef struct _dirSizeLine {	/* A buffered output line */
+  char *path;
+  total_t size;
+} dirSizeLine;
+
+#if HAS_THREADS
+typedef struct _scanTask {	/* A top-level subdirectory, scanned by a worker thread */
+  char *name;			    /* The subdirectory name */
+  scanOpts opts;		    /* The worker private copy of the scan options */
+  total_t size;			    /* The subdirectory total size */
+  int done;			    /* TRUE when the scan is complete */
+  int aborted;			    /* TRUE if a fatal error stopped it */
+  dirSizeLine *pLines;		    /* The output lines, to display in order later on */
+  sizeProfile *pProfile;	    /* The worker private size profile, if needed */
+  int nLines;
+  int nLinesAlloc;
+} scanTask;
+
+typedef struct _scanPool {	/* A pool of worker threads scanning subdirectories */
+  scanTask *pTasks;
+  int nTasks;
+  int iNext;			    /* Index of the next task to start */
+  PATHBUF *pParent;		    /* The parent directory of all subdirectories */
+  void *pConstraints;		    /* File selection constraints */
+  pthread_mutex_t mutex;	    /* Protects iNext and the done flags */
+  pthread_cond_t cond;		    /* Signaled when a task is done */
+  pthread_t *pThreads;		    /* The worker threads */
+  int nStarted;			    /* Number of worker threads started */
+} scanPool;
+#endif /* HAS_THREADS */
+
+#if HAS_CACHE
+/* Size cache file layout: A header, then the records sorted by (dev, ino),
+   then the names area with the subdirectories names of each record, each
+   followed by a NUL. All in the native byte order, so that the file can be
+   used in place once mapped in memory. */
+#define DSC_MAGIC   0x43535344	    /* "DSSC" in little endian machines */
+#define DSC_VERSION 2
+
+typedef struct _dscHeader {	/* Size cache file header */
+  uint32_t magic;		    /* DSC_MAGIC */
+  uint32_t version;		    /* DSC_VERSION */
+  uint64_t signature;		    /* Hash of the options that affect the sizes */
+  uint64_t nRecords;		    /* Number of records following the header */
+  uint64_t lNames;		    /* Size of the names area following the records */
+} dscHeader;
+
+typedef struct _dscRecord {	/* Size cache record for one directory */
+  uint64_t dev;			    /* The directory device and inode */
+  uint64_t ino;
+  int64_t mtime;		    /* Its mtime seconds and nanoseconds when scanned */
+  int64_t mtimeNs;
+  uint64_t own;			    /* The size of its own files */
+  uint64_t oNames;		    /* Offset of its subdirectories names */
+  uint32_t nNames;		    /* Number of subdirectories names */
+  uint32_t flags;		    /* DSC_xxx flags below */
+} dscRecord;
+#define DSC_NAMES   0x02	    /* The subdirectories names are valid */
+
+typedef struct _dirCache {	/* A size cache, loaded from, and saved to, a file */
+  char *pszFile;		    /* The cache file absolute pathname */
+  uint64_t signature;		    /* Hash of the options that affect the sizes */
+  time_t tStart;		    /* When the scan started */
+  void *pMap;			    /* The previous scan cache file, mapped in memory */
+  size_t lMap;
+  const dscRecord *pOld;	    /* Its records */
+  uint64_t nOld;
+  const char *pOldNames;	    /* Its names area */
+  uint64_t lOldNames;
+  dscRecord *pNew;		    /* The records for this scan */
+  uint64_t nNew;
+  uint64_t nNewAlloc;
+  char *pNewNames;		    /* The names area for this scan */
+  uint64_t lNewNames;
+  uint64_t lNewNamesAlloc;
+  long nHits;			    /* Number of unchanged directories */
+  long nMisses;			    /* Number of directories read */
+#if HAS_THREADS
+  pthread_mutex_t mutex;	    /* Protects the new records and the counters */
+#endif /* HAS_THREADS */
+} dirCache;
+
+typedef struct _dirCacheDir {	/* Cache data for the directory being scanned */
+  struct stat st;		    /* The directory stat data */
+  const dscRecord *pOld;	    /* Its previous scan record, if still valid */
+  int bNames;			    /* TRUE if its subdirectories were listed */
+  char *pNames;			    /* The names of its subdirectories */
+  size_t lNames;
+  size_t lNamesAlloc;
+  uint32_t nNames;
+} dirCacheDir;
+
+#if defined(__MACH__)
+#define ST_MTIME_NS(pst) ((pst)->st_mtimespec.tv_nsec)
+#else
+#define ST_MTIME_NS(pst) ((pst)->st_mtim.tv_nsec)
+#endif
+#endif /* HAS_CACHE */
+
 /* Global variables */
 
 char init_dir[PATHNAME_SIZE];       /* Initial directory */
@@ -258,6 +532,21 @@ int iQuiet = FALSE;		    /* If TRUE, only display major errors */
 int iVerbose = FALSE;		    /* If TRUE, display additional information */
 int iHuman = TRUE;		    /* If TRUE, display human-friendly values with a comma every 3 digits */
 char *pszUnit = "B";		    /* "B"=bytes; "KB"=Kilo-Bytes; "MB"; GB" */
+total_t llMinSize = 0;		    /* Do not display directories smaller than this */
+int nTop = 0;			    /* If > 0, display only the N largest directories */
+dirSizeLine *pTopDirs = NULL;	    /* Min-heap of the N largest directories found so far */
+int nTopDirs = 0;		    /* Number of directories in that heap */
+#if HAS_THREADS
+pthread_mutex_t topMutex = PTHREAD_MUTEX_INITIALIZER; /* Protects that heap */
+pthread_t mainThread;		    /* The thread running main() */
+int nIdleThreads = 0;		    /* Number of -j threads that can still be started */
+int iAbort = 0;			    /* Exit code of a fatal error in a worker thread */
+#endif
+time_t aDefaultAges[] = {7*86400L, 30*86400L, 90*86400L, 365*86400L, 3*365*86400L};
+time_t *pAgeLimits = aDefaultAges;  /* Upper limits of the profile age ranges, in seconds */
+int nAges = sizeof(aDefaultAges) / sizeof(time_t);
+time_t tProfile;		    /* The reference time for files ages */
+telemetry *pTelemetry = NULL;	    /* If not NULL, measure the scan progress */
 
 /* Function prototypes */
 
@@ -265,17 +554,60 @@ void usage(void);                   /* Display a brief help and exit */
 int IsSwitch(char *pszArg);	    /* Is this a command-line switch? */
 void finis(int retcode, ...);       /* Return to the initial drive & exit */
 int parse_date(char *token, time_t *pdate); /* Convert the argument to a time_t */
+int parse_size(char *token, total_t *pSize); /* Convert the argument to a size */
 int Size2String(char *pBuf, total_t ll); /* Convert size to a decimal, with a comma every 3 digits */
 int Size2StringWithUnit(char *pBuf, total_t llSize); /* Idem, appending the user-specified unit */
 
-total_t ScanFiles(scanOpts *pOpts, void *pConstraints); /* Scan the current dir */
-total_t ScanDirs(scanOpts *pOpts, void *pConstraints);  /* Scan every subdir */
+total_t ScanFiles(scanOpts *pOpts, void *pConstraints, PATHBUF *pPath); /* Scan a dir */
+total_t ScanDirs(scanOpts *pOpts, void *pConstraints, PATHBUF *pPath,
+		 struct _dirCacheDir *pCD, dirEntry **pList, int nDE);  /* Scan every subdir */
+total_t ScanSubDir(scanOpts *pOpts, void *pConstraints, PATHBUF *pPath, char *pszName); /* Scan one */
 void affiche(char *path, total_t size);/* Display sorted list */
-int scandirX(const char *pszName,
-	     struct dirent ***resultList,
-	     int (*cbSelect) (const struct dirent *, void *pRef),
-	     int (CDECL *cbCompare) (const struct dirent **, const struct dirent **),
+void ShowDirSize(scanOpts *pOpts, char *path, total_t size); /* affiche(), or buffer it */
+void AddTopDir(char *path, total_t size); /* Keep it if it's one of the nTop largest */
+void ShowTopDirs(void);		    /* Display the nTop largest, by decreasing size */
+sizeProfile *NewProfile(void);	    /* Create an empty size profile */
+void FreeProfile(sizeProfile *pProfile);
+void ProfileFile(sizeProfile *pProfile, const char *pszName, time_t mtime, unsigned long uid, total_t size); /* Add a file */
+void MergeProfile(sizeProfile *pTo, sizeProfile *pFrom); /* Add a profile to another */
+void ShowProfile(sizeProfile *pProfile); /* Display the profile tables */
+int parse_ages(char *token);	    /* Parse a list of ages in days */
+#if HAS_THREADS
+total_t ScanDirsMT(scanOpts *pOpts, void *pConstraints, PATHBUF *pPath,
+		   dirEntry **pList, int nEntries, int nThreads); /* Scan subdirs in parallel threads */
+int TakeThreads(int nThreads);	    /* Reserve up to nThreads idle threads */
+#endif
+int scandirX(PATHBUF *pPath,
+	     dirEntry ***resultList,
+	     int (*cbSelect) (PATHBUF *pPath, const struct dirent *, struct stat *, void *pRef),
+	     int (CDECL *cbCompare) (const dirEntry **, const dirEntry **),
 	     void *pRef);	    /* scandir() extension, passing a pRef to cbSelect() */
+int CDECL alphasortX(const dirEntry **ppEntry1, const dirEntry **ppEntry2); /* alphasort() for dirEntry */
+dirEntry *NewDirEntry(dirEntry ***ppList, int *pn, int *pnAlloc); /* Append an entry to a list */
+#if !defined(_UNIX)
+int StatEntry(PATHBUF *pPath, const char *pszName, struct stat *pStat, int iFollow); /* stat an entry in pPath */
+#endif
+total_t CountFile(scanOpts *pOpts, const char *pszName, uintmax_t fsize, time_t mtime, unsigned long uid);
+#if defined(_UNIX)
+int ScanFilesPlus(scanOpts *pOpts, selectOpts *pC, PATHBUF *pPath, total_t *pSize,
+		  dirEntry ***ppDirs, int *pnDirs); /* Sum the files sizes, and list the subdirs */
+#endif
+void TelemetryStart(int iInterval); /* Start measuring, and reporting the progress */
+double TelemetryBegin(int iOp);	    /* Start timing an operation */
+void TelemetryEnd(int iOp, double t0); /* Count its duration */
+void TelemetryEnterDir(char *pszPath, int iDepth); /* Record the directory being scanned */
+void TelemetryAddFiles(int nFiles); /* Count files scanned */
+void TelemetryStop(void);	    /* Display the final counts and histograms */
+#if HAS_CACHE
+void DirCacheLoad(dirCache *pCache, selectOpts *pConstraints, scanOpts *pOpts); /* Map the previous cache file */
+const dscRecord *DirCacheLookup(dirCache *pCache, struct stat *pStat); /* Get a dir record, if still valid */
+int DirCacheList(dirCache *pCache, const dscRecord *pRec, dirEntry ***resultList,
+		 int (CDECL *cbCompare) (const dirEntry **, const dirEntry **)); /* List its subdirs */
+void DirCacheAddName(dirCacheDir *pCD, const char *pszName); /* Record a subdirectory name */
+void DirCacheAdd(dirCache *pCache, dirCacheDir *pCD, total_t own, int iFlags); /* Record a dir */
+int DirCacheSave(dirCache *pCache); /* Atomically replace the cache file */
+void DirCacheFree(dirCache *pCache);
+#endif /* HAS_CACHE */
 
 long GetClusterSize(char drive);    /* Get cluster size */
 
@@ -293,15 +625,33 @@ int main(int argc, char *argv[]) {
   char *dateminarg = NULL;	/* Minimum date argument */
   char *datemaxarg = NULL;	/* Maximum date argument */
   int iUseCsz = FALSE;		/* If TRUE, use the cluster size */
+  int iProfile = FALSE;		/* If TRUE, display the size profile */
   int err;
   char *pc;
   total_t size;			/* Total size */
+  PATHBUF path;			/* Pathname of the directory being scanned */
+#if HAS_CACHE
+  dirCache cache = {0};		/* Directories sizes cache */
+#endif
+
+#if HAS_THREADS
+  mainThread = pthread_self();	/* finis() only exits from this thread */
+#endif
 
   /* Parse command line arguments */
   for (i=1; i<argc; i++) {
     char *arg = argv[i];
     if (IsSwitch(arg)) { /* It's a switch */
       char *opt = arg+1;
+      if (streq(opt, "ages")) {
+	if (((i+1) >= argc) || !parse_ages(argv[i+1])) {
+	  fprintf(stderr, "Error: Invalid list of ages: %s %s\n", arg, ((i+1) < argc) ? argv[i+1] : "");
+	  finis(RETCODE_INACCESSIBLE, NULL);
+	}
+	i += 1;			/* Skip the list in next argument */
+	iProfile = TRUE;
+	continue;
+      }
       if (streq(opt, "b")) {
 	band = TRUE;
 	continue;
@@ -315,6 +665,17 @@ int main(int argc, char *argv[]) {
 	}
       continue;
       }
+#if HAS_CACHE
+      if (streq(opt, "cache")) {
+	if ((i+1) < argc) {
+	  cache.pszFile = argv[++i];
+	  sOpts.pCache = &cache;
+	} else {
+	  fprintf(stderr, "Error: Missing cache file name: -cache\n");
+	}
+	continue;
+      }
+#endif
       if (streq(opt, "D")) {
 	sOpts.subdirs = TRUE;
 	continue;
@@ -330,6 +691,18 @@ int main(int argc, char *argv[]) {
 	sOpts.follow = TRUE;
 	continue;
       }
+#endif
+#if HAS_THREADS
+      if (streq(opt, "j")) {
+	if (((i+1) < argc) && !IsSwitch(argv[i+1]) && sscanf(argv[i+1], "%d", &sOpts.nThreads)) {
+	  i += 1;		/* Skip the number in next argument */
+	} else {
+	  sOpts.nThreads = 0;	/* Use one thread per CPU */
+	}
+	if (sOpts.nThreads <= 0) sOpts.nThreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	nIdleThreads = sOpts.nThreads - 1;
+	continue;
+      }
 #endif
       if (streq(opt, "from")) {
 	dateminarg = argv[++i];
@@ -368,7 +741,20 @@ int main(int argc, char *argv[]) {
 	pszUnit = "MB";
 	continue;
       }
+      if (   streq(opt, "minsize")
+	  || streq(opt, "-min-size")) {
+	if (((i+1) >= argc) || !parse_size(argv[i+1], &llMinSize)) {
+	  fprintf(stderr, "Error: Invalid size: %s %s\n", arg, ((i+1) < argc) ? argv[i+1] : "");
+	  finis(RETCODE_INACCESSIBLE, NULL);
+	}
+	i += 1;			/* Skip the size in next argument */
+	continue;
+      }
       if (streq(opt, "nologo")) continue; /* Old option retired */
+      if (streq(opt, "profile")) {
+	iProfile = TRUE;
+	continue;
+      }
       if (streq(opt, "q")) {
 	iQuiet = TRUE;
 	continue;
@@ -386,6 +772,26 @@ int main(int argc, char *argv[]) {
 	sOpts.total = FALSE;
 	continue;
       }
+      if (   streq(opt, "top")
+	  || streq(opt, "-top")) {
+	if (((i+1) >= argc) || (sscanf(argv[i+1], "%d", &nTop) != 1) || (nTop <= 0)) {
+	  fprintf(stderr, "Error: Invalid number: %s %s\n", arg, ((i+1) < argc) ? argv[i+1] : "");
+	  finis(RETCODE_INACCESSIBLE, NULL);
+	}
+	i += 1;			/* Skip the number in next argument */
+	pTopDirs = malloc(nTop * sizeof(dirSizeLine));
+	if (!pTopDirs) finis(RETCODE_NO_MEMORY, "Out of memory");
+	continue;
+      }
+      if (streq(opt, "telemetry")) {
+	int iInterval = 0;
+	if (((i+1) < argc) && !IsSwitch(argv[i+1]) && sscanf(argv[i+1], "%d", &iInterval)) {
+	  i += 1;		/* Skip the number in next argument */
+	}
+	if (iInterval <= 0) iInterval = 5;
+	if (!pTelemetry) TelemetryStart(iInterval);
+	continue;
+      }
       if (streq(opt, "to")) {
 	datemaxarg = argv[++i];
 	if (!parse_date(datemaxarg, &fConstraints.datemax)) {
@@ -414,6 +820,12 @@ int main(int argc, char *argv[]) {
     fprintf(stderr, "Warning: Unexpected argument \"%s\" ignored.", arg);
   }
 
+  /* Create the profile once -ages has set the number of age ranges */
+  if (iProfile) sOpts.pProfile = NewProfile();
+
+  /* Reporting the largest directories implies scanning them all */
+  if ((nTop || llMinSize) && !sOpts.subdirs) sOpts.recur = TRUE;
+
   /* If not explicitely defined, set iContinue based on context */
   if ((iContinue == -1) && (sOpts.total || sOpts.recur)) iContinue = TRUE; /* For all recursive operations, default to TRUE */
   if (iContinue == -1) iContinue = FALSE; /* Fon non-recusive operations, default to FALSE */
@@ -431,6 +843,10 @@ int main(int argc, char *argv[]) {
 	*pc = '\0';	/* Cut the wildcards pattern off the directory name */
 	fConstraints.pattern = pc+1;
       }
+      if (   FnmCompile(&fConstraints.fnmPattern, fConstraints.pattern, FNM_CASEFOLD)
+	  || FnmSetAdd(&fConstraints.fnmSet, fConstraints.pattern, FNM_CASEFOLD)) {
+	finis(RETCODE_NO_MEMORY, "Out of memory");
+      }
     }
   }
 
@@ -490,6 +906,16 @@ int main(int argc, char *argv[]) {
     finis(RETCODE_INACCESSIBLE, "Cannot get the current directory");
   }
 
+#if HAS_CACHE
+  /* Make the cache pathname absolute, as we're going to change directories */
+  if (sOpts.pCache && (cache.pszFile[0] != DIRSEPARATOR_CHAR)) {
+    char *pszFile = malloc(strlen(init_dir) + strlen(cache.pszFile) + 2);
+    if (!pszFile) finis(RETCODE_NO_MEMORY, "Out of memory");
+    sprintf(pszFile, "%s" DIRSEPARATOR_STRING "%s", init_dir, cache.pszFile);
+    cache.pszFile = pszFile; /* Freed on exit */
+  }
+#endif
+
   /* Go to the target directory */
   if (from && from[0]) {
 #if !HAS_MSVCLIBX
@@ -509,17 +935,63 @@ int main(int argc, char *argv[]) {
     if (iVerbose) printf("The cluster size is %ld bytes.\n\n", csz);
   }
 
+#if HAS_CACHE
+  /* The profile needs to see every file */
+  if (sOpts.pCache && sOpts.pProfile) {
+    fprintf(stderr, "Warning: Option -cache is ignored with option -profile\n");
+    sOpts.pCache = NULL;
+  }
+  /* Load the sizes from the previous scan with the same options */
+  if (sOpts.pCache) DirCacheLoad(&cache, &fConstraints, &sOpts);
+#endif
+  tProfile = time(NULL);
+
+  /* Get the canonic name of the target directory. The scan builds the
+     subdirectories names from it, without changing directories again. */
+  PathBufInit(&path);
+  {
+    NEW_PATHNAME_BUF(szTargetDir);
+#if PATHNAME_BUFS_IN_HEAP
+    if (!szTargetDir) finis(RETCODE_NO_MEMORY, "Out of memory");
+#endif
+    pc = getcwd(szTargetDir, PATHNAME_SIZE);
+    if (!pc) {
+      finis(RETCODE_INACCESSIBLE, "Cannot get the current directory");
+    }
+    if (PathBufSet(&path, pc)) finis(RETCODE_NO_MEMORY, "Out of memory");
+    FREE_PATHNAME_BUF(szTargetDir);
+  }
+
   /* Compute the files sizes */
   if (!sOpts.subdirs) {
-    size = ScanFiles(&sOpts, &fConstraints);
+    size = ScanFiles(&sOpts, &fConstraints, &path);
     if (!sOpts.recur) {
       char szBuf[40];
       Size2StringWithUnit(szBuf, size);
       printf("%s\n", szBuf);
     }
   } else {
-    size = ScanDirs(&sOpts, &fConstraints);
+    size = ScanDirs(&sOpts, &fConstraints, &path, NULL, NULL, -1);
   }
+  PathBufFree(&path);
+  TelemetryStop();
+  if (nTop) ShowTopDirs();
+  if (sOpts.pProfile) {
+    ShowProfile(sOpts.pProfile);
+    FreeProfile(sOpts.pProfile);
+  }
+
+#if HAS_CACHE
+  /* Replace the cache file with the sizes found by this scan */
+  if (sOpts.pCache) {
+    if (DirCacheSave(&cache)) {
+      fprintf(stderr, "Warning: Cannot update the cache file %s. %s\n", cache.pszFile, strerror(errno));
+    } else if (iVerbose) {
+      printf("Reused the cached size of %ld directories, and read %ld.\n", cache.nHits, cache.nMisses);
+    }
+    DirCacheFree(&cache);
+  }
+#endif
 
   /* Report if some errors were ignored */
   if (sOpts.nErrors) {
@@ -539,9 +1011,18 @@ Usage: dirsize [SWITCHES] [TARGET]\n\
 \n\
 Switches:\n\
   -?|-h       Display this help message and exit.\n\
+  -ages LIST  Set the -profile age ranges limits, in days. Implies -profile.\n\
+              Default: 7,30,90,365,1095\n\
   -b          Skip a line every 5 lines, to improve readability.\n\
   -c          Use the actual cluster size to compute the total size.\n\
-  -c size     Use the specified cluster size to compute the total size.\n\
+  -c size     Use the specified cluster size to compute the total size.\n"
+#if HAS_CACHE
+"\
+  -cache FILE Reuse the sizes of unchanged directories found in FILE, then\n\
+              update FILE. Files resized in place, without any change to\n\
+              their directory, are not noticed until that directory changes.\n"
+#endif
+"\
   -D          Measure every subdirectory of the target directory.\n"
 #ifdef _DEBUG
 "\
@@ -556,14 +1037,28 @@ Switches:\n\
   -g          Display sizes in Giga bytes.\n\
   -H          Display sizes without the human-friendly commas.\n\
   -i          Report only the number of access errors (Dflt for recursive ops.)\n\
-  -I          Stop in case of directory access error (Default for other ops.)\n\
+  -I          Stop in case of directory access error (Default for other ops.)\n"
+#if HAS_THREADS
+"\
+  -j [N]      Scan subdirectories in up to N parallel threads, at any depth.\n\
+              Default: 1 per CPU\n"
+#endif
+"\
   -k          Display sizes in Kilo bytes.\n\
   -m          Display sizes in Mega bytes.\n\
+  -minsize X  Display only directories of X bytes or more. X may end with\n\
+              K, M, G, or T for Kilo, Mega, Giga, or Tera bytes. Implies -r.\n\
+  -profile    Also display the number and size of files by age, extension,\n\
+              and owner. Use with -t to profile the whole tree.\n\
   -q          Quiet mode: Do not display minor errors.\n\
   -r|-s       Display the sizes of all subdirectories too.\n\
   -t          Count the total size of all files plus that of all subdirs.\n\
+  -telemetry [N]  Report the progress on stderr every N seconds. Default: 5\n\
+              At the end, display the latency histograms of system calls.\n\
   -T          Do not count the size of subdirs. (Default)\n\
   -to Y-M-D   List only files up to that date.\n\
+  -top N      Display only the N largest directories, by decreasing size.\n\
+              Implies -r. Use with -t to rank whole subtrees.\n\
   -v          Display verbose information.\n\
   -V          Display this program version and exit.\n\
 \n\
@@ -620,6 +1115,15 @@ void finis(int retcode, ...) {
     va_end(vl);
   }
 
+#if HAS_THREADS
+  /* In a worker thread, let the main thread exit once the worker tasks stopped */
+  if (retcode && !pthread_equal(pthread_self(), mainThread)) {
+    int iZero = 0;
+    __atomic_compare_exchange_n(&iAbort, &iZero, retcode, FALSE, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+    pthread_exit(NULL);	/* The cleanup handlers mark its tasks as aborted */
+  }
+#endif
+
   chdir(init_dir);	/* Don't test errors, as we're likely to be here due to another error */
 #if HAS_DRIVES
   chdrive(init_drive);
@@ -662,128 +1166,299 @@ int IsSwitch(char *pszArg) {
 *                                                                             *
 *       Function:       ScanFiles                                             *
 *                                                                             *
-*       Description:    Scan the current directory, and add-up file sizes     *
+*       Description:    Scan a directory, and add-up file sizes               *
 *                                                                             *
 *       Arguments:                                                            *
 *         void *pConstraints	File selection constraints                    *
+*         PATHBUF *pPath	The directory pathname, and its fd in Unix    *
 *                                                                             *
 *       Return value:   Total size of all files                               *
 *                                                                             *
-*       Notes:                                                                *
+*       Notes:          In Unix, ScanFilesPlus() reads the files sizes in     *
+*                       bulk, and lists the subdirectories in the same pass.  *
+*                       Elsewhere, scandirX() lists the files, and            *
+*                       SelectFilesCB() gets their stat data.                 *
+*                                                                             *
+*                       With a size cache, a directory whose mtime did not    *
+*                       change since the previous scan still has the same     *
+*                       entries. So its files size is taken from the cache,   *
+*                       and its subdirectories list too if it was recorded,   *
+*                       without reading the directory again.                  *
+*                       The subdirectories themselves are checked the same    *
+*                       way, as changes there don't affect this directory.    *
 *                                                                             *
 *       History:                                                              *
+*        2026-10-17 MAB Added the optional size cache.                        *
+*        2026-10-17 MAB In Unix, use ScanFilesPlus().                         *
+*        2026-10-17 MAB In Unix, list the subdirectories with the files.      *
 *                                                                             *
 ******************************************************************************/
 
-int SelectFilesCB(const struct dirent *pDE, void *p) {
+#if !defined(_UNIX)
+int SelectFilesCB(PATHBUF *pPath, const struct dirent *pDE, struct stat *pStat, void *p) {
   selectOpts *pC = p;
-  struct stat sStat;
   int iErr;
 
   /* Invoked by scandirX(), so d_type always valid, even under Unix */
-  if (pDE->d_type != DT_REG) return FALSE;	/* We want only files */
+  if (pDE->d_type != DT_REG) return SELECT_NO;	/* We want only files */
+
+  /* Skip files which don't match the wildcard pattern */
+  if (pC->pattern) {
+    if (FnmMatch(&pC->fnmPattern, pDE->d_name) == FNM_NOMATCH) {
+      return SELECT_NO;
+    }
+  }
 
+  /* Get the file size and date. Returned to ScanFiles() with the entry. */
 #if _DIRENT2STAT_DEFINED /* DOS/Windows return stat info in the dirent structure */
-  iErr = dirent2stat(pDE, &sStat);
+  iErr = dirent2stat(pDE, pStat);
 #else /* Unix has to query it separately */
-  iErr = lstat(pDE->d_name, &sStat);
+  iErr = StatEntry(pPath, pDE->d_name, pStat, FALSE);
 #endif
-  if (iErr) return FALSE;	/* Ignore suspect entries */
+  if (iErr) return SELECT_NO;	/* Ignore suspect entries */
 
   /* Skip files outside date range */
-  if (pC->datemin && (sStat.st_mtime < pC->datemin)) return FALSE;
-  if (pC->datemax && (sStat.st_mtime > pC->datemax)) return FALSE;
+  if (pC->datemin && (pStat->st_mtime < pC->datemin)) return SELECT_NO;
+  if (pC->datemax && (pStat->st_mtime > pC->datemax)) return SELECT_NO;
 
-  /* Skip files which don't match the wildcard pattern */
-  if (pC->pattern) {
-    if (fnmatch(pC->pattern, pDE->d_name, FNM_CASEFOLD) == FNM_NOMATCH) {
-      return FALSE;
-    }
+  /* OK, all criteria pass. */
+  return SELECT_STAT;
+}
+#endif /* !defined(_UNIX) */
+
+/* Count one file size, rounded to the cluster size, and profile it */
+total_t CountFile(scanOpts *pOpts, const char *pszName, uintmax_t fsize, time_t mtime, unsigned long uid) {
+  DEBUG_PRINTF(("// Counting %10"PRIuMAX" bytes for %-32s\n", fsize, pszName));
+  if (csz) {	/* If the cluster size is provided */
+		/* Round it to the next cluster multiple */
+    fsize += csz-1;
+    fsize -= fsize % csz;
   }
+  if (pOpts->pProfile) ProfileFile(pOpts->pProfile, pszName, mtime, uid, (total_t)fsize);
+  return (total_t)fsize;
+}
 
-  /* OK, all criteria pass. */
-  return TRUE;
+/* Report a link that can't be followed. errno = The stat error */
+void ReportBadLink(scanOpts *pOpts, PATHBUF *pPath, const char *pszName) {
+  char *pszSeverity = iContinue ? "Warning" : "dirsize: Error";
+  if (iVerbose || !iContinue) {
+    fprintf(stderr, "%s: Invalid link \"%s" DIRSEPARATOR_STRING "%s\". %s\n", pszSeverity, pPath->buf, pszName, strerror(errno));
+  }
+  if (!iContinue) finis(RETCODE_INACCESSIBLE, NULL); /* The error message has already been displayed */
+  pOpts->nErrors += 1;
+}
+
+#if defined(_UNIX)
+#define DXP_BATCH 256	/* Number of entries read per readdirplusf() call */
+
+/* Let readdirplusf() time its directory reads and its stats separately */
+double DxpTelemetryBegin(int iOp) {
+  return TelemetryBegin((iOp == DXP_OP_STAT) ? TELEMETRY_OP_STAT : TELEMETRY_OP_READ);
+}
+
+void DxpTelemetryEnd(int iOp, double t0) {
+  TelemetryEnd((iOp == DXP_OP_STAT) ? TELEMETRY_OP_STAT : TELEMETRY_OP_READ, t0);
+}
+
+static const DXPTIMER dxpTelemetry = {DxpTelemetryBegin, DxpTelemetryEnd};
+
+/* Append a subdirectory to the list built by ScanFilesPlus(). 0=Done, -1=Error */
+int AddSubDir(dirEntry ***ppDirs, int *pnDirs, int *pnAlloc, direntplus *pDE) {
+  dirEntry *pEntry = NewDirEntry(ppDirs, pnDirs, pnAlloc);
+  if (!pEntry) return -1;
+  strncpyz(pEntry->de.d_name, pDE->d_name, sizeof(pEntry->de.d_name));
+  pEntry->de.d_ino = pDE->d_ino;
+  pEntry->de.d_type = pDE->d_type;
+  pEntry->bStat = FALSE;
+  return 0;
+}
+
+/* Sum the sizes of the selected files, if pSize is not NULL. And list the
+   subdirectories, if ppDirs is not NULL. Returns the # of files, or -1 */
+int ScanFilesPlus(scanOpts *pOpts, selectOpts *pC, PATHBUF *pPath, total_t *pSize,
+		  dirEntry ***ppDirs, int *pnDirs) {
+  direntplus aDE[DXP_BATCH];
+  direntplus aLinks[DXP_BATCH];	/* The links to follow in the same batch */
+  DXPFILTER types = {0};
+  DXPFILTER filter = {0};
+  DIRPLUS *pDir;
+  dirEntry **pDirs = NULL;
+  int nDirs = 0;
+  int nAlloc = 0;
+  int iFields = DXP_SIZE;
+  int nFiles = 0;
+  int n, nSel, nLinks, i;
+  double t0;
+
+  /* The first pass gets the names and the types of the entries we may need */
+  if (pSize) types.uTypes |= DXT_MASK(DT_REG);
+  if (ppDirs) {
+    types.uTypes |= DXT_MASK(DT_DIR);
+    if (pOpts->follow) types.uTypes |= DXT_MASK(DT_LNK);
+  }
+  /* Then the files names are tested before any stat, and their dates after */
+  if (pC->pattern) filter.pNames = &pC->fnmSet;
+  filter.uTypes = DXT_MASK(DT_REG);
+  if (pC->datemin || pC->datemax) {
+    filter.iFlags = DXF_MTIME;
+    filter.tMinMtime = pC->datemin ? pC->datemin : (time_t)LONG_MIN;
+    filter.tMaxMtime = pC->datemax ? pC->datemax : (time_t)LONG_MAX;
+  }
+  if (pOpts->pProfile) iFields |= DXP_MTIME | DXP_UID;
+
+  t0 = TelemetryBegin(TELEMETRY_OP_OPEN);
+  { /* Duplicate the directory fd, as closedirplus() will close it. Each
+       directory is read only once, so sharing its file offset is fine. */
+    int iDirFD = (pPath->fd == AT_FDCWD) ? open(".", O_RDONLY | O_DIRECTORY | O_CLOEXEC)
+					 : fcntl(pPath->fd, F_DUPFD_CLOEXEC, 0);
+    pDir = (iDirFD >= 0) ? fdopendirplus(iDirFD) : NULL;
+  }
+  TelemetryEnd(TELEMETRY_OP_OPEN, t0);
+  if (!pDir) return -1;
+  if (pTelemetry) dirplustimer(pDir, &dxpTelemetry); /* Time the reads and stats */
+
+  while ((n = readdirplusf(pDir, aDE, DXP_BATCH, 0, &types)) > 0) {
+    for (i = nSel = nLinks = 0; i < n; i++) {
+      if (aDE[i].d_type == DT_REG) { /* Keep the files at the beginning */
+	aDE[nSel++] = aDE[i];
+      } else if (aDE[i].d_type == DT_LNK) { /* Only selected with pOpts->follow */
+	aLinks[nLinks++] = aDE[i];
+      } else if (AddSubDir(&pDirs, &nDirs, &nAlloc, aDE + i)) {
+	goto out_of_memory;
+      }
+    }
+    /* Keep the links to directories, getting their targets types with the batch */
+    statdirplusf(pDir, aLinks, nLinks, DXP_FOLLOW | DXP_MODE, NULL);
+    for (i = 0; i < nLinks; i++) {
+      if (aLinks[i].dx_errno) {
+	errno = aLinks[i].dx_errno;
+	ReportBadLink(pOpts, pPath, aLinks[i].d_name);
+      } else if (S_ISDIR(aLinks[i].dx_mode) && AddSubDir(&pDirs, &nDirs, &nAlloc, aLinks + i)) {
+	goto out_of_memory;
+      }
+    }
+    nSel = statdirplusf(pDir, aDE, nSel, iFields, &filter);
+    for (i = 0; i < nSel; i++) {
+      if (aDE[i].dx_errno) continue;	/* Ignore suspect entries */
+      *pSize += CountFile(pOpts, aDE[i].d_name, (uintmax_t)(aDE[i].dx_size),
+			  aDE[i].dx_mtime.tv_sec, (unsigned long)(aDE[i].dx_uid));
+      nFiles += 1;
+    }
+  }
+  if (n < 0) goto failed;
+  closedirplus(pDir);
+  if (ppDirs) {
+    *ppDirs = pDirs;
+    *pnDirs = nDirs;
+  }
+  return nFiles;
+
+out_of_memory:
+  errno = ENOMEM;
+failed:
+  {
+    int iErr = errno;
+    closedirplus(pDir);
+    while (nDirs > 0) free(pDirs[--nDirs]);
+    free(pDirs);
+    errno = iErr;
+  }
+  return -1;
 }
+#endif /* defined(_UNIX) */
 
-total_t ScanFiles(scanOpts *pOpts, void *pConstraints) {
+total_t ScanFiles(scanOpts *pOpts, void *pConstraints, PATHBUF *pPath) {
   total_t size = 0;
   total_t dSize;
-  NEW_PATHNAME_BUF(szCurDir);
-  struct dirent *pDE;
-  struct dirent **ppDE;
-  struct dirent **pDElist;
+  dirEntry **pDirs = NULL;	/* The subdirectories, if listed with the files */
+  int nDirs = -1;		/* -1 = Not listed */
+#if !defined(_UNIX)
+  dirEntry *pEntry;
+  dirEntry **ppEntry;
+  dirEntry **pList;
+#endif
   int nDE;
-  uintmax_t fsize;
-  struct stat sStat;
   int iErr;
+  struct _dirCacheDir *pCD = NULL;
+#if HAS_CACHE
+  dirCacheDir cd = {0};
+  total_t own;
+#endif
 
-  DEBUG_ENTER(("ScanFiles(%p);\n", pConstraints));
+  DEBUG_ENTER(("ScanFiles(%p, \"%s\");\n", pConstraints, pPath->buf));
+  TelemetryEnterDir(pPath->buf, pOpts->depth);
 
-#if PATHNAME_BUFS_IN_HEAP
-  if (!szCurDir) {
-    finis(RETCODE_NO_MEMORY, "Out of memory");
+#if HAS_CACHE
+  /* Reuse the files size if the directory has not changed since the last scan */
+  if (pOpts->pCache) {
+    double t0 = TelemetryBegin(TELEMETRY_OP_STAT);
+    if (!fstatat(pPath->fd, ".", &cd.st, 0)) pCD = &cd;
+    TelemetryEnd(TELEMETRY_OP_STAT, t0);
+  }
+  if (pCD) {
+    cd.pOld = DirCacheLookup(pOpts->pCache, &cd.st);
+    if (cd.pOld) {
+      DEBUG_PRINTF(("// Unchanged since the last scan\n"));
+      size = (total_t)(cd.pOld->own);
+      goto scan_subdirs;
+    }
   }
 #endif
 
-  /* Scan all files */
-  nDE = scandirX(".", &pDElist, SelectFilesCB, NULL, pConstraints);
+  /* Scan all files. No need to sort them. */
+#if defined(_UNIX)
+  nDE = ScanFilesPlus(pOpts, pConstraints, pPath, &size,
+		      (pOpts->recur || pOpts->total) ? &pDirs : NULL, &nDirs);
+#else
+  nDE = scandirX(pPath, &pList, SelectFilesCB, NULL, pConstraints);
+#endif
   if (nDE < 0) {
     iErr = errno;
     if (iVerbose || !iContinue) {
       char *pszSeverity = iContinue ? "Warning" : "Error";
-      char *pcd = getcwd(szCurDir, PATHNAME_SIZE); /* Canonic name of the target directory */
-      if (!pcd) {
-	finis(RETCODE_INACCESSIBLE, "Cannot get the current directory. %s", strerror(errno));
-      }
-      fprintf(stderr, "%s: Failed to scan files in %s. %s\n", pszSeverity, szCurDir, strerror(iErr));
+      fprintf(stderr, "%s: Failed to scan files in %s. %s\n", pszSeverity, pPath->buf, strerror(iErr));
     }
     if ((iErr == EACCES) && iContinue) {
       pOpts->nErrors += 1;
+      DEBUG_LEAVE(("return 0;\n"));
       return 0;
     }
     iErr = (iErr == EACCES) ? RETCODE_INACCESSIBLE : RETCODE_NO_MEMORY;
     finis(iErr, NULL); /* The error message has already been displayed */
   }
-  for (ppDE = pDElist; nDE--; ppDE++) {
-    pDE = *ppDE;
-    memset(&sStat, 0, sizeof(sStat));
-
-#if _DIRENT2STAT_DEFINED /* DOS/Windows return stat info in the dirent structure */
-    iErr = dirent2stat(pDE, &sStat);
-#else /* Unix has to query it separately */
-    iErr = lstat(pDE->d_name, &sStat);
-#endif
-    if (iErr) continue;
-    DEBUG_PRINTF(("// Counting %10"PRIuMAX" bytes for %-32s\n", (uintmax_t)(sStat.st_size), pDE->d_name));
-    fsize = sStat.st_size; /* Get the actual file size */
-    if (csz) {	/* If the cluster size is provided */
-		/* Round it to the next cluster multiple */
-      fsize += csz-1;
-      fsize -= fsize % csz;
-    }
-    size += fsize;  /* Totalize sizes */
-
-    free(pDE);
+  TelemetryAddFiles(nDE);
+#if !defined(_UNIX)
+  for (ppEntry = pList; nDE--; ppEntry++) {
+    pEntry = *ppEntry;
+    /* SelectFilesCB() always got the stat data */
+    size += CountFile(pOpts, pEntry->de.d_name, (uintmax_t)(pEntry->st.st_size),
+		      pEntry->st.st_mtime, (unsigned long)(pEntry->st.st_uid));
+    free(pEntry);
   }
-  free(pDElist);
+  free(pList);
+#endif
 
   /* Optionally scan all subdirectories */
+#if HAS_CACHE
+scan_subdirs:
+  own = size;
+#endif
   if (pOpts->recur || pOpts->total) {
     pOpts->depth += 1;
-    dSize = ScanDirs(pOpts, pConstraints);
+    dSize = ScanDirs(pOpts, pConstraints, pPath, pCD, pDirs, nDirs);
     pOpts->depth -= 1;
     if (pOpts->total) size += dSize;  /* Totalize sizes */
-    if (pOpts->recur) {
-      char *pcd = getcwd(szCurDir, PATHNAME_SIZE); /* Canonic name of the target directory */
-      if (!pcd) {
-	finis(RETCODE_INACCESSIBLE, "Cannot get the current directory. %s", strerror(errno));
-      }
-      TRIM_PATHNAME_BUF(szCurDir);
-      affiche(szCurDir, size);
-    }
+    if (pOpts->recur) ShowDirSize(pOpts, pPath->buf, size);
+  }
+
+#if HAS_CACHE
+  /* Record this directory sizes for the next scan */
+  if (pCD) {
+    DirCacheAdd(pOpts->pCache, pCD, own, cd.bNames ? DSC_NAMES : 0);
+    free(cd.pNames);
   }
+#endif
 
-  FREE_PATHNAME_BUF(szCurDir);
   DEBUG_LEAVE(("return %" TOTAL_FMT ";\n", size));
   return size;
 }
@@ -796,54 +1471,56 @@ total_t ScanFiles(scanOpts *pOpts, void *pConstraints) {
 *                                                                             *
 *       Arguments:                                                            *
 *         void *pConstraints	File selection constraints                    *
+*         PATHBUF *pPath	The directory pathname, and its fd in Unix    *
+*         dirCacheDir *pCD	Optional size cache data for pPath, or NULL   *
+*         dirEntry **pList	The subdirectories, if ScanFiles() listed     *
+*				them. Freed on return                         *
+*         int nDE		The number of subdirectories in pList, or -1  *
+*				to list them here                             *
 *                                                                             *
 *       Return value:   Total size of all files                               *
 *                                                                             *
-*       Notes:                                                                *
+*       Notes:          The subdirectories are opened relative to their       *
+*                       parent directory fd, and their pathnames are built    *
+*                       by appending their names to pPath. So there's no need *
+*                       to chdir() into them, nor to call getcwd() to know    *
+*                       where we are.                                         *
 *                                                                             *
 *       History:                                                              *
+*        2026-10-17 MAB Use a PATHBUF instead of chdir() and getcwd().        *
+*        2026-10-17 MAB Added the pList and nDE arguments. In Unix, list the  *
+*                       subdirectories with ScanFilesPlus() otherwise.        *
 *                                                                             *
 ******************************************************************************/
 
+#if !defined(_UNIX)
+
 #ifdef _MSC_VER
 #pragma warning(disable:4100) /* Ignore the "unreferenced formal parameter" warning */
 #endif
 
-int SelectDirsCB(const struct dirent *pDE, void *pRef) {
+int SelectDirsCB(PATHBUF *pPath, const struct dirent *pDE, struct stat *pStat, void *pRef) {
   /* Invoked by scandirX(), so d_type always valid, even under Unix */
   if (   (pDE->d_type == DT_DIR)	/* We want only directories */
       && (!streq(pDE->d_name, "."))	/* Except . */
       && (!streq(pDE->d_name, ".."))) { /* and .. */
-    return TRUE;
+    return SELECT_YES;
 #if OS_HAS_LINKS
   } else if (pDE->d_type == DT_LNK) {
     scanOpts *pOpts = pRef;
     if (pOpts->follow) {
-      struct stat s;
-      int iErr = stat(pDE->d_name, &s);
+      int iErr = StatEntry(pPath, pDE->d_name, pStat, TRUE);
       if (iErr) {
-	char *pszSeverity = iContinue ? "Warning" : "dirsize: Error";
-	if (iVerbose || !iContinue) {
-	  char *pcd = NULL;
-	  NEW_PATHNAME_BUF(szCurDir);
-	  if (szCurDir) pcd = getcwd(szCurDir, PATHNAME_SIZE); /* Canonic name of the target directory */
-	  if (!pcd) {
-	    finis(RETCODE_INACCESSIBLE, "Invalid link \"%s\". %s", pDE->d_name, strerror(errno));
-	  }
-	  fprintf(stderr, "%s: Invalid link \"%s" DIRSEPARATOR_STRING "%s\". %s\n", pszSeverity, szCurDir, pDE->d_name, strerror(errno));
-	  FREE_PATHNAME_BUF(szCurDir);
-	}
-	if (!iContinue) finis(RETCODE_INACCESSIBLE, NULL); /* The error message has already been displayed */
-	pOpts->nErrors += 1;
-      	return FALSE;
+	ReportBadLink(pOpts, pPath, pDE->d_name);
+      	return SELECT_NO;
       }
-      return S_ISDIR(s.st_mode);
+      return S_ISDIR(pStat->st_mode) ? SELECT_STAT : SELECT_NO;
     } else {
-      return FALSE;
+      return SELECT_NO;
     }
 #endif /* OS_HAS_LINKS */
   } else {
-    return FALSE;
+    return SELECT_NO;
   }
 }
 
@@ -851,177 +1528,744 @@ int SelectDirsCB(const struct dirent *pDE, void *pRef) {
 #pragma warning(default:4100) /* Ignore the "unreferenced formal parameter" warning */
 #endif
 
+#endif /* !defined(_UNIX) */
+
 /* Scan all subdirectories */
-total_t ScanDirs(scanOpts *pOpts, void *pConstraints) {
+total_t ScanDirs(scanOpts *pOpts, void *pConstraints, PATHBUF *pPath,
+		 struct _dirCacheDir *pCD, dirEntry **pList, int nDE) {
   total_t size = 0;
-  total_t dSize;
-  struct dirent *pDE;
-  struct dirent **ppDE;
-  struct dirent **pDElist;
-  int nDE;
+  dirEntry **ppEntry;
   int iErr;
-  struct stat sStat;
-  NEW_PATHNAME_BUF(szCurDir);
-
-  DEBUG_ENTER(("ScanDirs(%p);\n", pConstraints));
-
-#if PATHNAME_BUFS_IN_HEAP
-  if (!szCurDir) {
-    finis(RETCODE_NO_MEMORY, "Out of memory");
-  }
+  int bSort;
+
+  DEBUG_ENTER(("ScanDirs(%p, \"%s\");\n", pConstraints, pPath->buf));
+
+  /* Get all subdirectories. Sort them only if their sizes are displayed,
+     either by ScanFiles() in recursive mode, or here at depth 0 */
+  bSort = pOpts->recur || !pOpts->depth;
+  if (nDE < 0) { /* Else ScanFiles() listed them while reading the files */
+#if HAS_CACHE
+    if (pCD && pCD->pOld && (pCD->pOld->flags & DSC_NAMES)) { /* Unchanged dir */
+      nDE = DirCacheList(pOpts->pCache, pCD->pOld, &pList, NULL);
+    } else
 #endif
-
-  /* Get all subdirectories */
-  nDE = scandirX(".", &pDElist, SelectDirsCB, alphasort, pOpts);
+#if defined(_UNIX)
+    if (ScanFilesPlus(pOpts, pConstraints, pPath, NULL, &pList, &nDE) < 0) nDE = -1;
+#else
+    nDE = scandirX(pPath, &pList, SelectDirsCB, NULL, pOpts);
+#endif
+  }
   if (nDE < 0) {
     iErr = errno;
     if (iVerbose || !iContinue) {
       char *pszSeverity = iContinue ? "Warning" : "Error";
-      char *pcd = getcwd(szCurDir, PATHNAME_SIZE); /* Canonic name of the target directory */
-      if (!pcd) {
-	finis(RETCODE_INACCESSIBLE, "Cannot get the current directory. %s", strerror(errno));
-      }
-      fprintf(stderr, "%s: Failed to scan directories in %s. %s\n", pszSeverity, szCurDir, strerror(iErr));
+      fprintf(stderr, "%s: Failed to scan directories in %s. %s\n", pszSeverity, pPath->buf, strerror(iErr));
     }
     if ((iErr == EACCES) && iContinue) {
       pOpts->nErrors += 1;
+      DEBUG_LEAVE(("return 0;\n"));
       return 0;
     }
     iErr = (iErr == EACCES) ? RETCODE_INACCESSIBLE : RETCODE_NO_MEMORY;
     finis(iErr, NULL); /* The error message has already been displayed */
   }
-  for (ppDE = pDElist; nDE--; ppDE++) {
-    pDE = *ppDE;
+  if (bSort && (nDE > 1)) qsort(pList, nDE, sizeof(dirEntry *), (pCompareProc)alphasortX);
+#if HAS_CACHE
+  if (pCD) { /* Record the subdirectories names for the next scan */
+    for (ppEntry = pList; ppEntry < (pList + nDE); ppEntry++) {
+      DirCacheAddName(pCD, (*ppEntry)->de.d_name);
+    }
+    pCD->bNames = TRUE;
+  }
+#else
+  (void)pCD;
+#endif
+#if HAS_THREADS
+  /* Scan the subdirectories in parallel, if requested, and if threads are idle */
+  if ((pOpts->nThreads > 1) && (nDE > 1)) {
+    int nThreads = TakeThreads(nDE - 1);
+    if (nThreads) {
+      size = ScanDirsMT(pOpts, pConstraints, pPath, pList, nDE, nThreads);
+      nDE = 0; /* ScanDirsMT() freed all entries */
+    }
+  }
+#endif /* HAS_THREADS */
+  for (ppEntry = pList; nDE--; ppEntry++) {
+    size += ScanSubDir(pOpts, pConstraints, pPath, (*ppEntry)->de.d_name);
+    free(*ppEntry);
+  }
+  free(pList);
 
-#if _DIRENT2STAT_DEFINED /* DOS/Windows return stat info in the dirent structure */
-    iErr = dirent2stat(pDE, &sStat);
-#else /* Unix has to query it separately */
-    iErr = lstat(pDE->d_name, &sStat);
+  DEBUG_LEAVE(("return %" TOTAL_FMT ";\n", size));
+  return size;
+}
+
+/* Scan one subdirectory of pPath */
+total_t ScanSubDir(scanOpts *pOpts, void *pConstraints, PATHBUF *pPath, char *pszName) {
+  total_t dSize = 0;
+  int iErr;
+#if defined(_UNIX)
+  PATHBUFMARK mark;
+  double t0;
+#else
+  ssize_t len;
 #endif
 
-#if !HAS_MSVCLIBX
-    DEBUG_PRINTF(("chdir(\"%s\");\n", pDE->d_name));
-#endif
-    iErr = chdir(pDE->d_name);
-    if (iErr) {
-      char *pszSeverity = iContinue ? "Warning" : "dirsize: Error";
-      if (iVerbose || !iContinue) {
-	char *pcd = getcwd(szCurDir, PATHNAME_SIZE); /* Canonic name of the target directory */
-	if (!pcd) {
-	  finis(RETCODE_INACCESSIBLE, "Cannot get the current directory, nor access %s. %s", pDE->d_name, strerror(errno));
-	}
-      	fprintf(stderr, "%s: Cannot access directory %s" DIRSEPARATOR_STRING "%s. %s\n", pszSeverity, szCurDir, pDE->d_name, strerror(errno));
-      }
-      if (!iContinue) finis(RETCODE_INACCESSIBLE, NULL); /* The error message has already been displayed */
-      pOpts->nErrors += 1;
-    } else {
-      dSize = ScanFiles(pOpts, pConstraints);
-      if (!pOpts->depth) {
-	char *pcd = getcwd(szCurDir, PATHNAME_SIZE); /* Canonic name of the target directory */
-	if (!pcd) {
-	  finis(RETCODE_INACCESSIBLE, "Cannot get the current directory. %s", strerror(errno));
-	}
-	/* Don't trim the pathname here, as we're in a loop, and subsequent paths might be longer */
-	affiche(szCurDir, dSize);
-      }
-#if !HAS_MSVCLIBX
-      DEBUG_PRINTF(("chdir(\"..\");\n"));
+#if defined(_UNIX)
+  DEBUG_PRINTF(("openat(\"%s\");\n", pszName));
+  t0 = TelemetryBegin(TELEMETRY_OP_OPEN);
+  iErr = (PathBufPushDir(pPath, pszName, 0, &mark) < 0) ? -1 : 0;
+  TelemetryEnd(TELEMETRY_OP_OPEN, t0);
+#else
+  len = PathBufPush(pPath, pszName);
+  iErr = (len < 0) ? -1 : 0;
 #endif
-      iErr = chdir("..");
-      if (iErr) {
-	finis(RETCODE_INACCESSIBLE, "Cannot return to \"%s\" parent directory. %s", szCurDir, strerror(errno));
-      }
-  
-      size += dSize;  /* Totalize sizes */
+  if (iErr) {
+    char *pszSeverity = iContinue ? "Warning" : "dirsize: Error";
+    if (errno == ENOMEM) finis(RETCODE_NO_MEMORY, "Out of memory");
+    if (iVerbose || !iContinue) {
+      fprintf(stderr, "%s: Cannot access directory %s" DIRSEPARATOR_STRING "%s. %s\n", pszSeverity, pPath->buf, pszName, strerror(errno));
     }
-
-    free(pDE);
+    if (!iContinue) finis(RETCODE_INACCESSIBLE, NULL); /* The error message has already been displayed */
+    pOpts->nErrors += 1;
+  } else {
+    dSize = ScanFiles(pOpts, pConstraints, pPath);
+    if (!pOpts->depth) ShowDirSize(pOpts, pPath->buf, dSize);
+#if defined(_UNIX)
+    PathBufPopDir(pPath, &mark);
+#else
+    PathBufPop(pPath, (size_t)len);
+#endif
   }
-  free(pDElist);
 
-  FREE_PATHNAME_BUF(szCurDir);
-  DEBUG_LEAVE(("return %" TOTAL_FMT ";\n", size));
-  return size;
+  return dSize;
 }
 
 /******************************************************************************
 *                                                                             *
-*   Function:       affiche                                                   *
+*       Function:       ScanDirsMT                                            *
 *                                                                             *
-*   Description:	Display the directory size found		      *
+*       Description:    Scan subdirectories in parallel threads               *
 *                                                                             *
-*   Arguments:                                                                *
+*       Arguments:                                                            *
+*         scanOpts *pOpts	Scan options. pOpts->nThreads = # of threads  *
+*         void *pConstraints	File selection constraints                    *
+*         PATHBUF *pPath	The parent directory pathname, and its fd     *
+*         dirEntry **pList	The subdirectories. Freed on return           *
+*         int nEntries		The number of subdirectories                  *
+*         int nThreads		Number of threads to start, from TakeThreads()*
 *                                                                             *
-*      char *path	Name of the directory				      *
-*      total_t size	Size found					      *
+*       Return value:   Total size of all files                               *
 *                                                                             *
-*   Return value:   0=Success; !0=Failure                                     *
+*       Notes:          Each subdirectory is a task, scanned by the first     *
+*                       available thread, with its own copy of the scan       *
+*                       options and its own size accumulator.                 *
+*                       The output lines of each task are buffered, and the   *
+*                       calling thread displays them as soon as the task, and *
+*                       all the tasks before it, are done. So the output is   *
+*                       the same, and in the same order, as in a serial scan. *
+*                       In the meantime, the calling thread scans tasks too.  *
 *                                                                             *
-*   Notes:              Using a dedicated type allows to avoid using the      *
-*                       floating point libraries if we can.                   *
+*                       This is done at every depth, as long as the -j        *
+*                       threads budget allows starting more threads. So a     *
+*                       tree with a single large subdirectory is scanned in   *
+*                       parallel too. The worker threads return to the budget *
+*                       when their pool has no more tasks to start.           *
 *                                                                             *
-*   History:                                                                  *
-*    2001-04-10 JFL Fixed a bug when displaying sizes with intermediates 0s.  *
-*    2012-01-17 JFL Made the size argument type a macro depending on the      *
-*                   compiler capabilities.                                    *
+*                       finis() in a worker thread records the exit code in   *
+*                       iAbort, and exits that thread only. Its tasks are     *
+*                       marked aborted, the pools stop starting new tasks,    *
+*                       and the main thread exits when its own pool is done.  *
+*                                                                             *
+*       History:                                                              *
+*        2026-10-17 MAB Created this routine.                                 *
+*        2026-10-17 MAB Scan subdirectories in parallel at all depths.        *
+*                       Report fatal errors from the main thread.             *
 *                                                                             *
 ******************************************************************************/
 
-/* Display a huge integer with optional commas every three digits. */
-int Size2String(char *pBuf, total_t llSize) {
-  int n = 0;
-  char *pszFormat = "%" TOTAL_FMT;
-
-#if TOTAL_T_IS_INT
-  if (llSize >= 1000) {
-    n = Size2String(pBuf, llSize/1000);
-    llSize = llSize % 1000;
-    if (iHuman) pBuf[n++] = ',';
-    pszFormat = "%03" TOTAL_FMT; /*  Display leading 0s for the following groups */
-  }
-#else /* type is double */
-  if (llSize >= 1000.) {
-    n = Size2String(pBuf, floor(llSize/1000.));
-    llSize = floor(fmod(llSize, 1000.) + 0.5);	/* llSize %= 1000. */
-    if (iHuman) pBuf[n++] = ',';
-    pszFormat = "%03" TOTAL_FMT; /*  Display leading 0s for the following groups */
-  }
-#endif
-  n += sprintf(pBuf+n, pszFormat, llSize);
-  return n;
+#if HAS_THREADS
+
+/* Reserve up to nThreads idle threads. Returns the number reserved. */
+int TakeThreads(int nThreads) {
+  int nIdle = __atomic_load_n(&nIdleThreads, __ATOMIC_RELAXED);
+  do {
+    if (nIdle <= 0) return 0;
+    if (nThreads > nIdle) nThreads = nIdle;
+  } while (!__atomic_compare_exchange_n(&nIdleThreads, &nIdle, nIdle - nThreads,
+					FALSE, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+  return nThreads;
 }
 
-/* Convert Bytes to KBytes */
-total_t b2k(total_t llSize) {
-  llSize = (llSize + 1023) / 1024;
-#if !TOTAL_T_IS_INT
-  llSize = floor(llSize);
-#endif
-  return llSize;
+void ReturnThreads(int nThreads) {
+  __atomic_add_fetch(&nIdleThreads, nThreads, __ATOMIC_RELAXED);
 }
 
-/* Idem, using the user-specified unit. */
-int Size2StringWithUnit(char *pBuf, total_t llSize) {
-  int n;
-  int iShowUnit = 1;
+/* Mark a task done. Also invoked by pthread_exit() if finis() aborted it. */
+void ScanTaskDone(void *pArg) {
+  scanTask *pTask = pArg;
+  scanPool *pPool = pTask->opts.pPool;
 
-  switch (*pszUnit) {
-  case 'B': iShowUnit = 0; break;
-  case 'K': llSize = b2k(llSize); break;
-  case 'M': llSize = b2k(b2k(llSize)); break;
-  case 'G': llSize = b2k(b2k(b2k(llSize))); break;
-  }
+  pthread_mutex_lock(&pPool->mutex);
+  if (!pTask->done) pTask->aborted = TRUE; /* Not reached the normal end */
+  pTask->done = TRUE;
+  pthread_cond_broadcast(&pPool->cond);
+  pthread_mutex_unlock(&pPool->mutex);
+}
 
-  n = Size2String(pBuf, llSize);
+/* Scan the next task not started yet. Returns FALSE if there's none left. */
+int ScanNextTask(scanPool *pPool, PATHBUF *pPath) {
+  scanTask *pTask;
 
-  if (iShowUnit) {
-    n += sprintf(pBuf+n, " %s", pszUnit);
+  pthread_mutex_lock(&pPool->mutex);
+  if (pPool->iNext >= pPool->nTasks) {
+    pthread_mutex_unlock(&pPool->mutex);
+    return FALSE;
+  }
+  pTask = pPool->pTasks + pPool->iNext++;
+  if (__atomic_load_n(&iAbort, __ATOMIC_RELAXED)) { /* Don't start new tasks then */
+    pTask->done = pTask->aborted = TRUE;
+    pthread_cond_broadcast(&pPool->cond);
+    pthread_mutex_unlock(&pPool->mutex);
+    return TRUE;
   }
+  pthread_mutex_unlock(&pPool->mutex);
+
+  pthread_cleanup_push(ScanTaskDone, pTask);
+  pTask->size = ScanSubDir(&pTask->opts, pPool->pConstraints, pPath, pTask->name);
+  pthread_mutex_lock(&pPool->mutex);
+  pTask->done = TRUE;
+  pthread_mutex_unlock(&pPool->mutex);
+  pthread_cleanup_pop(TRUE); /* Wakes up the thread displaying the results */
+  return TRUE;
+}
 
-  return n;
+/* Initialize a private copy of the pool parent directory PATHBUF */
+void ScanPathInit(scanPool *pPool, PATHBUF *pPath) {
+  PathBufInit(pPath);
+  if (PathBufSet(pPath, pPool->pParent->buf)) finis(RETCODE_NO_MEMORY, "Out of memory");
+  pPath->fd = pPool->pParent->fd; /* Shared, but only used for openat() */
 }
 
-void affiche(char *path, total_t llSize) {
+void ScanPathFree(PATHBUF *pPath) {
+  pPath->fd = AT_FDCWD; /* Don't let PathBufFree() close the parent fd */
+  PathBufFree(pPath);
+}
+
+void ScanWorkerExit(void *pArg) {
+  (void)pArg;
+  ReturnThreads(1);		/* Let other pools use this thread */
+}
+
+void *ScanWorker(void *pArg) {
+  scanPool *pPool = pArg;
+  PATHBUF path;
+
+  pthread_cleanup_push(ScanWorkerExit, NULL);
+  ScanPathInit(pPool, &path);
+  while (ScanNextTask(pPool, &path)) ;
+  ScanPathFree(&path);
+  pthread_cleanup_pop(TRUE);
+  return NULL;
+}
+
+/* Display the results of a task, and add them to the parent's */
+void ScanTaskShow(scanOpts *pOpts, scanTask *pTask, int bShow) {
+  int j;
+
+  for (j = 0; j < pTask->nLines; j++) {
+    if (bShow) ShowDirSize(pOpts, pTask->pLines[j].path, pTask->pLines[j].size);
+    free(pTask->pLines[j].path);
+  }
+  free(pTask->pLines);
+  pOpts->nErrors += pTask->opts.nErrors;
+  if (pTask->pProfile) {
+    MergeProfile(pOpts->pProfile, pTask->pProfile);
+    FreeProfile(pTask->pProfile);
+  }
+}
+
+/* Stop a pool, and wait for its workers. Also invoked by pthread_exit() if
+   finis() exits the calling thread, as the workers use the pool on its stack. */
+void ScanPoolStop(void *pArg) {
+  scanPool *pPool = pArg;
+  int i;
+
+  pthread_mutex_lock(&pPool->mutex);
+  for ( ; pPool->iNext < pPool->nTasks; pPool->iNext++) { /* Don't start the others */
+    pPool->pTasks[pPool->iNext].done = pPool->pTasks[pPool->iNext].aborted = TRUE;
+  }
+  pthread_mutex_unlock(&pPool->mutex);
+  for (i = 0; i < pPool->nStarted; i++) pthread_join(pPool->pThreads[i], NULL);
+  pthread_cond_destroy(&pPool->cond);
+  pthread_mutex_destroy(&pPool->mutex);
+  free(pPool->pThreads);
+}
+
+total_t ScanDirsMT(scanOpts *pOpts, void *pConstraints, PATHBUF *pPath,
+		   dirEntry **pList, int nDE, int nThreads) {
+  total_t size = 0;
+  scanPool pool = {0};
+  PATHBUF path;
+  int iShown = 0;		/* Number of tasks displayed */
+  int bShow = TRUE;		/* FALSE after an aborted task */
+  int i;
+
+  DEBUG_ENTER(("ScanDirsMT(%p, \"%s\", %d, %d);\n", pConstraints, pPath->buf, nDE, nThreads));
+
+  pool.pTasks = calloc(nDE, sizeof(scanTask));
+  pool.pThreads = malloc(nThreads * sizeof(pthread_t));
+  if (!pool.pTasks || !pool.pThreads) {
+    ReturnThreads(nThreads);
+    finis(RETCODE_NO_MEMORY, "Out of memory");
+  }
+  pool.nTasks = nDE;
+  pool.pParent = pPath;
+  pool.pConstraints = pConstraints;
+  pthread_mutex_init(&pool.mutex, NULL);
+  pthread_cond_init(&pool.cond, NULL);
+  for (i = 0; i < nDE; i++) {
+    scanTask *pTask = pool.pTasks + i;
+    pTask->name = pList[i]->de.d_name;
+    pTask->opts = *pOpts;
+    pTask->opts.nErrors = 0;
+    pTask->opts.pTask = pTask;
+    pTask->opts.pPool = &pool;
+    if (pOpts->pProfile) pTask->pProfile = pTask->opts.pProfile = NewProfile();
+  }
+
+  for (pool.nStarted = 0; pool.nStarted < nThreads; pool.nStarted++) {
+    if (pthread_create(pool.pThreads + pool.nStarted, NULL, ScanWorker, &pool)) break;
+  }
+  ReturnThreads(nThreads - pool.nStarted);
+  pthread_cleanup_push(ScanPoolStop, &pool);
+
+  /* Scan tasks in this thread too, and display the results in order, as
+     soon as they're available. pPath is left alone, as the workers copy it. */
+  ScanPathInit(&pool, &path);
+  while (iShown < nDE) {
+    scanTask *pTask = pool.pTasks + iShown;
+    int bDone;
+    pthread_mutex_lock(&pool.mutex);
+    bDone = pTask->done;
+    pthread_mutex_unlock(&pool.mutex);
+    if (bDone) {
+      if (pTask->aborted) bShow = FALSE; /* A serial scan would have stopped there */
+      ScanTaskShow(pOpts, pTask, bShow);
+      size += pTask->size;
+      iShown += 1;
+      continue;
+    }
+    if (ScanNextTask(&pool, &path)) continue;
+    /* All tasks are started. Wait for the next one to display. */
+    pthread_mutex_lock(&pool.mutex);
+    while (!pTask->done) pthread_cond_wait(&pool.cond, &pool.mutex);
+    pthread_mutex_unlock(&pool.mutex);
+  }
+  ScanPathFree(&path);
+  pthread_cleanup_pop(TRUE); /* Join the workers */
+
+  for (i = 0; i < nDE; i++) free(pList[i]);
+  free(pool.pTasks);
+
+  /* If a worker thread failed, exit from the main thread */
+  i = __atomic_load_n(&iAbort, __ATOMIC_RELAXED);
+  if (i) finis(i, NULL); /* The error message has already been displayed */
+
+  DEBUG_LEAVE(("return %" TOTAL_FMT ";\n", size));
+  return size;
+}
+
+#endif /* HAS_THREADS */
+
+/******************************************************************************
+*                                                                             *
+*       Function:       DirCacheLoad                                          *
+*                                                                             *
+*       Description:    Map in memory the size cache of the previous scan     *
+*                                                                             *
+*       Arguments:                                                            *
+*         dirCache *pCache	The cache. pCache->pszFile = Its pathname     *
+*         selectOpts *pC	File selection constraints                    *
+*         scanOpts *pOpts	Scan options                                  *
+*                                                                             *
+*       Return value:   None                                                  *
+*                                                                             *
+*       Notes:          The cache is keyed by the device and inode numbers of *
+*                       the directories. A directory record is valid as long  *
+*                       as the directory mtime has not changed.               *
+*                       Only each directory's own files size is cached. A     *
+*                       change deep in a subtree does not change the mtime of *
+*                       the directories above it, so the subtree totals are   *
+*                       always added up again from the cached sizes.          *
+*                       The sizes depend on the selection options, so a cache *
+*                       made with other options is ignored.                   *
+*                       A missing or invalid file is not an error: All        *
+*                       directories are read, and the file is recreated.      *
+*                                                                             *
+*       History:                                                              *
+*        2026-10-17 MAB Created this routine.                                 *
+*                                                                             *
+******************************************************************************/
+
+#if HAS_CACHE
+
+void DirCacheLoad(dirCache *pCache, selectOpts *pC, scanOpts *pOpts) {
+  char szOpts[100];
+  int iFile;
+  struct stat st;
+  const dscHeader *pHdr;
+  void *pMap;
+  size_t lMap;
+  int iFollow = 0;
+
+#if OS_HAS_LINKS
+  iFollow = pOpts->follow;
+#endif
+  sprintf(szOpts, "%ld %ld %ld %d", (long)pC->datemin, (long)pC->datemax, csz, iFollow);
+  pCache->signature = HashString(szOpts) ^ (HashString(pC->pattern ? pC->pattern : "") * 0x100000001B3ULL);
+  pCache->tStart = time(NULL);
+#if HAS_THREADS
+  pthread_mutex_init(&pCache->mutex, NULL);
+#endif
+
+  iFile = open(pCache->pszFile, O_RDONLY | O_CLOEXEC);
+  if (iFile < 0) return; /* No previous scan */
+  if (fstat(iFile, &st) || (st.st_size < (off_t)sizeof(dscHeader))) {
+    close(iFile);
+    return;
+  }
+  lMap = (size_t)st.st_size;
+  pMap = mmap(NULL, lMap, PROT_READ, MAP_SHARED, iFile, 0);
+  close(iFile); /* The mapping remains valid */
+  if (pMap == MAP_FAILED) return;
+
+  pHdr = pMap;
+  if (   (pHdr->magic != DSC_MAGIC)
+      || (pHdr->version != DSC_VERSION)
+      || (pHdr->nRecords > ((lMap - sizeof(dscHeader)) / sizeof(dscRecord)))
+      || ((sizeof(dscHeader) + (pHdr->nRecords * sizeof(dscRecord)) + pHdr->lNames) != lMap)
+      || (pHdr->lNames && ((char *)pMap)[lMap-1])) {
+    fprintf(stderr, "Warning: Ignoring invalid cache file %s\n", pCache->pszFile);
+    munmap(pMap, lMap);
+    return;
+  }
+  if (pHdr->signature != pCache->signature) {
+    if (iVerbose) printf("Ignoring the cache file, made with different options.\n");
+    munmap(pMap, lMap);
+    return;
+  }
+
+  pCache->pMap = pMap;
+  pCache->lMap = lMap;
+  pCache->pOld = (const dscRecord *)(pHdr + 1);
+  pCache->nOld = pHdr->nRecords;
+  pCache->pOldNames = (const char *)(pCache->pOld + pCache->nOld);
+  pCache->lOldNames = pHdr->lNames;
+}
+
+/* Get the record of a directory, if it has not changed since the previous scan */
+const dscRecord *DirCacheLookup(dirCache *pCache, struct stat *pStat) {
+  uint64_t dev = (uint64_t)pStat->st_dev;
+  uint64_t ino = (uint64_t)pStat->st_ino;
+  uint64_t lo = 0;
+  uint64_t hi = pCache->nOld;
+
+  while (lo < hi) { /* Binary search in the records sorted by (dev, ino) */
+    uint64_t mid = lo + (hi - lo) / 2;
+    const dscRecord *pRec = pCache->pOld + mid;
+    if ((pRec->dev < dev) || ((pRec->dev == dev) && (pRec->ino < ino))) {
+      lo = mid + 1;
+    } else if ((pRec->dev > dev) || (pRec->ino > ino)) {
+      hi = mid;
+    } else { /* Found it. Is it still valid? */
+      if (   (pRec->mtime == (int64_t)pStat->st_mtime)
+	  && (pRec->mtimeNs == (int64_t)ST_MTIME_NS(pStat))
+	  && (pRec->oNames <= pCache->lOldNames)) {
+	return pRec;
+      }
+      break;
+    }
+  }
+  return NULL;
+}
+
+/* Get the subdirectories list of an unchanged directory, like scandirX() does */
+int DirCacheList(dirCache *pCache, const dscRecord *pRec, dirEntry ***resultList,
+		 int (CDECL *cbCompare) (const dirEntry **, const dirEntry **)) {
+  const char *pszName = pCache->pOldNames + pRec->oNames;
+  const char *pszEnd = pCache->pOldNames + pCache->lOldNames;
+  dirEntry **pList;
+  dirEntry *pEntry;
+  int n;
+
+  pList = malloc((pRec->nNames ? pRec->nNames : 1) * sizeof(dirEntry *));
+  if (!pList) goto out_of_memory;
+  for (n = 0; (n < (int)pRec->nNames) && (pszName < pszEnd); n++) {
+    pEntry = malloc(sizeof(dirEntry));
+    if (!pEntry) goto out_of_memory;
+    strncpyz(pEntry->de.d_name, pszName, sizeof(pEntry->de.d_name));
+    pEntry->de.d_type = DT_DIR;
+    pEntry->bStat = FALSE;
+    pList[n] = pEntry;
+    pszName += strlen(pszName) + 1;
+  }
+
+  if (cbCompare) qsort(pList, n, sizeof(dirEntry *), (pCompareProc)cbCompare);
+  *resultList = pList;
+  return n;
+
+out_of_memory:
+  if (pList) while (n > 0) free(pList[--n]);
+  free(pList);
+  errno = ENOMEM;
+  return -1;
+}
+
+/* Record the name of a subdirectory of the directory being scanned */
+void DirCacheAddName(dirCacheDir *pCD, const char *pszName) {
+  size_t l = strlen(pszName) + 1;
+
+  if ((pCD->lNames + l) > pCD->lNamesAlloc) {
+    size_t lNew = pCD->lNamesAlloc ? 2 * pCD->lNamesAlloc : 256;
+    char *pNew;
+    while (lNew < (pCD->lNames + l)) lNew *= 2;
+    pNew = realloc(pCD->pNames, lNew);
+    if (!pNew) finis(RETCODE_NO_MEMORY, "Out of memory");
+    pCD->pNames = pNew;
+    pCD->lNamesAlloc = lNew;
+  }
+  memcpy(pCD->pNames + pCD->lNames, pszName, l);
+  pCD->lNames += l;
+  pCD->nNames += 1;
+}
+
+/* Record the sizes of a scanned directory, for the next scan */
+void DirCacheAdd(dirCache *pCache, dirCacheDir *pCD, total_t own, int iFlags) {
+  const char *pNames = pCD->pNames;
+  size_t lNames = pCD->lNames;
+  uint32_t nNames = pCD->nNames;
+  dscRecord *pRec;
+
+  /* If the subdirectories were not listed this time, the old list is still valid */
+  if (!(iFlags & DSC_NAMES) && pCD->pOld && (pCD->pOld->flags & DSC_NAMES)) {
+    const char *pszEnd = pCache->pOldNames + pCache->lOldNames;
+    pNames = pCache->pOldNames + pCD->pOld->oNames;
+    for (lNames = 0, nNames = 0; (nNames < pCD->pOld->nNames) && ((pNames + lNames) < pszEnd); nNames++) {
+      lNames += strlen(pNames + lNames) + 1;
+    }
+    iFlags |= DSC_NAMES;
+  }
+
+#if HAS_THREADS
+  pthread_mutex_lock(&pCache->mutex);
+#endif
+  if (pCD->pOld) {
+    pCache->nHits += 1;
+  } else {
+    pCache->nMisses += 1;
+  }
+  /* Don't record directories that changed since the scan started, as they
+     may change again later on without changing their mtime seconds */
+  if (pCD->st.st_mtime >= pCache->tStart) goto cleanup;
+
+  if (pCache->nNew == pCache->nNewAlloc) {
+    uint64_t nNew = pCache->nNewAlloc ? 2 * pCache->nNewAlloc : 1024;
+    dscRecord *pNew = realloc(pCache->pNew, (size_t)(nNew * sizeof(dscRecord)));
+    if (!pNew) goto out_of_memory;
+    pCache->pNew = pNew;
+    pCache->nNewAlloc = nNew;
+  }
+  if ((pCache->lNewNames + lNames) > pCache->lNewNamesAlloc) {
+    uint64_t lNew = pCache->lNewNamesAlloc ? 2 * pCache->lNewNamesAlloc : 65536;
+    char *pNew;
+    while (lNew < (pCache->lNewNames + lNames)) lNew *= 2;
+    pNew = realloc(pCache->pNewNames, (size_t)lNew);
+    if (!pNew) goto out_of_memory;
+    pCache->pNewNames = pNew;
+    pCache->lNewNamesAlloc = lNew;
+  }
+
+  pRec = pCache->pNew + pCache->nNew++;
+  pRec->dev = (uint64_t)pCD->st.st_dev;
+  pRec->ino = (uint64_t)pCD->st.st_ino;
+  pRec->mtime = (int64_t)pCD->st.st_mtime;
+  pRec->mtimeNs = (int64_t)ST_MTIME_NS(&pCD->st);
+  pRec->own = (uint64_t)own;
+  pRec->oNames = pCache->lNewNames;
+  pRec->nNames = (iFlags & DSC_NAMES) ? nNames : 0;
+  pRec->flags = (uint32_t)iFlags;
+  if (iFlags & DSC_NAMES) {
+    memcpy(pCache->pNewNames + pCache->lNewNames, pNames, lNames);
+    pCache->lNewNames += lNames;
+  }
+
+cleanup:
+#if HAS_THREADS
+  pthread_mutex_unlock(&pCache->mutex);
+#endif
+  return;
+
+out_of_memory:		/* Don't exit with the mutex locked */
+#if HAS_THREADS
+  pthread_mutex_unlock(&pCache->mutex);
+#endif
+  finis(RETCODE_NO_MEMORY, "Out of memory");
+}
+
+/* Sort records by device and inode */
+int CDECL DirCacheCompare(const dscRecord *pRec1, const dscRecord *pRec2) {
+  if (pRec1->dev != pRec2->dev) return (pRec1->dev < pRec2->dev) ? -1 : 1;
+  if (pRec1->ino != pRec2->ino) return (pRec1->ino < pRec2->ino) ? -1 : 1;
+  return 0;
+}
+
+/* Write the new records into a temporary file, then rename it as the cache.
+   So concurrent or interrupted scans always see a complete cache file. */
+int DirCacheSave(dirCache *pCache) {
+  dscHeader hdr = {0};
+  char *pszTemp;
+  int iFile;
+  FILE *hf;
+  uint64_t i, n;
+  int iErr = 0;
+
+  qsort(pCache->pNew, (size_t)pCache->nNew, sizeof(dscRecord), (pCompareProc)DirCacheCompare);
+  /* Keep only one record for directories reached through several links */
+  for (i = n = 0; i < pCache->nNew; i++) {
+    if (n && !DirCacheCompare(pCache->pNew + n - 1, pCache->pNew + i)) continue;
+    pCache->pNew[n++] = pCache->pNew[i];
+  }
+
+  hdr.magic = DSC_MAGIC;
+  hdr.version = DSC_VERSION;
+  hdr.signature = pCache->signature;
+  hdr.nRecords = n;
+  hdr.lNames = pCache->lNewNames;
+
+  pszTemp = malloc(strlen(pCache->pszFile) + 8);
+  if (!pszTemp) return -1;
+  sprintf(pszTemp, "%s.XXXXXX", pCache->pszFile);
+  iFile = mkstemp(pszTemp);
+  if (iFile < 0) {
+    free(pszTemp);
+    return -1;
+  }
+  hf = fdopen(iFile, "wb");
+  if (!hf) {
+    close(iFile);
+    goto cleanup_error;
+  }
+  if (   (fwrite(&hdr, sizeof(hdr), 1, hf) != 1)
+      || (fwrite(pCache->pNew, sizeof(dscRecord), (size_t)n, hf) != (size_t)n)
+      || (fwrite(pCache->pNewNames, 1, (size_t)hdr.lNames, hf) != (size_t)hdr.lNames)
+      || fflush(hf)
+      || fsync(iFile)) {
+    fclose(hf);
+    goto cleanup_error;
+  }
+  if (fclose(hf)) goto cleanup_error;
+  if (rename(pszTemp, pCache->pszFile)) goto cleanup_error;
+  free(pszTemp);
+  return 0;
+
+cleanup_error:
+  iErr = errno;
+  unlink(pszTemp);
+  free(pszTemp);
+  errno = iErr;
+  return -1;
+}
+
+void DirCacheFree(dirCache *pCache) {
+  if (pCache->pMap) munmap(pCache->pMap, pCache->lMap);
+  free(pCache->pNew);
+  free(pCache->pNewNames);
+#if HAS_THREADS
+  pthread_mutex_destroy(&pCache->mutex);
+#endif
+}
+
+#endif /* HAS_CACHE */
+
+/******************************************************************************
+*                                                                             *
+*   Function:       affiche                                                   *
+*                                                                             *
+*   Description:	Display the directory size found		      *
+*                                                                             *
+*   Arguments:                                                                *
+*                                                                             *
+*      char *path	Name of the directory				      *
+*      total_t size	Size found					      *
+*                                                                             *
+*   Return value:   0=Success; !0=Failure                                     *
+*                                                                             *
+*   Notes:              Using a dedicated type allows to avoid using the      *
+*                       floating point libraries if we can.                   *
+*                                                                             *
+*   History:                                                                  *
+*    2001-04-10 JFL Fixed a bug when displaying sizes with intermediates 0s.  *
+*    2012-01-17 JFL Made the size argument type a macro depending on the      *
+*                   compiler capabilities.                                    *
+*                                                                             *
+******************************************************************************/
+
+/* Display a huge integer with optional commas every three digits. */
+int Size2String(char *pBuf, total_t llSize) {
+  int n = 0;
+  char *pszFormat = "%" TOTAL_FMT;
+
+#if TOTAL_T_IS_INT
+  if (llSize >= 1000) {
+    n = Size2String(pBuf, llSize/1000);
+    llSize = llSize % 1000;
+    if (iHuman) pBuf[n++] = ',';
+    pszFormat = "%03" TOTAL_FMT; /*  Display leading 0s for the following groups */
+  }
+#else /* type is double */
+  if (llSize >= 1000.) {
+    n = Size2String(pBuf, floor(llSize/1000.));
+    llSize = floor(fmod(llSize, 1000.) + 0.5);	/* llSize %= 1000. */
+    if (iHuman) pBuf[n++] = ',';
+    pszFormat = "%03" TOTAL_FMT; /*  Display leading 0s for the following groups */
+  }
+#endif
+  n += sprintf(pBuf+n, pszFormat, llSize);
+  return n;
+}
+
+/* Convert Bytes to KBytes */
+total_t b2k(total_t llSize) {
+  llSize = (llSize + 1023) / 1024;
+#if !TOTAL_T_IS_INT
+  llSize = floor(llSize);
+#endif
+  return llSize;
+}
+
+/* Idem, using the user-specified unit. */
+int Size2StringWithUnit(char *pBuf, total_t llSize) {
+  int n;
+  int iShowUnit = 1;
+
+  switch (*pszUnit) {
+  case 'B': iShowUnit = 0; break;
+  case 'K': llSize = b2k(llSize); break;
+  case 'M': llSize = b2k(b2k(llSize)); break;
+  case 'G': llSize = b2k(b2k(b2k(llSize))); break;
+  }
+
+  n = Size2String(pBuf, llSize);
+
+  if (iShowUnit) {
+    n += sprintf(pBuf+n, " %s", pszUnit);
+  }
+
+  return n;
+}
+
+void affiche(char *path, total_t llSize) {
   static int group=0;
   char szSize[40];
 
@@ -1037,6 +2281,408 @@ void affiche(char *path, total_t llSize) {
   return;
 }
 
+/* Display a directory size, or in a worker thread buffer it for ScanDirsMT() */
+void ShowDirSize(scanOpts *pOpts, char *path, total_t llSize) {
+  if (llSize < llMinSize) return; /* Too small to be reported */
+  if (nTop) { /* Only the largest are reported, at the end */
+    AddTopDir(path, llSize);
+    return;
+  }
+#if HAS_THREADS
+  scanTask *pTask = pOpts->pTask;
+  if (pTask) {
+    if (pTask->nLines == pTask->nLinesAlloc) {
+      int nNew = pTask->nLinesAlloc ? 2 * pTask->nLinesAlloc : 16;
+      dirSizeLine *pNew = realloc(pTask->pLines, nNew * sizeof(dirSizeLine));
+      if (!pNew) finis(RETCODE_NO_MEMORY, "Out of memory");
+      pTask->pLines = pNew;
+      pTask->nLinesAlloc = nNew;
+    }
+    pTask->pLines[pTask->nLines].path = strdup(path);
+    if (!pTask->pLines[pTask->nLines].path) finis(RETCODE_NO_MEMORY, "Out of memory");
+    pTask->pLines[pTask->nLines++].size = llSize;
+    return;
+  }
+#endif /* HAS_THREADS */
+  affiche(path, llSize);
+}
+
+/******************************************************************************
+*                                                                             *
+*   Function:       AddTopDir                                                 *
+*                                                                             *
+*   Description:    Keep a directory if it's one of the nTop largest          *
+*                                                                             *
+*   Arguments:                                                                *
+*                                                                             *
+*      char *path	Name of the directory				      *
+*      total_t size	Size found					      *
+*                                                                             *
+*   Return value:   None                                                      *
+*                                                                             *
+*   Notes:          pTopDirs is a min-heap, with the smallest of the largest  *
+*                   directories at its root. A new directory replaces it if   *
+*                   it's larger. So the memory used is bounded by nTop, and   *
+*                   each directory costs at most log2(nTop) comparisons.      *
+*                   Equal sizes are ordered by pathname, so that the result   *
+*                   does not depend on the scan order.                        *
+*                                                                             *
+*   History:                                                                  *
+*    2026-10-17 MAB Created this routine.                                     *
+*                                                                             *
+******************************************************************************/
+
+/* Return TRUE if directory 1 ranks below directory 2 */
+int TopDirLess(const dirSizeLine *pDir1, const dirSizeLine *pDir2) {
+  if (pDir1->size != pDir2->size) return pDir1->size < pDir2->size;
+  return strcmp(pDir1->path, pDir2->path) > 0;
+}
+
+void AddTopDir(char *path, total_t llSize) {
+  dirSizeLine dir;
+  int i, j;
+  int bNoMem = FALSE;
+
+  dir.path = path;
+  dir.size = llSize;
+#if HAS_THREADS
+  pthread_mutex_lock(&topMutex);
+#endif
+  if (nTopDirs < nTop) { /* The heap is not full yet. Sift the new one up */
+    for (i = nTopDirs++; i > 0; i = j) {
+      j = (i - 1) / 2;
+      if (!TopDirLess(&dir, pTopDirs + j)) break;
+      pTopDirs[i] = pTopDirs[j];
+    }
+  } else if (TopDirLess(pTopDirs, &dir)) { /* Replace the root. Sift it down */
+    free(pTopDirs[0].path);
+    for (i = 0; (j = 2*i + 1) < nTopDirs; i = j) {
+      if (((j+1) < nTopDirs) && TopDirLess(pTopDirs + j + 1, pTopDirs + j)) j += 1;
+      if (!TopDirLess(pTopDirs + j, &dir)) break;
+      pTopDirs[i] = pTopDirs[j];
+    }
+  } else { /* Too small */
+    goto cleanup;
+  }
+  pTopDirs[i].path = strdup(path);
+  pTopDirs[i].size = llSize;
+  bNoMem = !pTopDirs[i].path;
+cleanup:
+#if HAS_THREADS
+  pthread_mutex_unlock(&topMutex);
+#endif
+  if (bNoMem) finis(RETCODE_NO_MEMORY, "Out of memory"); /* Not with the mutex locked */
+  return;
+}
+
+/* Sort directories by decreasing size */
+int CDECL CompareTopDirs(const dirSizeLine *pDir1, const dirSizeLine *pDir2) {
+  if (TopDirLess(pDir2, pDir1)) return -1;
+  if (TopDirLess(pDir1, pDir2)) return 1;
+  return 0;
+}
+
+void ShowTopDirs(void) {
+  int i;
+
+  qsort(pTopDirs, nTopDirs, sizeof(dirSizeLine), (pCompareProc)CompareTopDirs);
+  for (i = 0; i < nTopDirs; i++) {
+    affiche(pTopDirs[i].path, pTopDirs[i].size);
+    free(pTopDirs[i].path);
+  }
+  nTopDirs = 0;
+}
+
+/******************************************************************************
+*                                                                             *
+*   Function:       ProfileFile                                               *
+*                                                                             *
+*   Description:    Add a file to the size profile                            *
+*                                                                             *
+*   Arguments:                                                                *
+*                                                                             *
+*      sizeProfile *pProfile	The profile to update			      *
+*      char *pszName		The file name				      *
+*      struct stat *pStat	The file stat data			      *
+*      total_t size		The file size, rounded to the cluster size    *
+*                                                                             *
+*   Return value:   None                                                      *
+*                                                                             *
+*   Notes:          The profile aggregates the number and size of files by    *
+*                   mtime age range, by extension, and by owner, all during   *
+*                   the same scan. So there's no need to run dirsize again    *
+*                   for every date range or pattern to be studied.            *
+*                   Extensions are compared in lower case. Names with no dot, *
+*                   or only a leading dot, or with an extension longer than   *
+*                   MAX_EXT_LENGTH, are counted as having no extension.       *
+*                   Each -j worker thread fills its own profile, which is     *
+*                   merged into the main one afterwards.                      *
+*                                                                             *
+*   History:                                                                  *
+*    2026-10-17 MAB Created this routine.                                     *
+*                                                                             *
+******************************************************************************/
+
+size_t HASH_KEY(extEntry)(extEntry *pEntry) {return HashString(pEntry->ext);}
+int HASH_CMP(extEntry)(extEntry *pEntry1, extEntry *pEntry2) {return strcmp(pEntry1->ext, pEntry2->ext);}
+HASH_DEFINE_PROCS(extTable, extEntry);
+
+size_t HASH_KEY(uidEntry)(uidEntry *pEntry) {return HashBytes(&pEntry->uid, sizeof(pEntry->uid));}
+int HASH_CMP(uidEntry)(uidEntry *pEntry1, uidEntry *pEntry2) {return pEntry1->uid != pEntry2->uid;}
+HASH_DEFINE_PROCS(uidTable, uidEntry);
+
+sizeProfile *NewProfile(void) {
+  sizeProfile *pProfile = calloc(1, sizeof(sizeProfile));
+  if (pProfile) pProfile->pAges = calloc(nAges + 1, sizeof(sizeBucket));
+  if (pProfile) pProfile->pExts = new_extEntry_hash();
+  if (pProfile) pProfile->pUids = new_uidEntry_hash();
+  if (!pProfile || !pProfile->pAges || !pProfile->pExts || !pProfile->pUids) {
+    finis(RETCODE_NO_MEMORY, "Out of memory");
+  }
+  return pProfile;
+}
+
+void FreeProfile(sizeProfile *pProfile) {
+  free(pProfile->pAges);
+  free_extEntry_hash(pProfile->pExts);
+  free_uidEntry_hash(pProfile->pUids);
+  free(pProfile);
+}
+
+void AddToBucket(sizeBucket *pBucket, total_t size, uintmax_t nFiles) {
+  pBucket->size += size;
+  pBucket->nFiles += nFiles;
+}
+
+/* Add a number of files to the bucket for an extension */
+void ProfileExt(sizeProfile *pProfile, const char *pszExt, total_t size, uintmax_t nFiles) {
+  extEntry ext = {0};
+  extEntry *pExt;
+
+  strncpyz(ext.ext, pszExt, sizeof(ext.ext));
+  pExt = put_extEntry(pProfile->pExts, &ext, NULL);
+  if (!pExt) finis(RETCODE_NO_MEMORY, "Out of memory");
+  AddToBucket(&pExt->bucket, size, nFiles);
+}
+
+/* Add a number of files to the bucket for an owner */
+void ProfileUid(sizeProfile *pProfile, unsigned long uid, total_t size, uintmax_t nFiles) {
+  uidEntry owner = {0};
+  uidEntry *pOwner;
+
+  owner.uid = uid;
+  pOwner = put_uidEntry(pProfile->pUids, &owner, NULL);
+  if (!pOwner) finis(RETCODE_NO_MEMORY, "Out of memory");
+  AddToBucket(&pOwner->bucket, size, nFiles);
+}
+
+void ProfileFile(sizeProfile *pProfile, const char *pszName, time_t mtime, unsigned long uid, total_t size) {
+  char szExt[MAX_EXT_LENGTH+1];
+  const char *pszDot = strrchr(pszName, '.');
+  time_t age = tProfile - mtime;
+  int i;
+
+  AddToBucket(&pProfile->all, size, 1);
+
+  for (i = 0; (i < nAges) && (age >= pAgeLimits[i]); i++) ;
+  AddToBucket(pProfile->pAges + i, size, 1);
+
+  szExt[0] = '\0';
+  if (pszDot && (pszDot > pszName) && (strlen(pszDot+1) <= MAX_EXT_LENGTH)) {
+    for (i = 0; pszDot[i+1]; i++) szExt[i] = (char)tolower((unsigned char)pszDot[i+1]);
+    szExt[i] = '\0';
+  }
+  ProfileExt(pProfile, szExt, size, 1);
+
+  ProfileUid(pProfile, uid, size, 1);
+}
+
+/* Merge the profile from a worker thread into the main one */
+void *MergeExtCB(extEntry *pExt, void *pRef) {
+  ProfileExt(pRef, pExt->ext, pExt->bucket.size, pExt->bucket.nFiles);
+  return NULL;
+}
+
+void *MergeUidCB(uidEntry *pOwner, void *pRef) {
+  ProfileUid(pRef, pOwner->uid, pOwner->bucket.size, pOwner->bucket.nFiles);
+  return NULL;
+}
+
+void MergeProfile(sizeProfile *pTo, sizeProfile *pFrom) {
+  int i;
+
+  AddToBucket(&pTo->all, pFrom->all.size, pFrom->all.nFiles);
+  for (i = 0; i <= nAges; i++) {
+    AddToBucket(pTo->pAges + i, pFrom->pAges[i].size, pFrom->pAges[i].nFiles);
+  }
+  foreach_extEntry(pFrom->pExts, MergeExtCB, pTo);
+  foreach_uidEntry(pFrom->pUids, MergeUidCB, pTo);
+}
+
+/******************************************************************************
+*                                                                             *
+*   Function:       ShowProfile                                               *
+*                                                                             *
+*   Description:    Display the size profile tables                           *
+*                                                                             *
+*   Arguments:                                                                *
+*                                                                             *
+*      sizeProfile *pProfile	The profile to display			      *
+*                                                                             *
+*   Return value:   None                                                      *
+*                                                                             *
+*   Notes:          The extensions and owners are sorted by decreasing size,  *
+*                   and only the first MAX_PROFILE_ROWS are displayed. The    *
+*                   others are added up in a last row.                        *
+*                                                                             *
+*   History:                                                                  *
+*    2026-10-17 MAB Created this routine.                                     *
+*                                                                             *
+******************************************************************************/
+
+typedef struct _profileRow {	/* A row in a profile table */
+  char szLabel[MAX_EXT_LENGTH+16];
+  sizeBucket bucket;
+} profileRow;
+
+typedef struct _profileRows {	/* The rows of a profile table */
+  profileRow *pRows;
+  int nRows;
+} profileRows;
+
+/* Sort rows by decreasing size */
+int CDECL CompareProfileRows(const profileRow *pRow1, const profileRow *pRow2) {
+  if (pRow1->bucket.size != pRow2->bucket.size) return (pRow1->bucket.size > pRow2->bucket.size) ? -1 : 1;
+  return strcmp(pRow1->szLabel, pRow2->szLabel);
+}
+
+void *ExtRowCB(extEntry *pExt, void *pRef) {
+  profileRows *pRows = pRef;
+  profileRow *pRow = pRows->pRows + pRows->nRows++;
+  if (pExt->ext[0]) {
+    sprintf(pRow->szLabel, ".%s", pExt->ext);
+  } else {
+    strcpy(pRow->szLabel, "(none)");
+  }
+  pRow->bucket = pExt->bucket;
+  return NULL;
+}
+
+void *UidRowCB(uidEntry *pOwner, void *pRef) {
+  profileRows *pRows = pRef;
+  profileRow *pRow = pRows->pRows + pRows->nRows++;
+#if defined(_UNIX)
+  struct passwd *pPW = getpwuid((uid_t)pOwner->uid);
+  if (pPW && (strlen(pPW->pw_name) < sizeof(pRow->szLabel))) {
+    strcpy(pRow->szLabel, pPW->pw_name);
+  } else
+#endif
+  sprintf(pRow->szLabel, "%lu", pOwner->uid);
+  pRow->bucket = pOwner->bucket;
+  return NULL;
+}
+
+void ShowProfileRow(char *pszLabel, sizeBucket *pBucket, total_t llTotal) {
+  char szFiles[40];
+  char szSize[40];
+  double dPercent = llTotal ? (100.0 * (double)pBucket->size / (double)llTotal) : 0;
+
+  Size2String(szFiles, (total_t)pBucket->nFiles);
+  Size2StringWithUnit(szSize, pBucket->size);
+  printf("  %-20s %15s %19s %6.1f%%\n", pszLabel, szFiles, szSize, dPercent);
+}
+
+void ShowProfileRows(profileRows *pRows, total_t llTotal) {
+  sizeBucket others = {0};
+  int i;
+
+  qsort(pRows->pRows, pRows->nRows, sizeof(profileRow), (pCompareProc)CompareProfileRows);
+  for (i = 0; i < pRows->nRows; i++) {
+    if (i < MAX_PROFILE_ROWS) {
+      ShowProfileRow(pRows->pRows[i].szLabel, &pRows->pRows[i].bucket, llTotal);
+    } else {
+      AddToBucket(&others, pRows->pRows[i].bucket.size, pRows->pRows[i].bucket.nFiles);
+    }
+  }
+  if (others.nFiles) ShowProfileRow("(others)", &others, llTotal);
+}
+
+/* Format an age in days, using years when possible */
+void FormatAge(char *pBuf, time_t age) {
+  long lDays = (long)(age / 86400);
+  if (lDays && !(lDays % 365)) {
+    sprintf(pBuf, "%ldy", lDays / 365);
+  } else {
+    sprintf(pBuf, "%ldd", lDays);
+  }
+}
+
+void ShowProfile(sizeProfile *pProfile) {
+  total_t llTotal = pProfile->all.size;
+  profileRows rows;
+  size_t nRows;
+  char szLabel[50];
+  char szAge1[20], szAge2[20];
+  int i;
+
+  printf("\n  %-20s %15s %19s %7s\n", "Age", "Files", "Size", "%");
+  for (i = 0; i <= nAges; i++) {
+    if (i < nAges) FormatAge(szAge2, pAgeLimits[i]);
+    if (i == 0) {
+      sprintf(szLabel, "< %s", szAge2);
+    } else if (i == nAges) {
+      sprintf(szLabel, ">= %s", szAge1);
+    } else {
+      sprintf(szLabel, "%s - %s", szAge1, szAge2);
+    }
+    ShowProfileRow(szLabel, pProfile->pAges + i, llTotal);
+    strcpy(szAge1, szAge2);
+  }
+
+  nRows = num_extEntry(pProfile->pExts);
+  if (num_uidEntry(pProfile->pUids) > nRows) nRows = num_uidEntry(pProfile->pUids);
+  rows.pRows = malloc((nRows ? nRows : 1) * sizeof(profileRow));
+  if (!rows.pRows) finis(RETCODE_NO_MEMORY, "Out of memory");
+
+  printf("\n  %-20s %15s %19s %7s\n", "Extension", "Files", "Size", "%");
+  rows.nRows = 0;
+  foreach_extEntry(pProfile->pExts, ExtRowCB, &rows);
+  ShowProfileRows(&rows, llTotal);
+
+  printf("\n  %-20s %15s %19s %7s\n", "Owner", "Files", "Size", "%");
+  rows.nRows = 0;
+  foreach_uidEntry(pProfile->pUids, UidRowCB, &rows);
+  ShowProfileRows(&rows, llTotal);
+
+  printf("\n");
+  ShowProfileRow("Total", &pProfile->all, llTotal);
+
+  free(rows.pRows);
+}
+
+/* Parse a list of ages in days. Ex: "7,30,365" */
+int parse_ages(char *token) {
+  char *pc;
+  long lDays;
+  int n;
+
+  for (n = 1, pc = token; *pc; pc++) if (*pc == ',') n++;
+  pAgeLimits = malloc(n * sizeof(time_t)); /* Freed on exit */
+  if (!pAgeLimits) finis(RETCODE_NO_MEMORY, "Out of memory");
+  for (nAges = 0, pc = token; nAges < n; nAges++) {
+    lDays = strtol(pc, &pc, 10);
+    if (lDays <= 0) return FALSE;
+    pAgeLimits[nAges] = (time_t)lDays * 86400;
+    if (nAges && (pAgeLimits[nAges] <= pAgeLimits[nAges-1])) return FALSE;
+    if (*pc == ',') {
+      pc++;
+    } else if (*pc) {
+      return FALSE;
+    }
+  }
+  return TRUE;
+}
+
 /******************************************************************************
 *                                                                             *
 *       Function:       parse_date                                            *
@@ -1112,6 +2758,48 @@ int parse_date(char *token, time_t *pDate) {
   return TRUE;
 }
 
+/******************************************************************************
+*                                                                             *
+*       Function:       parse_size                                            *
+*                                                                             *
+*       Description:    Parse a size on a command line switch                 *
+*                                                                             *
+*       Arguments:                                                            *
+*                                                                             *
+*         char *token   Size token from the command line. Ex: 1500, 20K, 3G   *
+*         total_t *pSize Pointer to the size field to update                  *
+*                                                                             *
+*       Return value:   TRUE if done, FALSE if invalid size found             *
+*                                                                             *
+*       Notes:          The K, M, G, T suffixes are powers of 1024, like the  *
+*                       -k, -m, -g display units.                             *
+*                                                                             *
+*       History:                                                              *
+*        2026-10-17 MAB Created this routine.                                 *
+*                                                                             *
+******************************************************************************/
+
+int parse_size(char *token, total_t *pSize) {
+  double dSize;
+  char *pc;
+
+  dSize = strtod(token, &pc);
+  if ((pc == token) || (dSize < 0)) return FALSE;
+  switch (toupper(*pc)) {
+    case 'T': dSize *= 1024;
+    case 'G': dSize *= 1024;
+    case 'M': dSize *= 1024;
+    case 'K': dSize *= 1024; pc++;
+    case 'B': if (toupper(*pc) == 'B') pc++;
+    case '\0': break;
+    default: return FALSE;
+  }
+  if (*pc) return FALSE;
+
+  *pSize = (total_t)dSize;
+  return TRUE;
+}
+
 /******************************************************************************
 *                                                                             *
 *	Function:	time2sec					      *
@@ -1330,10 +3018,11 @@ long GetClusterSize(char drive)	{       /* Get cluster size */
 *									      *
 *   Description:    Select entries in a directory			      *
 *									      *
-*   Arguments:	    const char *name	Directory name            	      *
-*		    dirent ***namelist  where to store the result array       *
+*   Arguments:	    PATHBUF *pPath	Directory name, and fd in Unix	      *
+*		    dirEntry ***namelist  where to store the result array     *
 *		    int (*cbSelect)()   Selection callback function           *
 *		    int (CDECL *cbCompare)()  Comparison function for sorting *
+*					NULL = Don't sort		      *
 *		    void *pRef		Reference data to pass to cbSelect    *
 *									      *
 *   Return value:   # of entries in the array, or -1 if error.		      *
@@ -1341,63 +3030,499 @@ long GetClusterSize(char drive)	{       /* Get cluster size */
 *   Notes:	    Extension of the standard scandir routine, allowing to    *
 *		    pass arguments to the selection routine.
 *		    							      *
+*		    cbSelect() returns SELECT_NO, SELECT_YES, or SELECT_STAT  *
+*		    if it selected the entry and got its stat data. This data *
+*		    is then returned with the entry, so that the caller does  *
+*		    not need to query it a second time.			      *
+*		    							      *
 *   History:								      *
 *    2012-01-11 JFL Initial implementation				      *
+*    2026-10-17 MAB Open the directory relative to the parent directory fd,   *
+*		    and pass the PATHBUF to cbSelect().			      *
+*    2026-10-17 MAB Return dirEntry structures, with the stat data obtained   *
+*		    by cbSelect(). Grow the list geometrically, and fixed     *
+*		    the out of memory error handling.			      *
+*    2026-10-17 MAB Not used in Unix anymore, where ScanFilesPlus() reads     *
+*		    the directories with readdirplusf() instead.	      *
 *                                                                             *
 \*****************************************************************************/
 
-typedef int (CDECL *pCompareProc)(const void *item1, const void *item2);
+/* Append a new entry to a list of entries, growing it geometrically */
+dirEntry *NewDirEntry(dirEntry ***ppList, int *pn, int *pnAlloc) {
+  dirEntry *pEntry;
+  if (*pn == *pnAlloc) {
+    int nAlloc = *pnAlloc ? 2 * *pnAlloc : 64;
+    dirEntry **pList = (dirEntry **)realloc(*ppList, nAlloc * sizeof(dirEntry *));
+    if (!pList) return NULL;
+    *ppList = pList;
+    *pnAlloc = nAlloc;
+  }
+  pEntry = malloc(sizeof(dirEntry));
+  if (pEntry) (*ppList)[(*pn)++] = pEntry;
+  return pEntry;
+}
+
+/* Sort directory entries in alphabetic order, like alphasort() does */
+int CDECL alphasortX(const dirEntry **ppEntry1, const dirEntry **ppEntry2) {
+  const struct dirent *pDE1 = &((*ppEntry1)->de);
+  const struct dirent *pDE2 = &((*ppEntry2)->de);
+  return alphasort(&pDE1, &pDE2);
+}
+
+#if !defined(_UNIX)
 
 #ifdef _MSC_VER
 #pragma warning(disable:4706) /* Ignore the "assignment within conditional expression" warning */
 #endif
 
-int scandirX(const char *pszName,
-	     struct dirent ***resultList,
-	     int (*cbSelect) (const struct dirent *, void *pRef),
-	     int (CDECL *cbCompare) (const struct dirent **, const struct dirent **),
+int scandirX(PATHBUF *pPath,
+	     dirEntry ***resultList,
+	     int (*cbSelect) (PATHBUF *pPath, const struct dirent *, struct stat *, void *pRef),
+	     int (CDECL *cbCompare) (const dirEntry **, const dirEntry **),
 	     void *pRef) {
   int n = 0;
+  int nAlloc = 0;
+  int iSelect;
   DIR *pDir;
   struct dirent *pDirent;
-  struct dirent *pDirent2;
-  struct dirent **pList = NULL;
-  struct dirent **pList2;
+  dirEntry *pEntry;
+  dirEntry **pList = NULL;
+  struct stat sStat;
+  double t0;
 
-  DEBUG_ENTER(("scandirX(\"%s\", %p, %p, %p, %p);\n", pszName, resultList, cbSelect, cbCompare, pRef));
+  DEBUG_ENTER(("scandirX(\"%s\", %p, %p, %p, %p);\n", pPath->buf, resultList, cbSelect, cbCompare, pRef));
 
-  pDir = opendirx(pszName);
+  t0 = TelemetryBegin(TELEMETRY_OP_OPEN);
+  pDir = opendirx(pPath->buf);
+  TelemetryEnd(TELEMETRY_OP_OPEN, t0);
   if (!pDir) {
     DEBUG_LEAVE(("return -1; // errno=%d\n", errno));
     return -1;
   }
 
-  while ((pDirent = readdirx(pDir))) { /* readdirx() ensures d_type is set */
-    if (cbSelect && !cbSelect(pDirent, pRef)) continue; /* We don't want this one. Continue search. */
+  while (1) {
+    t0 = TelemetryBegin(TELEMETRY_OP_READ);
+    pDirent = readdirx(pDir); /* readdirx() ensures d_type is set */
+    TelemetryEnd(TELEMETRY_OP_READ, t0);
+    if (!pDirent) break;
+    iSelect = SELECT_YES;
+    if (cbSelect) iSelect = cbSelect(pPath, pDirent, &sStat, pRef);
+    if (iSelect == SELECT_NO) continue; /* We don't want this one. Continue search. */
     /* OK, we've selected this one. So append a copy of this dirent to the list. */
-    n += 1;
-    pList2 = (struct dirent **)realloc(pList, n * sizeof(struct dirent *));
-    pDirent2 = malloc(sizeof(struct dirent));
-    if (!pList2 || !pDirent2) {
-      if (pDirent2) free(pDirent2);
-      for (n-=1; n>0; ) free(pList[--n]);
-      /* errno = ENOMEM; */ /* Out of memory. Should already be set by malloc failure */
-      DEBUG_LEAVE(("return -1; // errno=%d\n", errno));
-      return -1;
-    }
-    *pDirent2 = *pDirent;
-    pList = pList2;
-    pList[n-1] = pDirent2;
+    pEntry = NewDirEntry(&pList, &n, &nAlloc);
+    if (!pEntry) goto out_of_memory;
+    pEntry->de = *pDirent;
+    pEntry->bStat = (iSelect == SELECT_STAT);
+    if (pEntry->bStat) pEntry->st = sStat;
   }
 
   closedirx(pDir);
 
-  if (cbCompare) qsort(pList, n, sizeof(struct dirent *), (pCompareProc)cbCompare);
+  if (cbCompare) qsort(pList, n, sizeof(dirEntry *), (pCompareProc)cbCompare);
   *resultList = pList;
   DEBUG_LEAVE(("return %d;\n", n));
   return n;
+
+out_of_memory:
+  closedirx(pDir);
+  while (n > 0) free(pList[--n]);
+  free(pList);
+  errno = ENOMEM;
+  DEBUG_LEAVE(("return -1; // errno=%d\n", errno));
+  return -1;
 }
 
 #ifdef _MSC_VER
 #pragma warning(default:4706)
 #endif
+
+#endif /* !defined(_UNIX) */
+
+/*****************************************************************************\
+*                                                                             *
+*   Function:	    StatEntry		 				      *
+*									      *
+*   Description:    Get the stat data of an entry in a scanned directory      *
+*									      *
+*   Arguments:	    PATHBUF *pPath	Directory name, and fd in Unix	      *
+*		    const char *pszName	The entry name			      *
+*		    struct stat *pStat	Where to store the result	      *
+*		    int iFollow		If TRUE, stat the link targets	      *
+*									      *
+*   Return value:   0=Success, else -1 and errno is set			      *
+*									      *
+*   Notes:	    Not used in Unix, where ScanFilesPlus() gets the stat     *
+*		    data with readdirplusf(), in the same batch as the names. *
+*		    							      *
+*   History:								      *
+*    2026-10-17 MAB Initial implementation				      *
+*    2026-10-17 MAB Not used in Unix anymore.				      *
+*                                                                             *
+\*****************************************************************************/
+
+#if !defined(_UNIX)
+
+int StatEntry(PATHBUF *pPath, const char *pszName, struct stat *pStat, int iFollow) {
+  int iErr;
+  double t0;
+  ssize_t len = PathBufPush(pPath, pszName);
+  if (len < 0) {
+    errno = ENOMEM;
+    return -1;
+  }
+  t0 = TelemetryBegin(TELEMETRY_OP_STAT);
+#if OS_HAS_LINKS
+  iErr = iFollow ? stat(pPath->buf, pStat) : lstat(pPath->buf, pStat);
+#else
+  iErr = stat(pPath->buf, pStat);
+#endif
+  TelemetryEnd(TELEMETRY_OP_STAT, t0);
+  PathBufPop(pPath, (size_t)len);
+  return iErr;
+}
+
+#endif /* !defined(_UNIX) */
+
+/*****************************************************************************\
+*                                                                             *
+*   Function:	    TelemetryStart, etc		 			      *
+*									      *
+*   Description:    Measure the scan progress and the system calls latency    *
+*									      *
+*   Arguments:	    int iInterval	Seconds between progress reports      *
+*									      *
+*   Return value:   None						      *
+*									      *
+*   Notes:	    Everything is a no-op unless option -telemetry enabled    *
+*		    it, so that normal scans don't pay for the clock reads.   *
+*		    							      *
+*		    TelemetryBegin() and TelemetryEnd() surround every	      *
+*		    directory open, every directory entry read, and every     *
+*		    stat. The durations are counted in histograms with	      *
+*		    log2 buckets: < 1us, then [1us, 2us[, [2us, 4us[, etc.    *
+*		    In Unix, readdirplusf() calls them through dirplustimer() *
+*		    hooks, around each getdents64() read of many entries, and *
+*		    around each statx() or fstatat() of one entry.	      *
+*		    							      *
+*		    A reporter thread displays on stderr every iInterval      *
+*		    seconds the number of directories and files scanned, the  *
+*		    rates during that interval, the last directory entered,   *
+*		    and the operation in progress if it has been blocked for  *
+*		    more than a second. With -j, each thread records its own  *
+*		    operation in progress and histograms, so that they never  *
+*		    wait for each other. The report shows the operation      *
+*		    blocked for the longest time. The counters are atomic.    *
+*		    In OSs without threads, the progress is reported when     *
+*		    entering directories instead.			      *
+*		    							      *
+*		    TelemetryStop() displays the final counts and histograms. *
+*		    							      *
+*   History:								      *
+*    2026-10-17 MAB Initial implementation				      *
+*    2026-10-17 MAB Time readdirplusf() reads and stats separately.	      *
+*                                                                             *
+\*****************************************************************************/
+
+static const char *aszTelemetryOps[TELEMETRY_OPS] = {
+  "open dir",
+  "read dir",
+  "stat",
+};
+
+double TelemetryNow(void) {
+#if defined(_UNIX)
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + ((double)ts.tv_nsec / 1e9);
+#else
+  return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+void TelemetryLock(void) {
+#if HAS_THREADS
+  pthread_mutex_lock(&pTelemetry->mutex);
+#endif
+}
+
+void TelemetryUnlock(void) {
+#if HAS_THREADS
+  pthread_mutex_unlock(&pTelemetry->mutex);
+#endif
+}
+
+/* Format a duration in seconds, with 3 significant digits */
+char *FormatDuration(char *pBuf, double dSeconds) {
+  if (dSeconds < 1e-3) {
+    sprintf(pBuf, "%.3gus", dSeconds * 1e6);
+  } else if (dSeconds < 1) {
+    sprintf(pBuf, "%.3gms", dSeconds * 1e3);
+  } else {
+    sprintf(pBuf, "%.3gs", dSeconds);
+  }
+  return pBuf;
+}
+
+/* Get the current thread's measurements. NULL if out of memory */
+telemetryThread *TelemetryThread(void) {
+  telemetryThread *pTT;
+
+#if HAS_THREADS
+  pTT = pthread_getspecific(pTelemetry->key);
+#else
+  pTT = pTelemetry->pThreads;
+#endif
+  if (!pTT) {			/* This thread's first measurement */
+    pTT = calloc(1, sizeof(telemetryThread));
+    if (!pTT) return NULL;
+    pTT->iOp = -1;
+#if HAS_THREADS
+    pthread_mutex_init(&pTT->mutex, NULL);
+    pthread_setspecific(pTelemetry->key, pTT);
+#endif
+    TelemetryLock();
+    pTT->pNext = pTelemetry->pThreads;
+    pTelemetry->pThreads = pTT;
+    TelemetryUnlock();
+  }
+  return pTT;
+}
+
+/* Report the progress. Called with the telemetry lock held */
+void TelemetryReport(double tNow) {
+  double dt = tNow - pTelemetry->tReport;
+  int64_t nsNow = (int64_t)(tNow * 1e9);
+  char szDirs[40], szFiles[40], szTime[20];
+  uintmax_t nDirs = TelemetryLoad(&pTelemetry->nDirs);
+  uintmax_t nFiles = TelemetryLoad(&pTelemetry->nFiles);
+  telemetryThread *pTT;
+  telemetryThread *pLast = NULL;    /* The thread that entered a directory last */
+  int iOp = -1;			    /* The operation blocked for the longest time */
+  int64_t nsOp = nsNow;
+
+  for (pTT = pTelemetry->pThreads; pTT; pTT = pTT->pNext) {
+    int iOp2 = TelemetryLoad(&pTT->iOp);
+    int64_t nsOp2 = TelemetryLoad(&pTT->nsOp);
+    if ((iOp2 >= 0) && (nsOp2 < nsOp)) {
+      iOp = iOp2;
+      nsOp = nsOp2;
+    }
+    if (!pLast || (TelemetryLoad(&pTT->nsEnter) > TelemetryLoad(&pLast->nsEnter))) pLast = pTT;
+  }
+
+  if (dt <= 0) dt = 1;
+  Size2String(szDirs, (total_t)nDirs);
+  Size2String(szFiles, (total_t)nFiles);
+  fprintf(stderr, "dirsize: %.0fs: %s dirs (%.0f/s), %s files (%.0f/s)",
+	  tNow - pTelemetry->tStart,
+	  szDirs, (double)(nDirs - pTelemetry->nDirsReport) / dt,
+	  szFiles, (double)(nFiles - pTelemetry->nFilesReport) / dt);
+  if (pLast) {
+#if HAS_THREADS
+    pthread_mutex_lock(&pLast->mutex);
+#endif
+    fprintf(stderr, ", depth %d: %s", pLast->iDepth, pLast->pszPath ? pLast->pszPath : "");
+#if HAS_THREADS
+    pthread_mutex_unlock(&pLast->mutex);
+#endif
+  }
+  if ((iOp >= 0) && ((nsNow - nsOp) >= 1000000000)) {
+    fprintf(stderr, " [in %s for %s]", aszTelemetryOps[iOp],
+	    FormatDuration(szTime, (double)(nsNow - nsOp) / 1e9));
+  }
+  fputc('\n', stderr);
+  pTelemetry->tReport = tNow;
+  pTelemetry->nDirsReport = nDirs;
+  pTelemetry->nFilesReport = nFiles;
+}
+
+#if HAS_THREADS
+void *TelemetryReporter(void *pArg) {
+  struct timespec ts;
+
+  (void)pArg;
+  pthread_mutex_lock(&pTelemetry->mutex);
+  clock_gettime(CLOCK_REALTIME, &ts);
+  while (!pTelemetry->bStop) {
+    ts.tv_sec += pTelemetry->iInterval;
+    while (   !pTelemetry->bStop
+	   && (pthread_cond_timedwait(&pTelemetry->cond, &pTelemetry->mutex, &ts) != ETIMEDOUT)) ;
+    if (!pTelemetry->bStop) TelemetryReport(TelemetryNow());
+  }
+  pthread_mutex_unlock(&pTelemetry->mutex);
+  return NULL;
+}
+#endif /* HAS_THREADS */
+
+void TelemetryStart(int iInterval) {
+  pTelemetry = calloc(1, sizeof(telemetry));
+  if (!pTelemetry) finis(RETCODE_NO_MEMORY, "Out of memory");
+  pTelemetry->iInterval = iInterval;
+  pTelemetry->tStart = pTelemetry->tReport = TelemetryNow();
+#if HAS_THREADS
+  if (pthread_key_create(&pTelemetry->key, NULL)) finis(RETCODE_NO_MEMORY, "Out of memory");
+  pthread_mutex_init(&pTelemetry->mutex, NULL);
+  pthread_cond_init(&pTelemetry->cond, NULL);
+  pTelemetry->bReporter = !pthread_create(&pTelemetry->reporter, NULL, TelemetryReporter, NULL);
+#endif
+}
+
+/* Start timing an operation. Returns the start time */
+double TelemetryBegin(int iOp) {
+  telemetryThread *pTT;
+  double t0;
+
+  if (!pTelemetry) return 0;
+  t0 = TelemetryNow();
+  pTT = TelemetryThread();
+  if (pTT) {
+    TelemetryStore(&pTT->nsOp, (int64_t)(t0 * 1e9));
+    TelemetryStore(&pTT->iOp, iOp);
+  }
+  return t0;
+}
+
+/* Count the duration of an operation in its histogram */
+void TelemetryEnd(int iOp, double t0) {
+  telemetryThread *pTT;
+  double dt;
+  unsigned long long us;
+  int iBucket;
+
+  if (!pTelemetry) return;
+  dt = TelemetryNow() - t0;
+  pTT = TelemetryThread();
+  if (!pTT) return;
+  for (iBucket = 0, us = (unsigned long long)(dt * 1e6); us; us >>= 1) iBucket++;
+  if (iBucket >= TELEMETRY_BUCKETS) iBucket = TELEMETRY_BUCKETS - 1;
+  pTT->aHist[iOp][iBucket] += 1;
+  pTT->adTotal[iOp] += dt;
+  if (dt > pTT->adMax[iOp]) pTT->adMax[iOp] = dt;
+  TelemetryStore(&pTT->iOp, -1);
+}
+
+/* Record the directory being scanned */
+void TelemetryEnterDir(char *pszPath, int iDepth) {
+  telemetryThread *pTT;
+  size_t l;
+  double tNow;
+
+  if (!pTelemetry) return;
+  TelemetryAdd(&pTelemetry->nDirs, 1);
+  pTT = TelemetryThread();
+  if (!pTT) return;
+  l = strlen(pszPath) + 1;
+  tNow = TelemetryNow();
+#if HAS_THREADS
+  pthread_mutex_lock(&pTT->mutex);
+#endif
+  pTT->iDepth = iDepth;
+  if (l > pTT->lPathAlloc) {
+    char *pszNew = realloc(pTT->pszPath, l + 256);
+    if (pszNew) {
+      pTT->pszPath = pszNew;
+      pTT->lPathAlloc = l + 256;
+    }
+  }
+  if (l <= pTT->lPathAlloc) memcpy(pTT->pszPath, pszPath, l);
+#if HAS_THREADS
+  pthread_mutex_unlock(&pTT->mutex);
+#endif
+  TelemetryStore(&pTT->nsEnter, (int64_t)(tNow * 1e9));
+#if !HAS_THREADS /* No reporter thread. Report the progress from here */
+  if ((tNow - pTelemetry->tReport) >= pTelemetry->iInterval) TelemetryReport(tNow);
+#endif
+}
+
+/* Count files scanned */
+void TelemetryAddFiles(int nFiles) {
+  if (!pTelemetry) return;
+  TelemetryAdd(&pTelemetry->nFiles, (uintmax_t)nFiles);
+}
+
+/* Stop the reporter thread, and display the final counts and histograms */
+void TelemetryStop(void) {
+  double dt;
+  char szDirs[40], szFiles[40];
+  char szLow[20], szHigh[20], szTotal[20], szMean[20], szMax[20];
+  uintmax_t aHist[TELEMETRY_OPS][TELEMETRY_BUCKETS] = {{0}};
+  double adTotal[TELEMETRY_OPS] = {0};
+  double adMax[TELEMETRY_OPS] = {0};
+  telemetryThread *pTT;
+  int iOp, iBucket, i;
+
+  if (!pTelemetry) return;
+#if HAS_THREADS
+  pthread_mutex_lock(&pTelemetry->mutex);
+  pTelemetry->bStop = TRUE;
+  pthread_cond_signal(&pTelemetry->cond);
+  pthread_mutex_unlock(&pTelemetry->mutex);
+  if (pTelemetry->bReporter) pthread_join(pTelemetry->reporter, NULL);
+#endif
+
+  /* All scanning threads are done. Add up their measurements, and free them. */
+  while ((pTT = pTelemetry->pThreads) != NULL) {
+    for (iOp = 0; iOp < TELEMETRY_OPS; iOp++) {
+      for (iBucket = 0; iBucket < TELEMETRY_BUCKETS; iBucket++) {
+	aHist[iOp][iBucket] += pTT->aHist[iOp][iBucket];
+      }
+      adTotal[iOp] += pTT->adTotal[iOp];
+      if (pTT->adMax[iOp] > adMax[iOp]) adMax[iOp] = pTT->adMax[iOp];
+    }
+    pTelemetry->pThreads = pTT->pNext;
+#if HAS_THREADS
+    pthread_mutex_destroy(&pTT->mutex);
+#endif
+    free(pTT->pszPath);
+    free(pTT);
+  }
+
+  dt = TelemetryNow() - pTelemetry->tStart;
+  Size2String(szDirs, (total_t)pTelemetry->nDirs);
+  Size2String(szFiles, (total_t)pTelemetry->nFiles);
+  fprintf(stderr, "dirsize: Scanned %s dirs and %s files in %s (%.0f dirs/s, %.0f files/s)\n",
+	  szDirs, szFiles, FormatDuration(szTotal, dt),
+	  dt ? (double)pTelemetry->nDirs / dt : 0, dt ? (double)pTelemetry->nFiles / dt : 0);
+
+  for (iOp = 0; iOp < TELEMETRY_OPS; iOp++) {
+    uintmax_t nOps = 0;
+    uintmax_t nMax = 0;
+    for (iBucket = 0; iBucket < TELEMETRY_BUCKETS; iBucket++) {
+      nOps += aHist[iOp][iBucket];
+      if (aHist[iOp][iBucket] > nMax) nMax = aHist[iOp][iBucket];
+    }
+    if (!nOps) continue;
+    fprintf(stderr, "\n%s: %" PRIuMAX " calls, total %s, mean %s, max %s\n",
+	    aszTelemetryOps[iOp], nOps,
+	    FormatDuration(szTotal, adTotal[iOp]),
+	    FormatDuration(szMean, adTotal[iOp] / (double)nOps),
+	    FormatDuration(szMax, adMax[iOp]));
+    for (iBucket = 0; iBucket < TELEMETRY_BUCKETS; iBucket++) {
+      uintmax_t n = aHist[iOp][iBucket];
+      int nBar;
+      if (!n) continue;
+      if (iBucket) {
+	FormatDuration(szLow, (double)(1ULL << (iBucket-1)) / 1e6);
+      } else {
+	strcpy(szLow, "0");
+      }
+      if (iBucket < (TELEMETRY_BUCKETS-1)) {
+	FormatDuration(szHigh, (double)(1ULL << iBucket) / 1e6);
+      } else {
+	strcpy(szHigh, "");
+      }
+      nBar = (int)((n * 40 + nMax - 1) / nMax);
+      fprintf(stderr, "  %8s - %-8s %12" PRIuMAX " %5.1f%% ", szLow, szHigh, n, 100.0 * (double)n / (double)nOps);
+      for (i = 0; i < nBar; i++) fputc('#', stderr);
+      fputc('\n', stderr);
+    }
+  }
+
+#if HAS_THREADS
+  pthread_cond_destroy(&pTelemetry->cond);
+  pthread_mutex_destroy(&pTelemetry->mutex);
+  pthread_key_delete(pTelemetry->key);
+#endif
+  free(pTelemetry);
+  pTelemetry = NULL;
+}
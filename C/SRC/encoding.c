@@ -10,6 +10,10 @@
 *    2021-06-02 JFL Created this program.                                     *
 *    2021-06-03 JFL Restructured error messages output.                       *
 *    2021-12-07 JFL Updated help screen.                                      *
+*    2026-10-17 MAB Build the pathnames in place while recursing, using a     *
+*		    SysLib PATHBUF. Version 0.9.1.			      *
+*    2026-10-17 MAB Compile the wildcards pattern once with FnmCompile().     *
+*		    Version 0.9.2.					      *
 *		    							      *
 *         © Copyright 2021 Hewlett Packard Enterprise Development LP          *
 * Licensed under the Apache 2.0 license - www.apache.org/licenses/LICENSE-2.0 *
@@ -17,8 +21,8 @@
 
 #define PROGRAM_DESCRIPTION "Find the encoding of text files"
 #define PROGRAM_NAME "encoding"
-#define PROGRAM_VERSION "0.9"
-#define PROGRAM_DATE    "2021-12-07"
+#define PROGRAM_VERSION "0.9.2"
+#define PROGRAM_DATE    "2026-10-17"
 
 #include "predefine.h" /* Define optional features we need in the C libraries */
 
@@ -34,6 +38,8 @@
 #include <iconv.h>
 /* SysLib include files */
 #include "dirx.h"		/* Directory access functions eXtensions */
+#include "pathnames.h"	/* Pathname management definitions and functions */
+#include "fnmatchx.h"	/* Precompiled wildcards patterns */
 /* SysToolsLib include files */
 #include "debugm.h"	/* SysToolsLib debug macros */
 #include "stversion.h"	/* SysToolsLib version strings. Include last. */
@@ -159,8 +165,8 @@ FILE *mf;			/* Message output file */
 int printError(char *pszFormat, ...);	/* Print errors in a consistent format */
 int IsSwitch(char *pszArg);
 int ShowAllFilesEncoding(char *pszName, encoding_detection_opts *pOpts);
+int ShowAllFilesEncodingP(PATHBUF *pPath, const char *pszDir, FNMPATTERN *pPattern, encoding_detection_opts *pOpts);
 int ShowFileEncoding(char *pszName, encoding_detection_opts *pOpts);
-char *NewPathName(const char *path, const char *name);
 int GetProgramNames(char *argv0);
 int isEffectiveDir(const char *pszPath);
 
@@ -322,15 +328,16 @@ int ShowAllFilesEncoding(char *path, encoding_detection_opts *pOpts) {
   char *pName;
   char *pPath2 = NULL;
   char *pPath3 = NULL;
+  PATHBUF sPath;
+  FNMPATTERN fnmPattern = {0};
   int iErr;
-  DIR *pDir;
-  struct dirent *pDE;
   int nErr = 0;
-  int iFNM = (pOpts->iFlags & FLAG_NOCASE) ? FNM_CASEFOLD : 0;
   size_t len;
 
   DEBUG_ENTER(("ShowAllFilesEncoding(\"%s\");\n", path));
 
+  PathBufInit(&sPath);
+
   if ((!path) || !(len = strlen(path))) RETURN_INT_COMMENT(1, ("path is empty\n"));
 
   if ((!strpbrk(path, "*?")) && !(pOpts->iFlags & FLAG_RECURSE)) {	/* If there are no wild cards */
@@ -357,30 +364,57 @@ fail:
     goto fail;
   }
 
-  pDir = opendirx(pPath);
+  if (FnmCompile(&fnmPattern, pName, (pOpts->iFlags & FLAG_NOCASE) ? FNM_CASEFOLD : 0)) goto out_of_memory;
+  if (PathBufSet(&sPath, pPath)) goto out_of_memory; /* Hides the . path in the output */
+  nErr = ShowAllFilesEncodingP(&sPath, pPath, &fnmPattern, pOpts);
+
+cleanup_and_return:
+  FnmFree(&fnmPattern);
+  PathBufFree(&sPath);
+  free(pPath2);
+  free(pPath3);
+
+  RETURN_INT_COMMENT(nErr, (nErr ? "%d detections failed\n" : "Success\n", nErr));
+}
+
+/* Process the files in the directory in pPath - Internal method.
+   pszDir = The directory name to open, or NULL to use the pPath name.
+   pPattern = The compiled name pattern. */
+int ShowAllFilesEncodingP(PATHBUF *pPath, const char *pszDir, FNMPATTERN *pPattern, encoding_detection_opts *pOpts) {
+  int iErr;
+  DIR *pDir;
+  struct dirent *pDE;
+  int nErr = 0;
+
+  if (!pszDir) pszDir = pPath->buf;
+  DEBUG_ENTER(("ShowAllFilesEncodingP(\"%s\", \"%s\");\n", pszDir, pPattern->pszPattern));
+
+  pDir = opendirx(pszDir);
   if (!pDir) {
-    printError("Error: Can't access \"%s\": %s", pPath, strerror(errno));
-    goto fail;
+    printError("Error: Can't access \"%s\": %s", pszDir, strerror(errno));
+    RETURN_INT(1);
   }
-  if (streq(pPath, ".")) pPath = NULL;	/* Hide the . path in the output */
   while ((pDE = readdirx(pDir))) { /* readdirx() ensures d_type is set */
-    char *pPathname = NewPathName(pPath, pDE->d_name);
+    char *pPathname;
+    ssize_t lDir = PathBufPush(pPath, pDE->d_name);
     DEBUG_PRINTF(("// Dir Entry \"%s\" d_type=%d\n", pDE->d_name, (int)(pDE->d_type)));
-    if (!pPathname) goto out_of_memory;
+    if (lDir < 0) {
+      printError("Out of memory");
+      nErr += 1;
+      break;
+    }
+    pPathname = pPath->buf;
     switch (pDE->d_type) {
       case DT_DIR:
 process_files_in_subdirectory:
       	if (streq(pDE->d_name, ".")) break;	/* Skip the . directory */
       	if (streq(pDE->d_name, "..")) break;	/* Skip the .. directory */
       	if (pOpts->iFlags & FLAG_RECURSE) {
-	  char *pPathname2 = NewPathName(pPathname, pName);
-	  if (!pPathname2) goto out_of_memory;
-      	  nErr += ShowAllFilesEncoding(pPathname2, pOpts);
-      	  free(pPathname2);
+      	  nErr += ShowAllFilesEncodingP(pPath, NULL, pPattern, pOpts);
       	}
       	break;
       default:
-      	if (fnmatch(pName, pDE->d_name, iFNM) == FNM_NOMATCH) {
+      	if (FnmMatch(pPattern, pDE->d_name) == FNM_NOMATCH) {
       	  if (   (pDE->d_type == DT_LNK)
       	      && (pOpts->iFlags & FLAG_RECURSE)
       	      && (isEffectiveDir(pPathname))) goto process_files_in_subdirectory;
@@ -396,14 +430,10 @@ process_files_in_subdirectory:
 	}
       	break;
     }
-    free(pPathname);
+    PathBufPop(pPath, (size_t)lDir); /* Restore this directory pathname */
   }
   closedirx(pDir);
 
-cleanup_and_return:
-  free(pPath2);
-  free(pPath3);
-
   RETURN_INT_COMMENT(nErr, (nErr ? "%d detections failed\n" : "Success\n", nErr));
 }
 
@@ -741,55 +771,4 @@ cleanup_and_exit:
 
 #endif /* defined(_WIN32) */
 
-/*---------------------------------------------------------------------------*\
-*                                                                             *
-|   Function	    NewPathName						      |
-|									      |
-|   Description     Join a directory name and a file name into a new pathname |
-|									      |
-|   Parameters      const char *path		The directory name, or NULL   |
-|		    const char *name		The file name		      |
-|		    							      |
-|   Returns	    Pointer to the new pathname, or NULL if allocation failed.|
-|		    							      |
-|   Notes	    Wildcards allowed only in the name part of the pathname.  |
-|		    							      |
-|   History								      |
-|    2017-10-05 JFL Created this routine				      |
-|    2017-10-09 JFL Allow the path pointer to be NULL. If so, dup. the name.  |
-|    2019-02-06 JFL Added call to new routine TrimDot, removing all ./ parts. |
-*									      *
-\*---------------------------------------------------------------------------*/
-
-void TrimDot(char *path) { /* Remote ./ parts in the path */
-  char *pIn = path;
-  char *pOut = path;
-  char c;
-  int first = TRUE;
-  for ( ; (c = *(pIn++)) != '\0'; ) {
-    if (first && (c == '.') && (*pIn == DIRSEPARATOR_CHAR)) {
-      pIn += 1; /* Eat up the / and continue */
-      continue;
-    }
-    *(pOut++) = c;
-    first = (   (c == DIRSEPARATOR_CHAR)
-#if OS_HAS_DRIVES
-	     || ((pIn == (path+2)) && (c == ':'))
-#endif
-            );
-  }
-  *(pOut++) = c;
-}
-
-char *NewPathName(const char *path, const char *name) {
-  size_t lPath = path ? strlen(path) : 0;
-  size_t lName = strlen(name);
-  char *buf = malloc(lPath + lName + 2);
-  if (!buf) return NULL;
-  if (lPath) strcpy(buf, path);
-  if (lPath && (buf[lPath-1] != DIRSEPARATOR_CHAR)) buf [lPath++] = DIRSEPARATOR_CHAR;
-  strcpy(buf+lPath, name);
-  TrimDot(buf);
-  return buf;
-}
 
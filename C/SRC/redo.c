@@ -48,6 +48,8 @@
 *    2020-03-17 JFL Fixed issue with Unix readdir() not always setting d_type.*
 *                   Version 3.1.3.					      *
 *    2020-04-20 JFL Added support for MacOS. Version 3.2.                     *
+*    2026-10-17 MAB Allocate the fif structures and names in an arena.	      *
+*		    Version 3.2.1.					      *
 *                                                                             *
 *         © Copyright 2016 Hewlett Packard Enterprise Development LP          *
 * Licensed under the Apache 2.0 license - www.apache.org/licenses/LICENSE-2.0 *
@@ -55,8 +57,8 @@
 
 #define PROGRAM_DESCRIPTION "Execute a command recursively"
 #define PROGRAM_NAME    "redo"
-#define PROGRAM_VERSION "3.2"
-#define PROGRAM_DATE    "2020-04-20"
+#define PROGRAM_VERSION "3.2.1"
+#define PROGRAM_DATE    "2026-10-17"
 
 #include "predefine.h" /* Define optional features we need in the C libraries */
 
@@ -74,6 +76,7 @@
 #include <limits.h>
 /* SysLib include files */
 #include "dirx.h"		/* Directory access functions eXtensions */
+#include "arena.h"		/* Arena allocator for the fif structures */
 /* SysToolsLib include files */
 #include "debugm.h"	/* SysToolsLib debug macros */
 #include "stversion.h"	/* SysToolsLib version strings. Include last. */
@@ -267,6 +270,7 @@ int iVerbose = FALSE;		    /* If TRUE, echo commands executed */
 int iRelat;			    /* Index of a pathname relative to szInitDir */
 
 fif *firstfif = NULL;		    /* Pointer to the first allocated fif structure */
+ARENA fifArena = {0};		    /* Where the fif structures and names are allocated */
 
 #ifdef _MSDOS
 #define MAXARGS 25
@@ -688,9 +692,11 @@ int descend(char *from, int fif0) {
   int nfif;
   int i;
   fif **ppfif;
+  ARENAMARK mark;
 
   /* Get all subdirectories */
   DEBUG_ENTER(("descend(\"%s\", %d);\n", from, fif0));
+  ArenaMark(&fifArena, &mark);
   fif1 = lis(from, PATTERN_ALL, fif0, 0x8016);
   nfif = fif1 - fif0;
   ppfif = AllocFifArray(nfif);
@@ -712,6 +718,7 @@ int descend(char *from, int fif0) {
   }
 
   FreeFifArray(ppfif);
+  ArenaRelease(&fifArena, &mark);
 
   RETURN_INT(0);
 }
@@ -985,8 +992,8 @@ int lis(char *startdir, char *pattern, int nfif, ushort attrib) {
 	fif *pfif;
 
 	DEBUG_PRINTF(("// OK\n"));
-	pfif = (fif *)malloc(sizeof(fif));
-	pname = strdup(pDirent->d_name);
+	pfif = (fif *)ArenaAlloc(&fifArena, sizeof(fif));
+	pname = ArenaStrdup(&fifArena, pDirent->d_name);
 	if (!pfif || !pname) {
 	  closedirx(pDir);
 	  finis(RETCODE_NO_MEMORY, "Out of memory for directory access");
@@ -1140,7 +1147,7 @@ fif **AllocFifArray(size_t nfif) {
 *                                                                             *
 *       Function:       FreeFifArray                                          *
 *                                                                             *
-*       Description:    Free an array of fif pointers, and the fifs too.      *
+*       Description:    Free an array of fif pointers.                        *
 *                                                                             *
 *       Arguments:                                                            *
 *                                                                             *
@@ -1148,20 +1155,14 @@ fif **AllocFifArray(size_t nfif) {
 *                                                                             *
 *       Return value:   None                                                  *
 *                                                                             *
-*       Notes:                                                                *
+*       Notes:          The fifs themselves are in the fifArena. The caller   *
+*                       releases them with ArenaRelease().                    *
 *                                                                             *
 *       Updates:                                                              *
 *                                                                             *
 ******************************************************************************/
 
 void FreeFifArray(fif **ppfif) {
-  fif **ppf;
-
-  for (ppf=ppfif; *ppf; ppf++) {
-    free((*ppf)->name);
-    free(*ppf);
-  }
-
   free(ppfif);
 
   return;
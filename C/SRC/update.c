@@ -180,6 +180,14 @@
 *    2021-12-07 JFL Updated the explanations in the help screen.              *
 *                   Version 3.13.					      *
 *    2022-02-08 JFL Fixed option -- to force ending switches. Version 3.13.1. *
+*    2026-10-17 MAB zapDirM() builds the pathnames in place using a SysLib    *
+*		    PATHBUF. Removed the unused NewPathName(). Version 3.13.2.*
+*    2026-10-17 MAB Compile the wildcards patterns once with SysLib fnmatchx. *
+*		    Version 3.13.3.					      *
+*    2026-10-17 MAB In Linux, copyf() first tries cloning the file, then      *
+*		    copy_file_range(), then sendfile(), and only then copies  *
+*		    the rest through a 1MB buffer. In Unix, set the copy mode *
+*		    and times on the open file. Version 3.14.		      *
 *                                                                             *
 *       © Copyright 2016-2018 Hewlett Packard Enterprise Development LP       *
 * Licensed under the Apache 2.0 license - www.apache.org/licenses/LICENSE-2.0 *
@@ -187,8 +195,8 @@
 
 #define PROGRAM_DESCRIPTION "Update files based on their time stamps"
 #define PROGRAM_NAME    "update"
-#define PROGRAM_VERSION "3.13.1"
-#define PROGRAM_DATE    "2022-02-08"
+#define PROGRAM_VERSION "3.14"
+#define PROGRAM_DATE    "2026-10-17"
 
 #include "predefine.h" /* Define optional features we need in the C libraries */
 
@@ -210,6 +218,8 @@
 /* SysLib include files */
 #include "dirx.h"		/* Directory access functions eXtensions */
 #include "copyfile.h"		/* Copy file, and related functions */
+#include "pathnames.h"		/* Pathname management definitions and functions */
+#include "fnmatchx.h"		/* Precompiled wildcards patterns */
 /* SysToolsLib include files */
 #include "debugm.h"	/* SysToolsLib debugging macros */
 #include "stversion.h"	/* SysToolsLib version strings. Include last. */
@@ -312,6 +322,17 @@ char *fullpath(char *absPath, const char *relPath, size_t maxLength);
 
 #define _stricmp strcasecmp
 
+/* Let the kernel copy the files data, without going through our buffer */
+#if defined(__linux__)
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <linux/fs.h>		/* For FICLONE */
+#define HAS_KERNEL_COPY 1
+#if defined(__GLIBC__) && ((__GLIBC__ > 2) || ((__GLIBC__ == 2) && (__GLIBC_MINOR__ >= 27)))
+#define HAS_COPY_FILE_RANGE 1	/* Glibc 2.27 added the copy_file_range() wrapper */
+#endif
+#endif
+
 /* Redefine Microsoft-specific routines */
 off_t _filelength(int hFile);
 // Don't use realpath(), as it resolves links, which we do not want.
@@ -347,11 +368,30 @@ typedef unsigned long DWORD;
 
 #ifdef _MSDOS
 #define BUFFERSIZE 16384
+#elif defined(_UNIX)
+#define BUFFERSIZE (1024L * 1024L)
 #else
 #define BUFFERSIZE (256L * 1024L)
 #endif
 char *buffer;       /* Pointer on the intermediate copy buffer */
 
+#ifndef HAS_KERNEL_COPY
+#define HAS_KERNEL_COPY 0
+#endif
+#ifndef HAS_COPY_FILE_RANGE
+#define HAS_COPY_FILE_RANGE 0
+#endif
+
+#if HAS_KERNEL_COPY
+/* copyf() methods, tried in this order. Each copies as much as it can, and
+   the next one continues from there */
+#define COPY_CLONE    0	/* Share the source blocks, in copy-on-write file systems */
+#define COPY_RANGE    1	/* copy_file_range(). Within the kernel, or the file server */
+#define COPY_SENDFILE 2	/* sendfile(). Within the kernel */
+#define COPY_BUFFER   3	/* fread() and fwrite() through our buffer */
+#define KERNEL_COPY_SIZE (64L * 1024L * 1024L) /* Max bytes per kernel call */
+#endif
+
 #define isConsole(iFile) isatty(iFile)
 
 static int test = 0;			/* Flag indicating Test mode */
@@ -415,7 +455,6 @@ void stcgfn(char *, const char *);	/* Get file name */
 void stcgfp(char *, const char *);	/* Get file path */
 void strmfp(char *, const char *, const char *);    /* Make file pathname */
 void strsfp(const char *, char *, char *);          /* Split file pathname */
-char *NewPathName(const char *path, const char *name); /* Create a new pathname */
 /* zap functions options */
 typedef struct zapOpts {
   int iFlags;
@@ -432,6 +471,7 @@ int zapFile(const char *path, zapOpts *pzo); /* Delete a file */
 int zapFileM(const char *path, int iMode, zapOpts *pzo); /* Faster */
 int zapDir(const char *path, zapOpts *pzo);  /* Delete a directory */
 int zapDirM(const char *path, int iMode, zapOpts *pzo); /* Faster */
+int zapDirP(PATHBUF *pPath, const char *pszDir, int iMode, zapOpts *pzo);
 
 /* Global program name variables */
 char *program;	/* This program basename, with extension in Windows */
@@ -925,6 +965,7 @@ int updateall(char *p1,             /* Wildcard * and ? are interpreted */
     DIR *pDir;
     struct dirent *pDE;
     char *pattern;
+    FNMPATTERN fnmPattern = {0};
     int err;
     int nErrors = 0;
     int iTargetDirExisted;
@@ -1023,6 +1064,11 @@ int updateall(char *p1,             /* Wildcard * and ? are interpreted */
        the source, even if the command-line argument has a different case. */
 
     /* Scan all files that match the wild cards */
+    if (FnmCompile(&fnmPattern, pattern, iFnmFlag)) {
+      printError("Error: Not enough memory");
+      nErrors += 1;
+      goto cleanup_and_return;
+    }
     pDir = opendirx(path0);
     if (!pDir) {
       printError("Error: can't open directory \"%s\": %s", path0, strerror(errno));
@@ -1036,14 +1082,22 @@ int updateall(char *p1,             /* Wildcard * and ? are interpreted */
       	  && (pDE->d_type != DT_LNK)
 #endif
       	 ) continue;	/* We want only files or links */
-      if (fnmatch(pattern, pDE->d_name, iFnmFlag) == FNM_NOMATCH) continue;
+      if (FnmMatch(&fnmPattern, pDE->d_name) == FNM_NOMATCH) continue;
       if (nobak) {
 	static char *patterns[] = {"*.bak", "*~", "#*#", NULL};
-	char **ppPattern;
-	for (ppPattern = patterns; *ppPattern; ppPattern++) {
-	  if (fnmatch(*ppPattern, pDE->d_name, iFnmFlag) == 0) break; /* Match */
+	static FNMSET backupSet = {0};
+	if (!backupSet.nPatterns) { /* Compile the patterns the first time */
+	  char **ppPattern;
+	  for (ppPattern = patterns; *ppPattern; ppPattern++) {
+	    if (FnmSetAdd(&backupSet, *ppPattern, iFnmFlag)) {
+	      printError("Error: Not enough memory");
+	      nErrors += 1;
+	      closedirx(pDir);
+	      goto cleanup_and_return;
+	    }
+	  }
 	}
-	if (*ppPattern) continue; /* There was a match, so skip this backup file */
+	if (FnmSetMatch(&backupSet, pDE->d_name) == FNM_MATCH) continue; /* Skip this backup file */
       }
       strmfp(path1, path0, pDE->d_name);  /* Compute source path */
       DEBUG_PRINTF(("// Found %s\n", path1));
@@ -1077,7 +1131,7 @@ int updateall(char *p1,             /* Wildcard * and ? are interpreted */
 	  if (streq(pDE->d_name, ".")) continue;    /* Skip the . directory */
 	  if (streq(pDE->d_name, "..")) continue;   /* Skip the .. directory */
 	  DEBUG_PRINTF(("// Dir Entry \"%s\" d_type=%d\n", pDE->d_name, (int)(pDE->d_type)));
-	  if (fnmatch(pattern, pDE->d_name, iFnmFlag) == FNM_NOMATCH) continue;
+	  if (FnmMatch(&fnmPattern, pDE->d_name) == FNM_NOMATCH) continue;
 	  strmfp(path3, path2, pDE->d_name);  /* Compute the target file pathname */
 	  DEBUG_PRINTF(("// Found %s\n", path3));
 	  strmfp(path1, path0, pDE->d_name); /* Compute the corresponding source file pathname */
@@ -1189,6 +1243,7 @@ int updateall(char *p1,             /* Wildcard * and ? are interpreted */
     }
 
 cleanup_and_return:
+    FnmFree(&fnmPattern);
 #ifndef _MSDOS
     free(path0); free(path1); free(path2); free(path3); free(path); free(name); free(fullpathname);
 #endif
@@ -1523,6 +1578,9 @@ int update_link(char *p1,	/* Both names must be complete, without wildcards */
 |                   When reading fails to start, avoid deleting the target.   |
 |                   In case of error later on, delete incomplete copies.      |
 |    2016-05-10 JFL Added support for the --force option.                     |
+|    2026-10-17 MAB In Linux, try FICLONE, copy_file_range(), and sendfile()  |
+|                   before using the buffer. In Unix, set the target mode and |
+|                   times on the open file, instead of reopening it.          |
 *                                                                             *
 \*---------------------------------------------------------------------------*/
 
@@ -1539,6 +1597,13 @@ int copyf(char *name1,		    /* Source file to copy from */
     int iWidth = 0;	    /* Number of characters in the iProgress output */
     char *pszUnit = "B";    /* Unit used for iProgress output */
     long lUnit = 1;	    /* Number of bytes for 1 iProgress unit */
+#ifdef _UNIX
+    int iErr;
+#endif
+#if HAS_KERNEL_COPY
+    int hdest;		    /* Destination handle */
+    int iMethod = COPY_CLONE; /* The next copy method to try */
+#endif
 
     DEBUG_ENTER(("copyf(\"%s\", \"%s\");\n", name1, name2));
     if (iVerbose
@@ -1584,7 +1649,9 @@ retry_open_targetfile:
       fclose(pfs);
       RETURN_INT_COMMENT(2, ("Can't open the output file\n"));
     }
-    /* hdest = fileno(pfd); */
+#if HAS_KERNEL_COPY
+    hdest = fileno(pfd);
+#endif
 
     if (iShowCopying) printf(" : %"PRIuMAX" bytes\n", (uintmax_t)filelen);
 
@@ -1607,6 +1674,53 @@ retry_open_targetfile:
       	iWidth = printf("%3d%% (%"PRIuMAX"%s/%"PRIuMAX"%s)\r", pc, (uintmax_t)(offset/lUnit), pszUnit, (uintmax_t)(filelen/lUnit), pszUnit);
       }
       
+#if HAS_KERNEL_COPY
+      if (iMethod == COPY_CLONE) {
+	iMethod = COPY_RANGE;	/* This is all or nothing, so try it only once */
+#ifdef FICLONE
+	if (!ioctl(hdest, FICLONE, hsource)) {
+	  DEBUG_PRINTF(("// Cloned the whole file\n"));
+	  offset = filelen;
+	  tocopy = 0;
+	  continue;
+	}
+	DEBUG_PRINTF(("// Can't clone the file. %s\n", strerror(errno)));
+#endif
+      }
+      if (iMethod == COPY_RANGE) {
+	ssize_t n = -1;
+#if HAS_COPY_FILE_RANGE
+	loff_t offIn = offset;
+	loff_t offOut = offset;
+	n = copy_file_range(hsource, &offIn, hdest, &offOut, (size_t)min(KERNEL_COPY_SIZE, remainder), 0);
+#endif
+	if (n > 0) {
+	  tocopy = (size_t)n;
+	  continue;
+	}
+	DEBUG_PRINTF(("// Can't use copy_file_range() at offset %"PRIuMAX". %s\n", (uintmax_t)offset, n ? strerror(errno) : "EOF"));
+	iMethod = COPY_SENDFILE;
+      }
+      if (iMethod == COPY_SENDFILE) {
+	ssize_t n = -1;
+	off_t offIn = offset;
+	/* sendfile() writes at the current position, unlike the above */
+	if (lseek(hdest, offset, SEEK_SET) != -1) {
+	  n = sendfile(hdest, hsource, &offIn, (size_t)min(KERNEL_COPY_SIZE, remainder));
+	}
+	if (n > 0) {
+	  tocopy = (size_t)n;
+	  continue;
+	}
+	DEBUG_PRINTF(("// Can't use sendfile() at offset %"PRIuMAX". %s\n", (uintmax_t)offset, n ? strerror(errno) : "EOF"));
+	iMethod = COPY_BUFFER;
+	/* Continue through the buffer from there. If the kernel failed because
+	   of an I/O error, the fread() or fwrite() below will report it. */
+	fseeko(pfs, offset, SEEK_SET);
+	fseeko(pfd, offset, SEEK_SET);
+      }
+#endif /* HAS_KERNEL_COPY */
+
       XDEBUG_PRINTF(("fread(%p, %"PRIuPTR", 1, %p);\n", buffer, tocopy, pfs));
       if (!fread(buffer, tocopy, 1, pfs)) {
 	if (iProgress && iWidth) printf("\n");
@@ -1625,10 +1739,24 @@ retry_open_targetfile:
     }
     if (iProgress && iWidth) printf("%*s\r", iWidth, "");
 
+#ifdef _UNIX
+    if (fflush(pfd)) {	    /* Write the last data before setting the date */
+      fclose(pfs);
+      fclose(pfd);
+      unlink(name2); /* Avoid leaving an incomplete file on the target */
+      RETURN_INT_COMMENT(2, ("Can't write the output file. Deleted the partial copy.\n"));
+    }
+    /* & give the same date than the source file */
+    iErr = fcopydate(fileno(pfd), hsource);
+    fclose(pfs);
+    fclose(pfd);
+    if (iErr) copydate(name2, name1); /* No fd-based way to set the times */
+#else
     fclose(pfs);
     fclose(pfd);
 
     copydate(name2, name1);	/* & give the same date than the source file */
+#endif
 
     DEBUG_PRINTF(("// File %s mode is read%s\n", name2,
 			access(name2, 6) ? "-only" : "/write"));
@@ -2230,36 +2358,6 @@ int printError(char *pszFormat, ...) {
   return n;
 }
 
-/*---------------------------------------------------------------------------*\
-*                                                                             *
-|   Function	    NewPathName						      |
-|									      |
-|   Description     Join a directory name and a file name into a new pathname |
-|									      |
-|   Parameters      const char *path		The directory name, or NULL   |
-|		    const char *name		The file name		      |
-|		    							      |
-|   Returns	    0 = Success, else # of failures encountered.	      |
-|		    							      |
-|   Notes	    Wildcards allowed only in the name part of the pathname.  |
-|		    							      |
-|   History								      |
-|    2017-10-05 JFL Created this routine				      |
-|    2017-10-09 JFL Allow the path pointer to be NULL. If so, dup. the name.  |
-*									      *
-\*---------------------------------------------------------------------------*/
-
-char *NewPathName(const char *path, const char *name) {
-  size_t lPath = path ? strlen(path) : 0;
-  size_t lName = strlen(name);
-  char *buf = malloc(lPath + lName + 2);
-  if (!buf) return NULL;
-  if (lPath) strcpy(buf, path);
-  if (lPath && (buf[lPath-1] != DIRSEPARATOR_CHAR)) buf [lPath++] = DIRSEPARATOR_CHAR;
-  strcpy(buf+lPath, name);
-  return buf;
-}
-
 /*---------------------------------------------------------------------------*\
 *                                                                             *
 |   Function	    zapDir						      |
@@ -2339,7 +2437,22 @@ int zapFile(const char *path, zapOpts *pzo) {
 }
 
 int zapDirM(const char *path, int iMode, zapOpts *pzo) {
-  char *pPath;
+  PATHBUF sPath;
+  int nErr;
+  PathBufInit(&sPath);
+  if (PathBufPush(&sPath, path) < 0) {
+    errno = ENOMEM;
+    return 1;
+  }
+  nErr = zapDirP(&sPath, path, iMode, pzo);
+  PathBufFree(&sPath);
+  return nErr;
+}
+
+/* Delete the directory in pPath. pszDir = Its name, or NULL to use the pPath name. */
+int zapDirP(PATHBUF *pPath, const char *pszDir, int iMode, zapOpts *pzo) {
+  const char *path = pszDir ? pszDir : pPath->buf;
+  char *pPathname;
   int iErr;
   struct stat sStat;
   DIR *pDir;
@@ -2349,7 +2462,7 @@ int zapDirM(const char *path, int iMode, zapOpts *pzo) {
   int iNoExec = iFlags & FLAG_NOEXEC;
   char *pszSuffix;
 
-  DEBUG_ENTER(("zapDirM(\"%s\", 0x%04X);\n", path, iMode));
+  DEBUG_ENTER(("zapDirP(\"%s\", 0x%04X);\n", path, iMode));
 
   if (!S_ISDIR(iMode)) {
     errno = ENOTDIR;
@@ -2359,19 +2472,25 @@ int zapDirM(const char *path, int iMode, zapOpts *pzo) {
   pDir = opendirx(path);
   if (!pDir) RETURN_INT(1);
   while ((pDE = readdirx(pDir)) != NULL) {
+    ssize_t lDir = PathBufPush(pPath, pDE->d_name);
     DEBUG_PRINTF(("// Dir Entry \"%s\" d_type=%d\n", pDE->d_name, (int)(pDE->d_type)));
-    pPath = NewPathName(path, pDE->d_name);
+    if (lDir < 0) {
+      printError("Out of memory");
+      nErr += 1;
+      break;
+    }
+    pPathname = pPath->buf;
     pszSuffix = "";
 #if _DIRENT2STAT_DEFINED /* MsvcLibX return DOS/Windows stat info in the dirent structure */
     iErr = dirent2stat(pDE, &sStat);
 #else /* Unix has to query it separately */
-    iErr = -lstat(pPath, &sStat); /* If error, iErr = 1 = # of errors */
+    iErr = -lstat(pPathname, &sStat); /* If error, iErr = 1 = # of errors */
 #endif
     if (!iErr) switch (pDE->d_type) {
       case DT_DIR:
       	if (streq(pDE->d_name, ".")) break;	/* Skip the . directory */
       	if (streq(pDE->d_name, "..")) break;	/* Skip the .. directory */
-      	iErr = zapDirM(pPath, sStat.st_mode, pzo);
+      	iErr = zapDirP(pPath, NULL, sStat.st_mode, pzo);
       	pszSuffix = DIRSEPARATOR_STRING;
       	break;
 #if defined(S_ISLNK) && S_ISLNK(S_IFLNK) /* In DOS it's defined, but always returns 0 */
@@ -2380,7 +2499,7 @@ int zapDirM(const char *path, int iMode, zapOpts *pzo) {
       	/* Fall through into the DT_REG case */
 #endif
       case DT_REG:
-	iErr = zapFileM(pPath, sStat.st_mode, pzo);
+	iErr = zapFileM(pPathname, sStat.st_mode, pzo);
       	break;
       default:
       	iErr = 1;		/* We don't support deleting there */
@@ -2393,13 +2512,14 @@ int zapDirM(const char *path, int iMode, zapOpts *pzo) {
       	break;
     }
     if (iErr) {
-      if (pDE->d_type != DT_DIR) printError("Error deleting \"%s%s\": %s", pPath, pszSuffix, strerror(errno));
+      if (pDE->d_type != DT_DIR) printError("Error deleting \"%s%s\": %s", pPath->buf, pszSuffix, strerror(errno));
       nErr += iErr;
       /* Continue the directory scan, looking for other files to delete */
     }
-    free(pPath);
+    PathBufPop(pPath, (size_t)lDir); /* Restore this directory pathname */
   }
   closedirx(pDir);
+  if (!pszDir) path = pPath->buf; /* The buffer may have moved */
 
   iErr = 0;
   pszSuffix = DIRSEPARATOR_STRING;
@@ -35,13 +35,19 @@
 *    2020-04-28 JFL Fixed the recursion into linked subdirectories, and the   *
 *		    recursive deletion of fixed names. Version 1.4.1.         *
 *    2022-02-08 JFL Added option -- to force the end of switches. Version 1.5.*
+*    2026-10-17 MAB Build the pathnames in place while recursing, using a     *
+*		    SysLib PATHBUF, instead of allocating a new pathname for  *
+*		    every directory entry. Version 1.5.1.		      *
+*    2026-10-17 MAB Compile the wildcards patterns once with SysLib fnmatchx. *
+*		    Option -b deletes all backup files in a single pass.      *
+*		    Version 1.5.2.					      *
 *		    							      *
 \*****************************************************************************/
 
 #define PROGRAM_DESCRIPTION "Delete files and/or directories visibly"
 #define PROGRAM_NAME    "zap"
-#define PROGRAM_VERSION "1.5"
-#define PROGRAM_DATE    "2022-02-08"
+#define PROGRAM_VERSION "1.5.2"
+#define PROGRAM_DATE    "2026-10-17"
 
 #include "predefine.h" /* Define optional features we need in the C libraries */
 
@@ -55,6 +61,8 @@
 #include <sys/stat.h>
 /* SysLib include files */
 #include "dirx.h"		/* Directory access functions eXtensions */
+#include "pathnames.h"	/* Pathname management definitions and functions */
+#include "fnmatchx.h"	/* Precompiled wildcards patterns */
 /* SysToolsLib include files */
 #include "debugm.h"	/* SysToolsLib debug macros */
 #include "stversion.h"	/* SysToolsLib version strings. Include last. */
@@ -127,7 +135,6 @@ char *szHalRefusal = "I'm sorry Dave, I'm afraid I can't do that";
 void usage(void);
 int IsSwitch(char *pszArg);
 int isEffectiveDir(const char *pszPath);
-char *NewPathName(const char *path, const char *name);
 /* zap functions options */
 typedef struct zapOpts {
   int iFlags;
@@ -141,11 +148,13 @@ typedef struct zapOpts {
 #define FLAG_NOCASE	0x0008		/* Ignore case */
 #define FLAG_FORCE	0x0010		/* Force operation on read-only files */
 int zapFiles(const char *pathname, zapOpts *pzo); /* Remove files in a directory */
+int zapFilesP(PATHBUF *pPath, const char *pszDir, FNMSET *pNames, zapOpts *pzo);
 int zapBaks(const char *path, zapOpts *pzo); /* Remove backup files in a dir */
 int zapFile(const char *path, zapOpts *pzo); /* Delete a file */
 int zapFileM(const char *path, int iMode, zapOpts *pzo); /* Faster */
 int zapDir(const char *path, zapOpts *pzo);  /* Delete a directory */
 int zapDirM(const char *path, int iMode, zapOpts *pzo); /* Faster */
+int zapDirP(PATHBUF *pPath, const char *path, int iMode, zapOpts *pzo);
 int zapDirs(const char *path, zapOpts *pzo); /* Delete multiple directories */
 int isRootDir(const char *dir);		/* Check if dir is a root directory */
 
@@ -542,58 +551,6 @@ int isRootDir(const char *dir) {
   RETURN_INT(iResult);
 }
 
-/*---------------------------------------------------------------------------*\
-*                                                                             *
-|   Function	    NewPathName						      |
-|									      |
-|   Description     Join a directory name and a file name into a new pathname |
-|									      |
-|   Parameters      const char *path		The directory name, or NULL   |
-|		    const char *name		The file name		      |
-|		    							      |
-|   Returns	    Pointer to the new pathname, or NULL if allocation failed.|
-|		    							      |
-|   Notes	    Wildcards allowed only in the name part of the pathname.  |
-|		    							      |
-|   History								      |
-|    2017-10-05 JFL Created this routine				      |
-|    2017-10-09 JFL Allow the path pointer to be NULL. If so, dup. the name.  |
-|    2019-02-06 JFL Added call to new routine TrimDot, removing all ./ parts. |
-*									      *
-\*---------------------------------------------------------------------------*/
-
-void TrimDot(char *path) { /* Remote ./ parts in the path */
-  char *pIn = path;
-  char *pOut = path;
-  char c;
-  int first = TRUE;
-  for ( ; (c = *(pIn++)) != '\0'; ) {
-    if (first && (c == '.') && (*pIn == DIRSEPARATOR_CHAR)) {
-      pIn += 1; /* Eat up the / and continue */
-      continue;
-    }
-    *(pOut++) = c;
-    first = (   (c == DIRSEPARATOR_CHAR)
-#if OS_HAS_DRIVES
-	     || ((pIn == (path+2)) && (c == ':'))
-#endif
-            );
-  }
-  *(pOut++) = c;
-}
-
-char *NewPathName(const char *path, const char *name) {
-  size_t lPath = path ? strlen(path) : 0;
-  size_t lName = strlen(name);
-  char *buf = malloc(lPath + lName + 2);
-  if (!buf) return NULL;
-  if (lPath) strcpy(buf, path);
-  if (lPath && (buf[lPath-1] != DIRSEPARATOR_CHAR)) buf [lPath++] = DIRSEPARATOR_CHAR;
-  strcpy(buf+lPath, name);
-  TrimDot(buf);
-  return buf;
-}
-
 /*---------------------------------------------------------------------------*\
 *                                                                             *
 |   Function	    zapFiles						      |
@@ -622,15 +579,15 @@ int zapFiles(const char *path, zapOpts *pzo) {
   char *pName;
   char *pPath2 = NULL;
   char *pPath3 = NULL;
-  int iErr;
-  DIR *pDir;
-  struct dirent *pDE;
+  PATHBUF sPath;
+  FNMSET names = {0};
   int nErr = 0;
-  int iFNM = (pzo->iFlags & FLAG_NOCASE) ? FNM_CASEFOLD : 0;
   size_t len;
 
   DEBUG_ENTER(("zapFiles(\"%s\");\n", path));
 
+  PathBufInit(&sPath);
+
   if ((!path) || !(len = strlen(path))) RETURN_INT_COMMENT(1, ("path is empty\n"));
 
   if ((!strpbrk(path, "*?")) && !(pzo->iFlags & FLAG_RECURSE)) {	/* If there are no wild cards */
@@ -661,30 +618,57 @@ fail:
     goto fail;
   }
 
-  pDir = opendirx(pPath);
+  if (FnmSetAdd(&names, pName, (pzo->iFlags & FLAG_NOCASE) ? FNM_CASEFOLD : 0)) goto out_of_memory;
+  if (PathBufSet(&sPath, pPath)) goto out_of_memory; /* Hides the . path in the output */
+  nErr = zapFilesP(&sPath, pPath, &names, pzo);
+
+cleanup_and_return:
+  FnmSetFree(&names);
+  PathBufFree(&sPath);
+  free(pPath2);
+  free(pPath3);
+
+  RETURN_INT_COMMENT(nErr, (nErr ? "%d deletions failed\n" : "Success\n", nErr));
+}
+
+/* Delete files or links in the directory in pPath - Internal method.
+   pszDir = The directory name to open, or NULL to use the pPath name.
+   pNames = The set of name patterns to delete. */
+int zapFilesP(PATHBUF *pPath, const char *pszDir, FNMSET *pNames, zapOpts *pzo) {
+  int iErr;
+  DIR *pDir;
+  struct dirent *pDE;
+  int nErr = 0;
+
+  if (!pszDir) pszDir = pPath->buf;
+  DEBUG_ENTER(("zapFilesP(\"%s\", %p);\n", pszDir, pNames));
+
+  pDir = opendirx(pszDir);
   if (!pDir) {
-    printError("Error: Can't access \"%s\": %s", pPath, strerror(errno));
-    goto fail;
+    printError("Error: Can't access \"%s\": %s", pszDir, strerror(errno));
+    RETURN_INT(1);
   }
-  if (streq(pPath, ".")) pPath = NULL;	/* Hide the . path in the output */
   while ((pDE = readdirx(pDir))) { /* readdirx() ensures d_type is set */
-    char *pPathname = NewPathName(pPath, pDE->d_name);
+    char *pPathname;
+    ssize_t lDir = PathBufPush(pPath, pDE->d_name);
     DEBUG_PRINTF(("// Dir Entry \"%s\" d_type=%d\n", pDE->d_name, (int)(pDE->d_type)));
-    if (!pPathname) goto out_of_memory;
+    if (lDir < 0) {
+      printError("Out of memory");
+      nErr += 1;
+      break;
+    }
+    pPathname = pPath->buf;
     switch (pDE->d_type) {
       case DT_DIR:
 zap_files_in_subdirectory:
       	if (streq(pDE->d_name, ".")) break;	/* Skip the . directory */
       	if (streq(pDE->d_name, "..")) break;	/* Skip the .. directory */
       	if (pzo->iFlags & FLAG_RECURSE) {
-	  char *pPathname2 = NewPathName(pPathname, pName);
-	  if (!pPathname2) goto out_of_memory;
-      	  nErr += zapFiles(pPathname2, pzo);
-      	  free(pPathname2);
+      	  nErr += zapFilesP(pPath, NULL, pNames, pzo);
       	}
       	break;
       default:
-      	if (fnmatch(pName, pDE->d_name, iFNM) == FNM_NOMATCH) {
+      	if (FnmSetMatch(pNames, pDE->d_name) == FNM_NOMATCH) {
       	  if (   (pDE->d_type == DT_LNK)
       	      && (pzo->iFlags & FLAG_RECURSE)
       	      && (isEffectiveDir(pPathname))) goto zap_files_in_subdirectory;
@@ -701,14 +685,10 @@ zap_files_in_subdirectory:
 	}
       	break;
     }
-    free(pPathname);
+    PathBufPop(pPath, (size_t)lDir); /* Restore this directory pathname */
   }
   closedirx(pDir);
 
-cleanup_and_return:
-  free(pPath2);
-  free(pPath3);
-
   RETURN_INT_COMMENT(nErr, (nErr ? "%d deletions failed\n" : "Success\n", nErr));
 }
 
@@ -716,20 +696,31 @@ cleanup_and_return:
 #pragma warning(default:4706)
 #endif
 
-/* Zap backup files in a directory */
+/* Zap backup files in a directory, testing all backup patterns in one pass */
 int zapBaks(const char *path, zapOpts *pzo) {
   char *patterns[] = {"*.bak", "*~", "#*#"};
+  FNMSET names = {0};
+  PATHBUF sPath;
   int nErr = 0;
   int i;
+
+  if (!path) path = ".";
+  if (strpbrk(path, "*?")) { /* If there are wild cards in the path */
+    printError("Error: Wild cards aren't allowed in the directory name");
+    return 1;
+  }
+  PathBufInit(&sPath);
   for (i=0; i<(sizeof(patterns)/sizeof(char *)); i++) {
-    char *pszPath = NewPathName(path, patterns[i]);
-    if (!pszPath) {
-      printError("Out of memory");
-      return ++nErr;
-    }
-    nErr += zapFiles(pszPath, pzo);
-    free(pszPath);
+    if (FnmSetAdd(&names, patterns[i], (pzo->iFlags & FLAG_NOCASE) ? FNM_CASEFOLD : 0)) break;
+  }
+  if ((i < (sizeof(patterns)/sizeof(char *))) || PathBufSet(&sPath, path)) {
+    printError("Out of memory");
+    nErr += 1;
+  } else {
+    nErr = zapFilesP(&sPath, path, &names, pzo); /* PathBufSet() hides the . path in the output */
   }
+  FnmSetFree(&names);
+  PathBufFree(&sPath);
   return nErr;
 }
 
@@ -825,7 +816,23 @@ int zapFile(const char *path, zapOpts *pzo) {
 
 /* Delete one directory - Internal method */
 int zapDirM(const char *path, int iMode, zapOpts *pzo) {
-  char *pPath;
+  PATHBUF sPath;
+  int nErr;
+  PathBufInit(&sPath);
+  if (PathBufSet(&sPath, path)) {
+    printError("Out of memory");
+    return 1;
+  }
+  nErr = zapDirP(&sPath, path, iMode, pzo);
+  PathBufFree(&sPath);
+  return nErr;
+}
+
+/* Delete the directory in pPath - Internal method.
+   pszDir = The directory name to display, or NULL to use the pPath name. */
+int zapDirP(PATHBUF *pPath, const char *pszDir, int iMode, zapOpts *pzo) {
+  const char *path = pszDir ? pszDir : pPath->buf;
+  char *pPathname;
   int iErr;
   struct stat sStat;
   DIR *pDir;
@@ -836,7 +843,7 @@ int zapDirM(const char *path, int iMode, zapOpts *pzo) {
   int iNoExec = iFlags & FLAG_NOEXEC;
   char *pszSuffix = DIRSEPARATOR_STRING;
 
-  DEBUG_ENTER(("zapDirM(\"%s\", 0x%04X);\n", path, iMode));
+  DEBUG_ENTER(("zapDirP(\"%s\", 0x%04X);\n", path, iMode));
 
   if (!S_ISDIR(iMode)) {
     errno = ENOTDIR;
@@ -847,24 +854,26 @@ int zapDirM(const char *path, int iMode, zapOpts *pzo) {
     pDir = opendirx(path);
     if (!pDir) goto fail;
     while ((pDE = readdirx(pDir))) { /* readdirx() ensures d_type is set */
+      ssize_t lDir = PathBufPush(pPath, pDE->d_name);
       DEBUG_PRINTF(("// Dir Entry \"%s\" d_type=%d\n", pDE->d_name, (int)(pDE->d_type)));
-      pPath = NewPathName(path, pDE->d_name);
-      if (!pPath) {
+      if (lDir < 0) {
       	closedirx(pDir);
+      	if (!pszDir) path = pPath->buf; /* The buffer may have moved */
       	goto fail; /* Will report out of memory */
       }
+      pPathname = pPath->buf;
       pszSuffix = "";
 #if _DIRENT2STAT_DEFINED /* MsvcLibX return DOS/Windows stat info in the dirent structure */
       iErr = dirent2stat(pDE, &sStat);
 #else /* Unix has to query it separately */
-      iErr = -lstat(pPath, &sStat); /* If error, iErr = 1 = # of errors */
+      iErr = -lstat(pPathname, &sStat); /* If error, iErr = 1 = # of errors */
 #endif
       if (!iErr) switch (pDE->d_type) {
 	case DT_DIR:
 	  if (streq(pDE->d_name, ".")) break;	/* Skip the . directory */
 	  if (streq(pDE->d_name, "..")) break;	/* Skip the .. directory */
 	  /* Do not update iErr, as the error is already reported by the subroutine */
-	  nErr += zapDirM(pPath, sStat.st_mode, pzo);
+	  nErr += zapDirP(pPath, NULL, sStat.st_mode, pzo);
 	  pszSuffix = DIRSEPARATOR_STRING;
 	  break;
 #if defined(S_ISLNK) && S_ISLNK(S_IFLNK) /* In DOS it's defined, but always returns 0 */
@@ -874,7 +883,7 @@ int zapDirM(const char *path, int iMode, zapOpts *pzo) {
 #endif
 	case DT_REG:
 	  /* Do not update iErr, as the error is already reported by the subroutine */
-	  nErr += zapFileM(pPath, sStat.st_mode, pzo);
+	  nErr += zapFileM(pPathname, sStat.st_mode, pzo);
 	  break;
 	default:
 	  iErr = 1;		/* We don't support deleting there */
@@ -887,13 +896,14 @@ int zapDirM(const char *path, int iMode, zapOpts *pzo) {
 	  break;
       }
       if (iErr) {
-	if (pDE->d_type != DT_DIR) printError("Error deleting \"%s%s\": %s", pPath, pszSuffix, strerror(errno));
+	if (pDE->d_type != DT_DIR) printError("Error deleting \"%s%s\": %s", pPath->buf, pszSuffix, strerror(errno));
 	nErr += iErr;
 	/* Continue the directory scan, looking for other files to delete */
       }
-      free(pPath);
+      PathBufPop(pPath, (size_t)lDir); /* Restore this directory pathname */
     }
     closedirx(pDir);
+    if (!pszDir) path = pPath->buf; /* The buffer may have moved */
   }
 
   /* Skip the directory deletion if the directory is . or PATH\. or  D:. */
@@ -952,14 +962,17 @@ int zapDirs(const char *path, zapOpts *pzo) {
   char *pName;
   char *pPath2 = NULL;
   char *pPath3 = NULL;
+  PATHBUF sPath;
   DIR *pDir;
   struct dirent *pDE;
   int nErr = 0;
-  int iFNM = (pzo->iFlags & FLAG_NOCASE) ? FNM_CASEFOLD : 0;
+  FNMPATTERN fnmPattern = {0};
   size_t len;
 
   DEBUG_ENTER(("zapDirs(\"%s\");\n", path));
 
+  PathBufInit(&sPath);
+
   if ((!path) || !(len = strlen(path))) RETURN_INT_COMMENT(1, ("path is empty\n"));
 
   if (!strpbrk(path, "*?")) { /* If there are no wild cards */
@@ -992,16 +1005,17 @@ out_of_memory:
     goto cleanup_and_return;
   }
 
+  if (FnmCompile(&fnmPattern, pName, (pzo->iFlags & FLAG_NOCASE) ? FNM_CASEFOLD : 0)) goto out_of_memory;
+  if (PathBufSet(&sPath, pPath)) goto out_of_memory; /* Hides the . path in the output */
   pDir = opendirx(pPath);
   if (!pDir) {
     printError("Error deleting \"%s\": %s", pPath, strerror(errno));
     goto cleanup_and_return;
   }
-  if (streq(pPath, ".")) pPath = NULL;	/* Hide the . path in the output */
   while ((pDE = readdirx(pDir))) { /* readdirx() ensures d_type is set */
-    char *pPathname = NewPathName(pPath, pDE->d_name);
+    ssize_t lDir = PathBufPush(&sPath, pDE->d_name);
     DEBUG_PRINTF(("// Dir Entry \"%s\" d_type=%d\n", pDE->d_name, (int)(pDE->d_type)));
-    if (!pPathname) {
+    if (lDir < 0) {
       closedirx(pDir);
       goto out_of_memory;
     }
@@ -1009,17 +1023,19 @@ out_of_memory:
       case DT_DIR:
       	if (streq(pDE->d_name, ".")) break;	/* Skip the . directory */
       	if (streq(pDE->d_name, "..")) break;	/* Skip the .. directory */
-      	if (fnmatch(pName, pDE->d_name, iFNM) == FNM_NOMATCH) break;
-	nErr += zapDir(pPathname, pzo);
+      	if (FnmMatch(&fnmPattern, pDE->d_name) == FNM_NOMATCH) break;
+	nErr += zapDir(sPath.buf, pzo);
       	break;
       default:
       	break;
     }
-    free(pPathname);
+    PathBufPop(&sPath, (size_t)lDir);
   }
   closedirx(pDir);
 
 cleanup_and_return:
+  FnmFree(&fnmPattern);
+  PathBufFree(&sPath);
   free(pPath2);
   free(pPath3);
 
@@ -26,15 +26,19 @@
 
 # Common objects usable in all operating systems with a Standard C library
 COMMON_OBJECTS = \
+    +$(O)/arena.obj		\
     +$(O)/copydate.obj		\
+    +$(O)/fnmatchx.obj		\
     +$(O)/IsMBR.obj		\
     +$(O)/JoinPaths.obj		\
+    +$(O)/murmur3.obj		\
     +$(O)/oprintf.obj		\
     +$(O)/oprintf6.obj		\
     +$(O)/oprintf7.obj		\
     +$(O)/oprintf8.obj		\
     +$(O)/oprintf9.obj		\
     +$(O)/oprintf10.obj		\
+    +$(O)/PathBuf.obj		\
     +$(O)/PcUuid.obj		\
     +$(O)/pferror.obj		\
     +$(O)/PrintUuid.obj		\
@@ -65,6 +69,10 @@ OBJECTS = $(OBJECTS1:.obj=.o) $(UNIX_OBJECTS)
 
 CI=$(STINCLUDE)
 
+$(S)/arena.c: $(S)/arena.h
+
+$(S)/arena.h: $(S)/SysLib.h
+
 $(S)/Block.cpp: $(S)/Block.h $(S)/File.h $(S)/FloppyDisk.h $(S)/HardDisk.h $(S)/LogDisk.h
 
 $(S)/Block.h: $(S)/SysLib.h $(S)/qword.h
@@ -90,6 +98,10 @@ $(S)/File.cpp: $(S)/File.h $(S)/FileLibc.cpp $(S)/FileW32.cpp
 
 $(S)/File.h: $(S)/SysLib.h
 
+$(S)/fnmatchx.c: $(S)/fnmatchx.h
+
+$(S)/fnmatchx.h: $(S)/SysLib.h
+
 $(S)/gpt.cpp: $(S)/gpt.h $(S)/qword.h $(S)/harddisk.h $(S)/uuid.h
 
 $(S)/gpt.h: $(S)/SysLib.h $(S)/Block.h $(S)/efibind.h \
@@ -120,6 +132,8 @@ $(S)/IsMBR.h: $(S)/SysLib.h
 
 $(S)/JoinPaths.c: $(S)/pathnames.h
 
+$(S)/PathBuf.c: $(S)/pathnames.h
+
 $(S)/LDisk95.cpp: $(S)/LogDisk.h $(S)/Ring0.h $(S)/R0Ios.h
 
 $(S)/LDiskDos.cpp: $(S)/LogDisk.h
@@ -137,6 +151,10 @@ $(S)/macaddr.c: $(S)/macaddr.h $(S)/smbios.h $(S)/NetBIOS.h	# The DOS version op
 
 $(S)/macaddr.h: $(S)/SysLib.h $(S)/qword.h
 
+$(S)/murmur3.c: $(S)/murmur3.h
+
+$(S)/murmur3.h: $(S)/SysLib.h
+
 $(S)/NetBIOS.c: $(S)/NetBIOS.h	# The DOS version requires Microsoft LAN Manager Programmer's ToolKit vers. 2.1 (LMPTK)
 
 $(S)/NetBIOS.h: $(S)/SysLib.h
@@ -195,5 +213,5 @@ $(S)/VxDCall.c: $(S)/VxDCall.h
 
 $(S)/VxDCall.h: $(S)/SysLib.h
 
-$(S)/WalkDirTree.c: $(CI)/dict.h $(CI)/tree.h $(S)/dirx.h $(S)/mainutil.h $(S)/pathnames.h
+$(S)/WalkDirTree.c: $(CI)/hashtab.h $(S)/arena.h $(S)/dirx.h $(S)/mainutil.h $(S)/pathnames.h
 
@@ -8,6 +8,8 @@
 *                                                                             *
 *   History                                                                   *
 *    2021-12-15 JFL Created this file.					      *
+*    2026-10-17 MAB Fixed TrimDotParts() drive detection. OS_HAS_DRIVES was   *
+*		    never defined here. Use pathnames.h's HAS_DRIVES.	      *
 *                                                                             *
 \*****************************************************************************/
 
@@ -55,7 +57,7 @@ void TrimDotParts(char *path) { /* Remote ./ parts in the path */
     }
     *(pOut++) = c;
     first = (   (c == DIRSEPARATOR_CHAR)
-#if OS_HAS_DRIVES
+#if HAS_DRIVES
 	     || ((pIn == (path+2)) && (c == ':'))
 #endif
             );
@@ -0,0 +1,249 @@
+/*****************************************************************************\
+*                                                                             *
+*   File name	    PathBuf.c						      *
+*                                                                             *
+*   Description	    Build pathnames in place while walking directory trees   *
+*                                                                             *
+*   Notes	    A PATHBUF is a growable buffer containing the pathname of *
+*		    the current directory entry. Walking down into a	      *
+*		    subdirectory appends its name, and walking back up	      *
+*		    truncates the path back to its previous length.	      *
+*		    This avoids allocating and copying a new full pathname    *
+*		    for every directory entry.				      *
+*		    							      *
+*		    In Unix, the PATHBUF can optionally track a file	      *
+*		    descriptor for the directory, so that the entries can be  *
+*		    accessed with the *at() functions, without having the     *
+*		    kernel parse the whole pathname every time.		      *
+*                                                                             *
+*   History                                                                   *
+*    2026-10-17 MAB Created this file.					      *
+*                                                                             *
+\*****************************************************************************/
+
+#define _CRT_SECURE_NO_WARNINGS	/* Prevent MSVC warnings about unsecure C library functions */
+
+#if defined(__unix__) || defined(__MACH__)
+#define _GNU_SOURCE		/* For O_DIRECTORY and O_CLOEXEC */
+#endif
+
+#include <string.h>
+#include <stdlib.h>
+#include <limits.h>
+
+#include "pathnames.h"	/* Public definitions for this module */
+
+#if defined(__unix__) || defined(__MACH__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifndef PATH_MAX
+#define PATH_MAX 260
+#endif
+
+/*---------------------------------------------------------------------------*\
+*                                                                             *
+|   Function	    PathBufInit						      |
+|									      |
+|   Description     Initialize an empty path builder			      |
+|									      |
+|   Parameters      PATHBUF *pPB		The path builder	      |
+|		    							      |
+|   Returns	    Nothing						      |
+|		    							      |
+|   History								      |
+|    2026-10-17 MAB Created this routine				      |
+*									      *
+\*---------------------------------------------------------------------------*/
+
+void PathBufInit(PATHBUF *pPB) {
+  pPB->buf = NULL;
+  pPB->len = 0;
+  pPB->size = 0;
+#if defined(__unix__) || defined(__MACH__)
+  pPB->fd = AT_FDCWD;
+#endif
+}
+
+/*---------------------------------------------------------------------------*\
+*                                                                             *
+|   Function	    PathBufFree						      |
+|									      |
+|   Description     Free the path builder buffer, and close its directory fd |
+|									      |
+|   Parameters      PATHBUF *pPB		The path builder	      |
+|		    							      |
+|   Returns	    Nothing						      |
+|		    							      |
+|   Notes	    The PATHBUF is left initialized, and can be reused.	      |
+|		    							      |
+|   History								      |
+|    2026-10-17 MAB Created this routine				      |
+*									      *
+\*---------------------------------------------------------------------------*/
+
+void PathBufFree(PATHBUF *pPB) {
+  free(pPB->buf);
+#if defined(__unix__) || defined(__MACH__)
+  if (pPB->fd >= 0) close(pPB->fd);
+#endif
+  PathBufInit(pPB);
+}
+
+/*---------------------------------------------------------------------------*\
+*                                                                             *
+|   Function	    PathBufPush						      |
+|									      |
+|   Description     Append a name to the path				      |
+|									      |
+|   Parameters      PATHBUF *pPB		The path builder	      |
+|		    const char *pszName		The name to append	      |
+|		    							      |
+|   Returns	    The previous path length, to pass to PathBufPop(),	      |
+|		    or -1 if out of memory.				      |
+|		    							      |
+|   Notes	    A directory separator is inserted if needed.	      |
+|		    The buffer grows geometrically, so that in a typical walk |
+|		    it's only reallocated a few times in total.		      |
+|		    							      |
+|   History								      |
+|    2026-10-17 MAB Created this routine				      |
+*									      *
+\*---------------------------------------------------------------------------*/
+
+ssize_t PathBufPush(PATHBUF *pPB, const char *pszName) {
+  size_t len = pPB->len;
+  size_t lName = strlen(pszName);
+  size_t lNeeded = len + lName + 2;
+  if (lNeeded > pPB->size) {
+    size_t lNew = pPB->size ? 2 * pPB->size : PATH_MAX;
+    char *pNew;
+    while (lNew < lNeeded) lNew *= 2;
+    pNew = realloc(pPB->buf, lNew);
+    if (!pNew) return -1;
+    pPB->buf = pNew;
+    pPB->size = lNew;
+  }
+  if (len && lName && (pPB->buf[len-1] != DIRSEPARATOR_CHAR)) pPB->buf[pPB->len++] = DIRSEPARATOR_CHAR;
+  memcpy(pPB->buf + pPB->len, pszName, lName + 1);
+  pPB->len += lName;
+  return (ssize_t)len;
+}
+
+/*---------------------------------------------------------------------------*\
+*                                                                             *
+|   Function	    PathBufPop						      |
+|									      |
+|   Description     Truncate the path back to a previous length	      |
+|									      |
+|   Parameters      PATHBUF *pPB		The path builder	      |
+|		    size_t len			The length returned by Push() |
+|		    							      |
+|   Returns	    Nothing						      |
+|		    							      |
+|   History								      |
+|    2026-10-17 MAB Created this routine				      |
+*									      *
+\*---------------------------------------------------------------------------*/
+
+void PathBufPop(PATHBUF *pPB, size_t len) {
+  pPB->len = len;
+  if (pPB->buf) pPB->buf[len] = '\0';
+}
+
+/*---------------------------------------------------------------------------*\
+*                                                                             *
+|   Function	    PathBufSet						      |
+|									      |
+|   Description     Reset the path builder to a root pathname		      |
+|									      |
+|   Parameters      PATHBUF *pPB		The path builder	      |
+|		    const char *path		The root pathname, or NULL    |
+|		    							      |
+|   Returns	    0 = Success, -1 = Out of memory			      |
+|		    							      |
+|   Notes	    Useless ./ parts are removed, and "." becomes "", so that |
+|		    the pathnames built are the same as with		      |
+|		    NewCompactJoinedPath().				      |
+|		    Does not change the directory fd, if any.		      |
+|		    							      |
+|   History								      |
+|    2026-10-17 MAB Created this routine				      |
+*									      *
+\*---------------------------------------------------------------------------*/
+
+int PathBufSet(PATHBUF *pPB, const char *path) {
+  PathBufPop(pPB, 0);
+  if ((!path) || !strcmp(path, ".")) path = "";
+  if (PathBufPush(pPB, path) < 0) return -1;
+  TrimDotParts(pPB->buf);
+  pPB->len = strlen(pPB->buf);
+  return 0;
+}
+
+#if defined(__unix__) || defined(__MACH__)
+
+/*---------------------------------------------------------------------------*\
+*                                                                             *
+|   Function	    PathBufPushDir					      |
+|									      |
+|   Description     Append a subdirectory name, and open that subdirectory    |
+|									      |
+|   Parameters      PATHBUF *pPB		The path builder	      |
+|		    const char *pszName		The subdirectory name	      |
+|		    int iFlags			Additional openat() flags     |
+|		    PATHBUFMARK *pMark		Where to save the prev. state |
+|		    							      |
+|   Returns	    The new directory fd, or -1 if error, with errno set.     |
+|		    							      |
+|   Notes	    The subdirectory is opened relative to the current	      |
+|		    directory fd, or to the current directory initially.      |
+|		    The fd remains owned by the PATHBUF. It is closed by      |
+|		    PathBufPopDir(), which restores the previous state.	      |
+|		    							      |
+|		    Use O_NOFOLLOW in iFlags to refuse following symlinks.    |
+|		    							      |
+|   History								      |
+|    2026-10-17 MAB Created this routine				      |
+*									      *
+\*---------------------------------------------------------------------------*/
+
+int PathBufPushDir(PATHBUF *pPB, const char *pszName, int iFlags, PATHBUFMARK *pMark) {
+  int fd = openat(pPB->fd, pszName, O_RDONLY | O_DIRECTORY | O_CLOEXEC | iFlags);
+  ssize_t len;
+  if (fd < 0) return -1;
+  len = PathBufPush(pPB, pszName);
+  if (len < 0) {
+    close(fd);
+    return -1;
+  }
+  pMark->len = (size_t)len;
+  pMark->fd = pPB->fd;
+  pPB->fd = fd;
+  return fd;
+}
+
+/*---------------------------------------------------------------------------*\
+*                                                                             *
+|   Function	    PathBufPopDir					      |
+|									      |
+|   Description     Close the current directory, and go back to its parent    |
+|									      |
+|   Parameters      PATHBUF *pPB		The path builder	      |
+|		    PATHBUFMARK *pMark		State saved by PathBufPushDir |
+|		    							      |
+|   Returns	    Nothing						      |
+|		    							      |
+|   History								      |
+|    2026-10-17 MAB Created this routine				      |
+*									      *
+\*---------------------------------------------------------------------------*/
+
+void PathBufPopDir(PATHBUF *pPB, PATHBUFMARK *pMark) {
+  if (pPB->fd >= 0) close(pPB->fd);
+  pPB->fd = pMark->fd;
+  PathBufPop(pPB, pMark->len);
+}
+
+#endif /* defined(__unix__) || defined(__MACH__) */
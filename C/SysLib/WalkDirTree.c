@@ -8,6 +8,8 @@
 *                                                                             *
 *   History                                                                   *
 *    2021-11-27 JFL Created this file.					      *
+*    2026-10-17 MAB Added a native Unix version, based on openat/fdopendir.   *
+*		    Detect link loops using a hashed set of ancestors.	      *
 *                                                                             *
 \*****************************************************************************/
 
@@ -23,6 +25,8 @@
 #include <sys/stat.h>
 #include <dirent.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <stdio.h>
 
 /* SysToolsLib include files */
 #include "debugm.h"	/* SysToolsLib debugging macros */
@@ -31,6 +35,7 @@
 #include "dirx.h"		/* Directory access functions eXtensions */
 #include "pathnames.h"		/* Pathname management definitions and functions */
 #include "mainutil.h"		/* Print errors, streq, etc */
+#include "arena.h"		/* Arena memory allocator */
 
 /* Flag OSs that have links (For some OSs which don't, macros are defined, but S_ISLNK always returns 0) */
 #if defined(S_ISLNK) && S_ISLNK(S_IFLNK)
@@ -94,27 +99,137 @@ int isEffectiveDir(const char *pszPath) {
 |    2022-01-08 JFL Detect duplicate pathnames to folders visited before.     |
 |    2022-01-10 JFL Optionally detect alias names for folders visited before. |
 |    2022-01-11 JFL More consistent error handling & better statistics.       |
+|    2026-10-17 MAB Added a Unix version descending through directory file    |
+|		    descriptors, and identifying directories by (dev, ino).   |
+|		    Record visited directories in a hash table.		      |
+|		    Build the Unix pathnames in place using a SysLib PATHBUF. |
+|		    Detect link loops using a hash table of the ancestor      |
+|		    directories, instead of searching the parents list.       |
+|		    In Windows, don't resolve the true name of plain subdirs. |
 *									      *
 \*---------------------------------------------------------------------------*/
 
 /* Record all previously visited directories. Useful to avoid reporting files twice, when links point to directories */
 /* Note: Initially implemented as a linked list, but too slow when used on a whole hard disk. (O(N))
          With ~3 million files in ~300.000 directories, the linked list version took 16 minutes,
-         whereas the tree version took 3 minutes, and the dictionary version now takes 2.5 minutes. (Both O(N.log(N)) */
-/* TODO: It would be even better and faster to use a hash table, but I don't have one yet in my C library */
+         whereas the tree version took 3 minutes, and the dictionary version took 2.5 minutes. (Both O(N.log(N))
+         It's now a hash table, with O(1) lookups. */
 #if OS_HAS_LINKS
-#include "dict.h"
-DICT_DEFINE_PROCS();
+#include "hashtab.h"
+
+/* The set of visited directories. Keyed by their true name in Windows, and by their (dev, ino) in Unix */
+typedef struct _WDTONCE {
+  HASH_ENTRY_FIELDS();
+#if defined(__unix__)
+  dev_t dev;
+  ino_t ino;
+#else
+  char *pszTrueName;
+#endif
+  char *pszPath;	/* The pathname under which it was first visited */
+} WDTONCE;
+
+typedef struct _WDTONCESET {
+  HASH_TABLE_FIELDS(struct _WDTONCE);
+  ARENA sStrings;	/* The entries strings, all freed together with the set */
+} WDTONCESET;
+
+HASH_DEFINE_TYPES(WDTONCESET, WDTONCE);
+HASH_DEFINE_PROCS(WDTONCESET, WDTONCE);
+
+size_t HASH_KEY(WDTONCE)(WDTONCE *e) {
+#if defined(__unix__)
+  dev_t key[2];
+  key[0] = e->dev;
+  key[1] = (dev_t)e->ino;
+  return HashBytes(key, sizeof(key));
+#else
+  return HashString(e->pszTrueName);
+#endif
+}
+
+int HASH_CMP(WDTONCE)(WDTONCE *e1, WDTONCE *e2) {
+#if defined(__unix__)
+  return !((e1->ino == e2->ino) && (e1->dev == e2->dev));
+#else
+  return strcmp(e1->pszTrueName, e2->pszTrueName);
+#endif
+}
+
+/* Record a directory in the visited set.
+   Returns 0 if it's new, 1 if visited before as *ppszPrevious, or -1 if out of memory. */
+static int WdtVisitOnce(WDTONCESET *pSet, WDTONCE *pKey, const char *pszPath, char **ppszPrevious) {
+  WDTONCE *pEntry;
+  int bAdded;
+  pEntry = get_WDTONCE(pSet, pKey);
+  if (pEntry) { /* The same directory has been visited before under another alias name */
+    *ppszPrevious = pEntry->pszPath;
+    return 1;
+  }
+  pKey->pszPath = ArenaStrdup(&pSet->sStrings, pszPath);
+  if (!pKey->pszPath) return -1;
+#if !defined(__unix__)
+  pKey->pszTrueName = ArenaStrdup(&pSet->sStrings, pKey->pszTrueName);
+  if (!pKey->pszTrueName) return -1;
+#endif
+  if (!put_WDTONCE(pSet, pKey, &bAdded)) return -1;
+  return 0;
+}
+
+static void WdtFreeOnceSet(WDTONCESET *pSet) {
+  if (!pSet) return;
+  ArenaFree(&pSet->sStrings);
+  free_WDTONCE_hash(pSet);
+}
+
+/* The set of the directories from the root down to the one being scanned.
+   A link to any of them loops back. Same keys as the visited set. */
+typedef struct _WDTANCESTOR {
+  HASH_ENTRY_FIELDS();
+#if defined(__unix__)
+  dev_t dev;
+  ino_t ino;
+#else
+  const char *pszTrueName; /* Owned by the level that scans this directory */
+#endif
+} WDTANCESTOR;
+
+typedef struct _WDTANCESTORS {
+  HASH_TABLE_FIELDS(struct _WDTANCESTOR);
+} WDTANCESTORS;
+
+HASH_DEFINE_TYPES(WDTANCESTORS, WDTANCESTOR);
+HASH_DEFINE_PROCS(WDTANCESTORS, WDTANCESTOR);
+
+size_t HASH_KEY(WDTANCESTOR)(WDTANCESTOR *e) {
+#if defined(__unix__)
+  dev_t key[2];
+  key[0] = e->dev;
+  key[1] = (dev_t)e->ino;
+  return HashBytes(key, sizeof(key));
+#else
+  return HashString(e->pszTrueName);
+#endif
+}
+
+int HASH_CMP(WDTANCESTOR)(WDTANCESTOR *e1, WDTANCESTOR *e2) {
+#if defined(__unix__)
+  return !((e1->ino == e2->ino) && (e1->dev == e2->dev));
+#else
+  return strcmp(e1->pszTrueName, e2->pszTrueName);
+#endif
+}
 #endif /* OS_HAS_LINKS */
 
-/* Linked list of parent directories. Useful to detect back links */
+#ifndef __unix__
+
+/* Linked list of parent directories, with their true names */
 typedef struct _NAMELIST {
   struct _NAMELIST *prev;
   const char *path;
+  ARENA *pArena;	/* Where the true names are allocated. Shared by all levels */
 } NAMELIST;
 
-#ifndef __unix__
-
 /* Internal subroutine, used to avoid infinite loops on link back loops */
 static int WalkDirTree1(char *path, wdt_opts *pOpts, pWalkDirTreeCB_t pWalkDirTreeCB, void *pRef, NAMELIST *prev, int iDepth) {
   char *pPath;
@@ -124,9 +239,14 @@ static int WalkDirTree1(char *path, wdt_opts *pOpts, pWalkDirTreeCB_t pWalkDirTr
   struct dirent *pDE;
 #if OS_HAS_LINKS
   char *pRootBuf = NULL;
-  char *pTrueName = NULL;
-  dict_t *dict = NULL;
-  BOOL bCreatedDict = FALSE;
+  char *pTrueBuf = NULL;	/* Buffer for resolving the true names */
+  char *pTrueName = NULL;	/* Copy of the true name in the arena */
+  WDTONCESET *pOnce = NULL;
+  BOOL bCreatedOnce = FALSE;
+  WDTANCESTORS *pAncestors = NULL;
+  BOOL bCreatedAncestors = FALSE;
+  ARENA sArena = {0};		/* Root level only: The true names arena */
+  ARENAMARK sMark;		/* Where to release this level's true names */
 #endif /* OS_HAS_LINKS */
   NAMELIST root = {0};
   NAMELIST list = {0};
@@ -159,11 +279,20 @@ static int WalkDirTree1(char *path, wdt_opts *pOpts, pWalkDirTreeCB_t pWalkDirTr
     }
     pRootBuf = ShrinkBuf(pRootBuf, lstrlen(pRootBuf)+1); /* Free the unused space */
     root.path = pRootBuf;
+    root.pArena = &sArena;
     
     if (pOpts->iFlags & WDT_ONCE) { /* Check if an alias has been visited before */
-      pOpts->pOnce = dict = NewDict();
-      if (!dict) goto out_of_memory;
-      bCreatedDict = TRUE;
+      pOpts->pOnce = pOnce = new_WDTONCE_hash();
+      if (!pOnce) goto out_of_memory;
+      bCreatedOnce = TRUE;
+    }
+    if (pOpts->iFlags & WDT_FOLLOW) { /* Links may loop back to any ancestor */
+      WDTANCESTOR key = {0};
+      pOpts->pAncestors = pAncestors = new_WDTANCESTOR_hash();
+      if (!pAncestors) goto out_of_memory;
+      bCreatedAncestors = TRUE;
+      key.pszTrueName = pRootBuf;
+      if (!put_WDTANCESTOR(pAncestors, &key, NULL)) goto out_of_memory;
     }
 #else /* !OS_HAS_LINKS */
     root.path = path;
@@ -175,6 +304,10 @@ static int WalkDirTree1(char *path, wdt_opts *pOpts, pWalkDirTreeCB_t pWalkDirTr
   if (streq(pPath, ".")) pPath = NULL;	/* Hide the . path in the output */
 
   list.prev = prev;
+#if OS_HAS_LINKS
+  list.pArena = prev->pArena;
+  ArenaMark(list.pArena, &sMark);
+#endif /* OS_HAS_LINKS */
 
   while ((pDE = readdirx(pDir)) != NULL) { /* readdirx() ensures d_type is set */
 #if OS_HAS_LINKS
@@ -198,23 +331,33 @@ static int WalkDirTree1(char *path, wdt_opts *pOpts, pWalkDirTreeCB_t pWalkDirTr
     pTrueName = NULL;
     if (   ((pDE->d_type == DT_DIR) || (pDE->d_type == DT_LNK))
         && ((pOpts->iFlags & WDT_FOLLOW) || (pOpts->iFlags & WDT_ONCE))) {
-      pTrueName = malloc(PATH_MAX);
-      if (!pTrueName) goto out_of_memory;
       errno = 0;
-      bIsDir = isEffectiveDir(pPathname);
-      if (bIsDir && (MlxResolveLinks(pPathname, pTrueName, PATH_MAX) == 0)) {
-	/* Resolution succeeded */
-	pTrueName = ShrinkBuf(pTrueName, lstrlen(pTrueName)+1); /* Free the unused space */
+      if ((pDE->d_type == DT_DIR) && !pDE->d_ReparseTag) {
+	/* A plain subdirectory. Its true name is that of its parent, plus its own name */
+	size_t l = lstrlen(prev->path);
+	bIsDir = TRUE;
+	pTrueName = ArenaAlloc(list.pArena, l + lstrlen(pDE->d_name) + 2);
+	if (!pTrueName) goto out_of_memory;
+	strcpy(pTrueName, prev->path);
+	if (l && (pTrueName[l-1] != DIRSEPARATOR_CHAR)) pTrueName[l++] = DIRSEPARATOR_CHAR;
+	strcpy(pTrueName+l, pDE->d_name);
+      } else {
+	if (!pTrueBuf) pTrueBuf = malloc(PATH_MAX); /* Reused for all entries in this directory */
+	if (!pTrueBuf) goto out_of_memory;
+	bIsDir = isEffectiveDir(pPathname);
+	if (bIsDir && (MlxResolveLinks(pPathname, pTrueBuf, PATH_MAX) == 0)) {
+	  /* Resolution succeeded */
+	  pTrueName = ArenaStrdup(list.pArena, pTrueBuf);
+	  if (!pTrueName) goto out_of_memory;
+	}
+      }
+      if (pTrueName) {
+	list.path = pTrueName; /* Record this path for the subdirectory */
 	if (pOpts->iFlags & WDT_FOLLOW) {
-	  NAMELIST *pList;
-	  list.path = pTrueName; /* Record this path for next time */
-	  /* Check if we've seen this path before in the parent folders */
-	  for (pList = prev; pList; pList = pList->prev) {
-	    if (!lstrcmp(pTrueName, pList->path)) {
-	      pszBadLinkMsg = "Link loops back";
-	      break;
-	    }
-	  }
+	  WDTANCESTOR key = {0};
+	  /* Check if it's this directory, or one of its parent folders */
+	  key.pszTrueName = pTrueName;
+	  if (get_WDTANCESTOR(pOpts->pAncestors, &key)) pszBadLinkMsg = "Link loops back";
 	}
       } else { /* pPathname is a symlink pointing to a file, or a link looping to itself */
       	if (errno) switch (errno) {
@@ -262,25 +405,40 @@ static int WalkDirTree1(char *path, wdt_opts *pOpts, pWalkDirTreeCB_t pWalkDirTr
 #if OS_HAS_LINKS
 	/* Check if we've seen this path before anywhere else */
 	if (pOpts->iFlags & WDT_ONCE) { /* Check if an alias has been visited before */
-	  char *pszPrevious;
-	  dict = pOpts->pOnce;
-	  pszPrevious = DictValue(dict, pTrueName);
-	  if (pszPrevious) { /* The same directory has been visited before under another alias name */
-	    if (!(pOpts->iFlags & WDT_QUIET)) {
-	      fprintf(stderr, "Notice: Already visited \"%s\" as \"%s\"\n", pPathname, pszPrevious);
-	    }
-	    break;
-	  } else { /* OK, we've not visited this directory before. Record its name in the dictionary */
-	    char *pszDup = strdup(pPathname);
-	    if (!pszDup) goto out_of_memory;
-	    NewDictValue(dict, pTrueName, pszDup);
+	  char *pszPrevious = NULL;
+	  WDTONCE key = {0};
+	  key.pszTrueName = pTrueName;
+	  switch (WdtVisitOnce(pOpts->pOnce, &key, pPathname, &pszPrevious)) {
+	    case 1: /* The same directory has been visited before under another alias name */
+	      if (!(pOpts->iFlags & WDT_QUIET)) {
+		fprintf(stderr, "Notice: Already visited \"%s\" as \"%s\"\n", pPathname, pszPrevious);
+	      }
+	      break;
+	    case -1:
+	      goto out_of_memory;
+	    default: /* OK, we've not visited this directory before. It's now recorded in the set */
+	      break;
 	  }
+	  if (pszPrevious) break;
 	}
 #endif /* OS_HAS_LINKS */
       	if (!list.path) list.path = pPathname;
       	if (!(pOpts->iFlags & WDT_NORECURSE)) {
+#if OS_HAS_LINKS
+	  WDTANCESTOR key = {0};
+	  int bIsAncestor = FALSE;
+#endif /* OS_HAS_LINKS */
 	  if (!list.path) list.path = pPathname;
+#if OS_HAS_LINKS
+	  if (pTrueName && (pOpts->iFlags & WDT_FOLLOW)) { /* Record it as an ancestor of its subdirectories */
+	    key.pszTrueName = pTrueName;
+	    if (!put_WDTANCESTOR(pOpts->pAncestors, &key, &bIsAncestor)) goto out_of_memory;
+	  }
+#endif /* OS_HAS_LINKS */
       	  iRet = WalkDirTree1(pPathname, pOpts, pWalkDirTreeCB, pRef, &list, iDepth+1);
+#if OS_HAS_LINKS
+	  if (bIsAncestor) remove_WDTANCESTOR(pOpts->pAncestors, &key);
+#endif /* OS_HAS_LINKS */
       	}
       	break;
       default:
@@ -291,7 +449,7 @@ static int WalkDirTree1(char *path, wdt_opts *pOpts, pWalkDirTreeCB_t pWalkDirTr
     free(pPathname);
     pPathname = NULL;
 #if OS_HAS_LINKS
-    free(pTrueName);
+    ArenaRelease(list.pArena, &sMark); /* Free the true name, and those of all subdirectories */
     pTrueName = NULL;
 #endif /* OS_HAS_LINKS */
   }
@@ -323,13 +481,15 @@ cleanup_and_return:
   free(pPathname);
 #if OS_HAS_LINKS
   free(pRootBuf);
-  free(pTrueName);
-  if (bCreatedDict) { /* We're the first folder that created the visited dictionary. Delete it before returning. */
-    dictnode *pNode;
-    while ((pNode = FirstDictValue(dict)) != NULL) {
-      DeleteDictValue(dict, pNode->pszKey, free); /* Pass the free() function to free the value at the same time */
-    }
-    free(dict);
+  free(pTrueBuf);
+  if (list.pArena) ArenaRelease(list.pArena, &sMark);
+  ArenaFree(&sArena); /* Does nothing below the root level */
+  if (bCreatedAncestors) {
+    free_WDTANCESTOR_hash(pAncestors);
+    pOpts->pAncestors = NULL;
+  }
+  if (bCreatedOnce) { /* We're the first folder that created the visited set. Delete it before returning. */
+    WdtFreeOnceSet(pOnce);
     pOpts->pOnce = NULL;
   }
 #endif /* OS_HAS_LINKS */
@@ -341,4 +501,785 @@ int WalkDirTree(char *path, wdt_opts *pOpts, pWalkDirTreeCB_t pWalkDirTreeCB, vo
   return WalkDirTree1(path, pOpts, pWalkDirTreeCB, pRef, NULL, 0);
 }
 
-#endif /* ! __unix__ */
+#else /* defined(__unix__) */
+
+/* In Unix, a directory is uniquely identified by its device and inode numbers.
+   So there's no need to resolve links into true names, which is very slow. */
+
+#ifndef FALSE
+#define FALSE 0
+#define TRUE 1
+#endif
+
+/* Linked list of parent directories */
+typedef struct _NAMELIST {
+  struct _NAMELIST *prev;
+  dev_t dev;
+  ino_t ino;
+} NAMELIST;
+
+/* Internal subroutine, used to avoid infinite loops on link back loops */
+/* Opens pszName relative to iParentFD, and scans it. pPath contains its pathname for display. */
+static int WalkDirTree1(int iParentFD, const char *pszName, int bIsLink, PATHBUF *pPath,
+                        wdt_opts *pOpts, pWalkDirTreeCB_t pWalkDirTreeCB, void *pRef,
+                        NAMELIST *prev, int iDepth) {
+  char *path = pPath->buf;
+  int iRet = 0;
+  int iDirFD = -1;
+  DIR *pDir = NULL;
+  struct dirent *pDE;
+  struct stat sStat;
+#if OS_HAS_LINKS
+  WDTONCESET *pOnce = NULL;
+  int bCreatedOnce = FALSE;
+  WDTANCESTORS *pAncestors = NULL;
+  int bCreatedAncestors = FALSE;
+  WDTANCESTOR sAncestor = {0};	/* This directory key in the ancestors set */
+  int bIsAncestor = FALSE;	/* TRUE if it's been recorded there */
+#endif /* OS_HAS_LINKS */
+  NAMELIST list = {0};
+
+  DEBUG_ENTER(("WalkDirTree(\"%s\", ...);\n", pszName));
+
+  if ((!pszName) || !strlen(pszName)) RETURN_INT_COMMENT(-1, ("path is empty\n"));
+  if (!prev) path = (char *)pszName; /* Report errors on the root with the name we've been given */
+
+  iDirFD = openat(iParentFD, pszName, O_RDONLY | O_DIRECTORY | O_CLOEXEC | (bIsLink ? 0 : O_NOFOLLOW));
+  if (iDirFD == -1) {
+    if (errno == EACCES) goto access_denied;
+    goto fail_entry;
+  }
+  if (fstat(iDirFD, &sStat)) goto fail_entry;
+  list.prev = prev;
+  list.dev = sStat.st_dev;
+  list.ino = sStat.st_ino;
+
+#if OS_HAS_LINKS
+  if (!prev) { /* This is the directory tree root to search from */
+    if (pOpts->iFlags & WDT_ONCE) { /* Check if an alias has been visited before */
+      pOpts->pOnce = pOnce = new_WDTONCE_hash();
+      if (!pOnce) goto out_of_memory;
+      bCreatedOnce = TRUE;
+    }
+    if (pOpts->iFlags & WDT_FOLLOW) { /* Links may loop back to any ancestor */
+      pOpts->pAncestors = pAncestors = new_WDTANCESTOR_hash();
+      if (!pAncestors) goto out_of_memory;
+      bCreatedAncestors = TRUE;
+    }
+  }
+  /* Check if we've seen this directory before anywhere else */
+  if (pOpts->iFlags & WDT_ONCE) { /* Check if an alias has been visited before */
+    char *pszPrevious;
+    WDTONCE key = {0};
+    key.dev = list.dev;
+    key.ino = list.ino;
+    switch (WdtVisitOnce(pOpts->pOnce, &key, path, &pszPrevious)) {
+      case 1: /* The same directory has been visited before under another alias name */
+	if (!(pOpts->iFlags & WDT_QUIET)) {
+	  fprintf(stderr, "Notice: Already visited \"%s\" as \"%s\"\n", path, pszPrevious);
+	}
+	goto cleanup_and_return;
+      case -1:
+	goto out_of_memory;
+      default: /* OK, we've not visited this directory before. It's now recorded in the set */
+	break;
+    }
+  }
+  /* Record it as an ancestor of all its subdirectories */
+  if (pOpts->iFlags & WDT_FOLLOW) {
+    sAncestor.dev = list.dev;
+    sAncestor.ino = list.ino;
+    if (!put_WDTANCESTOR(pOpts->pAncestors, &sAncestor, &bIsAncestor)) goto out_of_memory;
+  }
+#endif /* OS_HAS_LINKS */
+
+  pDir = fdopendirx(iDirFD);
+  if (!pDir) goto fail_entry;
+  iDirFD = -1; /* It's now owned by pDir */
+
+  pOpts->nDir += 1;	/* One more directory scanned */
+
+  while ((errno = 0), (pDE = readdirx(pDir)) != NULL) { /* readdirx() ensures d_type is set */
+    ssize_t lParent;
+#if OS_HAS_LINKS
+    int bIsDir;		 /* TRUE if this is a link pointing to a directory */
+    char *pszBadLinkMsg; /* Flag bad links, pointing at a description of the problem */
+#endif /* OS_HAS_LINKS */
+
+    DEBUG_PRINTF(("// Dir Entry \"%s\" d_type=%d\n", pDE->d_name, (int)(pDE->d_type)));
+    if (streq(pDE->d_name, ".")) continue;	/* Skip the . directory */
+    if (streq(pDE->d_name, "..")) continue;	/* Skip the .. directory */
+
+    pOpts->nFile += 1;	/* One more file scanned */
+
+    lParent = PathBufPush(pPath, pDE->d_name);
+    if (lParent < 0) goto out_of_memory;
+    path = pPath->buf; /* The buffer may have moved */
+
+#if OS_HAS_LINKS
+    bIsDir = FALSE;
+    pszBadLinkMsg = NULL;
+    if (   (pDE->d_type == DT_LNK)
+        && ((pOpts->iFlags & WDT_FOLLOW) || (pOpts->iFlags & WDT_ONCE))) {
+      struct stat sTarget;
+      if (fstatat(dirxfd(pDir), pDE->d_name, &sTarget, 0) == 0) {
+	bIsDir = S_ISDIR(sTarget.st_mode);
+	if (bIsDir && (pOpts->iFlags & WDT_FOLLOW)) {
+	  WDTANCESTOR key = {0};
+	  /* Check if it's this directory, or one of its parent folders */
+	  key.dev = sTarget.st_dev;
+	  key.ino = sTarget.st_ino;
+	  if (get_WDTANCESTOR(pOpts->pAncestors, &key)) pszBadLinkMsg = "Link loops back";
+	}
+      } else switch (errno) { /* The link target can't be reached */
+	case ELOOP:	/* There's a link looping to itself */
+	  pszBadLinkMsg = "Link loops to itself"; break;
+	case ENOENT:	/* There's a dangling link */
+	  pszBadLinkMsg = "Dangling link"; break;
+	default: /* There's a real error we can't handle here */
+	  pferror("Can't resolve \"%s\": %s", path, strerror(errno));
+	  goto silent_fail; /* Abort the search */
+      }
+    }
+#endif /* OS_HAS_LINKS */
+
+    /* Report the valid directory entry to the callback */
+    iRet = pWalkDirTreeCB(path, pDE, pRef);
+    if (iRet) break;	/* -1 = Error, abort; 1 = Success, stop */
+
+    switch (pDE->d_type) {
+#if OS_HAS_LINKS
+      case DT_LNK:
+	if (pszBadLinkMsg) {
+	  if (pOpts->iFlags & WDT_FOLLOW) { /* When following links, it's an error */
+	    if (!((pOpts->iFlags & WDT_CONTINUE) && (pOpts->iFlags & WDT_QUIET))) {
+	      pferror("%s: \"%s\"", pszBadLinkMsg, path);
+	    }
+	    if (!(pOpts->iFlags & WDT_CONTINUE)) goto silent_fail;
+	    pOpts->nErr += 1; /* Else count the error, and keep searching */
+	  } else { /* When not following links, it's just a warning */
+	    if (!(pOpts->iFlags & WDT_QUIET)) {
+	      fprintf(stderr, "Warning: %s: \"%s\"\n", pszBadLinkMsg, path);
+	    }
+	  }
+	  break; /* Don't follow the bad or looping link, and keep searching */
+	}
+	if (!bIsDir) break; /* This is not a link to a subdirectory */
+	if (!(pOpts->iFlags & WDT_FOLLOW)) break;
+#endif /* OS_HAS_LINKS */
+	/* Fallthrough - into the directory case */
+      case DT_DIR:
+      	if (!(pOpts->iFlags & WDT_NORECURSE)) {
+      	  iRet = WalkDirTree1(dirxfd(pDir), pDE->d_name, (pDE->d_type == DT_LNK), pPath,
+      	                      pOpts, pWalkDirTreeCB, pRef, &list, iDepth+1);
+      	}
+      	break;
+      default:
+      	break;
+    }
+    if (iRet) break;	/* -1 = Error, abort; 1 = Success, stop */
+    /* Restore the pathname of this directory for the next entry */
+    PathBufPop(pPath, (size_t)lParent);
+    path = pPath->buf;
+  }
+  if (iRet) goto cleanup_and_return;	/* -1 = Error, abort; 1 = Success, stop */
+  /* Else it's readdir() that failed. Check errno to see the reason */
+  if (!errno) goto cleanup_and_return;	/* There are no more files */
+  if (errno == EACCES) {
+access_denied:
+    if (!((pOpts->iFlags & WDT_CONTINUE) && (pOpts->iFlags & WDT_QUIET))) {
+      pferror("Can't enter \"%s\": %s", path, strerror(errno));
+    }
+    if (pOpts->iFlags & WDT_CONTINUE) goto count_err_and_return;
+    goto silent_fail;
+  }
+  goto fail_entry; /* Anything else is an unexpected error we can't handle */
+
+out_of_memory:
+  pferror("Out of memory");
+  goto silent_fail;
+
+fail_entry:
+  pferror("Can't enter \"%s\": %s", path, strerror(errno));
+silent_fail:		/* The error message has already been displayed */
+  iRet = -1;
+count_err_and_return:	/* Count an error, cleanup and return */
+  pOpts->nErr += 1;
+cleanup_and_return:
+  if (pDir) closedirx(pDir);
+  if (iDirFD != -1) close(iDirFD);
+#if OS_HAS_LINKS
+  if (bIsAncestor) remove_WDTANCESTOR(pOpts->pAncestors, &sAncestor);
+  if (bCreatedAncestors) {
+    free_WDTANCESTOR_hash(pAncestors);
+    pOpts->pAncestors = NULL;
+  }
+  if (bCreatedOnce) { /* We're the first folder that created the visited set. Delete it before returning. */
+    WdtFreeOnceSet(pOnce);
+    pOpts->pOnce = NULL;
+  }
+#endif /* OS_HAS_LINKS */
+  RETURN_INT_COMMENT(iRet, ((iRet == -1) ? "Error, stop walk\n" : (iRet ? "Success, stop Walk\n" : "Success, continue walk\n")));
+}
+
+/* Public routine. Do not instrument with debug macros, to avoid call depth alignment issues. */
+int WalkDirTree(char *path, wdt_opts *pOpts, pWalkDirTreeCB_t pWalkDirTreeCB, void *pRef) {
+  PATHBUF sPath;
+  int iRet;
+  PathBufInit(&sPath);
+  if ((!path) || !strlen(path)) return WalkDirTree1(AT_FDCWD, path, FALSE, &sPath, pOpts, pWalkDirTreeCB, pRef, NULL, 0);
+  if (PathBufSet(&sPath, path)) {
+    pferror("Out of memory");
+    return -1;
+  }
+  iRet = WalkDirTree1(AT_FDCWD, path, TRUE, &sPath, pOpts, pWalkDirTreeCB, pRef, NULL, 0);
+  PathBufFree(&sPath);
+  return iRet;
+}
+
+/*---------------------------------------------------------------------------*\
+*                                                                             *
+|   Function	    WalkDirTreeMT					      |
+|									      |
+|   Description     Multi-threaded version of WalkDirTree		      |
+|									      |
+|   Parameters      char *path		The directory pathname		      |
+|		    wdt_opts *pOpts	Options. Must be cleared before use.  |
+|		    pWalkDirTreeCB	Callback called for every dir entry   |
+|		    void *pRef		Passed to the callback		      |
+|		    							      |
+|   Returns	    0=Walk complete; 1=Callback said to stop; -1=Error found  |
+|									      |
+|   Notes	    pOpts->nThread = Number of threads. 0 = 1 per CPU.	      |
+|		    							      |
+|		    Every subdirectory found becomes a task, pushed on the    |
+|		    work-stealing deque of the thread that found it. Threads  |
+|		    pop their own tasks in LIFO order, for locality, and      |
+|		    steal the oldest tasks of other threads when idle.        |
+|		    							      |
+|		    The callback is called concurrently by several threads,   |
+|		    so it must be thread-safe. The entries of a directory are |
+|		    reported in order, but the order of directories is not    |
+|		    deterministic.					      |
+|		    							      |
+|		    Subdirectories are opened relative to a duplicate of      |
+|		    their parent directory handle, which is closed as soon    |
+|		    as all its subdirectories have been opened. If that       |
+|		    handle can't be duplicated, for example because we ran   |
+|		    out of handles, report it once, and fall back to opening  |
+|		    the subdirectories by pathname.			      |
+|		    							      |
+|		    The WDT_ONCE set is shared by all threads. The	      |
+|		    parent directories chain used to detect link loops is     |
+|		    reference counted, as it is shared by all pending tasks.  |
+|		    							      |
+|   History								      |
+|    2026-10-17 MAB Created this routine.				      |
+|    2026-10-17 MAB Initialize the workers before anything can fail.	      |
+|		    Report F_DUPFD_CLOEXEC failures.			      |
+*									      *
+\*---------------------------------------------------------------------------*/
+
+#include <pthread.h>
+
+/* Reference-counted parent directories chain node */
+typedef struct _WDTNODE {
+  struct _WDTNODE *prev;
+  dev_t dev;
+  ino_t ino;
+  int fd;		/* Handle for opening subdirectories, or -1 */
+  int nRefs;		/* Number of references to this node */
+  int nFdRefs;		/* Number of references to the fd */
+} WDTNODE;
+
+/* A directory to scan */
+typedef struct {
+  WDTNODE *parent;	/* The parent directory node. We own one reference to it */
+  const char *name;	/* The name to open relative to the parent */
+  int bIsLink;		/* TRUE if this is a link to a directory */
+  int bFdRef;		/* TRUE if we own a reference to the parent fd */
+  char *path;		/* The pathname to display */
+} WDTTASK;
+
+struct _WDTMT;
+
+/* Per-thread context, with its own work-stealing deque and statistics */
+typedef struct {
+  struct _WDTMT *pMT;
+  pthread_t tid;
+  pthread_mutex_t lock;	/* Protects the deque */
+  WDTTASK **ppTasks;	/* The deque. The owner works at the tail, thieves at the head */
+  size_t iHead;
+  size_t iTail;
+  size_t nSize;
+  PATHBUF sPath;	/* The pathname of the current entry */
+  ino_t nDir;		/* Number of directories scanned by this thread */
+  ino_t nFile;		/* Number of directory entries processed by this thread */
+  int nErr;		/* Number of errors found by this thread */
+} WDTWORKER;
+
+/* State shared by all threads */
+typedef struct _WDTMT {
+  pthread_mutex_t lock;	/* Protects the counters below */
+  pthread_cond_t cond;	/* Signaled when new tasks are queued, or when done */
+  long nQueued;		/* Number of tasks in the deques */
+  long nBusy;		/* Number of tasks being processed */
+  int nIdle;		/* Number of threads waiting for work */
+  int iStop;		/* The first non-0 callback or error result */
+  int bNoFdReported;	/* TRUE once we reported running out of handles */
+  int nWorkers;
+  WDTWORKER *pWorkers;
+  int iFlags;
+  pWalkDirTreeCB_t pWalkDirTreeCB;
+  void *pRef;
+#if OS_HAS_LINKS
+  pthread_mutex_t onceLock;	/* Protects the WDT_ONCE set */
+  WDTONCESET *pOnce;
+#endif /* OS_HAS_LINKS */
+} WDTMT;
+
+#define WdtAddRef(pInt) __atomic_add_fetch(pInt, 1, __ATOMIC_RELAXED)
+#define WdtSubRef(pInt) __atomic_sub_fetch(pInt, 1, __ATOMIC_ACQ_REL)
+#define WdtStopped(pMT) __atomic_load_n(&(pMT)->iStop, __ATOMIC_RELAXED)
+
+static void WdtReleaseFd(WDTNODE *pNode) {
+  if (pNode && !WdtSubRef(&pNode->nFdRefs) && (pNode->fd != -1)) {
+    close(pNode->fd);
+    pNode->fd = -1;
+  }
+}
+
+static void WdtReleaseNode(WDTNODE *pNode) {
+  while (pNode && !WdtSubRef(&pNode->nRefs)) {
+    WDTNODE *prev = pNode->prev;
+    free(pNode);
+    pNode = prev;
+  }
+}
+
+static void WdtFreeTask(WDTTASK *pTask) {
+  if (pTask->bFdRef) WdtReleaseFd(pTask->parent);
+  WdtReleaseNode(pTask->parent);
+  free(pTask->path);
+  free(pTask);
+}
+
+/* Record the first reason to stop the walk */
+static void WdtStop(WDTMT *pMT, int iRet) {
+  pthread_mutex_lock(&pMT->lock);
+  if (!pMT->iStop) pMT->iStop = iRet;
+  pthread_cond_broadcast(&pMT->cond);
+  pthread_mutex_unlock(&pMT->lock);
+}
+
+static int WdtPushTask(WDTWORKER *pW, WDTTASK *pTask) {
+  WDTMT *pMT = pW->pMT;
+  pthread_mutex_lock(&pW->lock);
+  if (pW->iTail == pW->nSize) {
+    if (pW->iHead) { /* Reuse the space freed by thieves */
+      memmove(pW->ppTasks, pW->ppTasks + pW->iHead, (pW->iTail - pW->iHead) * sizeof(WDTTASK *));
+      pW->iTail -= pW->iHead;
+      pW->iHead = 0;
+    } else {
+      size_t nSize = pW->nSize ? 2 * pW->nSize : 64;
+      WDTTASK **ppTasks = realloc(pW->ppTasks, nSize * sizeof(WDTTASK *));
+      if (!ppTasks) {
+	pthread_mutex_unlock(&pW->lock);
+	return -1;
+      }
+      pW->ppTasks = ppTasks;
+      pW->nSize = nSize;
+    }
+  }
+  pW->ppTasks[pW->iTail++] = pTask;
+  pthread_mutex_unlock(&pW->lock);
+
+  pthread_mutex_lock(&pMT->lock);
+  pMT->nQueued += 1;
+  if (pMT->nIdle) pthread_cond_signal(&pMT->cond);
+  pthread_mutex_unlock(&pMT->lock);
+  return 0;
+}
+
+/* Pop the newest task from our own deque, or steal the oldest from another one */
+static WDTTASK *WdtTakeTask(WDTWORKER *pW, WDTWORKER *pFrom) {
+  WDTTASK *pTask = NULL;
+  pthread_mutex_lock(&pFrom->lock);
+  if (pFrom->iHead < pFrom->iTail) {
+    if (pFrom == pW) {
+      pTask = pFrom->ppTasks[--(pFrom->iTail)];
+    } else {
+      pTask = pFrom->ppTasks[(pFrom->iHead)++];
+    }
+    if (pFrom->iHead == pFrom->iTail) pFrom->iHead = pFrom->iTail = 0;
+  }
+  pthread_mutex_unlock(&pFrom->lock);
+  return pTask;
+}
+
+/* Get the next task to process, or NULL if the walk is over */
+static WDTTASK *WdtNextTask(WDTWORKER *pW) {
+  WDTMT *pMT = pW->pMT;
+  int iSelf = (int)(pW - pMT->pWorkers);
+  for (;;) {
+    WDTTASK *pTask = NULL;
+    int i;
+    if (!WdtStopped(pMT)) for (i = 0; (i < pMT->nWorkers) && !pTask; i++) {
+      pTask = WdtTakeTask(pW, pMT->pWorkers + ((iSelf + i) % pMT->nWorkers));
+    }
+    pthread_mutex_lock(&pMT->lock);
+    if (pTask) {
+      pMT->nQueued -= 1;
+      pMT->nBusy += 1;
+      pthread_mutex_unlock(&pMT->lock);
+      return pTask;
+    }
+    if (pMT->iStop || (!pMT->nQueued && !pMT->nBusy)) { /* The walk is over */
+      pthread_cond_broadcast(&pMT->cond);
+      pthread_mutex_unlock(&pMT->lock);
+      return NULL;
+    }
+    if (!pMT->nQueued) { /* Wait for busy threads to queue more tasks, or finish */
+      pMT->nIdle += 1;
+      pthread_cond_wait(&pMT->cond, &pMT->lock);
+      pMT->nIdle -= 1;
+    } /* Else a task is in transit to another thread. Try again */
+    pthread_mutex_unlock(&pMT->lock);
+  }
+}
+
+static void WdtTaskDone(WDTMT *pMT) {
+  pthread_mutex_lock(&pMT->lock);
+  pMT->nBusy -= 1;
+  if (!pMT->nBusy && !pMT->nQueued) pthread_cond_broadcast(&pMT->cond);
+  pthread_mutex_unlock(&pMT->lock);
+}
+
+/* Create a task for scanning a subdirectory */
+static WDTTASK *WdtNewTask(WDTNODE *parent, const char *path, size_t lName, int bIsLink) {
+  WDTTASK *pTask = malloc(sizeof(WDTTASK));
+  if (!pTask) return NULL;
+  pTask->path = strdup(path);
+  if (!pTask->path) {
+    free(pTask);
+    return NULL;
+  }
+  pTask->name = pTask->path + strlen(path) - lName;
+  pTask->bIsLink = bIsLink;
+  pTask->parent = parent;
+  pTask->bFdRef = (parent != NULL);
+  if (parent) {
+    WdtAddRef(&parent->nRefs);
+    WdtAddRef(&parent->nFdRefs);
+  }
+  return pTask;
+}
+
+/* Scan one directory. Returns 0=Continue; 1=Callback said to stop; -1=Error */
+static int WdtScanDir(WDTWORKER *pW, WDTTASK *pTask) {
+  WDTMT *pMT = pW->pMT;
+  int iFlags = pMT->iFlags;
+  PATHBUF *pPath = &pW->sPath;
+  char *path = pTask->path;
+  int iRet = 0;
+  int iBaseFD = AT_FDCWD;
+  const char *pszName = pTask->name;
+  int iDirFD = -1;
+  DIR *pDir = NULL;
+  struct dirent *pDE;
+  struct stat sStat;
+  WDTNODE *pNode = NULL;
+
+  if (pTask->parent) {
+    if (pTask->parent->fd != -1) {
+      iBaseFD = pTask->parent->fd;
+    } else { /* We ran out of handles. Use the pathname instead */
+      pszName = pTask->path;
+    }
+  }
+  iDirFD = openat(iBaseFD, pszName, O_RDONLY | O_DIRECTORY | O_CLOEXEC | (pTask->bIsLink ? 0 : O_NOFOLLOW));
+  WdtReleaseFd(pTask->parent);
+  pTask->bFdRef = FALSE;
+  if (iDirFD == -1) {
+    if (errno == EACCES) goto access_denied;
+    goto fail_entry;
+  }
+  if (fstat(iDirFD, &sStat)) goto fail_entry;
+
+#if OS_HAS_LINKS
+  /* Check if we've seen this directory before anywhere else */
+  if (iFlags & WDT_ONCE) { /* Check if an alias has been visited before */
+    char *pszPrevious;
+    WDTONCE key = {0};
+    int iOnce;
+    key.dev = sStat.st_dev;
+    key.ino = sStat.st_ino;
+    pthread_mutex_lock(&pMT->onceLock);
+    iOnce = WdtVisitOnce(pMT->pOnce, &key, path, &pszPrevious);
+    if ((iOnce == 1) && !(iFlags & WDT_QUIET)) { /* Visited before under another alias name */
+      fprintf(stderr, "Notice: Already visited \"%s\" as \"%s\"\n", path, pszPrevious);
+    }
+    pthread_mutex_unlock(&pMT->onceLock);
+    if (iOnce == 1) goto cleanup_and_return;
+    if (iOnce == -1) goto out_of_memory;
+  }
+#endif /* OS_HAS_LINKS */
+
+  pNode = malloc(sizeof(WDTNODE));
+  if (!pNode) goto out_of_memory;
+  pNode->prev = pTask->parent;	/* Take over the task reference to the parent */
+  pTask->parent = NULL;
+  pNode->dev = sStat.st_dev;
+  pNode->ino = sStat.st_ino;
+  pNode->nRefs = 1;
+  pNode->nFdRefs = 1;
+  pNode->fd = -1;
+  if (!(iFlags & WDT_NORECURSE)) {
+    pNode->fd = fcntl(iDirFD, F_DUPFD_CLOEXEC, 0);
+    if ((pNode->fd == -1) && !(iFlags & WDT_QUIET) && !__atomic_exchange_n(&pMT->bNoFdReported, 1, __ATOMIC_RELAXED)) {
+      /* Report it once. The subdirectories will be opened by pathname */
+      flockfile(stderr);
+      fprintf(stderr, "Warning: Can't duplicate the handle of \"%s\": %s. Opening subdirectories by pathname\n", path, strerror(errno));
+      funlockfile(stderr);
+    }
+  }
+
+  pDir = fdopendirx(iDirFD);
+  if (!pDir) goto fail_entry;
+  iDirFD = -1; /* It's now owned by pDir */
+
+  pW->nDir += 1;	/* One more directory scanned */
+
+  PathBufPop(pPath, 0);
+  if (PathBufPush(pPath, path) < 0) goto out_of_memory;
+
+  while ((errno = 0), (pDE = readdirx(pDir)) != NULL) { /* readdirx() ensures d_type is set */
+    ssize_t lParent;
+#if OS_HAS_LINKS
+    int bIsDir;		 /* TRUE if this is a link pointing to a directory */
+    char *pszBadLinkMsg; /* Flag bad links, pointing at a description of the problem */
+#endif /* OS_HAS_LINKS */
+
+    if (streq(pDE->d_name, ".")) continue;	/* Skip the . directory */
+    if (streq(pDE->d_name, "..")) continue;	/* Skip the .. directory */
+    if (WdtStopped(pMT)) break;		/* Another thread stopped the walk */
+
+    pW->nFile += 1;	/* One more file scanned */
+
+    lParent = PathBufPush(pPath, pDE->d_name);
+    if (lParent < 0) goto out_of_memory;
+
+#if OS_HAS_LINKS
+    bIsDir = FALSE;
+    pszBadLinkMsg = NULL;
+    if (   (pDE->d_type == DT_LNK)
+        && ((iFlags & WDT_FOLLOW) || (iFlags & WDT_ONCE))) {
+      struct stat sTarget;
+      if (fstatat(dirxfd(pDir), pDE->d_name, &sTarget, 0) == 0) {
+	bIsDir = S_ISDIR(sTarget.st_mode);
+	if (bIsDir && (iFlags & WDT_FOLLOW)) {
+	  WDTNODE *pList;
+	  /* Check if we've seen this directory before in the parent folders */
+	  for (pList = pNode; pList; pList = pList->prev) {
+	    if ((pList->ino == sTarget.st_ino) && (pList->dev == sTarget.st_dev)) {
+	      pszBadLinkMsg = "Link loops back";
+	      break;
+	    }
+	  }
+	}
+      } else switch (errno) { /* The link target can't be reached */
+	case ELOOP:	/* There's a link looping to itself */
+	  pszBadLinkMsg = "Link loops to itself"; break;
+	case ENOENT:	/* There's a dangling link */
+	  pszBadLinkMsg = "Dangling link"; break;
+	default: /* There's a real error we can't handle here */
+	  flockfile(stderr);
+	  pferror("Can't resolve \"%s\": %s", pPath->buf, strerror(errno));
+	  funlockfile(stderr);
+	  goto silent_fail; /* Abort the search */
+      }
+    }
+#endif /* OS_HAS_LINKS */
+
+    /* Report the valid directory entry to the callback */
+    iRet = pMT->pWalkDirTreeCB(pPath->buf, pDE, pMT->pRef);
+    if (iRet) break;	/* -1 = Error, abort; 1 = Success, stop */
+
+    switch (pDE->d_type) {
+#if OS_HAS_LINKS
+      case DT_LNK:
+	if (pszBadLinkMsg) {
+	  if (iFlags & WDT_FOLLOW) { /* When following links, it's an error */
+	    if (!((iFlags & WDT_CONTINUE) && (iFlags & WDT_QUIET))) {
+	      flockfile(stderr);
+	      pferror("%s: \"%s\"", pszBadLinkMsg, pPath->buf);
+	      funlockfile(stderr);
+	    }
+	    if (!(iFlags & WDT_CONTINUE)) goto silent_fail;
+	    pW->nErr += 1; /* Else count the error, and keep searching */
+	  } else { /* When not following links, it's just a warning */
+	    if (!(iFlags & WDT_QUIET)) {
+	      fprintf(stderr, "Warning: %s: \"%s\"\n", pszBadLinkMsg, pPath->buf);
+	    }
+	  }
+	  break; /* Don't follow the bad or looping link, and keep searching */
+	}
+	if (!bIsDir) break; /* This is not a link to a subdirectory */
+	if (!(iFlags & WDT_FOLLOW)) break;
+#endif /* OS_HAS_LINKS */
+	/* Fallthrough - into the directory case */
+      case DT_DIR:
+      	if (!(iFlags & WDT_NORECURSE)) {
+	  WDTTASK *pSubTask = WdtNewTask(pNode, pPath->buf, strlen(pDE->d_name), (pDE->d_type == DT_LNK));
+	  if (!pSubTask) goto out_of_memory;
+	  if (WdtPushTask(pW, pSubTask)) {
+	    WdtFreeTask(pSubTask);
+	    goto out_of_memory;
+	  }
+      	}
+      	break;
+      default:
+      	break;
+    }
+    /* Restore the pathname of this directory for the next entry */
+    PathBufPop(pPath, (size_t)lParent);
+  }
+  if (iRet) goto cleanup_and_return;	/* -1 = Error, abort; 1 = Success, stop */
+  /* Else it's readdir() that failed. Check errno to see the reason */
+  if (!errno) goto cleanup_and_return;	/* There are no more files */
+  if (errno == EACCES) {
+access_denied:
+    if (!((iFlags & WDT_CONTINUE) && (iFlags & WDT_QUIET))) {
+      flockfile(stderr);
+      pferror("Can't enter \"%s\": %s", path, strerror(errno));
+      funlockfile(stderr);
+    }
+    if (iFlags & WDT_CONTINUE) goto count_err_and_return;
+    goto silent_fail;
+  }
+  goto fail_entry; /* Anything else is an unexpected error we can't handle */
+
+out_of_memory:
+  pferror("Out of memory");
+  goto silent_fail;
+
+fail_entry:
+  flockfile(stderr);
+  pferror("Can't enter \"%s\": %s", path, strerror(errno));
+  funlockfile(stderr);
+silent_fail:		/* The error message has already been displayed */
+  iRet = -1;
+count_err_and_return:	/* Count an error, cleanup and return */
+  pW->nErr += 1;
+cleanup_and_return:
+  if (pDir) closedirx(pDir);
+  if (iDirFD != -1) close(iDirFD);
+  if (pNode) {
+    WdtReleaseFd(pNode);
+    WdtReleaseNode(pNode);
+  }
+  return iRet;
+}
+
+static void *WdtWorker(void *pArg) {
+  WDTWORKER *pW = pArg;
+  WDTTASK *pTask;
+  while ((pTask = WdtNextTask(pW)) != NULL) {
+    int iRet = WdtScanDir(pW, pTask);
+    WdtFreeTask(pTask);
+    if (iRet) WdtStop(pW->pMT, iRet);
+    WdtTaskDone(pW->pMT);
+  }
+  return NULL;
+}
+
+int WalkDirTreeMT(char *path, wdt_opts *pOpts, pWalkDirTreeCB_t pWalkDirTreeCB, void *pRef) {
+  WDTMT sMT = {0};
+  WDTTASK *pTask = NULL;
+  int nWorkers = pOpts->nThread;
+  int nStarted;
+  int i;
+
+  if ((!path) || !strlen(path)) {
+    pferror("Can't enter \"\": %s", strerror(ENOENT));
+    pOpts->nErr += 1;
+    return -1;
+  }
+  if (nWorkers <= 0) nWorkers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  if (nWorkers <= 0) nWorkers = 1;
+
+  sMT.nWorkers = nWorkers;
+  sMT.iFlags = pOpts->iFlags;
+  sMT.pWalkDirTreeCB = pWalkDirTreeCB;
+  sMT.pRef = pRef;
+  sMT.pWorkers = calloc(nWorkers, sizeof(WDTWORKER));
+  if (!sMT.pWorkers) goto out_of_memory;
+  pthread_mutex_init(&sMT.lock, NULL);
+  pthread_cond_init(&sMT.cond, NULL);
+  /* Initialize all workers before anything can fail, as the cleanup code
+     below tears them all down. No thread is started before the end. */
+  for (i = 0; i < nWorkers; i++) {
+    sMT.pWorkers[i].pMT = &sMT;
+    pthread_mutex_init(&sMT.pWorkers[i].lock, NULL);
+    PathBufInit(&sMT.pWorkers[i].sPath);
+  }
+#if OS_HAS_LINKS
+  pthread_mutex_init(&sMT.onceLock, NULL);
+  if (pOpts->iFlags & WDT_ONCE) {
+    pOpts->pOnce = sMT.pOnce = new_WDTONCE_hash();
+    if (!sMT.pOnce) goto out_of_memory;
+  }
+#endif /* OS_HAS_LINKS */
+
+  /* Queue the root directory */
+  if (PathBufSet(&sMT.pWorkers[0].sPath, path)) goto out_of_memory;
+  pTask = WdtNewTask(NULL, sMT.pWorkers[0].sPath.buf, 0, TRUE);
+  if (!pTask) goto out_of_memory;
+  pTask->name = path;
+  if (WdtPushTask(sMT.pWorkers, pTask)) goto out_of_memory;
+  pTask = NULL;
+
+  /* Start the other threads, and work in this one too */
+  for (nStarted = 1; nStarted < nWorkers; nStarted++) {
+    if (pthread_create(&sMT.pWorkers[nStarted].tid, NULL, WdtWorker, sMT.pWorkers + nStarted)) break;
+  }
+  WdtWorker(sMT.pWorkers);
+  for (i = 1; i < nStarted; i++) pthread_join(sMT.pWorkers[i].tid, NULL);
+  goto cleanup_and_return;
+
+out_of_memory:
+  pferror("Out of memory");
+  sMT.iStop = -1;
+  pOpts->nErr += 1;
+  nWorkers = sMT.pWorkers ? nWorkers : 0;
+cleanup_and_return:
+  if (pTask) WdtFreeTask(pTask);
+  for (i = 0; i < nWorkers; i++) { /* Merge the statistics, and free tasks left if stopped early */
+    WDTWORKER *pW = sMT.pWorkers + i;
+    WDTTASK *pLeft;
+    while ((pLeft = WdtTakeTask(pW, pW)) != NULL) WdtFreeTask(pLeft);
+    pOpts->nDir += pW->nDir;
+    pOpts->nFile += pW->nFile;
+    pOpts->nErr += pW->nErr;
+    free(pW->ppTasks);
+    PathBufFree(&pW->sPath);
+    pthread_mutex_destroy(&pW->lock);
+  }
+#if OS_HAS_LINKS
+  if (sMT.pOnce) {
+    WdtFreeOnceSet(sMT.pOnce);
+    pOpts->pOnce = NULL;
+  }
+#endif /* OS_HAS_LINKS */
+  if (sMT.pWorkers) {
+    pthread_cond_destroy(&sMT.cond);
+    pthread_mutex_destroy(&sMT.lock);
+#if OS_HAS_LINKS
+    pthread_mutex_destroy(&sMT.onceLock);
+#endif /* OS_HAS_LINKS */
+    free(sMT.pWorkers);
+  }
+  return sMT.iStop;
+}
+
+#endif /* defined(__unix__) */
@@ -0,0 +1,134 @@
+/*****************************************************************************\
+*                                                                             *
+*   File name	    arena.c						      *
+*                                                                             *
+*   Description	    Arena (a.k.a. bump or region) memory allocator	      *
+*                                                                             *
+*   Notes	    See arena.h for the usage rules.			      *
+*		    							      *
+*		    The arena is a stack of blocks. Allocations are carved    *
+*		    from the top block, and a new block is pushed when it's   *
+*		    full. Allocations larger than the block size get a	      *
+*		    dedicated block of their own size.			      *
+*		    ArenaRelease() pops the blocks allocated after the mark.  *
+*		    One standard-size block is kept as a spare, so that	      *
+*		    repeatedly marking and releasing around a block boundary  *
+*		    does not call malloc() and free() every time.	      *
+*                                                                             *
+*   History                                                                   *
+*    2026-10-17 MAB Created this file.					      *
+*                                                                             *
+\*****************************************************************************/
+
+#define _CRT_SECURE_NO_WARNINGS	/* Prevent MSVC warnings about unsecure C library functions */
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "arena.h"	/* Public definitions for this module */
+
+#if defined(_MSDOS)
+#define ARENA_BLOCK_SIZE 0x1000		/* Default block size: 4 KB */
+#else
+#define ARENA_BLOCK_SIZE 0x10000	/* Default block size: 64 KB */
+#endif
+
+/* Alignment of all allocations. Enough for any scalar type we use */
+#define ARENA_ALIGN (2 * sizeof(void *))
+#define ARENA_ROUND(n) (((n) + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1))
+
+struct _ARENABLOCK {
+  ARENABLOCK *pPrev;		/* The block below this one in the stack */
+  size_t nSize;			/* Size of the data area */
+  size_t nUsed;			/* Number of bytes used in the data area */
+};
+
+#define ARENA_HEADER_SIZE ARENA_ROUND(sizeof(ARENABLOCK))
+#define ARENA_DATA(pBlock) ((char *)(pBlock) + ARENA_HEADER_SIZE)
+
+/* Initialize an empty arena. nBlockSize = 0 for the default size */
+void ArenaInit(ARENA *pArena, size_t nBlockSize) {
+  pArena->pBlock = NULL;
+  pArena->pSpare = NULL;
+  pArena->nBlockSize = nBlockSize;
+}
+
+static size_t ArenaBlockSize(ARENA *pArena) {
+  return pArena->nBlockSize ? pArena->nBlockSize : ARENA_BLOCK_SIZE;
+}
+
+/* Push a new block with at least nSize bytes of data area */
+static ARENABLOCK *ArenaNewBlock(ARENA *pArena, size_t nSize) {
+  ARENABLOCK *pBlock;
+  size_t nBlockSize = ArenaBlockSize(pArena);
+  if (nSize < nBlockSize) nSize = nBlockSize;
+  if (pArena->pSpare && (pArena->pSpare->nSize >= nSize)) {
+    pBlock = pArena->pSpare;
+    pArena->pSpare = NULL;
+  } else {
+    pBlock = (ARENABLOCK *)malloc(ARENA_HEADER_SIZE + nSize);
+    if (!pBlock) return NULL;
+    pBlock->nSize = nSize;
+  }
+  pBlock->nUsed = 0;
+  pBlock->pPrev = pArena->pBlock;
+  pArena->pBlock = pBlock;
+  return pBlock;
+}
+
+/* Allocate aligned memory. Returns NULL if out of memory */
+void *ArenaAlloc(ARENA *pArena, size_t nSize) {
+  ARENABLOCK *pBlock = pArena->pBlock;
+  void *p;
+  nSize = ARENA_ROUND(nSize ? nSize : 1);
+  if ((!pBlock) || ((pBlock->nSize - pBlock->nUsed) < nSize)) {
+    pBlock = ArenaNewBlock(pArena, nSize);
+    if (!pBlock) return NULL;
+  }
+  p = ARENA_DATA(pBlock) + pBlock->nUsed;
+  pBlock->nUsed += nSize;
+  return p;
+}
+
+/* Duplicate the first nLength characters of a string */
+char *ArenaStrndup(ARENA *pArena, const char *pszString, size_t nLength) {
+  char *psz = (char *)ArenaAlloc(pArena, nLength + 1);
+  if (!psz) return NULL;
+  memcpy(psz, pszString, nLength);
+  psz[nLength] = '\0';
+  return psz;
+}
+
+/* Duplicate a string */
+char *ArenaStrdup(ARENA *pArena, const char *pszString) {
+  return ArenaStrndup(pArena, pszString, strlen(pszString));
+}
+
+/* Record the current allocation position */
+void ArenaMark(ARENA *pArena, ARENAMARK *pMark) {
+  pMark->pBlock = pArena->pBlock;
+  pMark->nUsed = pArena->pBlock ? pArena->pBlock->nUsed : 0;
+}
+
+/* Free everything allocated after the mark */
+void ArenaRelease(ARENA *pArena, ARENAMARK *pMark) {
+  ARENABLOCK *pBlock;
+  while ((pBlock = pArena->pBlock) != pMark->pBlock) {
+    if (!pBlock) break; /* Invalid mark. Should not happen */
+    pArena->pBlock = pBlock->pPrev;
+    if ((!pArena->pSpare) && (pBlock->nSize == ArenaBlockSize(pArena))) {
+      pArena->pSpare = pBlock;
+    } else {
+      free(pBlock);
+    }
+  }
+  if (pBlock) pBlock->nUsed = pMark->nUsed;
+}
+
+/* Free everything, including the spare block */
+void ArenaFree(ARENA *pArena) {
+  ARENAMARK mark = {0};
+  ArenaRelease(pArena, &mark);
+  free(pArena->pSpare);
+  pArena->pSpare = NULL;
+}
@@ -0,0 +1,61 @@
+/*****************************************************************************\
+*                                                                             *
+*   Filename:	    arena.h						      *
+*									      *
+*   Description:    Arena (a.k.a. bump or region) memory allocator	      *
+*                                                                             *
+*   Notes:	    Allocates many small objects with a common lifetime from  *
+*		    large blocks, and frees them all at once.		      *
+*		    Objects cannot be freed individually. Instead, record a   *
+*		    mark with ArenaMark(), and release everything allocated   *
+*		    since that mark with ArenaRelease(). Marks must be	      *
+*		    released in the reverse order they were taken.	      *
+*		    							      *
+*		    An ARENA structure cleared with zeros is a valid empty    *
+*		    arena, using the default block size.		      *
+*		    An arena is not thread-safe. Use one per thread, or	      *
+*		    protect it with a lock.				      *
+*		    							      *
+*   History:								      *
+*    2026-10-17 MAB Created this file.					      *
+*									      *
+* Licensed under the Apache 2.0 license - www.apache.org/licenses/LICENSE-2.0 *
+\*****************************************************************************/
+
+#ifndef _SYSLIB_ARENA_H_
+#define _SYSLIB_ARENA_H_
+
+#include "SysLib.h"		/* SysLib Library core definitions */
+
+#include <stddef.h>		/* For size_t */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+typedef struct _ARENABLOCK ARENABLOCK;	/* Opaque memory block header */
+
+typedef struct {		/* Arena. Clear it, or call ArenaInit(), before use */
+  ARENABLOCK *pBlock;		/* The block we're currently allocating from */
+  ARENABLOCK *pSpare;		/* A released block kept for reuse */
+  size_t nBlockSize;		/* Size of the blocks to allocate. 0=Default */
+} ARENA;
+
+typedef struct {		/* A position in the arena, to release back to */
+  ARENABLOCK *pBlock;
+  size_t nUsed;
+} ARENAMARK;
+
+void ArenaInit(ARENA *pArena, size_t nBlockSize);		/* Initialize an empty arena */
+void *ArenaAlloc(ARENA *pArena, size_t nSize);			/* Allocate aligned memory. NULL=Out of memory */
+char *ArenaStrdup(ARENA *pArena, const char *pszString);	/* Duplicate a string */
+char *ArenaStrndup(ARENA *pArena, const char *pszString, size_t nLength);  /* Idem, with a length */
+void ArenaMark(ARENA *pArena, ARENAMARK *pMark);		/* Record the current position */
+void ArenaRelease(ARENA *pArena, ARENAMARK *pMark);		/* Free everything allocated after the mark */
+void ArenaFree(ARENA *pArena);					/* Free everything */
+
+#ifdef __cplusplus
+}
+#endif /* defined(__cplusplus) */
+
+#endif /* _SYSLIB_ARENA_H_ */
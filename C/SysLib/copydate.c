@@ -8,6 +8,7 @@
 *                                                                             *
 *   History                                                                   *
 *    2020-11-05 JFL Factored-out the copydate routine from backnum, update,...*
+*    2026-10-17 MAB Added fcopydate(), for files that are still open.         *
 *                                                                             *
 *          Copyright 2016 Hewlett Packard Enterprise Development LP          *
 * Licensed under the Apache 2.0 license - www.apache.org/licenses/LICENSE-2.0 *
@@ -165,6 +166,25 @@ int copydate(const char *pszToFile, const char *pszFromFile) { /* Copy the file
   return err;                       /* Success */
 }
 
+#if defined(__unix__) || defined(__MACH__)
+/* Same thing for open files, without looking up their pathnames again.
+   The destination must be flushed before calling this function. */
+int fcopydate(int iToFd, int iFromFd) { /* Copy the open files dates */
+  struct stat stFrom = {0};
+  struct timespec tsTo[2] = {{0}, {0}};
+  int err;
+  err = fstat(iFromFd, &stFrom);
+  if (err) return err;
+  /* Copy file permissions too */
+  err = fchmod(iToFd, stFrom.st_mode);
+  /* And copy file times */
+  tsTo[0] = stFrom.st_atim;
+  tsTo[1] = stFrom.st_mtim;
+  err = futimens(iToFd, tsTo);
+  return err;
+}
+#endif
+
 /*---------------------------------------------------------------------------*\
 |*              Second best implementation with 1us resolution               *|
 \*---------------------------------------------------------------------------*/
@@ -228,6 +248,25 @@ int copydate(const char *pszToFile, const char *pszFromFile) { /* Copy the file
   return err;                       /* Success */
 }
 
+#if defined(__unix__) || defined(__MACH__)
+/* Same thing for open files, without looking up their pathnames again.
+   The destination must be flushed before calling this function. */
+int fcopydate(int iToFd, int iFromFd) { /* Copy the open files dates */
+  struct stat stFrom = {0};
+  struct timeval tvTo[2] = {{0}, {0}};
+  int err;
+  err = fstat(iFromFd, &stFrom);
+  if (err) return err;
+  /* Copy file permissions too */
+  err = fchmod(iToFd, stFrom.st_mode);
+  /* And copy file times */
+  TIMESPEC_TO_TIMEVAL(&tvTo[0], &stFrom.st_atim);
+  TIMESPEC_TO_TIMEVAL(&tvTo[1], &stFrom.st_mtim);
+  err = futimes(iToFd, tvTo);
+  return err;
+}
+#endif
+
 /*---------------------------------------------------------------------------*\
 |*               Worst implementation with just 1s resolution                *|
 \*---------------------------------------------------------------------------*/
@@ -270,5 +309,21 @@ int copydate(const char *pszToFile, const char *pszFromFile) { /* Copy the file
   return err;                       /* Success */
 }
 
+#if defined(__unix__) || defined(__MACH__)
+/* There's no fd-based utime(). Copy the permissions, and let the caller
+   fall back to copydate() once the file is closed. */
+int fcopydate(int iToFd, int iFromFd) { /* Copy the open files dates */
+  struct stat stFrom = {0};
+  int err;
+  err = fstat(iFromFd, &stFrom);
+  if (err) return err;
+  /* Copy file permissions */
+  err = fchmod(iToFd, stFrom.st_mode);
+  if (err) return err;
+  errno = ENOSYS;
+  return -1;
+}
+#endif
+
 #endif /* !defined(_STRUCT_TIMEVAL) */
 
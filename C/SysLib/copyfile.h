@@ -8,6 +8,7 @@
 *                                                                             *
 *   History                                                                   *
 *    2020-11-05 JFL Created this file.                                        *
+*    2026-10-17 MAB Added fcopydate() for Unix.                               *
 *                                                                             *
 *          Copyright 2020 Hewlett Packard Enterprise Development LP          *
 * Licensed under the Apache 2.0 license - www.apache.org/licenses/LICENSE-2.0 *
@@ -19,5 +20,8 @@
 #include "SysLib.h"		/* SysLib Library core definitions */
 
 int copydate(const char *pszToFile, const char *pszFromFile); /* Copy the file dates */
+#if defined(__unix__) || defined(__MACH__)
+int fcopydate(int iToFd, int iFromFd); /* Copy the open files dates. -1 if failed */
+#endif
 
 #endif /* _COPYFILE_H_ */
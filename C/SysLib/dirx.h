@@ -10,6 +10,11 @@
 *   History:								      *
 *    2020-03-11 JFL Created this file.					      *
 *    2020-03-19 JFL Enforce that we only supports 64-bits file sizes.	      *
+*    2026-10-17 MAB Added fdopendirx(), dirxfd() and StatModeToDType().	      *
+*    2026-10-17 MAB Added the readdirplus() bulk directory reading API.	      *
+*    2026-10-17 MAB Added readdirplusf(), with a DXPFILTER entry filter.      *
+*    2026-10-17 MAB Added dirplustimer(), to time the system calls.	      *
+*    2026-10-17 MAB Added statdirplusf(), to stat entries in a second pass.   *
 *									      *
 *          Copyright 2020 Hewlett Packard Enterprise Development LP          *
 * Licensed under the Apache 2.0 license - www.apache.org/licenses/LICENSE-2.0 *
@@ -29,11 +34,16 @@ extern "C" {
 #define opendirx(pName) opendir(pName)
 #define readdirx(pDir) readdir(pDir)
 #define closedirx(pDir) closedir(pDir)
+#define fdopendirx(iDirFD) fdopendir(iDirFD)
+#define dirxfd(pDir) dirfd(pDir)
 
 #else				/* Define a set of wrapper functions that do */
 
 #include "SysLib.h"		/* SysLib Library core definitions */
 #include <dirent.h>		/* Unix directory access functions definitions */
+#include <sys/types.h>		/* mode_t */
+#include <time.h>		/* struct timespec */
+#include "fnmatchx.h"		/* FNMSET name patterns sets */
 
 /* Detect unsupported cases */
 #if defined(_FILE_OFFSET_BITS)
@@ -49,8 +59,88 @@ extern "C" {
 #endif
 
 DIR *opendirx(const char *pName);
+DIR *fdopendirx(int iDirFD);		/* Takes ownership of iDirFD */
 struct dirent *readdirx(DIR *pDir);	/* Some Unix FS set d_type = UNKNOWN */
 int closedirx(DIR *);
+int dirxfd(DIR *pDir);			/* The file descriptor of the open directory */
+unsigned char StatModeToDType(mode_t mode); /* Convert a st_mode to a d_type */
+
+/* Bulk directory reading, returning arrays of entries with optional stat data */
+
+/* readdirplus() field selection flags. Also used to flag the valid fields */
+#define DXP_TYPE	0x0001	/* Make sure d_type is set, even if the FS does not report it */
+#define DXP_MODE	0x0002	/* dx_mode */
+#define DXP_NLINK	0x0004	/* dx_nlink */
+#define DXP_UID		0x0008	/* dx_uid */
+#define DXP_GID		0x0010	/* dx_gid */
+#define DXP_SIZE	0x0020	/* dx_size */
+#define DXP_BLOCKS	0x0040	/* dx_blocks */
+#define DXP_ATIME	0x0080	/* dx_atime */
+#define DXP_MTIME	0x0100	/* dx_mtime */
+#define DXP_CTIME	0x0200	/* dx_ctime */
+#define DXP_DEV		0x0400	/* dx_dev */
+#define DXP_STAT	0x07FF	/* All of the above */
+#define DXP_FOLLOW	0x10000	/* Get the stat data for the link targets */
+
+typedef struct direntplus {	/* Directory entry with selected stat fields */
+  const char *d_name;		/* Valid until the next readdirplus() call */
+  ino_t d_ino;
+  unsigned char d_type;
+  int dx_valid;			/* DXP_* flags for the valid fields below */
+  int dx_errno;			/* errno if the requested stat fields could not be read */
+  mode_t dx_mode;
+  nlink_t dx_nlink;
+  uid_t dx_uid;
+  gid_t dx_gid;
+  off_t dx_size;
+  blkcnt_t dx_blocks;
+  dev_t dx_dev;
+  struct timespec dx_atime;
+  struct timespec dx_mtime;
+  struct timespec dx_ctime;
+} direntplus;
+
+typedef struct _DIRPLUS DIRPLUS;
+
+DIRPLUS *opendirplus(const char *pName);
+DIRPLUS *fdopendirplus(int iDirFD);	/* Takes ownership of iDirFD */
+int readdirplus(DIRPLUS *pDir, direntplus *pEntries, int nEntries, int iFields); /* Returns the # of entries read, 0 at the end, or -1 */
+int closedirplus(DIRPLUS *pDir);
+int dirplusfd(DIRPLUS *pDir);		/* The file descriptor of the open directory */
+
+/* Optional timing of the system calls done by readdirplus() */
+#define DXP_OP_READ	0	/* Read a buffer of directory entries */
+#define DXP_OP_STAT	1	/* Get the stat data of one entry */
+
+typedef struct {
+  double (*pfnBegin)(int iOp);		/* Called before each system call. Returns its start time */
+  void (*pfnEnd)(int iOp, double t0);	/* Called after it, with that start time */
+} DXPTIMER;
+
+void dirplustimer(DIRPLUS *pDir, const DXPTIMER *pTimer); /* Time the system calls. NULL=Don't */
+
+/* readdirplusf() entry filter. Must be cleared before use.
+   Each test is done as soon as the data it needs is available: The names and
+   the types before any stat, then the sizes and times after a stat of these
+   fields only. Rejected entries are never stat'ed for the other fields. */
+typedef struct {
+  FNMSET *pNames;		/* Select names matching one of these patterns. NULL=All */
+  unsigned uTypes;		/* Select these DXT_MASK(d_type) types. 0=All */
+  int iFlags;			/* DXF_* flags enabling the windows below */
+  off_t llMinSize;		/* Select sizes in [llMinSize, llMaxSize] */
+  off_t llMaxSize;
+  time_t tMinMtime;		/* Select mtimes in [tMinMtime, tMaxMtime] */
+  time_t tMaxMtime;
+} DXPFILTER;
+
+#define DXT_MASK(type) (1U << (type))	/* Bit for a d_type in DXPFILTER.uTypes */
+#define DXF_SIZE	0x0001	/* Enable the size window */
+#define DXF_MTIME	0x0002	/* Enable the mtime window */
+
+int readdirplusf(DIRPLUS *pDir, direntplus *pEntries, int nEntries, int iFields, DXPFILTER *pFilter); /* Same, with only the entries selected by pFilter */
+/* Get more stat fields for some of the entries returned by the last readdirplus() call.
+   Returns the # of entries kept at the beginning of pEntries, those selected by pFilter */
+int statdirplusf(DIRPLUS *pDir, direntplus *pEntries, int nEntries, int iFields, DXPFILTER *pFilter);
 
 #endif /* not defined(_MSVCLIBX_H_) */
 
@@ -0,0 +1,326 @@
+/*****************************************************************************\
+*                                                                             *
+*   File name	    fnmatchx.c						      *
+*                                                                             *
+*   Description	    Precompiled fnmatch() patterns, and sets of patterns      *
+*                                                                             *
+*   Notes	    See fnmatchx.h for the pattern kinds.		      *
+*		    							      *
+*		    Only the FNM_CASEFOLD and FNM_NOESCAPE flags are handled  *
+*		    by the fast paths. Patterns with other flags are always   *
+*		    matched by fnmatch().				      *
+*		    							      *
+*		    Case-independent comparisons only fold ASCII letters.     *
+*		    The literal parts of such patterns must be ASCII, and if  *
+*		    the name has non-ASCII bytes where it's compared, then    *
+*		    fnmatch() gets the final word, as it may fold them	      *
+*		    differently depending on the locale. (Ex: The Kelvin sign *
+*		    matches k in UTF-8 locales.) As the pattern bytes are     *
+*		    ASCII, a matching name is never shorter than the pattern. *
+*                                                                             *
+*   History                                                                   *
+*    2026-10-17 MAB Created this file.					      *
+*                                                                             *
+\*****************************************************************************/
+
+#define _CRT_SECURE_NO_WARNINGS	/* Prevent MSVC warnings about unsecure C library functions */
+#define _GNU_SOURCE		/* For FNM_CASEFOLD */
+
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+
+#include "fnmatchx.h"	/* Public definitions for this module */
+
+#ifndef TRUE
+#define TRUE 1
+#define FALSE 0
+#endif
+
+#define FNM_FAST_FLAGS (FNM_CASEFOLD | FNM_NOESCAPE)
+
+#define SET_BIT(bitmap, c) ((bitmap)[(unsigned char)(c) >> 3] |= (unsigned char)(1 << ((c) & 7)))
+#define GET_BIT(bitmap, c) ((bitmap)[(unsigned char)(c) >> 3] & (1 << ((c) & 7)))
+
+/* Compare a part of a name with a literal. Returns 1=Equal, 0=Different, -1=Undecided */
+static int FnmEqual(const char *pszName, const char *pszLit, size_t l, int iFold) {
+  size_t i;
+  if (!iFold) return !memcmp(pszName, pszLit, l);
+  for (i = 0; i < l; i++) {
+    unsigned char c = (unsigned char)pszName[i];
+    if (c & 0x80) return -1;	/* Let fnmatch() fold non-ASCII characters */
+    if ((char)tolower(c) != pszLit[i]) return 0; /* The literal is already in lower case */
+  }
+  return 1;
+}
+
+/* Search a literal in a name. Returns 1=Found, 0=Not found, -1=Undecided */
+static int FnmSearch(const char *pszName, size_t lName, const char *pszLit, size_t l, int iFold) {
+  size_t i;
+  int iRet = 0;
+  if (!iFold) {
+    const char *pc = pszName;
+    const char *pcLast = pszName + lName - l;
+    if (l > lName) return 0;
+    if (!l) return 1;
+    /* Use memchr() to skip quickly to the candidate positions */
+    while ((pc <= pcLast) && ((pc = memchr(pc, pszLit[0], (size_t)(pcLast - pc) + 1)) != NULL)) {
+      if (!memcmp(pc, pszLit, l)) return 1;
+      pc += 1;
+    }
+    return 0;
+  }
+  if (l > lName) return 0;
+  for (i = 0; i + l <= lName; i++) {
+    int iEqual = FnmEqual(pszName + i, pszLit, l, iFold);
+    if (iEqual > 0) return 1;
+    if (iEqual < 0) iRet = -1;	/* Keep searching, maybe there's an ASCII match */
+  }
+  return iRet;
+}
+
+/* Duplicate a literal part of the pattern, in lower case if needed.
+   Returns NULL if it can't be handled by the fast paths */
+static char *FnmLiteral(const char *pszBegin, size_t l, int iFlags, int *piOK) {
+  char *pszLit;
+  size_t i;
+  *piOK = FALSE;
+  for (i = 0; i < l; i++) {
+    unsigned char c = (unsigned char)pszBegin[i];
+    if ((c == '*') || (c == '?') || (c == '[')) return NULL;
+    if ((c == '\\') && !(iFlags & FNM_NOESCAPE)) return NULL;
+    if ((c & 0x80) && (iFlags & FNM_CASEFOLD)) return NULL;
+  }
+  *piOK = TRUE;
+  pszLit = malloc(l + 1);
+  if (!pszLit) return NULL;
+  for (i = 0; i < l; i++) {
+    char c = pszBegin[i];
+    pszLit[i] = (iFlags & FNM_CASEFOLD) ? (char)tolower((unsigned char)c) : c;
+  }
+  pszLit[l] = '\0';
+  return pszLit;
+}
+
+/*---------------------------------------------------------------------------*\
+*                                                                             *
+|   Function	    FnmCompile						      |
+|									      |
+|   Description     Analyze a pattern, and prepare the fastest way to match it|
+|									      |
+|   Parameters      FNMPATTERN *pPat		The compiled pattern	      |
+|		    const char *pszPattern	The wildcards pattern	      |
+|		    int iFlags			fnmatch() flags		      |
+|		    							      |
+|   Returns	    0=Success, -1=Out of memory				      |
+|		    							      |
+|   History								      |
+|    2026-10-17 MAB Created this routine				      |
+*									      *
+\*---------------------------------------------------------------------------*/
+
+int FnmCompile(FNMPATTERN *pPat, const char *pszPattern, int iFlags) {
+  size_t l = strlen(pszPattern);
+  const char *pStar1;
+  const char *pStar2;
+  int iOK1 = TRUE, iOK2 = TRUE;
+
+  memset(pPat, 0, sizeof(FNMPATTERN));
+  pPat->iFlags = iFlags;
+  pPat->iKind = FNMK_GLOB;
+  pPat->pszPattern = malloc(l + 1);
+  if (!pPat->pszPattern) return -1;
+  memcpy(pPat->pszPattern, pszPattern, l + 1);
+
+  if (iFlags & ~FNM_FAST_FLAGS) return 0; /* Let fnmatch() handle the other flags */
+#if defined(_MSDOS) || defined(_WIN32)
+  /* In DOS/Windows, "*.*" matches any name, and "name." means without extension */
+  if (!strcmp(pszPattern, "*.*")) {
+    pszPattern = "*";
+    l = 1;
+  }
+  if (l && (pszPattern[l-1] == '.')) return 0;
+#endif
+
+  pStar1 = strchr(pszPattern, '*');
+  pStar2 = pStar1 ? strchr(pStar1 + 1, '*') : NULL;
+  if (!pStar1) {					/* "literal" */
+    pPat->lHead = l;
+    pPat->pszHead = FnmLiteral(pszPattern, l, iFlags, &iOK1);
+    if (iOK1) pPat->iKind = FNMK_LITERAL;
+  } else if (!pStar2) {					/* "prefix*suffix" */
+    pPat->lHead = (size_t)(pStar1 - pszPattern);
+    pPat->lTail = l - pPat->lHead - 1;
+    pPat->pszHead = FnmLiteral(pszPattern, pPat->lHead, iFlags, &iOK1);
+    if (iOK1 && pPat->pszHead) pPat->pszTail = FnmLiteral(pStar1 + 1, pPat->lTail, iFlags, &iOK2);
+    if (iOK1 && iOK2) pPat->iKind = (pPat->lHead || pPat->lTail) ? FNMK_AFFIX : FNMK_ALL;
+  } else if ((pStar1 == pszPattern) && (pStar2 == (pszPattern + l - 1))) { /* "*infix*" */
+    pPat->lHead = l - 2;
+    pPat->pszHead = FnmLiteral(pszPattern + 1, pPat->lHead, iFlags, &iOK1);
+    if (iOK1) pPat->iKind = pPat->lHead ? FNMK_INFIX : FNMK_ALL;
+  }
+  if (pPat->iKind == FNMK_GLOB) return 0;
+  if ((!pPat->pszHead) || ((pPat->iKind == FNMK_AFFIX) && !pPat->pszTail)) {
+    FnmFree(pPat);
+    return -1; /* Out of memory */
+  }
+  return 0;
+}
+
+/*---------------------------------------------------------------------------*\
+*                                                                             *
+|   Function	    FnmMatch						      |
+|									      |
+|   Description     Check if a name matches a compiled pattern		      |
+|									      |
+|   Parameters      FNMPATTERN *pPat		The compiled pattern	      |
+|		    const char *pszName		The name to test	      |
+|		    							      |
+|   Returns	    FNM_MATCH or FNM_NOMATCH, like fnmatch()		      |
+|		    							      |
+|   History								      |
+|    2026-10-17 MAB Created this routine				      |
+*									      *
+\*---------------------------------------------------------------------------*/
+
+static int FnmMatch1(FNMPATTERN *pPat, const char *pszName, size_t lName) {
+  int iFold = pPat->iFlags & FNM_CASEFOLD;
+  int iEqual = 1;
+
+  switch (pPat->iKind) {
+    case FNMK_ALL:
+      return FNM_MATCH;
+    case FNMK_LITERAL:
+      if (lName < pPat->lHead) return FNM_NOMATCH;
+      if (lName > pPat->lHead) { /* Only non-ASCII characters folded to ASCII can match */
+	size_t i;
+	if (!iFold) return FNM_NOMATCH;
+	for (iEqual = 0, i = 0; i < lName; i++) if (pszName[i] & 0x80) iEqual = -1;
+	break;
+      }
+      iEqual = FnmEqual(pszName, pPat->pszHead, lName, iFold);
+      break;
+    case FNMK_AFFIX:
+      if (lName < (pPat->lHead + pPat->lTail)) return FNM_NOMATCH;
+      if (pPat->lTail) {	/* Test the suffix first, as it's usually the most selective */
+	iEqual = FnmEqual(pszName + lName - pPat->lTail, pPat->pszTail, pPat->lTail, iFold);
+	if (!iEqual) return FNM_NOMATCH;
+      }
+      if (pPat->lHead) {
+	int iEqual2 = FnmEqual(pszName, pPat->pszHead, pPat->lHead, iFold);
+	if (!iEqual2) return FNM_NOMATCH;
+	if (iEqual2 < 0) iEqual = -1;
+      }
+      break;
+    case FNMK_INFIX:
+      iEqual = FnmSearch(pszName, lName, pPat->pszHead, pPat->lHead, iFold);
+      break;
+    default:
+      iEqual = -1;
+      break;
+  }
+  if (iEqual < 0) return fnmatch(pPat->pszPattern, pszName, pPat->iFlags) ? FNM_NOMATCH : FNM_MATCH;
+  return iEqual ? FNM_MATCH : FNM_NOMATCH;
+}
+
+int FnmMatch(FNMPATTERN *pPat, const char *pszName) {
+  return FnmMatch1(pPat, pszName, strlen(pszName));
+}
+
+/* Free the pattern copies */
+void FnmFree(FNMPATTERN *pPat) {
+  free(pPat->pszPattern);
+  free(pPat->pszHead);
+  free(pPat->pszTail);
+  memset(pPat, 0, sizeof(FNMPATTERN));
+}
+
+/*---------------------------------------------------------------------------*\
+*                                                                             *
+|   Function	    FnmSetAdd						      |
+|									      |
+|   Description     Compile a pattern, and add it to a set		      |
+|									      |
+|   Parameters      FNMSET *pSet		The set of patterns	      |
+|		    const char *pszPattern	The wildcards pattern	      |
+|		    int iFlags			fnmatch() flags		      |
+|		    							      |
+|   Returns	    0=Success, -1=Out of memory				      |
+|		    							      |
+|   Notes	    Literal and affix patterns that begin with a literal      |
+|		    register their first byte in the abFirst bitmap. Those    |
+|		    that only have a suffix register their last byte in the   |
+|		    abLast bitmap. Any other pattern sets bSlow, which	      |
+|		    disables that prefilter.				      |
+|		    							      |
+|   History								      |
+|    2026-10-17 MAB Created this routine				      |
+*									      *
+\*---------------------------------------------------------------------------*/
+
+int FnmSetAdd(FNMSET *pSet, const char *pszPattern, int iFlags) {
+  FNMPATTERN *pPat;
+  FNMPATTERN *pNew = realloc(pSet->pPatterns, (pSet->nPatterns + 1) * sizeof(FNMPATTERN));
+  if (!pNew) return -1;
+  pSet->pPatterns = pNew;
+  pPat = pNew + pSet->nPatterns;
+  if (FnmCompile(pPat, pszPattern, iFlags)) return -1;
+  pSet->nPatterns += 1;
+
+  if (((pPat->iKind == FNMK_LITERAL) && pPat->lHead) || ((pPat->iKind == FNMK_AFFIX) && pPat->lHead)) {
+    char c = pPat->pszHead[0];
+    SET_BIT(pSet->abFirst, c);
+    if (iFlags & FNM_CASEFOLD) SET_BIT(pSet->abFirst, toupper((unsigned char)c));
+  } else if (pPat->iKind == FNMK_AFFIX) {
+    char c = pPat->pszTail[pPat->lTail - 1];
+    SET_BIT(pSet->abLast, c);
+    if (iFlags & FNM_CASEFOLD) SET_BIT(pSet->abLast, toupper((unsigned char)c));
+  } else {
+    pSet->bSlow = TRUE;
+  }
+  return 0;
+}
+
+/*---------------------------------------------------------------------------*\
+*                                                                             *
+|   Function	    FnmSetMatch						      |
+|									      |
+|   Description     Check if a name matches any pattern in a set	      |
+|									      |
+|   Parameters      FNMSET *pSet		The set of patterns	      |
+|		    const char *pszName		The name to test	      |
+|		    							      |
+|   Returns	    FNM_MATCH or FNM_NOMATCH, like fnmatch()		      |
+|		    							      |
+|   History								      |
+|    2026-10-17 MAB Created this routine				      |
+*									      *
+\*---------------------------------------------------------------------------*/
+
+int FnmSetMatch(FNMSET *pSet, const char *pszName) {
+  size_t lName = strlen(pszName);
+  int i;
+
+  if (!pSet->nPatterns) return FNM_NOMATCH;
+  if (!pSet->bSlow) { /* Reject quickly names that can't match any pattern */
+    unsigned char c0 = (unsigned char)pszName[0];
+    unsigned char cN = lName ? (unsigned char)pszName[lName-1] : 0;
+    /* Non-ASCII bytes may be case-folded by fnmatch(), so don't prefilter them */
+    if (   !GET_BIT(pSet->abFirst, c0) && !GET_BIT(pSet->abLast, cN)
+        && !(c0 & 0x80) && !(cN & 0x80)) {
+      return FNM_NOMATCH;
+    }
+  }
+  for (i = 0; i < pSet->nPatterns; i++) {
+    if (FnmMatch1(pSet->pPatterns + i, pszName, lName) == FNM_MATCH) return FNM_MATCH;
+  }
+  return FNM_NOMATCH;
+}
+
+/* Free all patterns, and empty the set */
+void FnmSetFree(FNMSET *pSet) {
+  int i;
+  for (i = 0; i < pSet->nPatterns; i++) FnmFree(pSet->pPatterns + i);
+  free(pSet->pPatterns);
+  memset(pSet, 0, sizeof(FNMSET));
+}
@@ -0,0 +1,86 @@
+/*****************************************************************************\
+*                                                                             *
+*   Filename:	    fnmatchx.h						      *
+*									      *
+*   Description:    Precompiled fnmatch() patterns, and sets of patterns      *
+*                                                                             *
+*   Notes:	    Calling fnmatch() for every directory entry parses the    *
+*		    pattern again every time. Instead, FnmCompile() analyzes  *
+*		    the pattern once, and classifies it:		      *
+*		    - All:	"*" matches anything.			      *
+*		    - Literal:	"Makefile" is just a string comparison.	      *
+*		    - Affix:	"*.bak", "README*", "#*#" are a prefix and/or a   *
+*				suffix comparison around a single *.	      *
+*		    - Infix:	"*test*" is a substring search.		      *
+*		    - Glob:	Anything else is matched by fnmatch().	      *
+*		    FnmMatch() then uses the fastest method for that kind.    *
+*		    The results are the same as fnmatch()'s, including the    *
+*		    DOS/Windows special cases for "*.*" and "name.".	      *
+*		    							      *
+*		    A FNMSET tests a name against several patterns in one     *
+*		    pass. It records which first and last bytes can match its *
+*		    literal and affix patterns, so that most names that don't *
+*		    match are rejected after looking at two bytes.	      *
+*		    A FNMSET structure cleared with zeros is a valid empty    *
+*		    set, that matches nothing.				      *
+*		    							      *
+*   History:								      *
+*    2026-10-17 MAB Created this file.					      *
+*									      *
+* Licensed under the Apache 2.0 license - www.apache.org/licenses/LICENSE-2.0 *
+\*****************************************************************************/
+
+#ifndef _SYSLIB_FNMATCHX_H_
+#define _SYSLIB_FNMATCHX_H_
+
+#include "SysLib.h"		/* SysLib Library core definitions */
+
+#include <stddef.h>		/* For size_t */
+#include <fnmatch.h>		/* For the FNM_xxx flags and results */
+
+#ifndef FNM_MATCH		/* Not defined in Unix */
+#define FNM_MATCH 0
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+/* Pattern kinds, from the fastest to the slowest to match */
+#define FNMK_ALL	0	/* Matches any name. Ex: "*" */
+#define FNMK_LITERAL	1	/* No wildcards. Ex: "Makefile" */
+#define FNMK_AFFIX	2	/* A prefix and/or a suffix around one *. Ex: "*.c" */
+#define FNMK_INFIX	3	/* A string between two *. Ex: "*test*" */
+#define FNMK_GLOB	4	/* Anything else, matched by fnmatch() */
+
+typedef struct {		/* A compiled pattern */
+  int iKind;			/* One of the FNMK_xxx kinds above */
+  int iFlags;			/* fnmatch() flags */
+  char *pszPattern;		/* Copy of the pattern, for fnmatch() */
+  char *pszHead;		/* Literal, prefix, or infix string */
+  size_t lHead;
+  char *pszTail;		/* Suffix string */
+  size_t lTail;
+} FNMPATTERN;
+
+typedef struct {		/* A set of compiled patterns. Clear it before use */
+  FNMPATTERN *pPatterns;
+  int nPatterns;
+  int bSlow;			/* TRUE if some patterns can't be prefiltered */
+  unsigned char abFirst[32];	/* Bitmap of possible first bytes of matching names */
+  unsigned char abLast[32];	/* Bitmap of possible last bytes of matching names */
+} FNMSET;
+
+int FnmCompile(FNMPATTERN *pPat, const char *pszPattern, int iFlags);	/* 0=Success, -1=Out of memory */
+int FnmMatch(FNMPATTERN *pPat, const char *pszName);		/* Returns FNM_MATCH or FNM_NOMATCH */
+void FnmFree(FNMPATTERN *pPat);					/* Free the pattern copies */
+
+int FnmSetAdd(FNMSET *pSet, const char *pszPattern, int iFlags);	/* 0=Success, -1=Out of memory */
+int FnmSetMatch(FNMSET *pSet, const char *pszName);		/* FNM_MATCH if any pattern matches */
+void FnmSetFree(FNMSET *pSet);					/* Free all patterns, and empty the set */
+
+#ifdef __cplusplus
+}
+#endif /* defined(__cplusplus) */
+
+#endif /* _SYSLIB_FNMATCHX_H_ */
@@ -0,0 +1,131 @@
+/*****************************************************************************\
+*                                                                             *
+*   File name	    murmur3.c						      *
+*                                                                             *
+*   Description	    Incremental MurmurHash3 x64 128-bit digest		      *
+*                                                                             *
+*   Notes	    See murmur3.h for the usage rules.			      *
+*		    							      *
+*		    MurmurHash3 mixes 16-byte blocks, then the last partial   *
+*		    block, then the total length. DigestUpdate() keeps the    *
+*		    bytes of an incomplete block in a carry buffer, until     *
+*		    the next call completes it, or DigestFinal() mixes it as  *
+*		    the last partial block.				      *
+*                                                                             *
+*   History                                                                   *
+*    2026-10-17 MAB Created this file, from the code in dirc.c. Accept        *
+*		    pieces of any length, using a carry buffer.		      *
+*                                                                             *
+\*****************************************************************************/
+
+#define _CRT_SECURE_NO_WARNINGS	/* Prevent MSVC warnings about unsecure C library functions */
+
+#include <string.h>
+
+#include "murmur3.h"	/* Public definitions for this module */
+
+#define C1 0x87C37B91114253D5ULL
+#define C2 0x4CF5AD432745937FULL
+
+static uint64_t rotl64(uint64_t x, int r) {
+  return (x << r) | (x >> (64 - r));
+}
+
+static uint64_t fmix64(uint64_t k) {
+  k ^= k >> 33;
+  k *= 0xFF51AFD7ED558CCDULL;
+  k ^= k >> 33;
+  k *= 0xC4CEB9FE1A85EC53ULL;
+  k ^= k >> 33;
+  return k;
+}
+
+/* Mix whole 16-byte blocks */
+static void DigestBlocks(digestState *pDS, const unsigned char *pData, size_t nBlocks) {
+  uint64_t h1 = pDS->h1;
+  uint64_t h2 = pDS->h2;
+  uint64_t k1, k2;
+
+  for ( ; nBlocks--; pData += 16) {
+    memcpy(&k1, pData, 8);
+    memcpy(&k2, pData + 8, 8);
+    k1 *= C1; k1 = rotl64(k1, 31); k1 *= C2; h1 ^= k1;
+    h1 = rotl64(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52DCE729;
+    k2 *= C2; k2 = rotl64(k2, 33); k2 *= C1; h2 ^= k2;
+    h2 = rotl64(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495AB5;
+  }
+
+  pDS->h1 = h1;
+  pDS->h2 = h2;
+}
+
+void DigestInit(digestState *pDS) {
+  pDS->h1 = pDS->h2 = pDS->length = 0;
+  pDS->nTail = 0;
+}
+
+void DigestUpdate(digestState *pDS, const void *pData, size_t nBytes) {
+  const unsigned char *pBytes = (const unsigned char *)pData;
+
+  pDS->length += nBytes;
+  if (pDS->nTail) { /* First complete the block carried over from the previous call */
+    size_t n = 16 - pDS->nTail;
+    if (n > nBytes) n = nBytes;
+    memcpy(pDS->tail + pDS->nTail, pBytes, n);
+    pDS->nTail += n;
+    pBytes += n;
+    nBytes -= n;
+    if (pDS->nTail < 16) return;
+    DigestBlocks(pDS, pDS->tail, 1);
+    pDS->nTail = 0;
+  }
+  DigestBlocks(pDS, pBytes, nBytes / 16);
+  pDS->nTail = nBytes & 15;	/* Carry the rest over to the next call */
+  memcpy(pDS->tail, pBytes + nBytes - pDS->nTail, pDS->nTail);
+}
+
+void DigestString(digestState *pDS, const char *pszString) {
+  uint64_t l = (uint64_t)strlen(pszString);
+  DigestUpdate(pDS, &l, sizeof(l));
+  DigestUpdate(pDS, pszString, (size_t)l);
+}
+
+void DigestFinal(digestState *pDS, uint64_t *pDigest) {
+  const unsigned char *pTail = pDS->tail;
+  uint64_t h1 = pDS->h1;
+  uint64_t h2 = pDS->h2;
+  uint64_t k1 = 0;
+  uint64_t k2 = 0;
+
+  switch (pDS->nTail) { /* Mix the last partial block */
+    case 15: k2 ^= ((uint64_t)pTail[14]) << 48; /* Fall through */
+    case 14: k2 ^= ((uint64_t)pTail[13]) << 40; /* Fall through */
+    case 13: k2 ^= ((uint64_t)pTail[12]) << 32; /* Fall through */
+    case 12: k2 ^= ((uint64_t)pTail[11]) << 24; /* Fall through */
+    case 11: k2 ^= ((uint64_t)pTail[10]) << 16; /* Fall through */
+    case 10: k2 ^= ((uint64_t)pTail[ 9]) << 8;  /* Fall through */
+    case  9: k2 ^= ((uint64_t)pTail[ 8]);
+	     k2 *= C2; k2 = rotl64(k2, 33); k2 *= C1; h2 ^= k2;
+	     /* Fall through */
+    case  8: k1 ^= ((uint64_t)pTail[ 7]) << 56; /* Fall through */
+    case  7: k1 ^= ((uint64_t)pTail[ 6]) << 48; /* Fall through */
+    case  6: k1 ^= ((uint64_t)pTail[ 5]) << 40; /* Fall through */
+    case  5: k1 ^= ((uint64_t)pTail[ 4]) << 32; /* Fall through */
+    case  4: k1 ^= ((uint64_t)pTail[ 3]) << 24; /* Fall through */
+    case  3: k1 ^= ((uint64_t)pTail[ 2]) << 16; /* Fall through */
+    case  2: k1 ^= ((uint64_t)pTail[ 1]) << 8;  /* Fall through */
+    case  1: k1 ^= ((uint64_t)pTail[ 0]);
+	     k1 *= C1; k1 = rotl64(k1, 31); k1 *= C2; h1 ^= k1;
+  }
+
+  h1 ^= pDS->length;
+  h2 ^= pDS->length;
+  h1 += h2;
+  h2 += h1;
+  h1 = fmix64(h1);
+  h2 = fmix64(h2);
+  h1 += h2;
+  h2 += h1;
+  pDigest[0] = h1;
+  pDigest[1] = h2;
+}
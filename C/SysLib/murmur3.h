@@ -0,0 +1,53 @@
+/*****************************************************************************\
+*                                                                             *
+*   Filename:	    murmur3.h						      *
+*									      *
+*   Description:    Incremental MurmurHash3 x64 128-bit digest		      *
+*                                                                             *
+*   Notes:	    Digest a stream of bytes passed in pieces of any length.  *
+*		    The result is the same as MurmurHash3_x64_128() with a    *
+*		    seed of 0, over all the bytes concatenated.		      *
+*		    							      *
+*		    This is not a cryptographic hash. It detects accidental   *
+*		    changes, not deliberate collisions.			      *
+*		    							      *
+*		    When digesting a structure made of several variable-      *
+*		    length fields, use DigestString() for strings, so that    *
+*		    the field boundaries are part of the digest.	      *
+*		    							      *
+*   History:								      *
+*    2026-10-17 MAB Created this file, from the code in dirc.c.               *
+*									      *
+* Licensed under the Apache 2.0 license - www.apache.org/licenses/LICENSE-2.0 *
+\*****************************************************************************/
+
+#ifndef _SYSLIB_MURMUR3_H_
+#define _SYSLIB_MURMUR3_H_
+
+#include "SysLib.h"		/* SysLib Library core definitions */
+
+#include <stddef.h>		/* For size_t */
+#include <inttypes.h>		/* Actually we just need stdint.h, but Tru64 doesn't have it */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+typedef struct _digestState {	/* A digest being computed */
+  uint64_t h1;
+  uint64_t h2;
+  uint64_t length;		/* Total number of bytes digested */
+  unsigned char tail[16];	/* The bytes not yet digested, if not a whole block */
+  size_t nTail;
+} digestState;
+
+void DigestInit(digestState *pDS);				/* Start a new digest */
+void DigestUpdate(digestState *pDS, const void *pData, size_t nBytes); /* Digest more bytes */
+void DigestString(digestState *pDS, const char *pszString);	/* Digest a string, with its length */
+void DigestFinal(digestState *pDS, uint64_t *pDigest);		/* Get the 128-bit result */
+
+#ifdef __cplusplus
+}
+#endif /* defined(__cplusplus) */
+
+#endif /* _SYSLIB_MURMUR3_H_ */
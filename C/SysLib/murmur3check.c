@@ -0,0 +1,140 @@
+/*****************************************************************************\
+*                                                                             *
+*   Filename:	    murmur3check.c					      *
+*									      *
+*   Description:    Check that the incremental MurmurHash3 digest does not    *
+*		    depend on how the data is split.			      *
+*                                                                             *
+*   Notes:	    Run by `make check`. Digests a buffer in a single call,   *
+*		    then in pieces of various lengths, and compares the       *
+*		    results with each other, and with a one-shot reference    *
+*		    implementation of MurmurHash3_x64_128.		      *
+*		    							      *
+*		    Exits with 0 if all tests pass, else with 1.	      *
+*		    							      *
+*   History:								      *
+*    2026-10-17 MAB Created this file.					      *
+*									      *
+\*****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "murmur3.h"
+
+#define BUFSIZE 1000
+
+/* The reference algorithm, digesting all the data at once */
+static uint64_t rotl64(uint64_t x, int r) {
+  return (x << r) | (x >> (64 - r));
+}
+
+static uint64_t fmix64(uint64_t k) {
+  k ^= k >> 33;
+  k *= 0xFF51AFD7ED558CCDULL;
+  k ^= k >> 33;
+  k *= 0xC4CEB9FE1A85EC53ULL;
+  k ^= k >> 33;
+  return k;
+}
+
+void MurmurHash3_x64_128(const unsigned char *pData, size_t nBytes, uint64_t *pDigest) {
+  const uint64_t c1 = 0x87C37B91114253D5ULL;
+  const uint64_t c2 = 0x4CF5AD432745937FULL;
+  uint64_t h1 = 0, h2 = 0, k1, k2;
+  const unsigned char *pTail;
+  size_t i;
+
+  for (i = 0; (i + 16) <= nBytes; i += 16) {
+    memcpy(&k1, pData + i, 8);
+    memcpy(&k2, pData + i + 8, 8);
+    k1 *= c1; k1 = rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+    h1 = rotl64(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52DCE729;
+    k2 *= c2; k2 = rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+    h2 = rotl64(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495AB5;
+  }
+  pTail = pData + i;
+  k1 = k2 = 0;
+  for (i = nBytes & 15; i > 8; i--) k2 ^= ((uint64_t)pTail[i-1]) << (8 * (i - 9));
+  if ((nBytes & 15) > 8) {
+    k2 *= c2; k2 = rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+  }
+  for (i = ((nBytes & 15) > 8) ? 8 : (nBytes & 15); i > 0; i--) k1 ^= ((uint64_t)pTail[i-1]) << (8 * (i - 1));
+  if (nBytes & 15) {
+    k1 *= c1; k1 = rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+  }
+  h1 ^= nBytes; h2 ^= nBytes;
+  h1 += h2; h2 += h1;
+  h1 = fmix64(h1); h2 = fmix64(h2);
+  h1 += h2; h2 += h1;
+  pDigest[0] = h1;
+  pDigest[1] = h2;
+}
+
+/* Digest nBytes of pData in pieces of lengths taken in turn from aLengths */
+void DigestPieces(const unsigned char *pData, size_t nBytes, const size_t *aLengths, int nLengths, uint64_t *pDigest) {
+  digestState ds;
+  size_t i = 0;
+  int j = 0;
+
+  DigestInit(&ds);
+  while (i < nBytes) {
+    size_t n = aLengths[j++ % nLengths];
+    if (n > (nBytes - i)) n = nBytes - i;
+    DigestUpdate(&ds, pData + i, n);
+    i += n;
+  }
+  DigestFinal(&ds, pDigest);
+}
+
+int main(int argc, char *argv[]) {
+  static const struct {	/* Piece lengths, used in turn. Empty pieces are allowed too */
+    int n;
+    size_t a[4];
+  } aSplits[] = {
+    {1, {BUFSIZE}}, {1, {1}}, {1, {7}}, {1, {15}}, {1, {16}}, {1, {17}},
+    {2, {31, 1}}, {4, {3, 0, 13, 32}}, {4, {5, 16, 11, 100}},
+  };
+  static const char szFox[] = "The quick brown fox jumps over the lazy dog";
+  unsigned char buf[BUFSIZE];
+  uint64_t ref[2], dig[2];
+  digestState ds;
+  size_t nBytes;
+  int nFail = 0;
+  int nTests = 0;
+  int i;
+  (void)argc; (void)argv;
+
+  srand(1);
+  for (i = 0; i < BUFSIZE; i++) buf[i] = (unsigned char)rand();
+
+  /* A published test vector */
+  DigestInit(&ds);
+  DigestUpdate(&ds, szFox, 4);
+  DigestUpdate(&ds, szFox + 4, sizeof(szFox) - 5);
+  DigestFinal(&ds, dig);
+  nTests += 1;
+  if ((dig[0] != 0xE34BBC7BBC071B6CULL) || (dig[1] != 0x7A433CA9C49A9347ULL)) {
+    fprintf(stderr, "Wrong digest for \"%s\": %016llX %016llX\n", szFox,
+	    (unsigned long long)dig[0], (unsigned long long)dig[1]);
+    nFail += 1;
+  }
+
+  /* All data lengths around the block boundaries, and a long one */
+  for (nBytes = 0; nBytes <= BUFSIZE; nBytes = (nBytes < 50) ? nBytes + 1 : BUFSIZE + (nBytes == BUFSIZE)) {
+    MurmurHash3_x64_128(buf, nBytes, ref);
+    for (i = 0; i < (int)(sizeof(aSplits) / sizeof(aSplits[0])); i++) {
+      DigestPieces(buf, nBytes, aSplits[i].a, aSplits[i].n, dig);
+      nTests += 1;
+      if ((dig[0] != ref[0]) || (dig[1] != ref[1])) {
+	fprintf(stderr, "Digest of %d bytes in pieces of %d, %d, ... bytes differs from a single call\n",
+		(int)nBytes, (int)aSplits[i].a[0], (int)aSplits[i].a[1]);
+	nFail += 1;
+      }
+    }
+  }
+
+  printf("MurmurHash3 digests: %d tests, %s\n", nTests, nFail ? "FAILED" : "OK");
+  return nFail ? 1 : 0;
+}
@@ -8,6 +8,10 @@
 *		    							      *
 *   History:								      *
 *    2021-12-15 JFL Created this file.					      *
+*    2026-10-17 MAB Declare TrimDotParts(). WalkDirTree() now works in Unix.  *
+*		    Added WalkDirTreeMT(), and wdt_opts field nThread.	      *
+*		    Added the PATHBUF path builder.			      *
+*		    Added wdt_opts field pAncestors.			      *
 *									      *
 *          Copyright 2021 Hewlett Packard Enterprise Development LP          *
 * Licensed under the Apache 2.0 license - www.apache.org/licenses/LICENSE-2.0 *
@@ -20,6 +24,7 @@
 
 #include <dirent.h>
 #include <sys/types.h>
+#include <unistd.h>		/* For ssize_t */
 
 #ifdef __cplusplus
 extern "C" {
@@ -77,9 +82,36 @@ extern "C" {
 
 /********************** End of OS-specific definitions ***********************/
 
+void TrimDotParts(char *path);						/* Remove all useless ./ parts, in place */
 char *NewJoinedPath(const char *pszPart1, const char *pszPart2);	/* Join 2 paths, and return the new string */
 char *NewCompactJoinedPath(const char *pszPart1, const char *pszPart2);	/* Idem, removing all useless ./ parts */
 
+/* Path builder, for building pathnames in place while walking directory trees */
+typedef struct {
+  char *buf;			/* The current pathname. NULL until the first push */
+  size_t len;			/* Length of the current pathname */
+  size_t size;			/* Size of the buffer */
+#if defined(__unix__) || defined(__MACH__)
+  int fd;			/* fd of the current directory, or AT_FDCWD */
+#endif
+} PATHBUF;
+
+void PathBufInit(PATHBUF *pPB);				/* Initialize an empty path */
+void PathBufFree(PATHBUF *pPB);				/* Free the buffer and the fd */
+int PathBufSet(PATHBUF *pPB, const char *path);		/* Set the root path. 0=Success; -1=Out of memory */
+ssize_t PathBufPush(PATHBUF *pPB, const char *pszName);	/* Append a name. Returns the prev. length, or -1 */
+void PathBufPop(PATHBUF *pPB, size_t len);		/* Truncate back to the prev. length */
+
+#if defined(__unix__) || defined(__MACH__)
+typedef struct {		/* Path builder state saved by PathBufPushDir() */
+  size_t len;
+  int fd;
+} PATHBUFMARK;
+
+int PathBufPushDir(PATHBUF *pPB, const char *pszName, int iFlags, PATHBUFMARK *pMark); /* Append and open a subdir */
+void PathBufPopDir(PATHBUF *pPB, PATHBUFMARK *pMark);	/* Close it, and go back to the parent dir */
+#endif /* defined(__unix__) || defined(__MACH__) */
+
 /* WalkDirTree definitions */
 
 /* WalkDirTree option flags */
@@ -91,15 +123,21 @@ char *NewCompactJoinedPath(const char *pszPart1, const char *pszPart2);	/* Idem,
 
 typedef struct {		/* WalkDirTree options. Must be cleared before use. */
   int iFlags;			/* [IN] Options */
+  int nThread;			/* [IN] WalkDirTreeMT number of threads. 0=One per CPU */
   ino_t nDir;			/* [OUT] Number of directories scanned */
   ino_t nFile;			/* [OUT] Number of directory entries processed */
   int nErr;			/* [OUT] Number of errors */
   void *pOnce;			/* [RESERVED] Used internally to process WDT_ONCE */
+  void *pAncestors;		/* [RESERVED] Used internally to detect WDT_FOLLOW loops */
 } wdt_opts;
 
 typedef int (*pWalkDirTreeCB_t)(char *pszRelPath, struct dirent *pDE, void *pRef);
 
 extern int WalkDirTree(char *path, wdt_opts *pOpts, pWalkDirTreeCB_t pWalkDirTreeCB, void *pRef);
+#if defined(__unix__)
+/* Multi-threaded version. The callback must be thread-safe */
+extern int WalkDirTreeMT(char *path, wdt_opts *pOpts, pWalkDirTreeCB_t pWalkDirTreeCB, void *pRef);
+#endif /* defined(__unix__) */
 
 #ifdef __cplusplus
 }
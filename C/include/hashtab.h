@@ -0,0 +1,271 @@
+/*****************************************************************************	\
+*                                                                             *
+*   File name	    hashtab.h						      *
+*									      *
+*   Description	    A general purpose open-addressing hash table      	      *
+*									      *
+*   Notes:	    For use in C programs, in the absence of C++ templates.   *
+*		    Implemented as a set of macros, for generating types,     *
+*		    structures, and methods for handling an arbitrary table.  *
+*		    The user defines the table entry type, and two routines:  *
+*		    HASH_KEY(entry_t) computing the hash of an entry key,     *
+*		    and HASH_CMP(entry_t) returning 0 if two keys are equal.  *
+*		    A macro inserts table-specific fields in that entry       *
+*		    structure. These fields all have the hsh_ prefix.         *
+*		    							      *
+*		    Entries are stored by value in a single array, using      *
+*		    linear probing. Removals use backward shift deletion, so  *
+*		    there are no tombstones, and lookups stay short.          *
+*		    							      *
+*		    The table grows automatically to keep its load factor     *
+*		    under 3/4. So pointers to entries are only valid until    *
+*		    the next call to put_ENTRY_T() or remove_ENTRY_T().       *
+*		    							      *
+*		    Helper routines HashString() and HashBytes() compute      *
+*		    hashes for string keys, and for fixed-size binary keys.   *
+*		    							      *
+*		    Known issues:					      *
+*		    - The HASH_DEFINE_* macros will fail if the entry type    *
+*		      passed by the user has the same name as one of the      *
+*                     variables used internally by the macro.                 *
+*		    							      *
+*		    							      *
+*		    Usage:						      *
+* "public" macros:                                                            *
+*   HASH_ENTRY_FIELDS()        Called once in each entry structure definition.*
+*   HASH_TABLE_FIELDS(struct_entry_t) Called once in each table structure.    *
+*   HASH_DEFINE_TYPES(table_t, entry_t) Called once for each type of table,   *
+*                              in all files.                                  *
+*   HASH_DEFINE_PROCS(table_t, entry_t) Called once for each type of table,   *
+*                              in ONE file.                                   *
+*                                                                             *
+* public functions: (With ENTRY_T changed to the entry type name)             *
+*   new_ENTRY_T_hash()		  Create a new empty table.                   *
+*   free_ENTRY_T_hash(table)	  Free the table. (But not what entries use.) *
+*   get_ENTRY_T(table, entry)	  Search an entry with the same key.          *
+*   put_ENTRY_T(table, entry, &bAdded) Copy the entry into the table, unless  *
+*				  one with the same key exists. Returns the   *
+*				  entry in the table, or NULL if no memory.   *
+*   remove_ENTRY_T(table, entry)  Remove the entry with the same key.         *
+*   foreach_ENTRY_T(table, func, ref) Call func(entry, ref) for each entry.   *
+*   The foreach routine breaks out immediately if func() returns non NULL.    *
+*   num_ENTRY_T(table)	  	  Get the total number of entries.            *
+*                                                                             *
+* Example:                                                                    *
+*   #include "hashtab.h"                                                      *
+*   typedef struct _entry {                                                   *
+*     HASH_ENTRY_FIELDS(); // The table-specific fields.                      *
+*     char *key; // Any number of fields. For example this will be a key,     *
+*     int data;  // and this will be an integer data field.                   *
+*   } entry;                                                                  *
+*   typedef struct _table {                                                   *
+*     HASH_TABLE_FIELDS(struct _entry); // The table-specific fields.	      *
+*     // Optional global property fields				      *
+*   } table;                                                                  *
+*   HASH_DEFINE_TYPES(table, entry);                                          *
+*   HASH_DEFINE_PROCS(table, entry);                                          *
+*   size_t HASH_KEY(entry)(entry *e) {return HashString(e->key);}             *
+*   int HASH_CMP(entry)(entry *e1, entry *e2) {return strcmp(e1->key, e2->key);}
+*   main() {                                                                  *
+*     table *t = new_entry_hash();					      *
+*     entry e = {0};                                                          *
+*     int bAdded;                                                             *
+*     e.key = "one"; e.data = 1;                                              *
+*     put_entry(t, &e, &bAdded);                                              *
+*     ...                                                                     *
+*   }                                                                         *
+*		    							      *
+*   History:								      *
+*    2026-10-17 MAB Created this module. 				      *
+*                                                                             *
+*          Copyright 2026 Hewlett Packard Enterprise Development LP          *
+* Licensed under the Apache 2.0 license - www.apache.org/licenses/LICENSE-2.0 *
+\*****************************************************************************/
+
+#ifndef _hashtab_h_
+#define _hashtab_h_
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_MSC_VER) && (_MSC_VER <= 0x800) && (!defined(inline))
+  #define inline __inline
+#endif
+
+/* The table-specific fields to add to a table entry */
+#define HASH_ENTRY_FIELDS()							\
+  size_t	hsh_hash	/* The key hash. 0 = Empty slot */		\
+
+/* The table-specific fields to add to a table object */
+#define HASH_TABLE_FIELDS(struct_entry_t)					\
+  struct_entry_t *hsh_slots;							\
+  size_t	 hsh_size;	/* Number of slots. 0 or a power of 2 */	\
+  size_t	 hsh_length	/* Number of entries used */			\
+
+/* The user-provided key hashing and comparison routine names */
+#define HASH_KEY(entry_t) HASH_KEY_##entry_t##s
+#define HASH_CMP(entry_t) HASH_COMPARE_##entry_t##s
+
+#define HASH_MIN_SIZE 16
+
+/* Finalize a hash, so that all bits depend on all input bits (MurmurHash3 fmix64) */
+static inline size_t HashMix(unsigned long long h) {
+  h ^= h >> 33;
+  h *= 0xFF51AFD7ED558CCDULL;
+  h ^= h >> 33;
+  h *= 0xC4CEB9FE1A85EC53ULL;
+  h ^= h >> 33;
+  return (size_t)h;
+}
+
+/* Hash a fixed-size binary key. Ex: A structure with (st_dev, st_ino) */
+static inline size_t HashBytes(const void *pKey, size_t nBytes) {
+  const unsigned char *pc = (const unsigned char *)pKey;
+  unsigned long long h = 0xCBF29CE484222325ULL;	/* FNV-1a 64-bits */
+  while (nBytes--) {
+    h ^= *(pc++);
+    h *= 0x100000001B3ULL;
+  }
+  return HashMix(h);
+}
+
+/* Hash a NUL-terminated string key */
+static inline size_t HashString(const char *pszKey) {
+  const unsigned char *pc = (const unsigned char *)pszKey;
+  unsigned long long h = 0xCBF29CE484222325ULL;	/* FNV-1a 64-bits */
+  while (*pc) {
+    h ^= *(pc++);
+    h *= 0x100000001B3ULL;
+  }
+  return HashMix(h);
+}
+
+#define HASH_DEFINE_TYPES(table_t, entry_t)					\
+										\
+typedef void *HASH_##entry_t##_CB(entry_t *pEntry, void *ref);			\
+										\
+/* The user-provided routines */						\
+extern size_t HASH_KEY(entry_t)(entry_t *pEntry);				\
+extern int HASH_CMP(entry_t)(entry_t *e1, entry_t *e2);				\
+										\
+/* Public routines */								\
+extern table_t *new_##entry_t##_hash(void);					\
+extern void free_##entry_t##_hash(table_t *table);				\
+extern entry_t *get_##entry_t(table_t *table, entry_t *pEntry);			\
+extern entry_t *put_##entry_t(table_t *table, entry_t *pEntry, int *pbAdded);	\
+extern int remove_##entry_t(table_t *table, entry_t *pEntry);			\
+extern void *foreach_##entry_t(table_t *table, HASH_##entry_t##_CB *func, void *ref); \
+										\
+static inline size_t num_##entry_t(table_t *table) {				\
+  return table->hsh_length;							\
+}										\
+
+/* Private routines, to be defined once in one file for each table type. */
+
+#define HASH_DEFINE_PROCS(table_t, entry_t)					\
+										\
+/* Compute the hash of an entry key. 0 is reserved for empty slots */		\
+static size_t HASH_OF_##entry_t(entry_t *pEntry) {				\
+  size_t h = HASH_KEY(entry_t)(pEntry);						\
+  return h ? h : 1;								\
+}										\
+										\
+table_t *new_##entry_t##_hash(void) {						\
+  return (table_t *)calloc(1, sizeof(table_t));					\
+}										\
+										\
+void free_##entry_t##_hash(table_t *table) {					\
+  if (!table) return;								\
+  free(table->hsh_slots);							\
+  free(table);									\
+}										\
+										\
+/* Find the slot for a key: Either the entry with that key, or an empty slot */	\
+static entry_t *HASH_FIND_##entry_t(table_t *table, entry_t *pEntry, size_t h) { \
+  size_t mask = table->hsh_size - 1;						\
+  size_t i = h & mask;								\
+  for ( ; ; i = (i + 1) & mask) {						\
+    entry_t *pSlot = table->hsh_slots + i;					\
+    if (!pSlot->hsh_hash) return pSlot;						\
+    if ((pSlot->hsh_hash == h) && !HASH_CMP(entry_t)(pSlot, pEntry)) return pSlot; \
+  }										\
+}										\
+										\
+static int HASH_RESIZE_##entry_t(table_t *table, size_t size) {			\
+  entry_t *old = table->hsh_slots;						\
+  size_t oldSize = table->hsh_size;						\
+  size_t i;									\
+  entry_t *pSlots = (entry_t *)calloc(size, sizeof(entry_t));			\
+  if (!pSlots) return -1;							\
+  table->hsh_slots = pSlots;							\
+  table->hsh_size = size;							\
+  for (i = 0; i < oldSize; i++) {						\
+    if (old[i].hsh_hash) {							\
+      size_t j = old[i].hsh_hash & (size - 1);					\
+      while (pSlots[j].hsh_hash) j = (j + 1) & (size - 1);			\
+      pSlots[j] = old[i];							\
+    }										\
+  }										\
+  free(old);									\
+  return 0;									\
+}										\
+										\
+entry_t *get_##entry_t(table_t *table, entry_t *pEntry) {			\
+  entry_t *pSlot;								\
+  if (!table->hsh_length) return NULL;						\
+  pSlot = HASH_FIND_##entry_t(table, pEntry, HASH_OF_##entry_t(pEntry));	\
+  return pSlot->hsh_hash ? pSlot : NULL;					\
+}										\
+										\
+entry_t *put_##entry_t(table_t *table, entry_t *pEntry, int *pbAdded) {		\
+  size_t h = HASH_OF_##entry_t(pEntry);						\
+  entry_t *pSlot;								\
+  if (pbAdded) *pbAdded = 0;							\
+  if (((table->hsh_length + 1) * 4) > (table->hsh_size * 3)) {			\
+    size_t size = table->hsh_size ? (2 * table->hsh_size) : HASH_MIN_SIZE;	\
+    if (HASH_RESIZE_##entry_t(table, size)) return NULL;			\
+  }										\
+  pSlot = HASH_FIND_##entry_t(table, pEntry, h);				\
+  if (!pSlot->hsh_hash) { /* Not found. Copy the new entry in the free slot */	\
+    *pSlot = *pEntry;								\
+    pSlot->hsh_hash = h;							\
+    table->hsh_length += 1;							\
+    if (pbAdded) *pbAdded = 1;							\
+  }										\
+  return pSlot;									\
+}										\
+										\
+int remove_##entry_t(table_t *table, entry_t *pEntry) {				\
+  size_t mask = table->hsh_size - 1;						\
+  size_t i, j;									\
+  entry_t *pSlot;								\
+  if (!table->hsh_length) return 0;						\
+  pSlot = HASH_FIND_##entry_t(table, pEntry, HASH_OF_##entry_t(pEntry));	\
+  if (!pSlot->hsh_hash) return 0;						\
+  /* Shift back the following entries of the same cluster, if needed */		\
+  i = (size_t)(pSlot - table->hsh_slots);					\
+  for (j = (i + 1) & mask; table->hsh_slots[j].hsh_hash; j = (j + 1) & mask) {	\
+    size_t k = table->hsh_slots[j].hsh_hash & mask; /* Its preferred slot */	\
+    /* Move it back if its preferred slot is not cyclically in ]i, j] */	\
+    if ((i <= j) ? ((i < k) && (k <= j)) : ((i < k) || (k <= j))) continue;	\
+    table->hsh_slots[i] = table->hsh_slots[j];					\
+    i = j;									\
+  }										\
+  table->hsh_slots[i].hsh_hash = 0;						\
+  table->hsh_length -= 1;							\
+  return 1;									\
+}										\
+										\
+void *foreach_##entry_t(table_t *table, HASH_##entry_t##_CB *function, void *ref) { \
+  size_t i;									\
+  for (i = 0; i < table->hsh_size; i++) {					\
+    if (table->hsh_slots[i].hsh_hash) {						\
+      void *result = function(table->hsh_slots + i, ref);			\
+      if (result) return result;						\
+    }										\
+  }										\
+  return NULL;									\
+}										\
+
+#endif /* _hashtab_h_ */
+